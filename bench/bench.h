@@ -0,0 +1,65 @@
+//==== bench/bench.h ====
+
+// Host benchmark harness for the env:native build. Suites register themselves
+// with BENCH_SUITE() and report per-operation latency samples through
+// BenchLatency, which prints throughput and p50/p99 in one line per case.
+
+#ifndef KNX_BENCH_H
+#define KNX_BENCH_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <chrono>
+#include <vector>
+
+using BenchClock = std::chrono::steady_clock;
+
+inline uint64_t benchNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchClock::now().time_since_epoch()).count();
+}
+
+class BenchLatency {
+public:
+    explicit BenchLatency(size_t expectedSamples) { samples.reserve(expectedSamples); }
+
+    void add(uint64_t ns) { samples.push_back(ns); }
+    void setWallTime(uint64_t ns) { wallNs = ns; }
+    size_t count() const { return samples.size(); }
+
+    // Prints "<name>  <frames/s>  p50  p99  max" and returns frames/s.
+    double report(const char* name);
+
+private:
+    std::vector<uint64_t> samples;
+    uint64_t wallNs = 0;
+};
+
+// Prints a free-form result line aligned with BenchLatency::report().
+void benchNote(const char* name, const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+// Marks the benchmark run as failed (non-zero exit status) after printing why.
+// Used by suites that double as self-checks, e.g. allocation-free paths.
+void benchFail(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+// Builds a KNXnet/IP ROUTING_INDICATION carrying a GroupValue_Write from src
+// to the group address dst. Returns the datagram length.
+size_t benchRoutingFrame(uint8_t* buffer, uint16_t src, uint16_t dst,
+                         const uint8_t* payload, size_t payloadLength);
+
+// Delivers a datagram to the module under test the way lwIP would.
+inline size_t benchInject(const uint8_t* data, size_t length,
+                          const IPAddress& dst = IPAddress(224, 0, 23, 12)) {
+    return AsyncUDPLoopback::deliver(data, length, IPAddress(192, 168, 1, 50), 3671, dst, 3671);
+}
+
+struct BenchSuite {
+    BenchSuite(const char* name, void (*run)());
+    const char* name;
+    void (*run)();
+    BenchSuite* next;
+};
+
+#define BENCH_SUITE(name, function) static BenchSuite benchSuite_##function(name, function)
+
+#endif // KNX_BENCH_H
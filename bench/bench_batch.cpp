@@ -0,0 +1,151 @@
+//==== bench/bench_batch.cpp ====
+
+// Scene activation: 32 group writes of mixed DPTs sent one call at a time and
+// as a pre-encoded KNXBatch, with and without the group value cache. Checks
+// that both produce the same datagrams, that a batch send does not allocate,
+// priority ordering, and per-entry status with the transmit queue and during
+// a ROUTING_BUSY pause.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "native_heap.h"
+
+namespace {
+
+const size_t SCENES = 5000;
+const size_t ENTRIES = 32;
+
+uint16_t groupOf(size_t i) {
+    return (uint16_t)((4 << 11) | (1 << 8) | i);
+}
+
+KNXPriority priorityOf(size_t i) {
+    return i % 8 == 0 ? KNX_PRIORITY_URGENT : (i % 8 == 1 ? KNX_PRIORITY_NORMAL : KNX_PRIORITY_LOW);
+}
+
+void sendOneByOne(KNXIPModule& module) {
+    for (size_t i = 0; i < ENTRIES; i++) {
+        switch (i % 3) {
+        case 0: module.send<KNXDpt<1, 1>>(groupOf(i), (i & 4) != 0, priorityOf(i)); break;
+        case 1: module.send<KNXDpt<5, 1>>(groupOf(i), (uint16_t)(i * 3), priorityOf(i)); break;
+        default: module.send<KNXDpt<9, 1>>(groupOf(i), 20.0f + i, priorityOf(i)); break;
+        }
+    }
+}
+
+void buildScene(KNXBatch& scene) {
+    scene.begin(ENTRIES);
+    for (size_t i = 0; i < ENTRIES; i++) {
+        switch (i % 3) {
+        case 0: scene.add<KNXDpt<1, 1>>(groupOf(i), (i & 4) != 0, priorityOf(i)); break;
+        case 1: scene.add<KNXDpt<5, 1>>(groupOf(i), (uint16_t)(i * 3), priorityOf(i)); break;
+        default: scene.add<KNXDpt<9, 1>>(groupOf(i), 20.0f + i, priorityOf(i)); break;
+        }
+    }
+}
+
+std::vector<std::vector<uint8_t>> captureWrites(const std::function<void()>& send) {
+    std::vector<std::vector<uint8_t>> datagrams;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        datagrams.emplace_back(data, data + length);
+    });
+    send();
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+    return datagrams;
+}
+
+void runCase(const char* name, bool cache, bool batched) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    if (cache) module.enableGroupCache();
+    module.beginMulticast(1, 1, 10);
+    KNXBatch scene;
+    buildScene(scene);
+
+    BenchLatency latency(SCENES);
+    uint64_t allocationsBefore = nativeHeapAllocations();
+    uint64_t wallNs = 0;
+    for (size_t round = 0; round < SCENES; round++) {
+        uint64_t t0 = benchNowNs();
+        if (batched) {
+            module.sendBatch(scene);
+        } else {
+            sendOneByOne(module);
+        }
+        uint64_t elapsed = benchNowNs() - t0;
+        latency.add(elapsed);
+        wallNs += elapsed;
+        AsyncUDPLoopback::discardPending();
+    }
+    uint64_t allocations = nativeHeapAllocations() - allocationsBefore;
+    latency.setWallTime(wallNs);
+    latency.report(name);
+    if (batched && allocations != 0) {
+        benchFail("%s allocated %llu times", name, (unsigned long long)allocations);
+    }
+}
+
+void checkBatch() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    KNXBatch scene;
+    buildScene(scene);
+
+    auto single = captureWrites([&] { sendOneByOne(module); });
+    auto batched = captureWrites([&] { module.sendBatch(scene); });
+    if (single.size() != ENTRIES || single != batched) {
+        benchFail("batch sent %zu datagrams, not the %zu of single sends", batched.size(), single.size());
+    }
+    for (size_t i = 0; i < ENTRIES; i++) {
+        if (scene.status(i) != KNX_BATCH_SENT) benchFail("entry %zu not marked sent", i);
+    }
+
+    // Urgent entries first, then normal, then low, each in insertion order
+    auto ordered = captureWrites([&] { module.sendBatch(scene, KNX_BATCH_BY_PRIORITY); });
+    size_t position = 0;
+    bool inOrder = ordered.size() == ENTRIES;
+    for (KNXPriority priority : {KNX_PRIORITY_URGENT, KNX_PRIORITY_NORMAL, KNX_PRIORITY_LOW}) {
+        for (size_t i = 0; inOrder && i < ENTRIES; i++) {
+            if (priorityOf(i) != priority) continue;
+            const std::vector<uint8_t>& datagram = ordered[position++];
+            inOrder = ((datagram[12] << 8) | datagram[13]) == groupOf(i);
+        }
+    }
+    if (!inOrder) benchFail("priority order not kept");
+
+    // During a ROUTING_BUSY pause every entry fails
+    const uint8_t busy[] = {0x06, 0x10, 0x05, 0x32, 0x00, 0x0C, 0x06, 0x00, 0x00, 0x64, 0x00, 0x00};
+    benchInject(busy, sizeof(busy));
+    size_t sent = module.sendBatch(scene);
+    if (sent != 0 || scene.status(0) != KNX_BATCH_FAILED) benchFail("batch sent %zu during a pause", sent);
+    nativeAdvanceClock(500);
+
+    // With the transmit queue, entries beyond its capacity fail
+    KNXTxQueueConfig queue;
+    queue.capacity = 20;
+    queue.burst = 1;
+    module.enableTxQueue(queue);
+    sent = module.sendBatch(scene);
+    size_t queued = 0, failed = 0;
+    for (size_t i = 0; i < ENTRIES; i++) {
+        queued += scene.status(i) == KNX_BATCH_QUEUED;
+        failed += scene.status(i) == KNX_BATCH_FAILED;
+    }
+    benchNote("batch via tx queue", "%zu accepted, %zu queued, %zu failed", sent, queued, failed);
+    if (sent != 20 || queued != 20 || failed != ENTRIES - 20) benchFail("tx queue statuses wrong");
+    AsyncUDPLoopback::discardPending();
+}
+
+void runBatchBenchmark() {
+    runCase("scene x32, single sends", false, false);
+    runCase("scene x32, batch", false, true);
+    runCase("scene x32, single sends + cache", true, false);
+    runCase("scene x32, batch + cache", true, true);
+    checkBatch();
+}
+
+} // namespace
+
+BENCH_SUITE("batch", runBatchBenchmark);
@@ -0,0 +1,221 @@
+//==== bench/bench_bus_analytics.cpp ====
+
+// Bus analytics: checks the top talker summary against exact counts on a
+// skewed stream of 500 addresses, then two simulated minutes of a line where
+// one device floods a group address among ten well-behaved ones, comparing
+// rates, bus load and APCI mix with what was sent. Measures the receive path
+// with and without analytics and the summary update at several sizes.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const uint16_t FLOODER = (1 << 12) | (1 << 8) | 99;
+const uint16_t FLOODED_GROUP = (7 << 11) | (0 << 8) | 1;
+const size_t DEVICES = 10;
+// TP1 bit times of the frames below: a write with one payload octet is 10
+// octets on the line, a read 9 (see KNX_TP1_BITS_PER_OCTET)
+const uint32_t WRITE_BITS = KNX_TP1_FRAME_OVERHEAD_BITS + 10 * KNX_TP1_BITS_PER_OCTET;
+const uint32_t READ_BITS = KNX_TP1_FRAME_OVERHEAD_BITS + 9 * KNX_TP1_BITS_PER_OCTET;
+
+uint16_t deviceAddress(size_t i) {
+    return (uint16_t)((1 << 12) | (1 << 8) | (i + 20));
+}
+
+uint16_t deviceGroup(size_t i) {
+    return (uint16_t)((3 << 11) | (1 << 8) | i);
+}
+
+// Addresses with Zipf-like frequencies: address k comes about 1/k as often
+// as the first
+uint16_t skewedAddress(uint32_t& state, size_t addresses) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    double u = (state >> 8) / 16777216.0;
+    size_t k = (size_t)std::pow((double)addresses, u);
+    return (uint16_t)(0x1000 + (k < addresses ? k : addresses - 1));
+}
+
+void checkSummary() {
+    const size_t ADDRESSES = 500, CAPACITY = 16, STREAM = 100000;
+    KNXTopCounter summary;
+    summary.begin(CAPACITY);
+    std::vector<uint32_t> exact(0x1000 + ADDRESSES, 0);
+    uint32_t state = 2463534242U;
+    for (size_t i = 0; i < STREAM; i++) {
+        uint16_t address = skewedAddress(state, ADDRESSES);
+        exact[address]++;
+        summary.count(address);
+    }
+
+    KNXTopAddress top[CAPACITY];
+    size_t entries = summary.top(top, CAPACITY);
+    size_t bounded = 0, ordered = 1, heavyFound = 0, heavy = 0;
+    for (size_t i = 0; i < entries; i++) {
+        uint32_t truth = exact[top[i].address];
+        if (truth <= top[i].count && top[i].count - top[i].error <= truth) bounded++;
+        if (i > 0 && top[i].count > top[i - 1].count) ordered = 0;
+    }
+    // Every address above STREAM / CAPACITY must be reported
+    for (size_t address = 0; address < exact.size(); address++) {
+        if (exact[address] <= STREAM / CAPACITY) continue;
+        heavy++;
+        for (size_t i = 0; i < entries; i++) heavyFound += top[i].address == address;
+    }
+    std::vector<uint32_t> sorted(exact);
+    std::sort(sorted.begin(), sorted.end(), std::greater<uint32_t>());
+    benchNote("top talkers", "%zu counters for %zu addresses: %zu of %zu within bounds, %zu of %zu heavy "
+        "hitters found; first %u (exact %u)", CAPACITY, ADDRESSES, bounded, entries, heavyFound, heavy,
+        top[0].count, sorted[0]);
+    if (entries != CAPACITY || bounded != entries || !ordered || heavyFound != heavy) {
+        benchFail("top talker summary out of bounds");
+    }
+
+    // Fewer addresses than counters: exact
+    summary.clear();
+    for (int i = 0; i < 100; i++) summary.count((uint16_t)(i % 5));
+    entries = summary.top(top, CAPACITY);
+    bool exactSmall = entries == 5;
+    for (size_t i = 0; exactSmall && i < entries; i++) exactSmall = top[i].count == 20 && top[i].error == 0;
+    if (!exactSmall) benchFail("top talker summary not exact below its capacity");
+}
+
+void injectFrame(uint16_t source, uint16_t group, uint8_t apci, bool withPayload) {
+    uint8_t frame[32];
+    uint8_t value = 0x42;
+    size_t length = benchRoutingFrame(frame, source, group, &value, withPayload ? 1 : 0);
+    frame[16] = apci;
+    benchInject(frame, length);
+}
+
+void checkFlood() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    module.enableBusAnalytics();
+
+    // Per 100 ms: two writes of the flooder, one frame of a device; even
+    // devices read, odd ones respond
+    const uint32_t SIMULATED_MS = 120000;
+    for (uint32_t t = 0; t < SIMULATED_MS; t += 100) {
+        injectFrame(FLOODER, FLOODED_GROUP, 0x80, true);
+        injectFrame(FLOODER, FLOODED_GROUP, 0x80, true);
+        size_t device = (t / 100) % DEVICES;
+        if (device % 2 == 0) {
+            injectFrame(deviceAddress(device), deviceGroup(device), 0x00, false);
+        } else {
+            injectFrame(deviceAddress(device), deviceGroup(device), 0x40, true);
+        }
+        nativeAdvanceClock(100);
+    }
+
+    KNXBusStats stats = module.getBusStats();
+    KNXTopAddress sources[4], groups[4];
+    size_t sourceCount = module.getTopSources(sources, 4);
+    size_t groupCount = module.getTopGroupAddresses(groups, 4);
+
+    uint32_t bitsPerSecond = 20 * WRITE_BITS + 5 * READ_BITS + 5 * WRITE_BITS;
+    float expectedLoad = 100.0f * bitsPerSecond / 9600;
+    benchNote("flood", "%u frames/s, %u/min, load %.1f%% (expected %.1f%%), minute %.1f%%, peak %.1f%%",
+        stats.framesLastSecond, stats.framesLastMinute, stats.loadLastSecond, expectedLoad,
+        stats.loadLastMinute, stats.peakLoad);
+    benchNote("  top", "source %u.%u.%u with %u frames, group %u/%u/%u with %u; %u writes, %u reads, "
+        "%u responses", sources[0].address >> 12, (sources[0].address >> 8) & 0x0F, sources[0].address & 0xFF,
+        sources[0].count, groups[0].address >> 11, (groups[0].address >> 8) & 0x07, groups[0].address & 0xFF,
+        groups[0].count, stats.apci[KNX_APCI_GROUP_VALUE_WRITE], stats.apci[KNX_APCI_GROUP_VALUE_READ],
+        stats.apci[KNX_APCI_GROUP_VALUE_RESPONSE]);
+
+    const uint32_t ticks = SIMULATED_MS / 100;
+    if (stats.frames != ticks * 3 || stats.framesLastSecond != 30 || stats.framesLastMinute != 1800 ||
+        stats.peakFramesPerSecond != 30) {
+        benchFail("flood rates: %u frames, %u/s, %u/min, peak %u/s", stats.frames, stats.framesLastSecond,
+            stats.framesLastMinute, stats.peakFramesPerSecond);
+    }
+    if (std::fabs(stats.loadLastSecond - expectedLoad) > 0.01f ||
+        std::fabs(stats.loadLastMinute - expectedLoad) > 0.01f) {
+        benchFail("flood load %.2f%% / %.2f%%, expected %.2f%%", stats.loadLastSecond, stats.loadLastMinute,
+            expectedLoad);
+    }
+    if (sourceCount == 0 || sources[0].address != FLOODER || sources[0].count != ticks * 2 ||
+        groupCount == 0 || groups[0].address != FLOODED_GROUP) {
+        benchFail("flooder not at the top of the summaries");
+    }
+    if (stats.apci[KNX_APCI_GROUP_VALUE_WRITE] != ticks * 2 || stats.apci[KNX_APCI_GROUP_VALUE_READ] != ticks / 2 ||
+        stats.apci[KNX_APCI_GROUP_VALUE_RESPONSE] != ticks / 2 || stats.groupFrames != stats.frames) {
+        benchFail("APCI mix: %u writes, %u reads, %u responses", stats.apci[KNX_APCI_GROUP_VALUE_WRITE],
+            stats.apci[KNX_APCI_GROUP_VALUE_READ], stats.apci[KNX_APCI_GROUP_VALUE_RESPONSE]);
+    }
+
+    // Our sends count once, not again when multicast loopback returns them
+    for (int i = 0; i < 5; i++) module.sendBool(FLOODED_GROUP, true);
+    AsyncUDPLoopback::poll();
+    uint32_t afterSends = module.getBusStats().frames;
+    if (afterSends != stats.frames + 5) benchFail("5 own sends counted as %u frames", afterSends - stats.frames);
+
+    // A silent minute empties the windows; the peak stays
+    nativeAdvanceClock(61000);
+    stats = module.getBusStats();
+    if (stats.framesLastSecond != 0 || stats.framesLastMinute != 0 || stats.loadLastMinute != 0 ||
+        stats.peakFramesPerSecond != 30) {
+        benchFail("after a silent minute: %u/s, %u/min, peak %u/s", stats.framesLastSecond,
+            stats.framesLastMinute, stats.peakFramesPerSecond);
+    }
+}
+
+void runReceive(const char* name, bool analytics) {
+    const size_t FRAMES = 50000;
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    if (analytics) module.enableBusAnalytics();
+    module.onGroupAddress(FLOODED_GROUP, [](const KNXTelegram&) {});
+
+    uint8_t frame[32];
+    uint8_t value = 1;
+    uint32_t state = 88172645U;
+    BenchLatency latency(FRAMES);
+    uint64_t wallStart = benchNowNs();
+    for (size_t i = 0; i < FRAMES; i++) {
+        // One subscribed address among many unsubscribed ones
+        uint16_t group = i % 4 == 0 ? FLOODED_GROUP : skewedAddress(state, 2000);
+        size_t length = benchRoutingFrame(frame, skewedAddress(state, 300), group, &value, 1);
+        uint64_t t0 = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - t0);
+        if (i % 16 == 0) nativeAdvanceClock(1);
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    latency.report(name);
+}
+
+void runSummaryCost(size_t capacity) {
+    const size_t UPDATES = 200000;
+    KNXTopCounter summary;
+    summary.begin(capacity);
+    uint32_t state = 1234567U;
+    std::vector<uint16_t> stream(UPDATES);
+    for (size_t i = 0; i < UPDATES; i++) stream[i] = skewedAddress(state, 4000);
+    uint64_t t0 = benchNowNs();
+    for (size_t i = 0; i < UPDATES; i++) summary.count(stream[i]);
+    uint64_t elapsed = benchNowNs() - t0;
+    benchNote("  summary", "%zu counters: %.1f ns per frame", capacity, (double)elapsed / UPDATES);
+}
+
+void runBusAnalyticsBenchmark() {
+    checkSummary();
+    checkFlood();
+    runReceive("receive, no analytics", false);
+    runReceive("receive, bus analytics", true);
+    runSummaryCost(16);
+    runSummaryCost(256);
+    runSummaryCost(4096);
+}
+
+} // namespace
+
+BENCH_SUITE("analytics", runBusAnalyticsBenchmark);
@@ -0,0 +1,225 @@
+//==== bench/bench_capture.cpp ====
+
+// Packet capture: receive cost with capture on, pcap output parsed back with
+// the replay reader (record count, addresses, IPv4 checksums, payload), ring
+// overwrite, UDP streaming to a collector, and replaying a capture into a
+// fresh module at full and at scaled speed.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "knx_replay.h"
+
+namespace {
+
+const size_t FRAMES = 5000;
+const size_t SENDS = 100;
+const uint16_t GROUP = (1 << 11) | (3 << 8);
+
+class MemoryPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        bytes.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t length) override {
+        bytes.insert(bytes.end(), data, data + length);
+        return length;
+    }
+    std::vector<uint8_t> bytes;
+};
+
+size_t frameFor(uint8_t* frame, size_t i) {
+    const uint8_t payload[] = {(uint8_t)(i >> 8), (uint8_t)i};
+    return benchRoutingFrame(frame, 0x1105, (uint16_t)(GROUP | (i & 0xFF)), payload, sizeof(payload));
+}
+
+BenchLatency injectFrames(size_t count, uint32_t spacingMs = 0) {
+    uint8_t frame[64];
+    BenchLatency latency(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t length = frameFor(frame, i);
+        uint64_t t0 = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - t0);
+        if (spacingMs) nativeAdvanceClock(spacingMs);
+    }
+    return latency;
+}
+
+bool checksumValid(const KNXReplayDatagram& datagram) {
+    // The IPv4 header sits right before the UDP header
+    const uint8_t* ip = datagram.data - 28;
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) sum += (ip[i] << 8) | ip[i + 1];
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return sum == 0xFFFF;
+}
+
+void checkCapture(std::vector<uint8_t>& pcap) {
+    {
+        KNXIPModule plain;
+        plain.setDebugLevel(0);
+        plain.onMainGroup(1, [](const KNXTelegram&) {});
+        plain.beginMulticast(1, 1, 10);
+        injectFrames(FRAMES).report("rx, capture off");
+    }
+
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.onMainGroup(1, [](const KNXTelegram&) {});
+    KNXCaptureConfig config;
+    config.bufferSize = 1 << 20;
+    module.enableCapture(config);
+    module.beginMulticast(1, 1, 10);
+    AsyncUDPLoopback::setMulticastLoop(false);
+
+    injectFrames(FRAMES).report("rx, capture on");
+    for (size_t i = 0; i < SENDS; i++) module.sendBool(GROUP, i & 1);
+    AsyncUDPLoopback::discardPending();
+    AsyncUDPLoopback::setMulticastLoop(true);
+
+    MemoryPrint sink;
+    module.dumpCapture(sink);
+    pcap = sink.bytes;
+    KNXCaptureStats stats = module.getCaptureStats();
+    benchNote("  capture", "%u datagrams, %u dropped, %zu pcap bytes", stats.captured, stats.dropped, pcap.size());
+
+    KNXPcapReader reader;
+    if (!reader.parse(pcap.data(), pcap.size())) {
+        benchFail("capture does not parse: %s", reader.error().c_str());
+        return;
+    }
+    const std::vector<KNXReplayDatagram>& datagrams = reader.datagrams();
+    if (datagrams.size() != FRAMES + SENDS || stats.records != 0 || stats.streamed != FRAMES + SENDS) {
+        benchFail("capture holds %zu of %zu datagrams", datagrams.size(), FRAMES + SENDS);
+        return;
+    }
+
+    size_t wrong = 0;
+    uint8_t frame[64];
+    for (size_t i = 0; i < FRAMES; i++) {
+        const KNXReplayDatagram& datagram = datagrams[i];
+        size_t length = frameFor(frame, i);
+        if (datagram.length != length || memcmp(datagram.data, frame, length) != 0 ||
+            datagram.srcIP != IPAddress(192, 168, 1, 50) || datagram.dstIP != KNX_MULTICAST_IP ||
+            datagram.dstPort != KNX_PORT || !checksumValid(datagram)) {
+            wrong++;
+        }
+    }
+    const KNXReplayDatagram& sent = datagrams[FRAMES];
+    if (sent.srcIP != WiFi.localIP() || knxServiceType(sent.data, sent.length) != KNXNETIP_ROUTING_INDICATION) {
+        wrong++;
+    }
+    if (datagrams.back().timestampUs < datagrams.front().timestampUs) wrong++;
+    if (wrong) benchFail("%zu captured datagrams differ from what went over the network", wrong);
+}
+
+void checkOverwrite() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXCaptureConfig config;
+    config.bufferSize = 2048;
+    module.enableCapture(config);
+    module.beginMulticast(1, 1, 10);
+    injectFrames(100);
+
+    MemoryPrint sink;
+    module.dumpCapture(sink);
+    KNXCaptureStats stats = module.getCaptureStats();
+    KNXPcapReader reader;
+    reader.parse(sink.bytes.data(), sink.bytes.size());
+    const std::vector<KNXReplayDatagram>& datagrams = reader.datagrams();
+
+    uint8_t frame[64];
+    size_t length = frameFor(frame, 99);
+    benchNote("capture overwrite", "2048-byte buffer kept the newest %zu of 100, %u dropped",
+        datagrams.size(), stats.dropped);
+    if (datagrams.empty() || datagrams.size() + stats.dropped != 100 ||
+        memcmp(datagrams.back().data, frame, length) != 0) {
+        benchFail("overwrite did not keep the newest records");
+    }
+}
+
+void checkStreaming() {
+    const IPAddress COLLECTOR(192, 168, 1, 99);
+    std::vector<uint8_t> received;
+    size_t datagramsSent = 0;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port) {
+        if (ip != COLLECTOR || port != 5555) return;
+        received.insert(received.end(), data, data + length);
+        datagramsSent++;
+    });
+
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXCaptureConfig config;
+    config.streamIP = COLLECTOR;
+    config.streamPort = 5555;
+    module.enableCapture(config);
+    module.beginMulticast(1, 1, 10);
+    for (int round = 0; round < 10; round++) {
+        injectFrames(100);
+        module.loop();
+    }
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+
+    KNXPcapReader reader;
+    bool parsed = reader.parse(received.data(), received.size());
+    benchNote("capture stream", "%zu UDP datagrams, %zu bytes, %zu records",
+        datagramsSent, received.size(), reader.datagrams().size());
+    if (!parsed || reader.datagrams().size() != 1000) benchFail("streamed capture incomplete");
+}
+
+void checkReplay(const std::vector<uint8_t>& pcap) {
+    KNXPcapReader reader;
+    reader.parse(pcap.data(), pcap.size());
+
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    uint32_t calls = 0;
+    module.onMainGroup(1, [&calls](const KNXTelegram&) { calls++; });
+    module.beginMulticast(1, 1, 20);
+
+    std::vector<uint64_t> deliveryNs;
+    KNXReplayOptions options;
+    options.skipSource = WiFi.localIP(); // Our own writes from the capture
+    options.deliveryNs = &deliveryNs;
+    uint64_t start = benchNowNs();
+    size_t delivered = knxReplay(reader.datagrams(), options);
+    BenchLatency latency(deliveryNs.size());
+    for (uint64_t ns : deliveryNs) latency.add(ns);
+    latency.setWallTime(benchNowNs() - start);
+    latency.report("replay, max speed");
+    if (delivered != FRAMES || calls != FRAMES) benchFail("replay: %zu delivered, %u callbacks", delivered, calls);
+
+    // 50 frames captured 10 ms apart, replayed ten times faster
+    KNXIPModule source;
+    source.setDebugLevel(0);
+    source.enableCapture();
+    source.beginMulticast(1, 1, 10);
+    injectFrames(50, 10);
+    MemoryPrint sink;
+    source.dumpCapture(sink);
+    reader.parse(sink.bytes.data(), sink.bytes.size());
+
+    options.speed = 10;
+    options.deliveryNs = nullptr;
+    start = benchNowNs();
+    knxReplay(reader.datagrams(), options);
+    double elapsedMs = (benchNowNs() - start) / 1e6;
+    benchNote("replay, 10x speed", "490 ms of capture in %.1f ms", elapsedMs);
+    if (elapsedMs < 45 || elapsedMs > 150) benchFail("10x replay took %.1f ms", elapsedMs);
+}
+
+void runCaptureBenchmark() {
+    std::vector<uint8_t> pcap;
+    checkCapture(pcap);
+    checkOverwrite();
+    checkStreaming();
+    checkReplay(pcap);
+}
+
+} // namespace
+
+BENCH_SUITE("capture", runCaptureBenchmark);
@@ -0,0 +1,222 @@
+//==== bench/bench_cemi.cpp ====
+
+// cEMI L_Data family: checks knxParseCemi against well-formed and malformed
+// L_Data.req/.con/.ind frames, standard and extended, checks that the receive
+// path takes the address type from control field 2, passes extended frames on
+// and holds back those longer than KNX_TELEGRAM_MAX_DATA, and compares moving
+// a block of parameter data in standard frames (14 bytes each) with extended
+// frames (as long as KNX_TELEGRAM_MAX_DATA allows, 253 bytes at most).
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <vector>
+
+namespace {
+
+const uint16_t GROUP = (5 << 11) | (1 << 8) | 7;
+const size_t BULK_BYTES = 4096;
+
+// Builds an L_Data frame: additional info of addInfo bytes, the APDU given by
+// apduLength (APCI octet 0x80, then a counting pattern), and `lengthOctet`
+// overriding the length field when >= 0.
+std::vector<uint8_t> cemiFrame(uint8_t messageCode, uint8_t ctrl1, uint8_t ctrl2, size_t addInfo,
+                               size_t apduLength, int lengthOctet = -1) {
+    std::vector<uint8_t> frame;
+    frame.push_back(messageCode);
+    frame.push_back((uint8_t)addInfo);
+    for (size_t i = 0; i < addInfo; i++) frame.push_back(0xA0 + i);
+    frame.push_back(ctrl1);
+    frame.push_back(ctrl2);
+    frame.push_back(0x11);
+    frame.push_back(0x05);
+    frame.push_back(GROUP >> 8);
+    frame.push_back(GROUP & 0xFF);
+    frame.push_back(lengthOctet >= 0 ? (uint8_t)lengthOctet : (uint8_t)apduLength);
+    frame.push_back(0x00);
+    for (size_t i = 0; i < apduLength; i++) frame.push_back(i == 0 ? 0x80 : (uint8_t)i);
+    return frame;
+}
+
+void injectCemi(const std::vector<uint8_t>& cemi) {
+    std::vector<uint8_t> datagram(KNXNETIP_HEADER_LENGTH + cemi.size());
+    knxWriteHeader(datagram.data(), KNXNETIP_ROUTING_INDICATION, datagram.size());
+    memcpy(datagram.data() + KNXNETIP_HEADER_LENGTH, cemi.data(), cemi.size());
+    benchInject(datagram.data(), datagram.size());
+}
+
+void checkParser() {
+    struct Case {
+        const char* name;
+        std::vector<uint8_t> frame;
+        bool valid;
+    };
+    std::vector<uint8_t> truncated = cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 3);
+    truncated.pop_back();
+    std::vector<uint8_t> trailing = cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 3);
+    trailing.push_back(0x00);
+    std::vector<uint8_t> shortInfo = cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 1);
+    shortInfo[1] = 0x20; // Additional info beyond the end
+    const Case cases[] = {
+        {"L_Data.ind", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 3), true},
+        {"L_Data.req", cemiFrame(KNX_CEMI_L_DATA_REQ, 0xBC, 0xE0, 0, 3), true},
+        {"L_Data.con", cemiFrame(KNX_CEMI_L_DATA_CON, 0xBC, 0xE0, 0, 3), true},
+        {"additional info", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 7, 3), true},
+        {"TPCI only", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0x60, 0, 0), true},
+        {"standard, 15 octets", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 15), true},
+        {"extended, 254 octets", cemiFrame(KNX_CEMI_L_DATA_IND, 0x3C, 0xE0, 0, 254), true},
+        {"standard, 16 octets", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 16), false},
+        {"extended, length 255", cemiFrame(KNX_CEMI_L_DATA_IND, 0x3C, 0xE0, 0, 255), false},
+        {"L_Busmon.ind", cemiFrame(0x2B, 0xBC, 0xE0, 0, 3), false},
+        {"length octet too large", cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 3, 4), false},
+        {"truncated", truncated, false},
+        {"trailing byte", trailing, false},
+        {"additional info overrun", shortInfo, false},
+    };
+
+    size_t wrong = 0;
+    for (const Case& test : cases) {
+        KNXCemiFrame frame;
+        bool valid = knxParseCemi(test.frame.data(), test.frame.size(), frame);
+        if (valid && (frame.destination != GROUP || frame.source != 0x1105 ||
+                      frame.tpdu + 1 + frame.apduLength != test.frame.data() + test.frame.size())) {
+            valid = !test.valid; // Fields read from the wrong offsets
+        }
+        if (valid != test.valid) {
+            benchFail("cemi %s: %s", test.name, valid ? "accepted" : "rejected");
+            wrong++;
+        }
+    }
+    benchNote("cemi parser", "%zu cases, %zu wrong", sizeof(cases) / sizeof(cases[0]), wrong);
+}
+
+// Fits KNX_TELEGRAM_MAX_DATA exactly, and one far beyond it
+void checkReceive(bool dispatchTask) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    size_t calls = 0;
+    KNXTelegram last;
+    module.onGroupAddress(GROUP, [&](const KNXTelegram& telegram) {
+        calls++;
+        last = telegram;
+    });
+    module.enableGroupCache();
+    if (dispatchTask) module.enableDispatchTask();
+    module.beginMulticast(1, 1, 10);
+
+    // Extended frames with additional info
+    const size_t longest = KNX_TELEGRAM_MAX_DATA;
+    injectCemi(cemiFrame(KNX_CEMI_L_DATA_IND, 0x3C, 0xE0, 4, longest));
+    const uint32_t tooLong = longest < KNX_CEMI_EXTENDED_APDU ? 1 : 0;
+    if (tooLong) injectCemi(cemiFrame(KNX_CEMI_L_DATA_IND, 0x3C, 0xE0, 4, KNX_CEMI_EXTENDED_APDU));
+    // Same destination bits as an individual address: not a group telegram,
+    // whatever control field 1 says
+    injectCemi(cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0x60, 0, 3));
+    // Malformed frames are counted and dropped
+    injectCemi(cemiFrame(KNX_CEMI_L_DATA_IND, 0xBC, 0xE0, 0, 16));
+    if (dispatchTask) {
+        KNXRxQueueStats queue = module.getRxQueueStats();
+        while (queue.dispatched + queue.dropped < queue.received) {
+            delay(1);
+            queue = module.getRxQueueStats();
+        }
+        module.disableDispatchTask();
+    }
+
+    KNXStats stats = module.getStats();
+    KNXRxQueueStats queue = module.getRxQueueStats();
+    KNXCachedValue cached;
+    bool fullOk = last.extendedFrame && last.command == KNX_APCI_GROUP_VALUE_WRITE && !last.truncated &&
+        last.apduLength == longest && last.data.size() == longest && last.data[0] == 0x00 &&
+        last.data[longest - 1] == (uint8_t)(longest - 1);
+    // The longer frame must not reach the callback or replace the cached value
+    bool cacheOk = module.getCachedValue(GROUP, cached) && cached.length == longest && cached.count == 1;
+    const char* mode = dispatchTask ? "cemi receive, dispatch task" : "cemi receive";
+    benchNote(mode, "%zu-octet frame %s, %zu callbacks, %u truncated, %u parse errors, %u queue drops",
+        longest, fullOk ? "delivered" : "wrong", calls, stats.telegramsTruncated, stats.parseErrors,
+        queue.dropped);
+    if (!fullOk || !cacheOk || calls != 1 || stats.parseErrors != 1 ||
+        stats.telegramsTruncated + queue.dropped != tooLong) {
+        benchFail("%s: %zu callbacks, cache %s, %u truncated, %u parse errors", mode, calls,
+            cacheOk ? "ok" : "wrong", stats.telegramsTruncated, stats.parseErrors);
+    }
+}
+
+// Everything up to KNX_TELEGRAM_MAX_DATA is sent, directly, queued or batched
+void checkSendLimits() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    uint8_t apdu[KNX_TELEGRAM_MAX_DATA + 1] = {0x80};
+    bool direct = module.sendKNXMessage(GROUP, apdu, KNX_TELEGRAM_MAX_DATA) &&
+        !module.sendKNXMessage(GROUP, apdu, KNX_TELEGRAM_MAX_DATA + 1);
+    KNXBatch batch;
+    batch.begin(2, 2 * (10 + KNX_TELEGRAM_MAX_DATA + 1));
+    bool batched = batch.add(GROUP, apdu, KNX_TELEGRAM_MAX_DATA) &&
+        !batch.add(GROUP, apdu, KNX_TELEGRAM_MAX_DATA + 1);
+    module.enableTxQueue();
+    bool queued = module.sendKNXMessage(GROUP, apdu, KNX_TELEGRAM_MAX_DATA) &&
+        !module.sendKNXMessage(GROUP, apdu, KNX_TELEGRAM_MAX_DATA + 1);
+    AsyncUDPLoopback::discardPending();
+    if (!direct || !batched || !queued) {
+        benchFail("cemi send limits: direct %d, batch %d, queue %d", direct, batched, queued);
+    }
+}
+
+// Sends BULK_BYTES of data in chunks of `chunk` bytes after the APCI octet
+void runBulk(const char* name, size_t chunk) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+
+    size_t datagrams = 0;
+    size_t wireBytes = 0;
+    size_t malformed = 0;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        KNXCemiFrame frame;
+        if (!knxParseCemi(data + KNXNETIP_HEADER_LENGTH, length - KNXNETIP_HEADER_LENGTH, frame) ||
+            frame.isExtended() != (frame.apduLength > KNX_CEMI_STANDARD_APDU)) {
+            malformed++;
+        }
+        datagrams++;
+        wireBytes += length;
+    });
+
+    uint8_t apdu[KNX_CEMI_EXTENDED_APDU];
+    size_t telegrams = (BULK_BYTES + chunk - 1) / chunk;
+    BenchLatency latency(telegrams);
+    uint64_t wallStart = benchNowNs();
+    for (size_t sent = 0; sent < BULK_BYTES; sent += chunk) {
+        size_t length = std::min(chunk, BULK_BYTES - sent);
+        apdu[0] = 0x80;
+        for (size_t i = 0; i < length; i++) apdu[1 + i] = (uint8_t)(sent + i);
+        uint64_t start = benchNowNs();
+        if (!module.sendKNXMessage(GROUP, apdu, 1 + length)) malformed++;
+        latency.add(benchNowNs() - start);
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+
+    latency.report(name);
+    benchNote("  on the wire", "%zu telegrams, %zu bytes for %zu bytes of data", datagrams, wireBytes,
+        BULK_BYTES);
+    if (datagrams != telegrams || malformed != 0) {
+        benchFail("%s: %zu of %zu telegrams, %zu malformed", name, datagrams, telegrams, malformed);
+    }
+}
+
+void runCemiBenchmark() {
+    checkParser();
+    checkReceive(false);
+    checkReceive(true);
+    checkSendLimits();
+    runBulk("cemi bulk, standard frames", KNX_CEMI_STANDARD_APDU - 1);
+    // As long as KNX_TELEGRAM_MAX_DATA allows; 254 for the full comparison
+    if (KNX_TELEGRAM_MAX_DATA > KNX_CEMI_STANDARD_APDU) {
+        runBulk("cemi bulk, extended frames", KNX_TELEGRAM_MAX_DATA - 1);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("cemi", runCemiBenchmark);
@@ -0,0 +1,98 @@
+//==== bench/bench_dedup.cpp ====
+
+// Receive dedup: every bus event arrives three times (two IP routers and a TP
+// repeat with the repeat flag cleared and one hop less) and our own writes
+// come back through multicast loopback. Compares callback counts and receive
+// cost with and without the dedup stage, and checks that a value sent again
+// after the window passes.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t EVENTS = 20000;
+const uint16_t OWN_GROUP = (1 << 11) | (7 << 8) | 1;
+
+struct Result {
+    uint32_t calls;
+    BenchLatency latency{EVENTS * 3};
+};
+
+void injectEvents(Result& result) {
+    uint8_t frame[64];
+    for (size_t i = 0; i < EVENTS; i++) {
+        const uint8_t payload[] = {(uint8_t)(i >> 8), (uint8_t)i};
+        uint16_t group = (uint16_t)((1 << 11) | (i % 512));
+        size_t length = benchRoutingFrame(frame, 0x1105, group, payload, sizeof(payload));
+        for (int copy = 0; copy < 3; copy++) {
+            if (copy == 2) {
+                frame[8] &= ~0x20; // Repeated frame
+                frame[9] = 0xD0;   // One hop less
+            }
+            uint64_t t0 = benchNowNs();
+            benchInject(frame, length);
+            result.latency.add(benchNowNs() - t0);
+        }
+        if (i % 16 == 0) nativeAdvanceClock(1);
+    }
+}
+
+void run(bool dedupEnabled, Result& result) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    result.calls = 0;
+    module.onMainGroup(1, [&result](const KNXTelegram&) { result.calls++; });
+    if (dedupEnabled) {
+        KNXDedupConfig config;
+        config.capacity = 256;
+        module.enableDedup(config);
+    }
+    module.beginMulticast(1, 1, 10);
+
+    injectEvents(result);
+
+    // Our own writes come back through multicast loopback
+    for (int i = 0; i < 100; i++) {
+        module.sendBool(OWN_GROUP, i & 1);
+        AsyncUDPLoopback::poll();
+    }
+
+    if (!dedupEnabled) return;
+    KNXDedupStats stats = module.getDedupStats();
+    benchNote("  dedup", "%u checked, %u own, %u duplicates, %u evictions, %u slots",
+        stats.checked, stats.ownFrames, stats.duplicates, stats.evictions, stats.capacity);
+    if (stats.ownFrames != 100 || stats.duplicates != 2 * EVENTS) {
+        benchFail("dedup dropped %u own frames and %u duplicates", stats.ownFrames, stats.duplicates);
+    }
+
+    // The same value again after the window is a new event
+    uint8_t frame[64];
+    const uint8_t payload[] = {0x00, 0x01};
+    size_t length = benchRoutingFrame(frame, 0x1105, 1 << 11 | 1, payload, sizeof(payload));
+    uint32_t before = result.calls;
+    benchInject(frame, length);
+    benchInject(frame, length);
+    nativeAdvanceClock(201);
+    benchInject(frame, length);
+    if (result.calls - before != 2) benchFail("repeat after the window: %u callbacks", result.calls - before);
+}
+
+void runDedupBenchmark() {
+    Result plain;
+    run(false, plain);
+    plain.latency.report("rx x3, no dedup");
+    benchNote("  callbacks", "%u for %zu events and 100 own writes", plain.calls, EVENTS);
+
+    Result deduplicated;
+    run(true, deduplicated);
+    deduplicated.latency.report("rx x3, dedup");
+    benchNote("  callbacks", "%u for %zu events and 100 own writes", deduplicated.calls, EVENTS);
+    if (deduplicated.calls != EVENTS + 2) {
+        benchFail("dedup: %u callbacks for %zu events", deduplicated.calls, EVENTS);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("dedup", runDedupBenchmark);
@@ -0,0 +1,171 @@
+//==== bench/bench_discovery.cpp ====
+
+// Gateway discovery and failover against three gateway simulators with
+// different latencies and tunnel slots: the search finds all three, probing
+// ranks them, the module connects to the fastest one with a free slot, and
+// when that gateway goes silent it moves on - past a gateway that refuses
+// the connection - and keeps sending. A gateway that replies later than the
+// probe interval must be timed from the probe it answers and rank behind a
+// faster one. Time is simulated, one millisecond per pump step.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const uint16_t GROUP = (1 << 11) | (4 << 8) | 1;
+
+struct Site {
+    KNXGatewaySim slow{IPAddress(192, 168, 178, 10)};
+    KNXGatewaySim full{IPAddress(192, 168, 178, 11)};
+    KNXGatewaySim legacy{IPAddress(192, 168, 178, 12)};
+
+    Site() {
+        slow.setName("Slow");
+        slow.setResponseDelay(30);
+        slow.setTunnelSlots(4, 2);
+        full.setName("Full");
+        full.setResponseDelay(5);
+        full.setTunnelSlots(2, 0);
+        legacy.setName("Legacy"); // KNXnet/IP 1: no tunnelling info
+        legacy.setResponseDelay(12);
+    }
+
+    void poll() {
+        slow.poll(millis());
+        full.poll(millis());
+        legacy.poll(millis());
+    }
+};
+
+template <typename Gateways>
+void pump(KNXIPModule& module, Gateways& site, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        site.poll();
+        AsyncUDPLoopback::poll();
+        module.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+// Pumps until the module is connected to the given gateway; returns the
+// simulated milliseconds it took, or 0 on timeout.
+template <typename Gateways>
+uint32_t waitForGateway(KNXIPModule& module, Gateways& site, const KNXGatewaySim& gateway, uint32_t limitMs) {
+    for (uint32_t ms = 1; ms <= limitMs; ms++) {
+        pump(module, site, 1);
+        if (module.isConnected() && module.getGatewayIP() == gateway.address()) return ms;
+    }
+    return 0;
+}
+
+// Both reply later than the 100 ms probe interval
+struct DistantSite {
+    KNXGatewaySim distant{IPAddress(192, 168, 178, 20)};
+    KNXGatewaySim near{IPAddress(192, 168, 178, 21)};
+
+    DistantSite() {
+        distant.setName("Distant");
+        distant.setResponseDelay(250);
+        distant.setTunnelSlots(4, 4);
+        near.setName("Near");
+        near.setResponseDelay(90);
+        near.setTunnelSlots(4, 4);
+    }
+
+    void poll() {
+        distant.poll(millis());
+        near.poll(millis());
+    }
+};
+
+void checkLateReplies() {
+    DistantSite site;
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginDiscovery(1, 1, 10);
+
+    uint32_t elapsed = waitForGateway(module, site, site.near, 10000);
+    KNXGatewayInfo gateways[KNX_DISCOVERY_GATEWAYS];
+    size_t found = module.getGateways(gateways, KNX_DISCOVERY_GATEWAYS);
+    uint32_t distantRtt = 0, nearRtt = 0;
+    for (size_t i = 0; i < found; i++) {
+        if (gateways[i].ip == site.distant.address()) distantRtt = gateways[i].rttMicros;
+        if (gateways[i].ip == site.near.address()) nearRtt = gateways[i].rttMicros;
+    }
+    benchNote("late replies", "connected to %s after %u ms; rtt %u us (250 ms gateway), %u us (90 ms)",
+        module.getGatewayIP().toString().c_str(), elapsed, distantRtt, nearRtt);
+    if (elapsed == 0 || distantRtt < 250000 || distantRtt > 260000 || nearRtt < 90000 || nearRtt > 100000) {
+        benchFail("late replies timed from the wrong probe or the slower gateway chosen");
+    }
+}
+
+void checkFailover() {
+    Site site;
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXTunnelConfig tunnel;
+    tunnel.heartbeatIntervalMs = 5000;
+    tunnel.heartbeatTimeoutMs = 1000;
+    tunnel.heartbeatRetries = 2;
+    module.setTunnelConfig(tunnel);
+    module.beginDiscovery(1, 1, 10);
+
+    uint32_t elapsed = waitForGateway(module, site, site.legacy, 10000);
+    KNXGatewayInfo gateways[KNX_DISCOVERY_GATEWAYS];
+    size_t found = module.getGateways(gateways, KNX_DISCOVERY_GATEWAYS);
+    benchNote("discovery", "%zu gateways, connected to %s after %u ms",
+        found, module.getGatewayIP().toString().c_str(), elapsed);
+    for (size_t i = 0; i < found; i++) {
+        benchNote("  gateway", "%-15s %-8s rtt %5u us, %u replies, %d free slots",
+            gateways[i].ip.toString().c_str(), gateways[i].name, (unsigned)gateways[i].rttMicros,
+            gateways[i].probeReplies, gateways[i].freeSlots);
+    }
+    if (found != 3 || elapsed == 0) {
+        benchFail("discovery found %zu gateways, connected to %s", found,
+            module.getGatewayIP().toString().c_str());
+        return;
+    }
+    for (size_t i = 0; i < found; i++) {
+        if (gateways[i].probeReplies != 3 || !gateways[i].tunnelling) benchFail("gateway %zu not probed", i);
+    }
+
+    // The legacy gateway goes silent while a telegram waits for its ACK
+    site.legacy.setSilent(true);
+    module.sendBool(GROUP, true);
+    pump(module, site, 1);
+    for (int i = 0; i < 3; i++) module.sendBool(GROUP, i & 1);
+    elapsed = waitForGateway(module, site, site.slow, 10000);
+    pump(module, site, 50);
+    benchNote("failover, ACK timeout", "connected to %s after %u ms, %zu telegrams delivered there",
+        module.getGatewayIP().toString().c_str(), elapsed, site.slow.frames.size());
+    if (elapsed == 0 || site.slow.frames.size() != 3) {
+        benchFail("failover to the slow gateway: %u ms, %zu frames", elapsed, site.slow.frames.size());
+    }
+
+    // The slow one fails without traffic; the full one refuses, the legacy
+    // one is back and failed longest ago
+    site.legacy.setSilent(false);
+    site.slow.setSilent(true);
+    elapsed = waitForGateway(module, site, site.legacy, 20000);
+    KNXTunnelStats stats = module.getTunnelStats();
+    benchNote("failover, heartbeat", "connected to %s after %u ms, %u connects, %u refused",
+        module.getGatewayIP().toString().c_str(), elapsed, stats.connects, site.full.refused);
+    if (elapsed == 0 || site.full.refused != 1 || site.legacy.connects != 2) {
+        benchFail("second failover: %u ms, full gateway asked %u times", elapsed, site.full.refused);
+    }
+    module.sendBool(GROUP, true);
+    pump(module, site, 10);
+    if (site.legacy.frames.size() != 1) benchFail("no traffic after the second failover");
+}
+
+void runDiscoveryBenchmark() {
+    checkFailover();
+    checkLateReplies();
+}
+
+} // namespace
+
+BENCH_SUITE("discovery", runDiscoveryBenchmark);
@@ -0,0 +1,219 @@
+//==== bench/bench_dpt.cpp ====
+
+// DPT codecs: checks DPT 9 bit-exact against a double-precision reference
+// over all 65536 codes and over every hundredth in +-7000.00, round-trips the
+// other types, times encode/decode and verifies that typed sends and typed
+// callbacks do not allocate.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "native_heap.h"
+#include <cmath>
+
+namespace {
+
+// Reference: value in hundredths, computed in double
+int64_t referenceDecode(uint16_t raw) {
+    int mantissa = raw & 0x07FF;
+    if (raw & 0x8000) mantissa -= 2048;
+    return (int64_t)std::ldexp((double)mantissa, (raw >> 11) & 0x0F);
+}
+
+// Reference: smallest exponent whose rounded mantissa fits; 0x7FFF means
+// invalid data, so larger values stop at 0x7FFE
+uint16_t referenceEncode(int64_t hundredths) {
+    for (int exponent = 0; exponent < 16; exponent++) {
+        long long mantissa = std::llround(std::ldexp((double)hundredths, -exponent));
+        if (mantissa >= -2048 && mantissa <= 2047) {
+            uint16_t raw = (uint16_t)((mantissa < 0 ? 0x8000 : 0) | (exponent << 11) | (mantissa & 0x07FF));
+            return raw == 0x7FFF ? 0x7FFE : raw;
+        }
+    }
+    return hundredths < 0 ? 0xF800 : 0x7FFE;
+}
+
+// The encoder this library shipped before the codec layer, kept for comparison
+uint16_t legacyEncode(float value) {
+    int16_t mantissa = (int16_t)(value * 100.0f);
+    uint8_t exponent = 0;
+    while (mantissa > 2047 || mantissa < -2048) {
+        mantissa /= 2;
+        exponent++;
+    }
+    uint16_t raw = (exponent << 11) | (mantissa & 0x07FF);
+    if (value < 0) raw |= 0x8000;
+    return raw;
+}
+
+void checkDpt9() {
+    using Dpt9 = KNXDpt<9, 1>;
+    size_t decodeErrors = 0;
+    size_t encodeErrors = 0;
+    size_t floatErrors = 0;
+    size_t legacyErrors = 0;
+
+    for (uint32_t raw = 0; raw < 65536; raw++) {
+        int64_t expected = referenceDecode((uint16_t)raw);
+        int32_t hundredths = Dpt9::fromRaw((uint16_t)raw);
+        if (hundredths != expected) decodeErrors++;
+
+        // Re-encoding a decoded value yields the canonical code for it
+        uint16_t canonical = referenceEncode(expected);
+        if (Dpt9::toRaw(hundredths) != canonical) encodeErrors++;
+
+        uint8_t data[Dpt9::LENGTH];
+        float value = hundredths / 100.0f;
+        Dpt9::encode(value, data);
+        if (((data[1] << 8) | data[2]) != canonical) floatErrors++;
+        if (referenceDecode(legacyEncode(value)) != expected) legacyErrors++;
+    }
+
+    // Every representable input step in the common range, including the halfway cases
+    for (int32_t hundredths = -700000; hundredths <= 700000; hundredths++) {
+        if (Dpt9::toRaw(hundredths) != referenceEncode(hundredths)) encodeErrors++;
+    }
+
+    benchNote("dpt 9 sweep", "65536 codes + 1400001 inputs: %zu decode, %zu encode, %zu float mismatches",
+        decodeErrors, encodeErrors, floatErrors);
+    benchNote("  legacy encoder", "%zu of 65536 decoded values re-encoded to a different value",
+        legacyErrors);
+    if (decodeErrors || encodeErrors || floatErrors) benchFail("DPT 9 codec differs from the reference");
+
+    // NaN is sent as invalid data, which no decode accepts
+    uint8_t data[Dpt9::LENGTH];
+    float value = 0;
+    Dpt9::encode(NAN, data);
+    bool nanInvalid = ((data[1] << 8) | data[2]) == Dpt9::INVALID && !Dpt9::decode(data, sizeof(data), value);
+    Dpt9::encode(1e9f, data);
+    bool clamped = ((data[1] << 8) | data[2]) == 0x7FFE && Dpt9::decode(data, sizeof(data), value) &&
+        value == Dpt9::MAX_HUNDREDTHS / 100.0f;
+    if (!nanInvalid || !clamped) {
+        benchFail("DPT 9 invalid data: NaN %s, overflow %s", nanInvalid ? "ok" : "wrong", clamped ? "ok" : "wrong");
+    }
+}
+
+template <typename Dpt>
+bool roundTrip(const typename Dpt::Value& value, typename Dpt::Value& decoded) {
+    uint8_t data[Dpt::LENGTH];
+    size_t length = Dpt::encode(value, data);
+    data[0] &= 0x3F; // As KNXTelegram::data holds it
+    return length == Dpt::LENGTH && Dpt::decode(data, length, decoded);
+}
+
+template <typename Dpt>
+void expectRoundTrip(const char* name, const typename Dpt::Value& value) {
+    typename Dpt::Value decoded = typename Dpt::Value();
+    if (!roundTrip<Dpt>(value, decoded) || memcmp(&decoded, &value, sizeof(value)) != 0) {
+        benchFail("DPT %s does not round-trip", name);
+    }
+}
+
+void checkRoundTrips() {
+    expectRoundTrip<KNXDpt<1, 1>>("1.001", true);
+    expectRoundTrip<KNXDpt<2, 1>>("2.001", KNXDpt2Value{true, false});
+    expectRoundTrip<KNXDpt<3, 7>>("3.007", KNXDpt3Value{true, 5});
+    expectRoundTrip<KNXDpt<5, 1>>("5.001", (uint16_t)42);
+    expectRoundTrip<KNXDpt<5, 3>>("5.003", (uint16_t)270);
+    expectRoundTrip<KNXDpt<5, 10>>("5.010", (uint8_t)200);
+    expectRoundTrip<KNXDpt<6, 10>>("6.010", (int8_t)-100);
+    expectRoundTrip<KNXDpt<7, 1>>("7.001", (uint16_t)54321);
+    expectRoundTrip<KNXDpt<8, 1>>("8.001", (int16_t)-12345);
+    expectRoundTrip<KNXDpt<9, 1>>("9.001", -12.5f);
+    expectRoundTrip<KNXDpt<10, 1>>("10.001", KNXTimeOfDay{3, 23, 59, 58});
+    expectRoundTrip<KNXDpt<11, 1>>("11.001", KNXDate{2031, 12, 24});
+    expectRoundTrip<KNXDpt<11, 1>>("11.001", KNXDate{1995, 1, 1});
+    expectRoundTrip<KNXDpt<12, 1>>("12.001", (uint32_t)4000000000UL);
+    expectRoundTrip<KNXDpt<13, 1>>("13.001", (int32_t)-2000000000L);
+    expectRoundTrip<KNXDpt<14, 56>>("14.056", 1234.5678f);
+    expectRoundTrip<KNXDpt<16, 0>>("16.000", KNXDptString("KNX is great!!"));
+    expectRoundTrip<KNXDpt<17, 1>>("17.001", (uint8_t)63);
+    expectRoundTrip<KNXDpt<18, 1>>("18.001", KNXSceneControl{true, 17});
+    expectRoundTrip<KNXDpt<20, 102>>("20.102", (uint8_t)3);
+
+    // 5.001 hits every step exactly at the ends and rounds in between
+    uint16_t percent;
+    uint8_t data[2];
+    KNXDpt<5, 1>::encode(100, data);
+    if (data[1] != 255) benchFail("DPT 5.001: 100%% encodes as %u", data[1]);
+    KNXDpt<5, 1>::encode(50, data);
+    if (data[1] != 128) benchFail("DPT 5.001: 50%% encodes as %u", data[1]);
+    data[1] = 128;
+    KNXDpt<5, 1>::decode(data, 2, percent);
+    if (percent != 50) benchFail("DPT 5.001: 128 decodes as %u%%", percent);
+}
+
+void timeCodecs() {
+    const size_t N = 1000000;
+    using Dpt9 = KNXDpt<9, 1>;
+    BenchLatency encode(N / 100);
+    BenchLatency decode(N / 100);
+    volatile uint32_t sink = 0;
+    uint8_t data[Dpt9::LENGTH];
+
+    // 100 operations per sample; single calls are below the clock resolution
+    for (size_t i = 0; i < N; i += 100) {
+        uint64_t t0 = benchNowNs();
+        for (size_t j = 0; j < 100; j++) {
+            Dpt9::encode((float)(i + j) * 0.37f - 10000.0f, data);
+            sink = sink + data[2];
+        }
+        encode.add((benchNowNs() - t0) / 100);
+        t0 = benchNowNs();
+        for (size_t j = 0; j < 100; j++) {
+            float value;
+            data[2] = (uint8_t)j;
+            Dpt9::decode(data, sizeof(data), value);
+            sink = sink + (uint32_t)value;
+        }
+        decode.add((benchNowNs() - t0) / 100);
+    }
+    encode.report("dpt 9 encode");
+    decode.report("dpt 9 decode");
+}
+
+void checkTypedPaths() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    AsyncUDPLoopback::setMulticastLoop(false);
+
+    const uint16_t GROUP = (3 << 11) | (1 << 8) | 7;
+    float received = 0;
+    uint32_t calls = 0;
+    module.onGroupValue<KNXDpt<9, 1>>(GROUP, [&](const float& value, const KNXTelegram&) {
+        received = value;
+        calls++;
+    });
+
+    const size_t SENDS = 10000;
+    uint8_t frame[64];
+    BenchLatency send(SENDS);
+    uint64_t allocationsBefore = nativeHeapAllocations();
+    for (size_t i = 0; i < SENDS; i++) {
+        uint64_t t0 = benchNowNs();
+        module.send<KNXDpt<9, 1>>(GROUP, 21.5f);
+        send.add(benchNowNs() - t0);
+        AsyncUDPLoopback::discardPending();
+
+        const uint8_t payload[] = {0x0C, 0x65}; // 22.5
+        size_t length = benchRoutingFrame(frame, 0x1105, GROUP, payload, sizeof(payload));
+        benchInject(frame, length);
+    }
+    uint64_t allocations = nativeHeapAllocations() - allocationsBefore;
+    AsyncUDPLoopback::setMulticastLoop(true);
+
+    send.report("send<KNXDpt<9, 1>>");
+    if (allocations != 0) benchFail("typed send/receive allocated %llu times", (unsigned long long)allocations);
+    if (calls != SENDS || received != 22.5f) benchFail("typed callback: %u calls, value %.2f", calls, received);
+}
+
+void runDptBenchmark() {
+    checkDpt9();
+    checkRoundTrips();
+    timeCodecs();
+    checkTypedPaths();
+}
+
+} // namespace
+
+BENCH_SUITE("dpt", runDptBenchmark);
@@ -0,0 +1,143 @@
+//==== bench/bench_group_cache.cpp ====
+
+// Group value cache: fills the table from bus traffic, times getCachedValue()
+// for hits and misses, and answers GroupValue_Reads of owned addresses from
+// the cache. Checks cached values, the capacity bound, that unsubscribed
+// traffic is filtered before the cache, that an owned address still finds a
+// slot in a full table and that only owned addresses are answered.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t CAPACITY = 1000;
+const size_t LOOKUPS = 200000;
+const size_t READS = 20000;
+
+// Addresses cluster the way real projects do: a few main groups, dense middle groups
+uint16_t addressAt(size_t index) {
+    return (uint16_t)(((1 + index / 2048) << 11) | (index % 2048));
+}
+
+uint8_t valueAt(size_t index, size_t round) {
+    return (uint8_t)(index * 13 + round);
+}
+
+void runGroupCacheBenchmark() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXGroupCacheConfig config;
+    config.capacity = CAPACITY;
+    module.enableGroupCache(config);
+    module.onMainGroup(1, [](const KNXTelegram&) {});
+    module.beginMulticast(1, 1, 10);
+
+    // Traffic of unsubscribed addresses neither reaches nor fills the cache
+    uint8_t frame[64];
+    const size_t FOREIGN_WRITES = 200;
+    for (size_t i = 0; i < FOREIGN_WRITES; i++) {
+        const uint8_t payload[] = {1};
+        size_t length = benchRoutingFrame(frame, 0x1107, (uint16_t)((2 << 11) | i), payload, sizeof(payload));
+        benchInject(frame, length);
+    }
+    KNXStats moduleStats = module.getStats();
+    KNXGroupCacheStats stats = module.getGroupCacheStats();
+    if (moduleStats.telegramsFiltered != FOREIGN_WRITES || stats.entries != 0 || stats.rejected != 0) {
+        benchFail("foreign traffic: %u filtered, %u cached, %u rejected", moduleStats.telegramsFiltered,
+            stats.entries, stats.rejected);
+    }
+
+    // Three rounds of writes to more addresses than fit
+    const size_t ADDRESSES = CAPACITY + 100;
+    BenchLatency fill(ADDRESSES * 3);
+    for (size_t round = 0; round < 3; round++) {
+        for (size_t i = 0; i < ADDRESSES; i++) {
+            const uint8_t payload[] = {valueAt(i, round)};
+            size_t length = benchRoutingFrame(frame, 0x1105, addressAt(i), payload, sizeof(payload));
+            uint64_t t0 = benchNowNs();
+            benchInject(frame, length);
+            fill.add(benchNowNs() - t0);
+        }
+    }
+    fill.report("cache fill (rx write + update)");
+
+    stats = module.getGroupCacheStats();
+    if (stats.entries != CAPACITY || stats.rejected != 300) {
+        benchFail("cache holds %u entries, rejected %u updates", stats.entries, stats.rejected);
+    }
+
+    BenchLatency hits(LOOKUPS);
+    BenchLatency misses(LOOKUPS);
+    size_t wrong = 0;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        size_t index = (i * 7919) % CAPACITY;
+        KNXCachedValue value;
+        uint64_t t0 = benchNowNs();
+        bool found = module.getCachedValue(addressAt(index), value);
+        hits.add(benchNowNs() - t0);
+        if (!found || value.length != 2 || value.data[1] != valueAt(index, 2) ||
+            value.sourceAddress != 0x1105 || value.count != 3) {
+            wrong++;
+        }
+
+        uint16_t unknown = (uint16_t)(0x8000 | (i & 0x7FFF));
+        t0 = benchNowNs();
+        found = module.getCachedValue(unknown, value);
+        misses.add(benchNowNs() - t0);
+        if (found) wrong++;
+    }
+    hits.report("getCachedValue hit");
+    misses.report("getCachedValue miss");
+    if (wrong > 0) benchFail("%zu lookups returned a wrong value", wrong);
+
+    // Reads of an owned address are answered with the value this device sent;
+    // it is not subscribed and the table is full of bus values
+    const uint16_t OWNED = (4 << 11) | 1;
+    const uint16_t FOREIGN = addressAt(6);
+    if (!module.setOwnedAddress(OWNED)) benchFail("owned address crowded out by bus traffic");
+    module.sendTemperature(OWNED, 21.5f);
+    KNXCachedValue ownValue;
+    if (!module.getCachedValue(OWNED, ownValue)) benchFail("value sent to an owned address not cached");
+    std::vector<uint8_t> sent;
+    AsyncUDPLoopback::setTap([&sent](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        sent.assign(data, data + length);
+    });
+    AsyncUDPLoopback::discardPending();
+
+    size_t answered = 0;
+    size_t bad = 0;
+    std::vector<uint8_t> expected(KNXDpt<9, 1>::LENGTH);
+    KNXDpt<9, 1>::encode(21.5f, expected.data());
+    BenchLatency reads(READS);
+    for (size_t i = 0; i < READS; i++) {
+        size_t length = benchRoutingFrame(frame, 0x1106, (i & 1) ? FOREIGN : OWNED, nullptr, 0);
+        frame[16] = 0x00; // GroupValue_Read
+        sent.clear();
+        uint64_t t0 = benchNowNs();
+        benchInject(frame, length);
+        reads.add(benchNowNs() - t0);
+        AsyncUDPLoopback::discardPending();
+
+        if (sent.empty()) continue;
+        answered++;
+        uint16_t dst = (sent[12] << 8) | sent[13];
+        if (dst != OWNED || sent.size() != 19 || sent[16] != 0x40 ||
+            sent[17] != expected[1] || sent[18] != expected[2]) {
+            bad++;
+        }
+    }
+    AsyncUDPLoopback::setTap(nullptr);
+    reads.report("GroupValue_Read answered locally");
+
+    stats = module.getGroupCacheStats();
+    benchNote("  cache", "%u/%u entries (%u owned), %u updates, %u rejected, %u reads answered",
+        stats.entries, stats.capacity, stats.owned, stats.updates, stats.rejected, stats.readsAnswered);
+    if (answered != READS / 2 || bad > 0) {
+        benchFail("%zu of %zu owned reads answered, %zu malformed", answered, READS / 2, bad);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("cache", runGroupCacheBenchmark);
@@ -0,0 +1,121 @@
+//==== bench/bench_group_read.cpp ====
+
+// Boot-time state sync: 300 GroupValue_Reads through the tunnel against the
+// gateway simulator, which answers each read after a device latency with
+// responses spaced by the bus time of one telegram. Compares one read in
+// flight (the serialized pattern) with a window of several, and checks that
+// unanswered reads are repeated and then time out. Time is simulated, one
+// millisecond per pump step.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t READS = 300;
+const uint16_t FIRST_GROUP = (3 << 11) | (0 << 8) | 1;
+const uint32_t DEVICE_LATENCY_MS = 40; // Read on the bus, device answers
+const uint32_t BUS_SPACING_MS = 20;    // One standard telegram on TP1
+
+void pump(KNXIPModule& module, KNXGatewaySim& gateway, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        gateway.poll(millis());
+        AsyncUDPLoopback::poll();
+        module.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+// Every address answers with a DPT 5 value derived from it, except those the
+// caller marks as missing
+size_t respond(uint16_t groupAddress, uint8_t* apdu, uint16_t missingFrom) {
+    if (groupAddress >= missingFrom) return 0;
+    apdu[0] = 0x40; // GroupValue_Response, no data in the APCI octet
+    apdu[1] = (uint8_t)(groupAddress * 3);
+    return 2;
+}
+
+struct SyncResult {
+    uint32_t elapsedMs;
+    uint32_t done;
+    uint32_t timeouts;
+    uint32_t wrong;
+};
+
+SyncResult syncState(uint8_t window, uint16_t missing, KNXGroupReadStats& stats, BenchLatency& latency) {
+    KNXGatewaySim gateway;
+    uint16_t missingFrom = (uint16_t)(FIRST_GROUP + READS - missing);
+    gateway.setReadResponder([missingFrom](uint16_t groupAddress, uint8_t* apdu) {
+        return respond(groupAddress, apdu, missingFrom);
+    }, DEVICE_LATENCY_MS, BUS_SPACING_MS);
+
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXGroupReadConfig config;
+    config.capacity = READS;
+    config.window = window;
+    config.timeoutMs = 1000;
+    config.retries = 1;
+    module.enableGroupReads(config);
+    module.begin(gateway.address(), 1, 1, 10);
+    for (int i = 0; i < 100 && !module.isConnected(); i++) pump(module, gateway, 1);
+
+    SyncResult result = {};
+    auto onRead = [&result](const KNXReadResult& read) {
+        if (read.status == KNX_READ_TIMEOUT) {
+            result.timeouts++;
+        } else if (read.status == KNX_READ_DONE) {
+            result.done++;
+            if (read.length != 2 || read.data[1] != (uint8_t)(read.groupAddress * 3)) result.wrong++;
+        }
+    };
+
+    uint32_t start = (uint32_t)millis();
+    for (size_t i = 0; i < READS; i++) {
+        uint64_t t0 = benchNowNs();
+        KNXReadHandle handle = module.readGroupValue(FIRST_GROUP + i, onRead);
+        latency.add(benchNowNs() - t0);
+        if (handle == 0) benchFail("read %zu rejected", i);
+    }
+    while (result.done + result.timeouts < READS && millis() - start < 600000) {
+        pump(module, gateway, 1);
+    }
+    result.elapsedMs = (uint32_t)millis() - start;
+    stats = module.getGroupReadStats();
+    return result;
+}
+
+void runGroupReadBenchmark() {
+    const uint8_t windows[] = {1, 8, 16};
+    for (uint8_t window : windows) {
+        char name[48];
+        snprintf(name, sizeof(name), "readGroupValue (window %u)", window);
+        BenchLatency latency(READS);
+        KNXGroupReadStats stats;
+        SyncResult result = syncState(window, 0, stats, latency);
+        latency.report(name);
+        benchNote("  state sync", "%zu reads in %u ms, %u answered, %u timeouts, %u sent",
+            READS, result.elapsedMs, result.done, result.timeouts, stats.sent);
+        if (result.done != READS || result.wrong != 0 || stats.sent != READS) {
+            benchFail("window %u: %u of %zu reads answered, %u wrong values", window, result.done,
+                READS, result.wrong);
+        }
+    }
+
+    // Ten devices are missing: each of their reads goes out twice, then times out
+    BenchLatency latency(READS);
+    KNXGroupReadStats stats;
+    SyncResult result = syncState(8, 10, stats, latency);
+    benchNote("state sync, 10 unanswered", "%u answered, %u timeouts, %u retries in %u ms",
+        result.done, result.timeouts, stats.retries, result.elapsedMs);
+    if (result.done != READS - 10 || result.timeouts != 10 || stats.retries != 10) {
+        benchFail("unanswered reads: %u answered, %u timeouts, %u retries", result.done,
+            result.timeouts, stats.retries);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("groupread", runGroupReadBenchmark);
@@ -0,0 +1,101 @@
+//==== bench/bench_main.cpp ====
+
+// Entry point of the env:native benchmark program.
+//
+//   pio run -e native && .pio/build/native/program [suite...]
+//
+// Without arguments every registered suite runs; otherwise only the suites
+// whose names are given.
+
+#include "bench.h"
+#include <algorithm>
+
+static BenchSuite* suites = nullptr;
+static bool failed = false;
+
+BenchSuite::BenchSuite(const char* name, void (*run)()) : name(name), run(run), next(nullptr) {
+    // Keep registration order stable regardless of static initialisation order
+    // within a translation unit.
+    BenchSuite** tail = &suites;
+    while (*tail) tail = &(*tail)->next;
+    *tail = this;
+}
+
+double BenchLatency::report(const char* name) {
+    if (samples.empty()) {
+        printf("%-44s  (no samples)\n", name);
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    uint64_t total = wallNs;
+    if (total == 0) {
+        for (uint64_t ns : samples) total += ns;
+    }
+    double perSecond = total ? (double)samples.size() * 1e9 / (double)total : 0.0;
+    uint64_t p50 = samples[samples.size() / 2];
+    uint64_t p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    printf("%-44s %12.0f frames/s  p50 %7llu ns  p99 %7llu ns  max %8llu ns\n",
+        name, perSecond, (unsigned long long)p50, (unsigned long long)p99,
+        (unsigned long long)samples.back());
+    return perSecond;
+}
+
+void benchNote(const char* name, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    printf("%-44s %s\n", name, buffer);
+}
+
+void benchFail(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    printf("FAIL: %s\n", buffer);
+    failed = true;
+}
+
+size_t benchRoutingFrame(uint8_t* buffer, uint16_t src, uint16_t dst,
+                         const uint8_t* payload, size_t payloadLength) {
+    size_t length = 0;
+    buffer[length++] = 0x06; // Header length
+    buffer[length++] = 0x10; // Protocol version
+    buffer[length++] = 0x05; // ROUTING_INDICATION (0x0530)
+    buffer[length++] = 0x30;
+    buffer[length++] = 0x00; // Total length, filled below
+    buffer[length++] = 0x00;
+    buffer[length++] = 0x29; // L_Data.ind
+    buffer[length++] = 0x00; // No additional info
+    buffer[length++] = 0xBC; // Standard frame, no repeat, low priority
+    buffer[length++] = 0xE0; // Group address, hop count 6
+    buffer[length++] = src >> 8;
+    buffer[length++] = src & 0xFF;
+    buffer[length++] = dst >> 8;
+    buffer[length++] = dst & 0xFF;
+    buffer[length++] = payloadLength + 1; // TPCI/APCI byte plus payload
+    buffer[length++] = 0x00;              // TPCI, APCI high bits
+    buffer[length++] = 0x80;              // GroupValue_Write
+    memcpy(buffer + length, payload, payloadLength);
+    length += payloadLength;
+    buffer[4] = length >> 8;
+    buffer[5] = length & 0xFF;
+    return length;
+}
+
+int main(int argc, char** argv) {
+    Serial.setOutputEnabled(false);
+    for (BenchSuite* suite = suites; suite; suite = suite->next) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc && !selected; i++) {
+            selected = strcmp(argv[i], suite->name) == 0;
+        }
+        if (!selected) continue;
+        printf("== %s\n", suite->name);
+        suite->run();
+    }
+    return failed ? 1 : 0;
+}
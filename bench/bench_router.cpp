@@ -0,0 +1,205 @@
+//==== bench/bench_router.cpp ====
+
+// KNXIPRouter between routing multicast on Ethernet and WiFi, and between
+// Ethernet multicast and a tunnel to the gateway simulator. Measures the
+// forward path (receive, filter, hop count, send) and checks the filter
+// tables, routing counter handling, echo suppression, ROUTING_BUSY on the
+// outgoing side and both directions through the tunnel.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_router.h"
+
+namespace {
+
+const size_t FRAMES = 20000;
+const IPAddress BUS_ROUTER(192, 168, 1, 50);
+
+// Counts routing indications on one interface that the router sent
+class Listener {
+public:
+    explicit Listener(tcpip_adapter_if_t iface) {
+        udp.listenMulticast(KNX_MULTICAST_IP, KNX_PORT, 1, iface);
+        udp.onPacket([this](AsyncUDPPacket& packet) {
+            if (packet.remoteIP() == BUS_ROUTER) return;
+            frames++;
+            lastLength = packet.length();
+            memcpy(last, packet.data(), packet.length() < sizeof(last) ? packet.length() : sizeof(last));
+        });
+    }
+
+    uint32_t frames = 0;
+    size_t lastLength = 0;
+    uint8_t last[64];
+
+private:
+    AsyncUDP udp;
+};
+
+size_t injectOn(tcpip_adapter_if_t iface, const uint8_t* frame, size_t length) {
+    return AsyncUDPLoopback::deliver(frame, length, BUS_ROUTER, KNX_PORT, KNX_MULTICAST_IP, KNX_PORT, iface);
+}
+
+KNXRouterSideConfig multicastSide(tcpip_adapter_if_t iface) {
+    KNXRouterSideConfig config;
+    config.type = KNX_ROUTER_MULTICAST;
+    config.interface = iface;
+    return config;
+}
+
+void checkMulticastBridge() {
+    KNXIPRouter router;
+    router.setDebugLevel(0);
+    router.setFilter(KNX_ROUTER_A_TO_B, KNXGroupFilter().passMainGroup(1).blockMiddleGroup(1, 7));
+    router.setFilter(KNX_ROUTER_B_TO_A, KNXGroupFilter().passAll());
+    if (!router.begin(multicastSide(TCPIP_ADAPTER_IF_ETH), multicastSide(TCPIP_ADAPTER_IF_STA))) {
+        benchFail("router did not start");
+        return;
+    }
+    Listener ethernet(TCPIP_ADAPTER_IF_ETH);
+    Listener wifi(TCPIP_ADAPTER_IF_STA);
+
+    // Main groups 1 and 2 alternate; 1/7/x is blocked
+    uint8_t frame[64];
+    uint32_t expected = 0;
+    BenchLatency latency(FRAMES);
+    uint64_t start = benchNowNs();
+    for (size_t i = 0; i < FRAMES; i++) {
+        const uint8_t payload[] = {(uint8_t)i};
+        uint16_t group = (uint16_t)(((1 + (i & 1)) << 11) | ((i >> 1) & 0x7FF));
+        if ((group >> 11) == 1 && ((group >> 8) & 7) != 7) expected++;
+        size_t length = benchRoutingFrame(frame, 0x1105, group, payload, sizeof(payload));
+        uint64_t t0 = benchNowNs();
+        injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+        latency.add(benchNowNs() - t0);
+        if (AsyncUDPLoopback::pending() > 200) AsyncUDPLoopback::poll();
+    }
+    latency.setWallTime(benchNowNs() - start);
+    AsyncUDPLoopback::poll();
+    latency.report("router eth -> wifi");
+
+    KNXRouterStats stats = router.getStats();
+    const KNXRouterPathStats& path = stats.paths[KNX_ROUTER_A_TO_B];
+    benchNote("  path A->B", "%u received, %u forwarded, %u filtered, %u own echoes",
+        path.received, path.forwarded, path.filtered, stats.ownEchoes);
+    if (path.forwarded != expected || wifi.frames != expected || ethernet.frames != 0 ||
+        stats.ownEchoes != expected || stats.paths[KNX_ROUTER_B_TO_A].received != 0) {
+        benchFail("router forwarded %u (wifi saw %u, ethernet %u) of %u, %u echoes",
+            path.forwarded, wifi.frames, ethernet.frames, expected, stats.ownEchoes);
+    }
+    if (wifi.lastLength != 18 || wifi.last[9] != 0xD0) {
+        benchFail("forwarded frame altered beyond the routing counter");
+    }
+
+    // Routing counter: 0 stops, 7 passes unchanged
+    const uint8_t payload[] = {0x01};
+    size_t length = benchRoutingFrame(frame, 0x1105, 1 << 11, payload, sizeof(payload));
+    frame[9] = 0x80;
+    injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+    frame[9] = 0xF0;
+    injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+    AsyncUDPLoopback::poll();
+    stats = router.getStats();
+    if (stats.paths[KNX_ROUTER_A_TO_B].hopLimit != 1 || wifi.last[9] != 0xF0) {
+        benchFail("routing counter: %u stopped, last forwarded with 0x%02X",
+            stats.paths[KNX_ROUTER_A_TO_B].hopLimit, wifi.last[9]);
+    }
+
+    // The other direction, and a filter replaced at runtime
+    length = benchRoutingFrame(frame, 0x1206, 5 << 11, payload, sizeof(payload));
+    injectOn(TCPIP_ADAPTER_IF_STA, frame, length);
+    router.setFilter(KNX_ROUTER_B_TO_A, KNXGroupFilter().passAll().blockMainGroup(5));
+    injectOn(TCPIP_ADAPTER_IF_STA, frame, length);
+    AsyncUDPLoopback::poll();
+    stats = router.getStats();
+    if (ethernet.frames != 1 || stats.paths[KNX_ROUTER_B_TO_A].filtered != 1) {
+        benchFail("B->A: ethernet saw %u frames, %u filtered", ethernet.frames,
+            stats.paths[KNX_ROUTER_B_TO_A].filtered);
+    }
+
+    // ROUTING_BUSY from a router on the WiFi side holds back forwarding there
+    const uint8_t busy[] = {0x06, 0x10, 0x05, 0x32, 0x00, 0x0C, 0x06, 0x00, 0x00, 0x64, 0x00, 0x00};
+    AsyncUDPLoopback::deliver(busy, sizeof(busy), IPAddress(192, 168, 2, 60), KNX_PORT,
+        KNX_MULTICAST_IP, KNX_PORT, TCPIP_ADAPTER_IF_STA);
+    length = benchRoutingFrame(frame, 0x1105, 1 << 11, payload, sizeof(payload));
+    injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+    nativeAdvanceClock(400);
+    injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+    AsyncUDPLoopback::poll();
+    stats = router.getStats();
+    if (stats.paths[KNX_ROUTER_A_TO_B].flowControl != 1 ||
+        stats.paths[KNX_ROUTER_A_TO_B].forwarded != expected + 2) {
+        benchFail("busy: %u held back, %u forwarded", stats.paths[KNX_ROUTER_A_TO_B].flowControl,
+            stats.paths[KNX_ROUTER_A_TO_B].forwarded - expected);
+    }
+}
+
+void pump(KNXIPRouter& router, KNXGatewaySim& gateway, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        gateway.poll(millis());
+        AsyncUDPLoopback::poll();
+        router.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+void checkTunnelBridge() {
+    const size_t TELEGRAMS = 200;
+    KNXGatewaySim gateway;
+    KNXIPRouter router;
+    router.setDebugLevel(0);
+    router.setFilter(KNX_ROUTER_A_TO_B, KNXGroupFilter().passMainGroup(3));
+    router.setFilter(KNX_ROUTER_B_TO_A, KNXGroupFilter().passMainGroup(4));
+
+    KNXRouterSideConfig tunnelSide;
+    tunnelSide.type = KNX_ROUTER_TUNNEL;
+    tunnelSide.gatewayIP = gateway.address();
+    tunnelSide.tunnel.localPort = KNX_PORT + 1;
+    router.begin(multicastSide(TCPIP_ADAPTER_IF_ETH), tunnelSide);
+    for (int i = 0; i < 100 && !router.isConnected(); i++) pump(router, gateway, 1);
+    if (!router.isConnected()) {
+        benchFail("router tunnel did not connect");
+        return;
+    }
+    Listener ethernet(TCPIP_ADAPTER_IF_ETH);
+
+    uint8_t frame[64];
+    for (size_t i = 0; i < TELEGRAMS; i++) {
+        const uint8_t payload[] = {(uint8_t)i};
+        size_t length = benchRoutingFrame(frame, 0x1105, (uint16_t)(3 << 11 | i), payload, sizeof(payload));
+        injectOn(TCPIP_ADAPTER_IF_ETH, frame, length);
+        pump(router, gateway, 1);
+    }
+    for (size_t i = 0; i < TELEGRAMS; i++) {
+        const uint8_t payload[] = {0x80, (uint8_t)i};
+        gateway.indicate((uint16_t)(((i & 1) ? 4 : 6) << 11 | i), payload, sizeof(payload));
+        pump(router, gateway, 1);
+    }
+    pump(router, gateway, 10);
+
+    KNXRouterStats stats = router.getStats();
+    benchNote("router eth <-> tunnel", "%zu to the gateway, %u back to ethernet, %u filtered",
+        gateway.frames.size(), ethernet.frames, stats.paths[KNX_ROUTER_B_TO_A].filtered);
+    bool framesOk = gateway.frames.size() == TELEGRAMS;
+    for (size_t i = 0; framesOk && i < TELEGRAMS; i++) {
+        const std::vector<uint8_t>& cemi = gateway.frames[i];
+        framesOk = cemi[0] == KNX_CEMI_L_DATA_REQ && cemi[3] == 0xD0 && cemi.back() == (uint8_t)i &&
+            ((cemi[4] << 8) | cemi[5]) == 0x1105;
+    }
+    if (!framesOk) benchFail("frames tunnelled to the gateway differ from those routed");
+    if (ethernet.frames != TELEGRAMS / 2 || stats.paths[KNX_ROUTER_B_TO_A].filtered != TELEGRAMS / 2 ||
+        knxServiceType(ethernet.last, ethernet.lastLength) != KNXNETIP_ROUTING_INDICATION ||
+        ethernet.last[6] != KNX_CEMI_L_DATA_IND || ethernet.last[9] != 0xD0) {
+        benchFail("tunnel indications routed to ethernet: %u", ethernet.frames);
+    }
+}
+
+void runRouterBenchmark() {
+    checkMulticastBridge();
+    checkTunnelBridge();
+}
+
+} // namespace
+
+BENCH_SUITE("router", runRouterBenchmark);
@@ -0,0 +1,162 @@
+//==== bench/bench_routing_flow.cpp ====
+
+// Routing flow control against the router simulator: a burst of group writes
+// through the transmit queue into a router that drains 50 telegrams/s, once
+// with ROUTING_BUSY and once with only lost message reports to go by. Checks
+// that BUSY frames prevent losses, that pauses end and the busy count decays,
+// that BUSY frames for other devices are ignored and that reports are kept
+// per router. Time is simulated, one millisecond per pump step.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "knx_router_sim.h"
+
+namespace {
+
+const size_t BURST = 250; // Transmit queue maximum
+const uint16_t GROUP = (2 << 11) | (1 << 8);
+
+void pump(KNXIPModule& module, KNXRouterSim& router, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        router.poll(millis());
+        AsyncUDPLoopback::poll();
+        module.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+void startModule(KNXIPModule& module) {
+    module.setDebugLevel(0);
+    KNXTxQueueConfig queue;
+    queue.capacity = BURST;
+    queue.telegramsPerSecond = 1000; // Far above what the router drains
+    queue.burst = 8;
+    queue.coalesce = false;
+    module.enableTxQueue(queue);
+    module.beginMulticast(1, 1, 10);
+}
+
+void runBurst(const char* name, bool emitBusy) {
+    KNXRouterSim router;
+    router.setEmitBusy(emitBusy);
+    KNXIPModule module;
+    startModule(module);
+
+    uint32_t start = (uint32_t)millis();
+    for (size_t i = 0; i < BURST; i++) {
+        const uint8_t data[] = {0x80, (uint8_t)i};
+        module.sendKNXMessage(GROUP | (i & 0xFF), data, sizeof(data));
+    }
+    while (module.getTxQueueStats().depth > 0 && millis() - start < 120000) {
+        pump(module, router, 1);
+    }
+    uint32_t elapsed = (uint32_t)millis() - start;
+    pump(module, router, 1000);
+
+    KNXRoutingFlowState state = module.getRoutingFlowState();
+    benchNote(name, "%u lost of %u, sent in %u ms, max router queue %zu",
+        router.lost, router.received, elapsed, router.maxDepth);
+    benchNote("  flow control", "%u busy, %u pauses, %u lost reports, spacing %u ms",
+        state.busyFrames, state.pauses, state.lostReports, state.sendIntervalMs);
+
+    if (router.received != BURST || router.forwarded + router.lost != BURST) {
+        benchFail("%s: router saw %u of %zu telegrams", name, router.received, BURST);
+    }
+    if (emitBusy && router.lost != 0) benchFail("%s: %u telegrams lost despite ROUTING_BUSY", name, router.lost);
+    if (!emitBusy && state.lostMessages != router.lost) {
+        benchFail("%s: %u of %u lost messages reported", name, state.lostMessages, router.lost);
+    }
+}
+
+void checkPauseAndDecay() {
+    KNXRouterSim router;
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    const uint8_t data[] = {0x81};
+
+    // Addressed to someone else: no effect
+    router.sendBusy(100, 0x0001);
+    pump(module, router, 1);
+    KNXRoutingFlowState state = module.getRoutingFlowState();
+    if (state.busyIgnored != 1 || state.paused || !module.sendKNXMessage(GROUP, data, 1)) {
+        benchFail("BUSY with a control field paused the sender");
+    }
+
+    // Three BUSY frames in one burst count once; 30 ms plus up to 50 ms random
+    router.sendBusy(30);
+    router.sendBusy(30);
+    router.sendBusy(30);
+    pump(module, router, 1);
+    state = module.getRoutingFlowState();
+    if (!state.paused || state.busyCount != 1 || state.resumeInMs < 29 || state.resumeInMs > 80) {
+        benchFail("BUSY: paused %d, count %u, resume in %u ms", state.paused, state.busyCount, state.resumeInMs);
+    }
+    if (module.sendKNXMessage(GROUP, data, 1)) benchFail("send went out during a BUSY pause");
+
+    // Another burst 20 ms later extends the pause and raises the count
+    pump(module, router, 19);
+    router.sendBusy(30);
+    pump(module, router, 1);
+    state = module.getRoutingFlowState();
+    if (state.busyCount != 2 || state.resumeInMs < 29) {
+        benchFail("second BUSY: count %u, resume in %u ms", state.busyCount, state.resumeInMs);
+    }
+
+    pump(module, router, state.resumeInMs);
+    if (!module.sendKNXMessage(GROUP, data, 1)) benchFail("send refused after the pause ended");
+
+    // The count holds for N x 100 ms, then drops every 5 ms
+    pump(module, router, 150);
+    if (module.getRoutingFlowState().busyCount != 2) benchFail("busy count decayed too early");
+    pump(module, router, 60);
+    state = module.getRoutingFlowState();
+    benchNote("routing busy pause", "%u pauses, busy count back to %u", state.pauses, state.busyCount);
+    if (state.busyCount != 0) benchFail("busy count %u did not decay", state.busyCount);
+}
+
+void checkLostReports() {
+    KNXRouterSim first;
+    KNXRouterSim second(IPAddress(192, 168, 178, 4));
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+
+    first.sendLostMessage(3);
+    second.sendLostMessage(5);
+    second.sendLostMessage(2);
+    pump(module, first, 1);
+
+    KNXRoutingFlowState state = module.getRoutingFlowState();
+    if (state.peerCount != 2 || state.lostMessages != 10 ||
+        state.peers[0].address != first.address() || state.peers[0].lostMessages != 3 ||
+        state.peers[1].address != second.address() || state.peers[1].lostReports != 2 ||
+        state.peers[1].lostMessages != 7) {
+        benchFail("lost message reports are not tracked per router");
+    }
+
+    // Three reports double the spacing twice; quiet time halves it back to none
+    if (state.sendIntervalMs != 80) benchFail("spacing %u ms after three reports", state.sendIntervalMs);
+    const uint8_t data[] = {0x81};
+    module.sendKNXMessage(GROUP, data, 1);
+    if (module.sendKNXMessage(GROUP, data, 1)) benchFail("second send ignored the spacing");
+    pump(module, first, 80);
+    if (!module.sendKNXMessage(GROUP, data, 1)) benchFail("send refused after the spacing");
+    pump(module, first, 4 * 2000);
+    state = module.getRoutingFlowState();
+    benchNote("routing lost messages", "%u reports from %u routers, spacing back to %u ms",
+        state.lostReports, state.peerCount, state.sendIntervalMs);
+    if (state.sendIntervalMs != 0) benchFail("spacing did not recover");
+}
+
+void runRoutingFlowBenchmark() {
+    runBurst("routing burst, BUSY", true);
+    runBurst("routing burst, lost reports only", false);
+    checkPauseAndDecay();
+    checkLostReports();
+}
+
+} // namespace
+
+BENCH_SUITE("routing", runRoutingFlowBenchmark);
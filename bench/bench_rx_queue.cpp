@@ -0,0 +1,133 @@
+//==== bench/bench_rx_queue.cpp ====
+
+// Stress test of the dispatch task mode: a producer thread plays the AsyncUDP
+// task and injects frames as fast as it can while a deliberately slow callback
+// runs on the dispatch thread. Reports producer-side latency and the queue
+// counters for both drop policies, and checks that no frame was torn,
+// reordered or lost without being counted.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <thread>
+
+namespace {
+
+const size_t FRAMES = 200000;
+const uint16_t GROUP = (1 << 11) | (2 << 8) | 3;
+const unsigned SLOW_CALLBACK_NS = 2000;
+
+struct Observer {
+    uint32_t lastSequence = 0;
+    bool first = true;
+    uint32_t seen = 0;
+    uint32_t torn = 0;
+    uint32_t reordered = 0;
+};
+
+void spin(unsigned ns) {
+    uint64_t until = benchNowNs() + ns;
+    while (benchNowNs() < until) {}
+}
+
+void observe(Observer& observer, const KNXTelegram& telegram) {
+    // Payload: 32-bit sequence followed by its complement
+    if (telegram.data.size() < 9) {
+        observer.torn++;
+        return;
+    }
+    uint32_t sequence = 0;
+    uint32_t check = 0;
+    for (size_t i = 0; i < 4; i++) {
+        sequence = (sequence << 8) | telegram.data[1 + i];
+        check = (check << 8) | telegram.data[5 + i];
+    }
+    if (~sequence != check) {
+        observer.torn++;
+        return;
+    }
+    if (!observer.first && sequence <= observer.lastSequence) observer.reordered++;
+    observer.lastSequence = sequence;
+    observer.first = false;
+    observer.seen++;
+}
+
+void produce(BenchLatency& latency) {
+    uint8_t frame[64];
+    uint64_t wallStart = benchNowNs();
+    for (size_t i = 0; i < FRAMES; i++) {
+        uint32_t sequence = (uint32_t)i;
+        uint8_t payload[8];
+        for (size_t b = 0; b < 4; b++) {
+            payload[b] = (uint8_t)(sequence >> (24 - 8 * b));
+            payload[4 + b] = (uint8_t)(~sequence >> (24 - 8 * b));
+        }
+        size_t length = benchRoutingFrame(frame, 0x1105, GROUP, payload, sizeof(payload));
+        uint64_t start = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - start);
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+}
+
+void runDirect() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    Observer observer;
+    module.onGroupAddress(GROUP, [&observer](const KNXTelegram& telegram) {
+        spin(SLOW_CALLBACK_NS);
+        observe(observer, telegram);
+    });
+
+    BenchLatency latency(FRAMES);
+    std::thread producer([&latency]() { produce(latency); });
+    producer.join();
+    latency.report("network task, direct dispatch");
+}
+
+void runQueued(KNXRxDropPolicy policy, const char* name) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    Observer observer;
+    module.onGroupAddress(GROUP, [&observer](const KNXTelegram& telegram) {
+        spin(SLOW_CALLBACK_NS);
+        observe(observer, telegram);
+    });
+
+    KNXDispatchTaskConfig config;
+    config.queueDepth = 64;
+    config.dropPolicy = policy;
+    module.enableDispatchTask(config);
+    module.beginMulticast(1, 1, 10);
+
+    BenchLatency latency(FRAMES);
+    std::thread producer([&latency]() { produce(latency); });
+    producer.join();
+
+    // Let the dispatch thread drain what is still queued
+    KNXRxQueueStats stats = module.getRxQueueStats();
+    while (stats.dispatched + stats.dropped < stats.received) {
+        delay(1);
+        stats = module.getRxQueueStats();
+    }
+    module.disableDispatchTask();
+
+    latency.report(name);
+    benchNote("  queue", "received %u dispatched %u dropped %u high-water %u/%u",
+        stats.received, stats.dispatched, stats.dropped, stats.highWater, stats.depth);
+
+    if (stats.received != FRAMES) benchFail("%s: %u frames offered, expected %zu", name, stats.received, FRAMES);
+    if (observer.seen != stats.dispatched) benchFail("%s: %u callbacks for %u dispatched", name, observer.seen, stats.dispatched);
+    if (observer.torn) benchFail("%s: %u torn frames", name, observer.torn);
+    if (observer.reordered) benchFail("%s: %u reordered frames", name, observer.reordered);
+}
+
+void runRxQueueBenchmarks() {
+    runDirect();
+    runQueued(KNX_RX_DROP_OLDEST, "network task, queued (drop oldest)");
+    runQueued(KNX_RX_DROP_NEWEST, "network task, queued (drop newest)");
+}
+
+} // namespace
+
+BENCH_SUITE("rxqueue", runRxQueueBenchmarks);
@@ -0,0 +1,110 @@
+//==== bench/bench_rx_tx.cpp ====
+
+// Baseline throughput and per-frame latency of the receive path
+// (processUdpData -> parseTelegram -> notifyCallbacks) and of the transmit
+// path (encode -> sendKNXMessage -> AsyncUDP::writeTo) with 1, 100 and 10k
+// registered group addresses.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "native_heap.h"
+
+namespace {
+
+const size_t FRAMES_PER_CASE = 200000;
+const size_t GROUP_COUNTS[] = {1, 100, 10000};
+
+volatile uint32_t callbackHits = 0;
+
+void countCallback(const KNXTelegram& telegram) {
+    callbackHits = callbackHits + telegram.targetAddress;
+}
+
+// Spread registrations over the whole 16-bit group address space.
+uint16_t groupAddressAt(size_t index, size_t count) {
+    return (uint16_t)(1 + (index * (0xFFFEu / count)));
+}
+
+void registerGroups(KNXIPModule& module, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        module.onGroupAddress(groupAddressAt(i, count), countCallback);
+    }
+}
+
+void runRx(size_t groups) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    registerGroups(module, groups);
+
+    const uint8_t payload[] = {0x0C, 0x65}; // 22.5 C as DPT 9.001
+    uint8_t frame[64];
+    BenchLatency latency(FRAMES_PER_CASE);
+    char name[64];
+
+    uint64_t allocationsBefore = nativeHeapAllocations();
+    uint64_t wallStart = benchNowNs();
+    for (size_t i = 0; i < FRAMES_PER_CASE; i++) {
+        size_t length = benchRoutingFrame(frame, 0x1105, groupAddressAt(i % groups, groups),
+                                          payload, sizeof(payload));
+        uint64_t start = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - start);
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    uint64_t allocations = nativeHeapAllocations() - allocationsBefore;
+    snprintf(name, sizeof(name), "rx parse+dispatch, %zu groups", groups);
+    latency.report(name);
+    benchNote("  rx heap allocations", "%llu over %zu frames",
+        (unsigned long long)allocations, FRAMES_PER_CASE);
+    if (allocations != 0) {
+        benchFail("receive path allocated %llu times", (unsigned long long)allocations);
+    }
+
+    // Traffic for addresses nobody subscribed to, as seen in multicast mode.
+    BenchLatency missLatency(FRAMES_PER_CASE);
+    wallStart = benchNowNs();
+    for (size_t i = 0; i < FRAMES_PER_CASE; i++) {
+        uint16_t dst = (uint16_t)(groupAddressAt(i % groups, groups) + 1);
+        size_t length = benchRoutingFrame(frame, 0x1105, dst, payload, sizeof(payload));
+        uint64_t start = benchNowNs();
+        benchInject(frame, length);
+        missLatency.add(benchNowNs() - start);
+    }
+    missLatency.setWallTime(benchNowNs() - wallStart);
+    snprintf(name, sizeof(name), "rx unsubscribed, %zu groups", groups);
+    missLatency.report(name);
+}
+
+void runTx(size_t groups) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    registerGroups(module, groups);
+
+    BenchLatency latency(FRAMES_PER_CASE);
+    char name[64];
+
+    uint64_t wallStart = benchNowNs();
+    for (size_t i = 0; i < FRAMES_PER_CASE; i++) {
+        uint64_t start = benchNowNs();
+        module.sendTemperature(groupAddressAt(i % groups, groups), 22.5f);
+        latency.add(benchNowNs() - start);
+        if (AsyncUDPLoopback::pending() > 128) AsyncUDPLoopback::discardPending();
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    AsyncUDPLoopback::discardPending();
+    snprintf(name, sizeof(name), "tx encode+send, %zu groups", groups);
+    latency.report(name);
+}
+
+void runRxTxBenchmarks() {
+    for (size_t groups : GROUP_COUNTS) {
+        runRx(groups);
+        runTx(groups);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("rxtx", runRxTxBenchmarks);
@@ -0,0 +1,362 @@
+//==== bench/bench_scheduler.cpp ====
+
+// Scheduler: checks the timer wheel against a reference list of deadlines
+// under random arming, cancelling and clock jumps (including deadlines past
+// the 2^24 ms top level and the wrap of millis()), then the module's cyclic
+// sends, send objects and timeouts with the sketch sleeping for whatever
+// poll() returns. Measures arming and expiry on the wheel against a scan over
+// all deadlines, the pattern of per-component millis() checks in loop().
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint16_t TEMPERATURE_GROUP = (1 << 11) | (0 << 8) | 1;
+const uint16_t LIGHT_GROUP = (2 << 11) | (1 << 8) | 5;
+
+struct Random {
+    uint32_t state;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint32_t below(uint32_t limit) { return next() % limit; }
+};
+
+// Random delays: mostly short, some minutes and hours, a few past the top level
+uint32_t randomDelay(Random& random) {
+    switch (random.below(8)) {
+    case 0: return 0;
+    case 1: return random.below(64);
+    case 2: case 3: return random.below(5000);
+    case 4: case 5: return random.below(600000);
+    case 6: return random.below(1U << 24);
+    default: return (1U << 24) + random.below(1U << 26);
+    }
+}
+
+void checkWheel() {
+    const size_t TIMERS = 2000;
+    KNXTimerWheel wheel;
+    // Starts just before millis() wraps
+    uint32_t now = 0xFFFF0000UL;
+    wheel.begin(TIMERS, now);
+    std::vector<uint64_t> deadline(TIMERS, 0);
+    std::vector<bool> armed(TIMERS, false);
+    uint64_t clock = 0; // Time since start, without the wrap
+
+    Random random = {12345};
+    for (size_t i = 0; i < TIMERS; i++) {
+        uint32_t delay = randomDelay(random);
+        wheel.schedule((uint16_t)i, now, delay);
+        deadline[i] = clock + delay;
+        armed[i] = true;
+    }
+
+    size_t fired = 0, early = 0, late = 0, stray = 0, sleptPast = 0;
+    for (int step = 0; step < 20000; step++) {
+        // A sleep of what msUntilNext() asks for, or a random jump
+        uint32_t wait = wheel.msUntilNext(now);
+        uint64_t nextDeadline = UINT64_MAX;
+        for (size_t i = 0; i < TIMERS; i++) {
+            if (armed[i] && deadline[i] < nextDeadline) nextDeadline = deadline[i];
+        }
+        if (nextDeadline != UINT64_MAX && clock + wait > nextDeadline) sleptPast++;
+        uint32_t advance = random.below(4) == 0 ? random.below(200000) : wait;
+        if (advance == UINT32_MAX) advance = 1000;
+        uint64_t previous = clock;
+        clock += advance;
+        now += advance;
+
+        uint16_t id;
+        while ((id = wheel.expire(now)) != KNXTimerWheel::NONE) {
+            if (!armed[id]) {
+                stray++;
+                continue;
+            }
+            fired++;
+            armed[id] = false;
+            if (deadline[id] > clock) early++;
+            if (deadline[id] < previous) late++;
+        }
+        for (size_t i = 0; i < TIMERS; i++) {
+            if (armed[i] && deadline[i] <= clock) late++;
+        }
+
+        // Churn: re-arm idle timers, cancel or move armed ones
+        for (int k = 0; k < 4; k++) {
+            uint16_t i = (uint16_t)random.below(TIMERS);
+            if (armed[i] && random.below(2) == 0) {
+                wheel.cancel(i);
+                armed[i] = false;
+            } else {
+                uint32_t delay = randomDelay(random);
+                wheel.schedule(i, now, delay);
+                deadline[i] = clock + delay;
+                armed[i] = true;
+            }
+        }
+    }
+    benchNote("timer wheel", "%zu expiries over %.1f simulated days: %zu early, %zu late, %zu cancelled "
+        "fired, %zu sleeps past a deadline", fired, clock / 86400000.0, early, late, stray, sleptPast);
+    if (early || late || stray || sleptPast || fired == 0) benchFail("timer wheel out of step");
+}
+
+// Arms `timers` timers with periods of 100 ms to 10 min and keeps them
+// running for a simulated hour, once on the wheel and once as an array of
+// deadlines scanned every millisecond
+void runChurn(size_t timers) {
+    const uint32_t SIMULATED_MS = 3600 * 1000;
+    std::vector<uint32_t> period(timers);
+    Random random = {777};
+    for (size_t i = 0; i < timers; i++) period[i] = 100 + random.below(600000);
+
+    KNXTimerWheel wheel;
+    wheel.begin(timers, 0);
+    uint64_t expiries = 0;
+    uint64_t t0 = benchNowNs();
+    for (size_t i = 0; i < timers; i++) wheel.schedule((uint16_t)i, 0, period[i]);
+    for (uint32_t now = 1; now <= SIMULATED_MS; now++) {
+        uint16_t id;
+        while ((id = wheel.expire(now)) != KNXTimerWheel::NONE) {
+            wheel.schedule(id, now, period[id]);
+            expiries++;
+        }
+    }
+    uint64_t wheelNs = benchNowNs() - t0;
+
+    std::vector<uint32_t> due(period);
+    uint64_t scanned = 0;
+    t0 = benchNowNs();
+    for (uint32_t now = 1; now <= SIMULATED_MS; now++) {
+        for (size_t i = 0; i < timers; i++) {
+            if (now - due[i] < 0x80000000UL) {
+                due[i] = now + period[i];
+                scanned++;
+            }
+        }
+    }
+    uint64_t scanNs = benchNowNs() - t0;
+
+    benchNote("  timers", "%zu: wheel %.1f ns per ms tick (%llu expiries), scan %.1f ns per ms tick", timers,
+        (double)wheelNs / SIMULATED_MS, (unsigned long long)expiries, (double)scanNs / SIMULATED_MS);
+    if (scanned != expiries) {
+        benchFail("churn with %zu timers: %llu expiries on the wheel, %llu by scanning", timers,
+            (unsigned long long)expiries, (unsigned long long)scanned);
+    }
+}
+
+void runWheelCost() {
+    const size_t TIMERS = 4096;
+    KNXTimerWheel wheel;
+    wheel.begin(TIMERS, 0);
+    Random random = {99};
+    BenchLatency schedule(TIMERS), expire(TIMERS);
+    for (size_t i = 0; i < TIMERS; i++) {
+        uint32_t delay = 1 + random.below(600000);
+        uint64_t t0 = benchNowNs();
+        wheel.schedule((uint16_t)i, 0, delay);
+        schedule.add(benchNowNs() - t0);
+    }
+    schedule.report("wheel schedule, 4096 armed");
+
+    // Each expiry costs its share of the cascades and the jumps between slots
+    uint64_t t0 = benchNowNs();
+    size_t expired = 0;
+    for (uint32_t now = 0; expired < TIMERS; now += 1000) {
+        uint64_t s0 = benchNowNs();
+        size_t before = expired;
+        while (wheel.expire(now) != KNXTimerWheel::NONE) expired++;
+        uint64_t spent = benchNowNs() - s0;
+        for (size_t i = before; i < expired; i++) expire.add(spent / (expired - before));
+    }
+    expire.setWallTime(benchNowNs() - t0);
+    expire.report("wheel expire, 4096 over 10 min");
+
+    runChurn(32);
+    runChurn(256);
+}
+
+struct Sent {
+    uint32_t at;
+    uint16_t groupAddress;
+    uint8_t value; // APCI data bits or first payload byte
+};
+
+// Sleeps for what poll() returns (capped at maxSleepMs) until `until`;
+// returns the number of wake-ups
+size_t sleepWithPoll(KNXIPModule& module, uint32_t until, uint32_t maxSleepMs = 60000) {
+    size_t wakeups = 0;
+    while ((uint32_t)millis() < until) {
+        uint32_t wait = module.poll();
+        wakeups++;
+        AsyncUDPLoopback::discardPending();
+        uint32_t left = until - (uint32_t)millis();
+        if (wait > maxSleepMs) wait = maxSleepMs;
+        if (wait > left) wait = left;
+        nativeAdvanceClock(wait != 0 ? wait : 1);
+    }
+    return wakeups;
+}
+
+void checkModule() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    module.enableScheduler();
+    uint32_t start = millis();
+
+    std::vector<Sent> sent;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        if (length < 17) return;
+        Sent entry;
+        entry.at = (uint32_t)millis() - start;
+        entry.groupAddress = (data[12] << 8) | data[13];
+        entry.value = length > 17 ? data[17] : data[16] & 0x3F;
+        sent.push_back(entry);
+    });
+
+    // A temperature every 5 s, phase-locked to the start
+    float temperature = 21.0f;
+    KNXTimerHandle cyclic = module.sendCyclic<KNXDpt<9, 1>>(TEMPERATURE_GROUP, 5000, [&temperature] {
+        return temperature += 0.5f;
+    });
+    // A light sent on change, at most every second, refreshed every 10 s
+    KNXTimerHandle light = module.addSendObject(LIGHT_GROUP, 10000, 1000);
+    // Timeouts: one fires, one is cancelled, one re-arms itself twice
+    std::vector<uint32_t> timeouts;
+    module.setTimeout(250, [&] { timeouts.push_back((uint32_t)millis() - start); });
+    KNXTimerHandle cancelled = module.setTimeout(300, [&] { timeouts.push_back(0); });
+    module.cancelTimer(cancelled);
+    struct Chain {
+        KNXIPModule* module;
+        std::vector<uint32_t>* timeouts;
+        uint32_t start;
+        int rounds;
+        KNXTimerCallback callback;
+    } chain = {&module, &timeouts, start, 0, nullptr};
+    // One pointer of captured state, within KNX_CALLBACK_SIZE
+    chain.callback = [&chain] {
+        chain.timeouts->push_back((uint32_t)millis() - chain.start);
+        if (++chain.rounds < 3) chain.module->setTimeout(700, chain.callback);
+    };
+    module.setTimeout(700, chain.callback);
+
+    module.updateSendObject<KNXDpt<1, 1>>(light, true);       // t=0: sent
+    sleepWithPoll(module, start + 100);
+    module.updateSendObject<KNXDpt<1, 1>>(light, true);       // unchanged
+    sleepWithPoll(module, start + 200);
+    module.updateSendObject<KNXDpt<1, 1>>(light, false);      // held until t=1000
+    size_t wakeups = sleepWithPoll(module, start + 30000);
+    module.cancelTimer(cyclic);
+    sleepWithPoll(module, start + 40000);
+    AsyncUDPLoopback::setTap(nullptr);
+
+    std::vector<uint32_t> temperatureAt, lightAt;
+    std::vector<uint8_t> lightValue;
+    for (const Sent& entry : sent) {
+        if (entry.groupAddress == TEMPERATURE_GROUP) temperatureAt.push_back(entry.at);
+        if (entry.groupAddress == LIGHT_GROUP) {
+            lightAt.push_back(entry.at);
+            lightValue.push_back(entry.value);
+        }
+    }
+
+    // Cancelled at 30000 ms, before its sixth send
+    bool cyclicOk = temperatureAt.size() == 5;
+    for (size_t i = 0; cyclicOk && i < temperatureAt.size(); i++) cyclicOk = temperatureAt[i] == 5000 * (i + 1);
+    if (!cyclicOk) benchFail("cyclic send: %zu sends, not every 5000 ms", temperatureAt.size());
+
+    // t=0 on, t=1000 off (minimum interval), refreshes at 11000, 21000, 31000
+    const uint32_t expectedAt[] = {0, 1000, 11000, 21000, 31000};
+    const uint8_t expectedValue[] = {1, 0, 0, 0, 0};
+    bool objectOk = lightAt.size() == 5;
+    for (size_t i = 0; objectOk && i < 5; i++) {
+        objectOk = lightAt[i] == expectedAt[i] && lightValue[i] == expectedValue[i];
+    }
+    if (!objectOk) benchFail("send object: %zu sends, expected 5 at 0/1000/11000/21000/31000 ms", lightAt.size());
+
+    bool timeoutOk = timeouts.size() == 4 && timeouts[0] == 250 && timeouts[1] == 700 &&
+        timeouts[2] == 1400 && timeouts[3] == 2100;
+    if (!timeoutOk) benchFail("timeouts: %zu fired, expected at 250/700/1400/2100 ms", timeouts.size());
+
+    KNXSchedulerStats stats = module.getSchedulerStats();
+    benchNote("scheduler", "%s cyclic, %s send object, %s timeouts; %zu wake-ups in 30 s (delay(10): 3000)",
+        cyclicOk ? "exact" : "WRONG", objectOk ? "exact" : "WRONG", timeoutOk ? "exact" : "WRONG", wakeups);
+    benchNote("  stats", "%u timeouts, %u cyclic sends, %u object sends, %u unchanged, %u missed, %u active",
+        stats.timeouts, stats.cyclicSends, stats.objectSends, stats.unchanged, stats.missed, stats.active);
+    if (stats.unchanged != 1 || stats.active != 1) {
+        benchFail("scheduler stats: %u unchanged, %u active", stats.unchanged, stats.active);
+    }
+}
+
+void checkMissedAndDeadlines() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    if (module.poll() != UINT32_MAX) benchFail("poll() with nothing to do wants a wake-up");
+
+    // A stalled loop: cycles that passed are skipped, the phase is kept
+    KNXSchedulerConfig config;
+    config.capacity = 2;
+    module.enableScheduler(config);
+    size_t sends = 0;
+    module.sendCyclic(TEMPERATURE_GROUP, 1000, [&sends](uint8_t* data) -> size_t {
+        sends++;
+        return KNXDpt<5, 10>::encode(7, data);
+    });
+    nativeAdvanceClock(3500);
+    uint32_t wait = module.poll();
+    AsyncUDPLoopback::discardPending();
+    KNXSchedulerStats stats = module.getSchedulerStats();
+    if (sends != 1 || stats.missed != 2 || wait != 500) {
+        benchFail("stalled cycle: %zu sends, %u missed, next in %u ms", sends, stats.missed, wait);
+    }
+    // Full: the third entry is refused
+    module.setTimeout(100, [] {});
+    if (module.setTimeout(100, [] {}) != 0 || module.getSchedulerStats().rejected != 1) {
+        benchFail("full scheduler accepted an entry");
+    }
+
+    // Outstanding reads bound the sleep by their timeout
+    KNXGroupReadConfig reads;
+    reads.timeoutMs = 40;
+    module.enableGroupReads(reads);
+    module.readGroupValue(LIGHT_GROUP);
+    wait = module.poll();
+    AsyncUDPLoopback::discardPending();
+    if (wait > 40) benchFail("poll() sleeps %u ms past a read timeout of 40 ms", wait);
+    module.disableGroupReads();
+}
+
+void checkTask() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    KNXSchedulerConfig config;
+    config.task = true;
+    module.enableScheduler(config);
+    std::atomic<int> fired(0);
+    module.setTimeout(0, [&fired] { fired++; });
+    for (int i = 0; i < 200 && fired == 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    module.disableScheduler();
+    if (fired != 1) benchFail("scheduler task ran %d timeouts, expected 1", fired.load());
+}
+
+void runSchedulerBenchmark() {
+    checkWheel();
+    checkModule();
+    checkMissedAndDeadlines();
+    checkTask();
+    runWheelCost();
+}
+
+} // namespace
+
+BENCH_SUITE("scheduler", runSchedulerBenchmark);
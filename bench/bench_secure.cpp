@@ -0,0 +1,440 @@
+//==== bench/bench_secure.cpp ====
+
+// KNX IP Secure: checks the crypto primitives against their published test
+// vectors (FIPS-197 AES, SHA-256, RFC 7748 X25519, the KNX password
+// derivations) and the wrapper code against the AN159 session examples, runs
+// secure routing through the module (accept, tampered, replayed, outdated,
+// plain, timer synchronisation) and a secure tunnel against the gateway
+// simulator, then measures what a frame costs to wrap and unwrap.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_module.h"
+#include <vector>
+
+namespace {
+
+const uint16_t GROUP = (3 << 11) | (4 << 8) | 5;
+const uint8_t PEER_SERIAL[6] = {0x00, 0xFA, 0x10, 0x20, 0x30, 0x40};
+const uint8_t OTHER_SERIAL[6] = {0x00, 0xFA, 0x10, 0x20, 0x30, 0x41};
+const uint8_t OWN_SERIAL[6] = {0x00, 0xFA, 0x00, 0x00, 0x00, 0x01};
+const uint8_t BACKBONE_KEY[16] = {0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7,
+                                  0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF};
+const size_t COST_FRAMES = 20000;
+const size_t COST_HANDSHAKES = 200;
+
+std::vector<uint8_t> fromHex(const char* hex) {
+    std::vector<uint8_t> bytes;
+    for (; hex[0] && hex[1]; hex += 2) {
+        unsigned value;
+        sscanf(hex, "%2x", &value);
+        bytes.push_back((uint8_t)value);
+    }
+    return bytes;
+}
+
+bool expect(const char* name, const uint8_t* actual, const char* hex, size_t& wrong) {
+    std::vector<uint8_t> expected = fromHex(hex);
+    if (memcmp(actual, expected.data(), expected.size()) == 0) return true;
+    benchFail("secure vector %s: mismatch", name);
+    wrong++;
+    return false;
+}
+
+void checkPrimitives() {
+    size_t wrong = 0;
+    uint8_t out[32];
+    KNXAes128 aes;
+
+    // FIPS-197 appendix C.1 and appendix B
+    aes.setKey(fromHex("000102030405060708090a0b0c0d0e0f").data());
+    aes.encryptBlock(fromHex("00112233445566778899aabbccddeeff").data(), out);
+    expect("AES-128 C.1", out, "69c4e0d86a7b0430d8cdb78070b4c55a", wrong);
+    aes.setKey(fromHex("2b7e151628aed2a6abf7158809cf4f3c").data());
+    aes.encryptBlock(fromHex("3243f6a8885a308d313198a2e0370734").data(), out);
+    expect("AES-128 B", out, "3925841d02dc09fbdc118597196a0b32", wrong);
+
+    KNXSha256 hash;
+    hash.update((const uint8_t*)"abc", 3);
+    hash.finish(out);
+    expect("SHA-256 abc", out, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", wrong);
+
+    // AN159: password "trustme" of the interface, "secret" of user 1
+    knxSecureDeviceAuthenticationCode("trustme", out);
+    expect("device authentication code", out, "e158e4012047bd6cc41aafbc5c04c1fc", wrong);
+    knxSecureUserPasswordKey("secret", out);
+    expect("user password key", out, "03fcedb66660251ec81a1a716901696a", wrong);
+
+    // RFC 7748 section 6.1
+    std::vector<uint8_t> alice = fromHex("77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+    std::vector<uint8_t> bob = fromHex("5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+    uint8_t alicePublic[32];
+    uint8_t bobPublic[32];
+    knxX25519Base(alicePublic, alice.data());
+    knxX25519Base(bobPublic, bob.data());
+    expect("X25519 Alice", alicePublic, "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a", wrong);
+    expect("X25519 Bob", bobPublic, "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f", wrong);
+    const char* shared = "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742";
+    knxX25519(out, alice.data(), bobPublic);
+    expect("X25519 shared (Alice)", out, shared, wrong);
+    knxX25519(out, bob.data(), alicePublic);
+    expect("X25519 shared (Bob)", out, shared, wrong);
+
+    benchNote("secure primitives", "AES, SHA-256, PBKDF2, X25519: %zu vectors wrong (%s AES)", wrong,
+        KNXAes128::hardware() ? "hardware" : "software");
+}
+
+// The session example of AN159: SESSION_RESPONSE and SESSION_AUTHENTICATE
+// MACs, and SESSION_AUTHENTICATE in a SECURE_WRAPPER
+void checkSessionVectors() {
+    size_t wrong = 0;
+    std::vector<uint8_t> clientPublic = fromHex("0aa227b4fd7a32319ba9960ac036ce0e5c4507b5ae55161f1078b1dcfb3cb631");
+    std::vector<uint8_t> serverPublic = fromHex("bdf099909923143ef0a5de0b3be3687bc5bd3cf5f9e6f901699cd870ec1ff824");
+    uint8_t associated[40];
+    for (size_t i = 0; i < 32; i++) associated[8 + i] = clientPublic[i] ^ serverPublic[i];
+
+    uint8_t code[16];
+    uint8_t mac[KNX_SECURE_MAC_LENGTH];
+    KNXAes128 key;
+    knxSecureDeviceAuthenticationCode("trustme", code);
+    key.setKey(code);
+    memcpy(associated, fromHex("0610095200380001").data(), 8);
+    knxSecureHandshakeMac(key, associated, sizeof(associated), mac);
+    expect("SESSION_RESPONSE MAC", mac, "a922505aaa436163570bd5494c2df2a3", wrong);
+
+    knxSecureUserPasswordKey("secret", code);
+    key.setKey(code);
+    memcpy(associated, fromHex("0610095300180001").data(), 8);
+    knxSecureHandshakeMac(key, associated, sizeof(associated), mac);
+    expect("SESSION_AUTHENTICATE MAC", mac, "1f1d59ea9f12a152e5d9727f08462cde", wrong);
+
+    std::vector<uint8_t> wrapper = fromHex(
+        "06100950003e0001000000000000" "00fa12345678affe"
+        "7915a4f36e6e4208d28b4a207d8f35c0d138c26a7b5e7169"
+        "52dba8e7e4bd80bd7d868a3ae78749de");
+    const char* authenticate = "06100953001800011f1d59ea9f12a152e5d9727f08462cde";
+    key.setKey(fromHex("289426c2912535ba98279a4d1843c487").data());
+    uint8_t plain[KNX_SECURE_FRAME_SIZE];
+    KNXSecureHeader header;
+    size_t length = knxSecureUnwrap(key, wrapper.data(), wrapper.size(), plain, sizeof(plain), header);
+    if (length != 24 || header.sessionId != 1 || header.sequence != 0 || header.tag != 0xAFFE) {
+        benchFail("secure vector SECURE_WRAPPER: not accepted");
+        wrong++;
+    } else {
+        expect("SECURE_WRAPPER plain", plain, authenticate, wrong);
+    }
+    // Wrapping the same frame with the same header gives the same datagram
+    uint8_t wrapped[64];
+    size_t wrappedLength = knxSecureWrap(key, header, fromHex(authenticate).data(), 24, wrapped,
+        sizeof(wrapped));
+    if (wrappedLength != wrapper.size() || memcmp(wrapped, wrapper.data(), wrappedLength) != 0) {
+        benchFail("secure vector SECURE_WRAPPER: wrap differs");
+        wrong++;
+    }
+    // A single flipped bit anywhere is refused
+    size_t accepted = 0;
+    for (size_t i = 0; i < wrapper.size(); i++) {
+        std::vector<uint8_t> tampered = wrapper;
+        tampered[i] ^= 0x01;
+        if (knxSecureUnwrap(key, tampered.data(), tampered.size(), plain, sizeof(plain), header) > 0) {
+            accepted++;
+        }
+    }
+    if (accepted > 0) {
+        benchFail("secure vector SECURE_WRAPPER: %zu tampered datagrams accepted", accepted);
+        wrong++;
+    }
+    benchNote("secure AN159 session", "handshake MACs and wrapper: %zu vectors wrong", wrong);
+}
+
+size_t secureRoutingFrame(uint8_t* out, const KNXAes128& key, const uint8_t serial[6], uint64_t timer,
+                          uint16_t tag, uint8_t value) {
+    uint8_t frame[64];
+    size_t length = benchRoutingFrame(frame, 0x1105, GROUP, &value, 1);
+    KNXSecureHeader header = {};
+    header.sequence = timer;
+    memcpy(header.serial, serial, 6);
+    header.tag = tag;
+    return knxSecureWrap(key, header, frame, length, out, KNX_SECURE_WRAPPER_OVERHEAD + length);
+}
+
+void checkRouting() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    KNXSecureRoutingConfig config;
+    memcpy(config.backboneKey, BACKBONE_KEY, 16);
+    memcpy(config.serialNumber, OWN_SERIAL, 6);
+    config.notifyIntervalMs = 0;
+    module.enableSecureRouting(config);
+    module.beginMulticast(1, 1, 10);
+
+    std::vector<uint8_t> values;
+    module.onGroupAddress(GROUP, [&](const KNXTelegram& telegram) {
+        if (telegram.data.size() > 1) values.push_back(telegram.data[1]);
+    });
+    KNXAes128 key;
+    key.setKey(BACKBONE_KEY);
+
+    std::vector<std::vector<uint8_t>> sent;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        sent.push_back(std::vector<uint8_t>(data, data + length));
+    });
+
+    // The first loop announces our timer
+    module.loop();
+    bool announced = sent.size() == 1 && knxServiceType(sent[0].data(), sent[0].size()) == KNXNETIP_TIMER_NOTIFY;
+
+    uint8_t datagram[128];
+    uint64_t timer = 100000; // Ahead of ours: adopted, as is every newer one
+    size_t length = secureRoutingFrame(datagram, key, PEER_SERIAL, timer, 1, 0x11);
+    benchInject(datagram, length);
+    benchInject(datagram, length); // Replayed
+    length = secureRoutingFrame(datagram, key, PEER_SERIAL, timer + 10, 2, 0x22);
+    datagram[length - 20] ^= 0x80; // Tampered with
+    benchInject(datagram, length);
+    datagram[length - 20] ^= 0x80;
+    benchInject(datagram, length);
+    uint8_t plain[64];
+    uint8_t value = 0x55;
+    length = benchRoutingFrame(plain, 0x1105, GROUP, &value, 1);
+    benchInject(plain, length); // Without a wrapper
+
+    // Far behind the adopted timer: refused, and answered with our timer
+    nativeAdvanceClock(200);
+    length = secureRoutingFrame(datagram, key, OTHER_SERIAL, timer - 5000, 1, 0x33);
+    benchInject(datagram, length);
+    sent.clear();
+    module.loop();
+    bool answered = false;
+    KNXSecureHeader header;
+    for (const std::vector<uint8_t>& frame : sent) {
+        if (knxServiceType(frame.data(), frame.size()) == KNXNETIP_TIMER_NOTIFY &&
+            knxSecureCheckTimerNotify(key, frame.data(), frame.size(), header)) {
+            answered = header.sequence >= timer + 10 && memcmp(header.serial, OWN_SERIAL, 6) == 0;
+        }
+    }
+
+    // Our own frames go out wrapped, with increasing timers
+    sent.clear();
+    value = 0x44;
+    module.sendKNXMessage(GROUP, &value, 1);
+    module.sendKNXMessage(GROUP, &value, 1);
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+    size_t ownOk = 0;
+    uint64_t lastTimer = 0;
+    for (const std::vector<uint8_t>& frame : sent) {
+        size_t plainLength = knxSecureUnwrap(key, frame.data(), frame.size(), plain, sizeof(plain), header);
+        if (plainLength > 0 && knxServiceType(plain, plainLength) == KNXNETIP_ROUTING_INDICATION &&
+            header.sequence > lastTimer && header.sequence >= timer) {
+            ownOk++;
+        }
+        lastTimer = header.sequence;
+    }
+
+    KNXSecureStats stats = module.getSecureRoutingStats();
+    benchNote("secure routing", "%zu delivered, %u replayed, %u tampered, %u outdated, %u plain, %u syncs",
+        values.size(), stats.replayed, stats.authFailures, stats.outdated, stats.plainDropped, stats.timerSyncs);
+    if (values != std::vector<uint8_t>({0x11, 0x22}) || stats.replayed != 1 || stats.authFailures != 1 ||
+        stats.outdated != 1 || stats.plainDropped != 1 || stats.timerSyncs != 2) {
+        benchFail("secure routing: wrong frames accepted or refused");
+    }
+    if (!announced || !answered) {
+        benchFail("secure routing: TIMER_NOTIFY %s", announced ? "not answered" : "not sent at start");
+    }
+    if (ownOk != 2 || sent.size() != 2) {
+        benchFail("secure routing: %zu of %zu own frames wrapped correctly", ownOk, sent.size());
+    }
+    module.disableSecureRouting();
+}
+
+void pump(KNXIPModule& module, KNXGatewaySim& gateway, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        gateway.poll(millis());
+        AsyncUDPLoopback::poll();
+        module.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+bool connectSecure(KNXIPModule& module, KNXGatewaySim& gateway, const KNXSecureTunnelConfig& config) {
+    module.setDebugLevel(0);
+    module.setTunnelConfig(KNXTunnelConfig());
+    module.enableSecureTunnel(config);
+    if (!module.begin(gateway.address(), 1, 1, 10)) return false;
+    for (int i = 0; i < 100 && !module.isConnected(); i++) pump(module, gateway, 1);
+    return module.isConnected();
+}
+
+void checkTunnel() {
+    uint8_t deviceCode[16];
+    uint8_t userKey[16];
+    knxSecureDeviceAuthenticationCode("trustme", deviceCode);
+    knxSecureUserPasswordKey("secret", userKey);
+    KNXSecureTunnelConfig config;
+    config.userId = 2;
+    memcpy(config.deviceAuthenticationCode, deviceCode, 16);
+    memcpy(config.userPasswordKey, userKey, 16);
+    memcpy(config.serialNumber, OWN_SERIAL, 6);
+
+    {
+        KNXGatewaySim gateway;
+        gateway.setSecure(deviceCode, 2, userKey);
+        KNXIPModule module;
+        std::vector<uint8_t> values;
+        module.onGroupAddress(GROUP, [&](const KNXTelegram& telegram) {
+            if (telegram.data.size() > 1) values.push_back(telegram.data[1]);
+        });
+        if (!connectSecure(module, gateway, config)) {
+            benchFail("secure tunnel: no connection");
+            return;
+        }
+        for (uint8_t i = 0; i < 20; i++) {
+            module.send<KNXDpt<5, 10>>(GROUP, i);
+            pump(module, gateway, 2);
+        }
+        pump(module, gateway, 50);
+        const uint8_t write[] = {0x80, 0x5A}; // GroupValue_Write
+        gateway.indicate(GROUP, write, sizeof(write));
+        pump(module, gateway, 5);
+        gateway.replayLastDatagram();
+        pump(module, gateway, 5);
+        // Past the keepalive interval
+        pump(module, gateway, config.keepaliveMs + 1000);
+        // The server ends the session: the client comes back with a new one
+        gateway.closeSession();
+        pump(module, gateway, 20);
+        for (int i = 0; i < 20000 && !module.isConnected(); i++) pump(module, gateway, 1);
+
+        KNXSecureStats stats = module.getSecureTunnelStats();
+        benchNote("secure tunnel", "%zu telegrams sent, %zu received, %u sessions, %u replayed, %u keepalives",
+            gateway.frames.size(), values.size(), stats.sessions, stats.replayed, gateway.keepalives);
+        if (gateway.frames.size() != 20 || values != std::vector<uint8_t>({0x5A}) || stats.replayed != 1 ||
+            gateway.plainRefused != 0) {
+            benchFail("secure tunnel: %zu sent, %zu received, %u replayed, %u plain refused",
+                gateway.frames.size(), values.size(), stats.replayed, gateway.plainRefused);
+        }
+        if (gateway.keepalives == 0 || stats.sessions != 2 || gateway.sessions != 2 || !module.isConnected()) {
+            benchFail("secure tunnel: %u keepalives, %u sessions, %s after close", gateway.keepalives,
+                stats.sessions, module.isConnected() ? "reconnected" : "not reconnected");
+        }
+    }
+
+    // Wrong device authentication code: the server is not trusted
+    {
+        KNXGatewaySim gateway;
+        uint8_t otherCode[16];
+        memcpy(otherCode, deviceCode, 16);
+        otherCode[0] ^= 0xFF;
+        gateway.setSecure(otherCode, 2, userKey);
+        KNXIPModule module;
+        bool connected = connectSecure(module, gateway, config);
+        KNXSecureStats stats = module.getSecureTunnelStats();
+        if (connected || stats.authFailures == 0 || gateway.sessions != 0) {
+            benchFail("secure tunnel: server with a wrong device code accepted");
+        }
+    }
+
+    // Wrong user password: the server refuses the client
+    {
+        KNXGatewaySim gateway;
+        uint8_t otherKey[16];
+        memcpy(otherKey, userKey, 16);
+        otherKey[15] ^= 0x01;
+        gateway.setSecure(deviceCode, 2, otherKey);
+        KNXIPModule module;
+        bool connected = connectSecure(module, gateway, config);
+        KNXSecureStats stats = module.getSecureTunnelStats();
+        if (connected || gateway.sessionsRefused == 0 || stats.sessionFailures == 0) {
+            benchFail("secure tunnel: client with a wrong password accepted");
+        }
+    }
+    AsyncUDPLoopback::discardPending();
+}
+
+// Wrap and unwrap with the key schedule kept, and wrap with the schedule
+// expanded for every frame as a stateless implementation would
+void runFrameCost(const char* name, size_t apduLength) {
+    uint8_t frame[KNX_SECURE_FRAME_SIZE];
+    uint8_t payload[KNX_CEMI_EXTENDED_APDU];
+    for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)i;
+    size_t length = benchRoutingFrame(frame, 0x1105, GROUP, payload, apduLength);
+    uint8_t wrapped[KNX_SECURE_FRAME_SIZE + KNX_SECURE_WRAPPER_OVERHEAD];
+    uint8_t plain[KNX_SECURE_FRAME_SIZE];
+    KNXAes128 key;
+    key.setKey(BACKBONE_KEY);
+    KNXSecureHeader header = {};
+    memcpy(header.serial, OWN_SERIAL, 6);
+
+    BenchLatency wrapLatency(COST_FRAMES);
+    BenchLatency unwrapLatency(COST_FRAMES);
+    BenchLatency rekeyLatency(COST_FRAMES);
+    uint64_t wrapWall = 0;
+    uint64_t unwrapWall = 0;
+    uint64_t rekeyWall = 0;
+    size_t failures = 0;
+    for (size_t i = 0; i < COST_FRAMES; i++) {
+        header.sequence = i;
+        uint64_t t0 = benchNowNs();
+        size_t wrappedLength = knxSecureWrap(key, header, frame, length, wrapped, sizeof(wrapped));
+        uint64_t t1 = benchNowNs();
+        KNXSecureHeader received;
+        size_t plainLength = knxSecureUnwrap(key, wrapped, wrappedLength, plain, sizeof(plain), received);
+        uint64_t t2 = benchNowNs();
+        KNXAes128 fresh;
+        fresh.setKey(BACKBONE_KEY);
+        knxSecureWrap(fresh, header, frame, length, wrapped, sizeof(wrapped));
+        uint64_t t3 = benchNowNs();
+        wrapLatency.add(t1 - t0);
+        unwrapLatency.add(t2 - t1);
+        rekeyLatency.add(t3 - t2);
+        wrapWall += t1 - t0;
+        unwrapWall += t2 - t1;
+        rekeyWall += t3 - t2;
+        if (plainLength != length || memcmp(plain, frame, length) != 0) failures++;
+    }
+    char label[64];
+    wrapLatency.setWallTime(wrapWall);
+    snprintf(label, sizeof(label), "secure wrap, %s (%zu bytes)", name, length);
+    wrapLatency.report(label);
+    unwrapLatency.setWallTime(unwrapWall);
+    snprintf(label, sizeof(label), "secure unwrap, %s", name);
+    unwrapLatency.report(label);
+    rekeyLatency.setWallTime(rekeyWall);
+    snprintf(label, sizeof(label), "  wrap with key setup, %s", name);
+    rekeyLatency.report(label);
+    if (failures > 0) benchFail("secure %s: %zu frames did not round-trip", name, failures);
+}
+
+void runHandshakeCost() {
+    BenchLatency latency(COST_HANDSHAKES);
+    uint8_t privateKey[32];
+    uint8_t publicKey[32];
+    uint8_t secret[32];
+    knxRandomBytes(privateKey, sizeof(privateKey));
+    uint64_t wall0 = benchNowNs();
+    for (size_t i = 0; i < COST_HANDSHAKES; i++) {
+        uint64_t t0 = benchNowNs();
+        knxX25519Base(publicKey, privateKey);
+        knxX25519(secret, privateKey, publicKey);
+        latency.add(benchNowNs() - t0);
+        privateKey[i % 32] ^= secret[0];
+    }
+    latency.setWallTime(benchNowNs() - wall0);
+    latency.report("secure session key agreement");
+}
+
+void runSecureBenchmark() {
+    checkPrimitives();
+    checkSessionVectors();
+    checkRouting();
+    checkTunnel();
+    runFrameCost("group write", 1);
+    runFrameCost("extended frame", KNX_CEMI_EXTENDED_APDU - 1);
+    runHandshakeCost();
+}
+
+} // namespace
+
+BENCH_SUITE("secure", runSecureBenchmark);
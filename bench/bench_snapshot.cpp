@@ -0,0 +1,195 @@
+//==== bench/bench_snapshot.cpp ====
+
+// Group state snapshot on a file-backed flash stand-in: persists the values of
+// 300 subscribed addresses, then "reboots" (new module and store on the same
+// file) and checks that begin restores them and hands them to the callbacks.
+// Also checks that flushes only write changed values, how evenly a long run
+// wears the sectors, and that a write cut short by power loss costs at most
+// the values of that flush. Time is simulated.
+
+#include "bench.h"
+#include "knx_file_flash.h"
+#include "knx_ip_module.h"
+#include <algorithm>
+#include <stdio.h>
+
+namespace {
+
+const size_t ADDRESSES = 300;
+const size_t FLASH_SIZE = 4 * 4096;
+const uint32_t INTERVAL_MS = 1000;
+const char* const PATH = P_tmpdir "/knx_snapshot_bench.bin";
+
+// Subscribed addresses are in main group 3; main group 4 is traffic we ignore
+uint16_t addressAt(size_t index) {
+    return (uint16_t)((3 << 11) | index);
+}
+
+uint8_t valueAt(size_t index, size_t round) {
+    return (uint8_t)(index * 13 + round);
+}
+
+void write(uint16_t groupAddress, uint8_t value) {
+    uint8_t frame[64];
+    const uint8_t payload[] = {value};
+    size_t length = benchRoutingFrame(frame, 0x1105, groupAddress, payload, sizeof(payload));
+    benchInject(frame, length);
+}
+
+// One boot of the device: cache, snapshot and a subscription to main group 3
+struct Node {
+    KNXFileFlash flash{PATH, FLASH_SIZE};
+    KNXIPModule module;
+    size_t notified = 0;
+    uint8_t latest[ADDRESSES] = {};
+
+    bool boot() {
+        module.setDebugLevel(0);
+        KNXGroupCacheConfig cache;
+        cache.capacity = 512;
+        module.enableGroupCache(cache);
+        KNXSnapshotConfig config;
+        config.intervalMs = INTERVAL_MS;
+        if (!module.enableSnapshot(flash, config)) return false;
+        module.onMainGroup(3, [this](const KNXTelegram& telegram) {
+            notified++;
+            latest[telegram.targetAddress & 0x7FF] = telegram.data[1];
+        });
+        return module.beginMulticast(1, 1, 10);
+    }
+
+    void idle(uint32_t ms) {
+        nativeAdvanceClock(ms);
+        module.loop();
+    }
+};
+
+// Compares the restored cache with the expected round of values; returns the
+// addresses that differ
+size_t verify(Node& node, const size_t* rounds) {
+    size_t wrong = 0;
+    for (size_t i = 0; i < ADDRESSES; i++) {
+        KNXCachedValue value;
+        if (!node.module.getCachedValue(addressAt(i), value) || value.length != 2 ||
+            value.data[1] != valueAt(i, rounds[i]) || value.count != 0) {
+            wrong++;
+        }
+    }
+    return wrong;
+}
+
+void runSnapshotBenchmark() {
+    remove(PATH);
+    size_t rounds[ADDRESSES] = {};
+
+    {
+        Node node;
+        if (!node.boot()) {
+            benchFail("snapshot not enabled");
+            return;
+        }
+        for (size_t i = 0; i < ADDRESSES; i++) write(addressAt(i), valueAt(i, 0));
+        for (size_t i = 0; i < 50; i++) write((uint16_t)((4 << 11) | i), 1);
+        node.idle(INTERVAL_MS);
+        KNXSnapshotStats first = node.module.getSnapshotStats();
+        benchNote("snapshot first flush", "%u records, %u bytes, %u checkpoints",
+            first.records, first.bytesWritten, first.checkpoints);
+        if (first.records != ADDRESSES || first.checkpoints != 1) {
+            benchFail("first flush wrote %u records", first.records);
+        }
+
+        // 20 values change, 20 are sent again unchanged
+        for (size_t i = 0; i < 20; i++) {
+            rounds[i] = 1;
+            write(addressAt(i), valueAt(i, 1));
+            write(addressAt(100 + i), valueAt(100 + i, 0));
+        }
+        node.idle(INTERVAL_MS);
+        KNXSnapshotStats second = node.module.getSnapshotStats();
+        benchNote("snapshot incremental flush", "%u records, %u bytes",
+            second.records - first.records, second.bytesWritten - first.bytesWritten);
+        if (second.records - first.records != 20 || second.checkpoints != 1) {
+            benchFail("incremental flush wrote %u records", second.records - first.records);
+        }
+    }
+
+    // Reboot
+    {
+        Node node;
+        uint64_t t0 = benchNowNs();
+        node.boot();
+        uint64_t bootNs = benchNowNs() - t0;
+        KNXSnapshotStats stats = node.module.getSnapshotStats();
+        size_t wrong = verify(node, rounds);
+        benchNote("snapshot restore", "%u records in %u us (begin %llu us), %zu callbacks",
+            stats.restored, stats.restoreMicros, (unsigned long long)(bootNs / 1000), node.notified);
+        size_t stale = 0;
+        for (size_t i = 0; i < ADDRESSES; i++) {
+            if (node.latest[i] != valueAt(i, rounds[i])) stale++;
+        }
+        if (wrong != 0 || node.notified != ADDRESSES || stale != 0) {
+            benchFail("restore: %zu wrong values, %zu callbacks, %zu stale", wrong, node.notified, stale);
+        }
+
+        // A long run: 30 values change between flushes
+        const size_t FLUSHES = 2000;
+        BenchLatency latency(FLUSHES);
+        for (size_t flush = 0; flush < FLUSHES; flush++) {
+            for (size_t j = 0; j < 30; j++) {
+                size_t i = (flush * 31 + j * 7) % ADDRESSES;
+                rounds[i]++;
+                write(addressAt(i), valueAt(i, rounds[i]));
+            }
+            nativeAdvanceClock(INTERVAL_MS);
+            uint64_t f0 = benchNowNs();
+            node.module.loop();
+            latency.add(benchNowNs() - f0);
+        }
+        latency.report("snapshot flush, 30 changed values");
+        stats = node.module.getSnapshotStats();
+        const std::vector<uint32_t>& erases = node.flash.eraseCounts();
+        uint32_t least = *std::min_element(erases.begin(), erases.end());
+        uint32_t most = *std::max_element(erases.begin(), erases.end());
+        benchNote("snapshot wear", "%zu flushes: %u checkpoints, erases per sector %u..%u, %llu bytes/flush",
+            FLUSHES, stats.checkpoints, least, most,
+            (unsigned long long)(node.flash.bytesWritten() / FLUSHES));
+        if (most - least > 1 || stats.skipped != 0 || stats.errors != 0) {
+            benchFail("wear: erases %u..%u, %u skipped, %u errors", least, most, stats.skipped, stats.errors);
+        }
+
+        // Power is lost in the middle of the fourth record (6 bytes each)
+        for (size_t i = 0; i < 10; i++) {
+            rounds[i]++;
+            write(addressAt(i), valueAt(i, rounds[i]));
+        }
+        node.flash.setWriteBudget(3 * 6 + 2);
+        node.idle(INTERVAL_MS);
+    }
+
+    {
+        Node node;
+        node.boot();
+        KNXSnapshotStats stats = node.module.getSnapshotStats();
+        // Three records made it, the other seven values of the flush are lost
+        size_t lost = 0;
+        for (size_t i = 0; i < ADDRESSES; i++) {
+            KNXCachedValue value;
+            if (!node.module.getCachedValue(addressAt(i), value) || value.data[1] != valueAt(i, rounds[i])) {
+                lost++;
+            }
+        }
+        node.idle(INTERVAL_MS);
+        KNXSnapshotStats after = node.module.getSnapshotStats();
+        benchNote("snapshot power loss", "%zu of 10 values lost, torn record %s, new sector after %u records",
+            lost, stats.errors ? "detected" : "missed", after.records);
+        if (lost != 7 || stats.errors != 1 || after.checkpoints != 1 || after.records != ADDRESSES) {
+            benchFail("power loss: %zu values lost, %u errors, %u checkpoints", lost, stats.errors,
+                after.checkpoints);
+        }
+    }
+    remove(PATH);
+}
+
+} // namespace
+
+BENCH_SUITE("snapshot", runSnapshotBenchmark);
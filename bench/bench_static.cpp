@@ -0,0 +1,114 @@
+//==== bench/bench_static.cpp ====
+
+// Memory profile of a fully configured module: counts heap allocations while
+// the components are enabled, callbacks registered, traffic handled and the
+// module torn down, and prints the RAM report. Built with
+// KNX_STATIC_ALLOCATION (env:native_static) every stage must stay off the
+// heap, except begin, whose AsyncUDP sockets are outside the stack; the
+// heap profile only reports the counts. Background tasks are left off, as
+// they are std::threads on the host.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include "native_heap.h"
+
+namespace {
+
+const size_t GROUPS = 48;
+const size_t FRAMES = 20000;
+
+uint16_t groupAddressAt(size_t index) {
+    return (uint16_t)((2 << 11) | (1 << 8) | index);
+}
+
+// Heap allocations of one stage; a failure in the static profile
+void checkStage(const char* stage, uint64_t allocations, bool covered = true) {
+    benchNote(stage, "%llu heap allocations%s", (unsigned long long)allocations,
+        covered ? "" : " (outside the stack)");
+    if (KNX_STATIC_ALLOCATION && covered && allocations != 0) {
+        benchFail("%s allocated %llu times in the static profile", stage, (unsigned long long)allocations);
+    }
+}
+
+void runStaticBenchmark() {
+    KNXMemoryStats idle = knxMemoryStats();
+    size_t received = 0;
+    {
+        KNXIPModule module;
+        module.setDebugLevel(0);
+
+        uint64_t before = nativeHeapAllocations();
+        KNXGroupCacheConfig cache;
+        cache.capacity = 128;
+        bool enabled = module.enableGroupCache(cache);
+        enabled &= module.enableTxQueue();
+        enabled &= module.enableDedup();
+        enabled &= module.enableGroupReads();
+        KNXTraceConfig trace;
+        trace.drainTask = false;
+        enabled &= module.enableTrace(trace);
+        KNXCaptureConfig capture;
+        capture.bufferSize = 4096;
+        enabled &= module.enableCapture(capture);
+        checkStage("static enable", nativeHeapAllocations() - before);
+        if (!enabled) benchFail("a component could not be enabled");
+
+        before = nativeHeapAllocations();
+        for (size_t i = 0; i < GROUPS; i++) {
+            module.onGroupAddress(groupAddressAt(i), [&received](const KNXTelegram&) { received++; });
+        }
+        module.onGroupValue<KNXDpt<9, 1>>(groupAddressAt(0), [](float, const KNXTelegram&) {});
+        module.onMainGroup(3, [&received](const KNXTelegram&) { received++; });
+        checkStage("static callbacks", nativeHeapAllocations() - before);
+
+        before = nativeHeapAllocations();
+        module.beginMulticast(1, 1, 10);
+        checkStage("static begin", nativeHeapAllocations() - before, false);
+
+        before = nativeHeapAllocations();
+        uint8_t frame[64];
+        const uint8_t payload[] = {0x0C, 0x65};
+        for (size_t i = 0; i < FRAMES; i++) {
+            size_t length = benchRoutingFrame(frame, (uint16_t)(0x1100 + i % 7),
+                groupAddressAt(i % GROUPS), payload, sizeof(payload));
+            benchInject(frame, length);
+            if (i % 100 == 0) {
+                module.send<KNXDpt<9, 1>>(groupAddressAt(i % GROUPS), 21.5f);
+                module.readGroupValue(groupAddressAt((i / 100) % GROUPS));
+                nativeAdvanceClock(50);
+                module.loop();
+            }
+        }
+        checkStage("static traffic", nativeHeapAllocations() - before);
+        if (received != FRAMES) benchFail("static traffic: %zu of %zu frames dispatched", received, FRAMES);
+
+        // The harness silences Serial; the report is part of the results
+        Serial.setOutputEnabled(true);
+        module.printRamReport(Serial);
+        Serial.setOutputEnabled(false);
+        KNXRamReport report = module.getRamReport();
+        if (report.buffers.blocks == 0 || report.buffers.failures != idle.failures) {
+            benchFail("RAM report: %u blocks, %u failures", report.buffers.blocks, report.buffers.failures);
+        }
+
+#if KNX_STATIC_ALLOCATION
+        // The callback table is fixed: registrations past it are refused
+        size_t refused = 0;
+        for (size_t i = 0; i < KNX_MAX_CALLBACKS; i++) {
+            if (!module.onGroupAddress((4 << 11) | i, [](const KNXTelegram&) {})) refused++;
+        }
+        benchNote("static callback table", "%zu of %u registrations refused", refused,
+            (unsigned)KNX_MAX_CALLBACKS);
+        if (refused != GROUPS + 1) benchFail("callback table refused %zu registrations", refused);
+#endif
+    }
+    KNXMemoryStats after = knxMemoryStats();
+    if (after.blocks != idle.blocks || after.used != idle.used) {
+        benchFail("teardown left %u blocks (%u bytes) of the stack", after.blocks - idle.blocks,
+            after.used - idle.used);
+    }
+}
+
+} // namespace
+
+BENCH_SUITE("static", runStaticBenchmark);
@@ -0,0 +1,177 @@
+//==== bench/bench_stats.cpp ====
+
+// Performance counters: cost of the instrumentation on the receive path,
+// per-stage latency percentiles as the module itself measured them, counter
+// accounting for good, filtered, malformed and unknown datagrams and for
+// failed sends, and the UDP stats endpoint in both reply formats.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t FRAMES = 100000;
+const uint16_t STATS_PORT = 3700;
+
+void reportStage(const KNXStats& stats, KNXStatsStage stage, const char* name) {
+    const KNXLatencyHistogram& histogram = stats.stages[stage];
+    double perUs = stats.cyclesPerMicrosecond;
+    double mean = histogram.count ? (double)histogram.totalCycles / histogram.count : 0;
+    benchNote(name, "%u samples, mean %.2f us, p50 <%.2f us, p99 <%.2f us, max %.2f us",
+        histogram.count, mean / perUs, histogram.percentileCycles(0.5f) / perUs,
+        histogram.percentileCycles(0.99f) / perUs, histogram.maxCycles / perUs);
+}
+
+void measureStages() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    uint32_t calls = 0;
+    module.onMainGroup(1, [&calls](const KNXTelegram&) { calls++; });
+    module.beginMulticast(1, 1, 10);
+    AsyncUDPLoopback::setMulticastLoop(false);
+
+    const uint8_t payload[] = {0x0C, 0x65};
+    uint8_t frame[64];
+    BenchLatency latency(FRAMES);
+    for (size_t i = 0; i < FRAMES; i++) {
+        // Every other frame goes to an address nobody subscribed to
+        uint16_t group = (uint16_t)(((1 + (i & 1)) << 11) | (i & 0x7FF));
+        size_t length = benchRoutingFrame(frame, 0x1105, group, payload, sizeof(payload));
+        uint64_t t0 = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - t0);
+    }
+    for (size_t i = 0; i < FRAMES / 10; i++) {
+        module.send<KNXDpt<9, 1>>((1 << 11) | 1, 21.5f);
+    }
+    AsyncUDPLoopback::discardPending();
+    AsyncUDPLoopback::setMulticastLoop(true);
+
+    KNXStats stats = module.getStats();
+    latency.report("rx with stats");
+    reportStage(stats, KNX_STAGE_RECEIVE, "  stage receive");
+    reportStage(stats, KNX_STAGE_PARSE, "  stage parse");
+    reportStage(stats, KNX_STAGE_CALLBACKS, "  stage callbacks");
+    reportStage(stats, KNX_STAGE_SEND, "  stage send");
+
+    if (stats.packetsReceived != FRAMES || stats.telegramsFiltered != FRAMES / 2 ||
+        stats.telegramsParsed != FRAMES / 2 || stats.telegramsDispatched != FRAMES / 2 ||
+        calls != FRAMES / 2) {
+        benchFail("stats: %u received, %u filtered, %u parsed, %u dispatched, %u callbacks",
+            stats.packetsReceived, stats.telegramsFiltered, stats.telegramsParsed,
+            stats.telegramsDispatched, calls);
+    }
+    if (stats.telegramsSent != FRAMES / 10 || stats.stages[KNX_STAGE_SEND].count != FRAMES / 10) {
+        benchFail("stats: %u sent, %u send samples", stats.telegramsSent, stats.stages[KNX_STAGE_SEND].count);
+    }
+    if (stats.stages[KNX_STAGE_RECEIVE].count != FRAMES || stats.stages[KNX_STAGE_PARSE].count != FRAMES / 2) {
+        benchFail("stats: stage sample counts do not match the frame counts");
+    }
+}
+
+void checkErrorCounters() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.onMainGroup(1, [](const KNXTelegram&) {});
+    module.beginMulticast(1, 1, 10);
+
+    // Not KNXnet/IP at all
+    const uint8_t garbage[] = {0xDE, 0xAD, 0xBE, 0xEF, 0x00, 0x10, 0x00};
+    benchInject(garbage, sizeof(garbage));
+
+    // Valid header, service this module does not handle
+    uint8_t unknown[8];
+    knxWriteHeader(unknown, 0x0950, sizeof(unknown));
+    unknown[6] = unknown[7] = 0;
+    benchInject(unknown, sizeof(unknown));
+
+    // Subscribed address, APDU length beyond the end of the datagram
+    uint8_t frame[64];
+    const uint8_t payload[] = {0x0C, 0x65};
+    size_t length = benchRoutingFrame(frame, 0x1105, (1 << 11) | 4, payload, sizeof(payload));
+    benchInject(frame, length - 1);
+
+    // Too long even for an extended frame
+    uint8_t oversized[KNX_CEMI_EXTENDED_APDU + 1] = {0x80};
+    bool sent = module.sendKNXMessage((1 << 11) | 4, oversized, sizeof(oversized));
+
+    KNXStats stats = module.getStats();
+    benchNote("stats error counters", "%u invalid, %u unknown, %u parse errors, %u send failures",
+        stats.packetsInvalid, stats.unknownServices, stats.parseErrors, stats.sendFailures);
+    if (stats.packetsReceived != 3 || stats.packetsInvalid != 1 || stats.unknownServices != 1 ||
+        stats.parseErrors != 1 || stats.sendFailures != 1 || sent) {
+        benchFail("stats error counters do not match the injected datagrams");
+    }
+
+    module.resetStats();
+    stats = module.getStats();
+    if (stats.packetsReceived != 0 || stats.stages[KNX_STAGE_RECEIVE].count != 0 ||
+        stats.cyclesPerMicrosecond == 0) {
+        benchFail("resetStats left counters behind");
+    }
+}
+
+// Sends a request to the stats endpoint and returns the reply
+std::vector<uint8_t> queryEndpoint() {
+    std::vector<uint8_t> reply;
+    AsyncUDPLoopback::setTap([&reply](const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port) {
+        if (ip == IPAddress(192, 168, 1, 77) && port == 40000) reply.assign(data, data + length);
+    });
+    const uint8_t request[] = {'?'};
+    AsyncUDPLoopback::deliver(request, sizeof(request), IPAddress(192, 168, 1, 77), 40000,
+                              IPAddress(127, 0, 0, 1), STATS_PORT);
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+    return reply;
+}
+
+uint32_t read32(const uint8_t* data) {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+void checkEndpoint() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.onMainGroup(1, [](const KNXTelegram&) {});
+    module.beginMulticast(1, 1, 10);
+
+    uint8_t frame[64];
+    const uint8_t payload[] = {0x0C, 0x65};
+    size_t length = benchRoutingFrame(frame, 0x1105, (1 << 11) | 4, payload, sizeof(payload));
+    for (int i = 0; i < 7; i++) benchInject(frame, length);
+
+    if (!module.enableStatsEndpoint(STATS_PORT)) {
+        benchFail("stats endpoint did not start");
+        return;
+    }
+    std::vector<uint8_t> json = queryEndpoint();
+    std::string text(json.begin(), json.end());
+    benchNote("stats endpoint json", "%zu bytes", json.size());
+    if (text.find("\"packetsReceived\":7,") == std::string::npos ||
+        text.find("\"callbacks\":{\"count\":7,") == std::string::npos ||
+        text.front() != '{' || text.back() != '}') {
+        benchFail("stats endpoint JSON: %s", text.c_str());
+    }
+
+    module.enableStatsEndpoint(STATS_PORT, KNX_STATS_BINARY);
+    std::vector<uint8_t> binary = queryEndpoint();
+    benchNote("stats endpoint binary", "%zu bytes", binary.size());
+    // Header, then cyclesPerMicrosecond and packetsReceived
+    if (binary.size() < 16 || memcmp(binary.data(), "KNXS", 4) != 0 || binary[4] != 2 ||
+        read32(&binary[8]) != knxCyclesPerMicrosecond() || read32(&binary[12]) != 7) {
+        benchFail("stats endpoint binary reply malformed (%zu bytes)", binary.size());
+    }
+
+    module.disableStatsEndpoint();
+    if (!queryEndpoint().empty()) benchFail("stats endpoint answered after disable");
+}
+
+void runStatsBenchmark() {
+    measureStages();
+    checkErrorCounters();
+    checkEndpoint();
+}
+
+} // namespace
+
+BENCH_SUITE("stats", runStatsBenchmark);
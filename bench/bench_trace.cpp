@@ -0,0 +1,125 @@
+//==== bench/bench_trace.cpp ====
+
+// Debug output cost on the receive path: debug level 2 printing through
+// Serial versus recording into the trace buffer. Serial bytes per frame give
+// the frame rate a 115200 baud console would allow. Also checks the overflow
+// accounting and that the drain task prints every record it was given.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <atomic>
+
+namespace {
+
+const size_t FRAMES = 50000;
+const double SERIAL_BYTES_PER_SECOND = 115200 / 10.0; // 8N1
+
+// Counts lines and bytes instead of printing them
+class CountingPrint : public Print {
+public:
+    size_t write(uint8_t c) override {
+        bytes++;
+        if (c == '\n') lines++;
+        return 1;
+    }
+    std::atomic<size_t> lines{0};
+    std::atomic<size_t> bytes{0};
+};
+
+BenchLatency injectFrames(size_t frames) {
+    const uint8_t payload[] = {0x0C, 0x65};
+    uint8_t frame[64];
+    BenchLatency latency(frames);
+    uint64_t wallStart = benchNowNs();
+    for (size_t i = 0; i < frames; i++) {
+        uint16_t group = (uint16_t)((1 << 11) | (2 << 8) | (i & 0xFF));
+        size_t length = benchRoutingFrame(frame, 0x1105, group, payload, sizeof(payload));
+        uint64_t t0 = benchNowNs();
+        benchInject(frame, length);
+        latency.add(benchNowNs() - t0);
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    return latency;
+}
+
+void runSerialBaseline() {
+    KNXIPModule module;
+    module.setDebugLevel(2);
+    module.beginMulticast(1, 1, 10);
+
+    uint64_t bytesBefore = Serial.bytesWritten();
+    BenchLatency latency = injectFrames(FRAMES);
+    double bytesPerFrame = (double)(Serial.bytesWritten() - bytesBefore) / FRAMES;
+
+    latency.report("rx debug 2, Serial");
+    benchNote("  console", "%.0f bytes/frame, 115200 baud limits rx to %.0f frames/s",
+        bytesPerFrame, SERIAL_BYTES_PER_SECOND / bytesPerFrame);
+}
+
+void runTraceRecording() {
+    KNXIPModule module;
+    module.setDebugLevel(2);
+    KNXTraceConfig config;
+    config.capacity = 256;
+    config.drainTask = false;
+    module.enableTrace(config);
+    module.beginMulticast(1, 1, 10);
+
+    uint64_t bytesBefore = Serial.bytesWritten();
+    BenchLatency latency = injectFrames(FRAMES);
+    uint64_t serialBytes = Serial.bytesWritten() - bytesBefore;
+    KNXTraceStats stats = module.getTraceStats();
+
+    latency.report("rx debug 2, trace buffer");
+    benchNote("  trace", "%u recorded, %u overflows, %u waiting, %llu Serial bytes",
+        stats.recorded, stats.overflows, stats.depth, (unsigned long long)serialBytes);
+
+    // One datagram and one telegram record per frame
+    if (stats.recorded + stats.overflows != 2 * FRAMES || stats.depth != config.capacity) {
+        benchFail("trace accounting: %u recorded + %u overflows for %zu records",
+            stats.recorded, stats.overflows, 2 * FRAMES);
+    }
+    if (serialBytes != 0) benchFail("trace mode printed %llu bytes", (unsigned long long)serialBytes);
+
+    // On-demand dump prints the oldest records and then the loss count
+    CountingPrint sink;
+    size_t printed = module.dumpTrace(sink);
+    if (printed != config.capacity || sink.lines != printed + 1) {
+        benchFail("dump printed %zu records in %zu lines", printed, sink.lines.load());
+    }
+}
+
+void runDrainTask() {
+    CountingPrint sink;
+    KNXIPModule module;
+    module.setDebugLevel(1);
+    module.onMainGroup(1, [](const KNXTelegram&) {});
+    KNXTraceConfig config;
+    config.capacity = 4096;
+    config.output = &sink;
+    module.enableTrace(config);
+    module.beginMulticast(1, 1, 10);
+
+    const size_t DRAINED_FRAMES = 2000;
+    injectFrames(DRAINED_FRAMES);
+    for (int i = 0; i < 200 && module.getTraceStats().depth > 0; i++) delay(5);
+    delay(5);
+    KNXTraceStats stats = module.getTraceStats();
+    module.disableTrace();
+
+    benchNote("trace drain task", "%zu lines, %zu bytes for %u records",
+        sink.lines.load(), sink.bytes.load(), stats.recorded);
+    if (stats.recorded != DRAINED_FRAMES || stats.overflows != 0 || sink.lines != DRAINED_FRAMES) {
+        benchFail("drain task printed %zu of %u records", sink.lines.load(), stats.recorded);
+    }
+}
+
+void runTraceBenchmark() {
+    runSerialBaseline();
+    runTraceRecording();
+    runDrainTask();
+}
+
+} // namespace
+
+BENCH_SUITE("trace", runTraceBenchmark);
@@ -0,0 +1,244 @@
+//==== bench/bench_tunnel.cpp ====
+
+// Tunnelling client against the gateway simulator: connection setup, send
+// throughput with one and with several requests in flight, retransmission
+// when ACKs get lost, inbound indications (including repeats), heartbeats and
+// reconnection after the gateway goes silent. Time is simulated, one
+// millisecond per pump step.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t TELEGRAMS = 2000;
+const uint16_t GROUP = (1 << 11) | (2 << 8) | 3;
+
+void pump(KNXIPModule& module, KNXGatewaySim& gateway, uint32_t ms) {
+    for (uint32_t i = 0; i < ms; i++) {
+        nativeAdvanceClock(1);
+        gateway.poll(millis());
+        AsyncUDPLoopback::poll();
+        module.loop();
+        AsyncUDPLoopback::poll();
+    }
+}
+
+bool connect(KNXIPModule& module, KNXGatewaySim& gateway, const KNXTunnelConfig& config) {
+    module.setDebugLevel(0);
+    module.setTunnelConfig(config);
+    if (!module.begin(gateway.address(), 1, 1, 10)) return false;
+    for (int i = 0; i < 100 && !module.isConnected(); i++) pump(module, gateway, 1);
+    return module.isConnected();
+}
+
+// The value carried by telegram i; the gateway checks order and completeness
+uint8_t valueOf(size_t i) {
+    return (uint8_t)(i * 7);
+}
+
+bool checkFrames(const KNXGatewaySim& gateway, size_t count, const char* name) {
+    if (gateway.frames.size() != count) {
+        benchFail("%s: gateway received %zu of %zu telegrams", name, gateway.frames.size(), count);
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const std::vector<uint8_t>& frame = gateway.frames[i];
+        if (frame.size() != 12 || frame[0] != KNX_CEMI_L_DATA_REQ || frame[11] != valueOf(i)) {
+            benchFail("%s: telegram %zu lost, repeated or reordered", name, i);
+            return false;
+        }
+        uint16_t source = (frame[4] << 8) | frame[5];
+        if (source != KNXGatewaySim::TUNNEL_ADDRESS) {
+            benchFail("%s: source 0x%04X is not the tunnel address", name, source);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sends TELEGRAMS group writes as fast as the client accepts them and returns
+// the simulated time until the last one was acknowledged.
+uint32_t sendAll(KNXIPModule& module, KNXGatewaySim& gateway, BenchLatency& latency) {
+    uint32_t start = (uint32_t)millis();
+    size_t next = 0;
+    while (next < TELEGRAMS) {
+        uint64_t t0 = benchNowNs();
+        bool accepted = module.send<KNXDpt<5, 10>>(GROUP, valueOf(next));
+        if (accepted) {
+            latency.add(benchNowNs() - t0);
+            next++;
+        } else {
+            pump(module, gateway, 1);
+        }
+    }
+    while (module.getTunnelStats().backlog > 0 && millis() - start < 600000) {
+        pump(module, gateway, 1);
+    }
+    return (uint32_t)millis() - start;
+}
+
+void runThroughput(uint8_t window) {
+    KNXGatewaySim gateway;
+    gateway.setAckDelay(5);
+    KNXIPModule module;
+    KNXTunnelConfig config;
+    config.window = window;
+    if (!connect(module, gateway, config)) {
+        benchFail("window %u: no connection", window);
+        return;
+    }
+
+    BenchLatency latency(TELEGRAMS);
+    uint64_t wall0 = benchNowNs();
+    uint32_t elapsed = sendAll(module, gateway, latency);
+    latency.setWallTime(benchNowNs() - wall0);
+    KNXTunnelStats stats = module.getTunnelStats();
+
+    char name[48];
+    snprintf(name, sizeof(name), "tunnel send (window %u)", window);
+    latency.report(name);
+    benchNote("  simulated", "%zu telegrams in %u ms at 5 ms ACK latency: %.0f telegrams/s, %u in flight max",
+        TELEGRAMS, elapsed, TELEGRAMS * 1000.0 / elapsed, gateway.maxOutstanding);
+
+    checkFrames(gateway, TELEGRAMS, name);
+    if (stats.sent != TELEGRAMS || stats.retransmits != 0) {
+        benchFail("%s: sent %u retransmits %u", name, stats.sent, stats.retransmits);
+    }
+    if (gateway.maxOutstanding > window) {
+        benchFail("%s: %u requests outstanding", name, gateway.maxOutstanding);
+    }
+}
+
+void runRetransmit() {
+    KNXGatewaySim gateway;
+    gateway.setDropAckEvery(10);
+    KNXIPModule module;
+    KNXTunnelConfig config;
+    config.window = 4;
+    if (!connect(module, gateway, config)) {
+        benchFail("retransmit: no connection");
+        return;
+    }
+
+    BenchLatency latency(TELEGRAMS);
+    uint32_t elapsed = sendAll(module, gateway, latency);
+    KNXTunnelStats stats = module.getTunnelStats();
+    benchNote("tunnel lost ACKs", "%u ACKs dropped, %u retransmits, %u repeats seen, %u ms",
+        gateway.acksDropped, stats.retransmits, gateway.repeats, elapsed);
+
+    checkFrames(gateway, TELEGRAMS, "retransmit");
+    if (stats.retransmits == 0 || stats.retransmits != gateway.repeats) {
+        benchFail("retransmit: %u retransmits but %u repeats", stats.retransmits, gateway.repeats);
+    }
+    if (stats.disconnects != 0) benchFail("retransmit: connection dropped");
+}
+
+void runInbound() {
+    KNXGatewaySim gateway;
+    KNXIPModule module;
+    uint32_t received = 0;
+    uint8_t lastValue = 0;
+    bool ordered = true;
+    module.onGroupAddress(GROUP, [&](const KNXTelegram& telegram) {
+        if (telegram.data.size() == 2) {
+            if (received > 0 && telegram.data[1] != (uint8_t)(lastValue + 1)) ordered = false;
+            lastValue = telegram.data[1];
+        }
+        received++;
+    });
+    if (!connect(module, gateway, KNXTunnelConfig())) {
+        benchFail("inbound: no connection");
+        return;
+    }
+
+    const uint32_t INDICATIONS = 1000;
+    uint32_t repeated = 0;
+    BenchLatency latency(INDICATIONS);
+    for (uint32_t i = 0; i < INDICATIONS; i++) {
+        const uint8_t payload[] = {0x80, (uint8_t)i};
+        gateway.indicate(GROUP, payload, sizeof(payload));
+        if (i % 10 == 0) {
+            gateway.repeatLast();
+            repeated++;
+        }
+        uint64_t t0 = benchNowNs();
+        AsyncUDPLoopback::poll();
+        latency.add(benchNowNs() - t0);
+    }
+    pump(module, gateway, 1);
+    KNXTunnelStats stats = module.getTunnelStats();
+
+    latency.report("tunnel receive (ind + ACK)");
+    if (received != INDICATIONS || !ordered) {
+        benchFail("inbound: %u callbacks for %u indications", received, INDICATIONS);
+    }
+    if (stats.duplicates != repeated) {
+        benchFail("inbound: %u duplicates detected, %u sent", stats.duplicates, repeated);
+    }
+    if (gateway.acksReceived != INDICATIONS + repeated) {
+        benchFail("inbound: %u ACKs for %u requests", gateway.acksReceived, INDICATIONS + repeated);
+    }
+}
+
+void runHeartbeatAndReconnect() {
+    KNXGatewaySim gateway;
+    KNXIPModule module;
+    if (!connect(module, gateway, KNXTunnelConfig())) {
+        benchFail("heartbeat: no connection");
+        return;
+    }
+
+    // Two heartbeat intervals with a healthy gateway
+    nativeAdvanceClock(60000);
+    pump(module, gateway, 10);
+    nativeAdvanceClock(60000);
+    pump(module, gateway, 10);
+    if (gateway.heartbeats != 2 || !module.isConnected()) {
+        benchFail("heartbeat: %u heartbeats answered", gateway.heartbeats);
+    }
+
+    // Gateway goes silent: three unanswered heartbeats end the connection
+    gateway.setSilent(true);
+    uint32_t silentSince = millis();
+    while (module.isConnected() && millis() - silentSince < 200000) {
+        pump(module, gateway, 100);
+    }
+    uint32_t detection = millis() - silentSince;
+    if (module.isConnected()) {
+        benchFail("heartbeat: silent gateway not detected");
+        return;
+    }
+
+    // Telegrams sent meanwhile are held back and delivered after reconnecting
+    module.send<KNXDpt<5, 10>>(GROUP, valueOf(0));
+    gateway.setSilent(false);
+    uint32_t lostAt = millis();
+    while (!module.isConnected() && millis() - lostAt < 60000) {
+        pump(module, gateway, 100);
+    }
+    pump(module, gateway, 10);
+    KNXTunnelStats stats = module.getTunnelStats();
+    benchNote("tunnel failover", "loss detected after %u ms, reconnected after %u ms, %u connects",
+        detection, (uint32_t)millis() - lostAt, stats.connects);
+
+    if (!module.isConnected() || stats.connects != 2 || stats.disconnects != 1) {
+        benchFail("reconnect: connected %d, %u connects, %u disconnects",
+            module.isConnected(), stats.connects, stats.disconnects);
+    }
+    checkFrames(gateway, 1, "reconnect");
+}
+
+void runTunnelBenchmark() {
+    runThroughput(1);
+    runThroughput(4);
+    runRetransmit();
+    runInbound();
+    runHeartbeatAndReconnect();
+    AsyncUDPLoopback::discardPending();
+}
+
+} // namespace
+
+BENCH_SUITE("tunnel", runTunnelBenchmark);
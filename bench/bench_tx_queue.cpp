@@ -0,0 +1,215 @@
+//==== bench/bench_tx_queue.cpp ====
+
+// Transmit scheduler: a controller hammers a handful of dimmer addresses far
+// faster than a TP line can carry. Reports enqueue latency, how many telegrams
+// actually went out and checks that pacing, coalescing (latest value wins)
+// and priority ordering hold, that reads and responses queued among writes
+// to the same address are neither merged nor overwritten, and that writes
+// wait in the queue while the tunnel is not connected.
+
+#include "bench.h"
+#include "knx_gateway_sim.h"
+#include "knx_ip_module.h"
+
+namespace {
+
+const size_t UPDATES = 100000;
+const size_t DIMMERS = 8;
+const uint16_t RATE = 50;
+const uint16_t ALARM_GROUP = (7 << 11) | 1;
+
+struct Capture {
+    uint32_t frames = 0;
+    uint8_t lastValue[DIMMERS] = {};
+    bool alarmSeen = false;
+    uint32_t framesBeforeAlarm = 0;
+};
+
+uint16_t dimmerGroup(size_t index) {
+    return (uint16_t)((2 << 11) | (1 << 8) | (index + 1));
+}
+
+void checkMixedServices() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    KNXTxQueueConfig config;
+    config.telegramsPerSecond = 10;
+    config.burst = 1;
+    module.enableTxQueue(config);
+
+    const uint16_t group = dimmerGroup(0);
+    uint8_t apci[8];
+    size_t frames = 0;
+    AsyncUDPLoopback::setTap([&](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        if (length >= 17 && ((data[12] << 8) | data[13]) == group && frames < sizeof(apci)) {
+            apci[frames++] = data[16];
+        }
+    });
+
+    // The first write uses up the burst; the rest wait. The answer to a read
+    // of an owned address and a read of our own come between two writes.
+    const uint8_t first[] = {0x81}, pending[] = {0x81}, response[] = {0x41}, read[] = {0x00},
+        latest[] = {0x80};
+    module.sendKNXMessage(group, first, 1);
+    module.sendKNXMessage(group, pending, 1);
+    module.sendKNXMessage(group, response, 1);
+    module.sendKNXMessage(group, read, 1);
+    module.sendKNXMessage(group, latest, 1);
+    for (int i = 0; i < 20 && module.getTxQueueStats().depth > 0; i++) {
+        nativeAdvanceClock(100);
+        module.loop();
+    }
+    KNXTxQueueStats stats = module.getTxQueueStats();
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+
+    // The later write replaces the pending one in its place
+    const uint8_t expected[] = {0x81, 0x80, 0x41, 0x00};
+    bool ordered = frames == sizeof(expected) && memcmp(apci, expected, sizeof(expected)) == 0;
+    benchNote("  mixed services", "%zu telegrams, %u coalesced", frames, stats.coalesced);
+    if (!ordered || stats.coalesced != 1) {
+        benchFail("write, response and read to one address: %zu telegrams, %u coalesced", frames,
+            stats.coalesced);
+    }
+}
+
+// More writes than the tunnel backlog holds, queued before the gateway
+// answers: they stay queued and coalescing, and all reach the gateway once
+// the tunnel connects
+void checkTunnelWait() {
+    const size_t ADDRESSES = 12;
+    KNXGatewaySim gateway;
+    gateway.setSilent(true);
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.enableTxQueue();
+    module.begin(gateway.address(), 1, 1, 10);
+    auto pump = [&](uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            nativeAdvanceClock(1);
+            gateway.poll(millis());
+            AsyncUDPLoopback::poll();
+            module.loop();
+            AsyncUDPLoopback::poll();
+        }
+    };
+
+    for (size_t i = 0; i < ADDRESSES; i++) module.sendPercentage(dimmerGroup(i), 10);
+    for (uint8_t value = 20; value <= 60; value += 10) module.sendPercentage(dimmerGroup(0), value);
+    pump(1000);
+    KNXTxQueueStats waiting = module.getTxQueueStats();
+    KNXStats moduleStats = module.getStats();
+    if (waiting.depth != ADDRESSES || waiting.sent != 0 || waiting.coalesced != 5 ||
+        moduleStats.telegramsSent != 0 || moduleStats.sendFailures != 0) {
+        benchFail("tunnel down: depth %u, sent %u, coalesced %u; module sent %u, failed %u", waiting.depth,
+            waiting.sent, waiting.coalesced, moduleStats.telegramsSent, moduleStats.sendFailures);
+    }
+
+    gateway.setSilent(false);
+    for (int i = 0; i < 30000 && (module.getTxQueueStats().depth > 0 || gateway.frames.size() < ADDRESSES); i++) {
+        pump(1);
+    }
+    KNXTxQueueStats stats = module.getTxQueueStats();
+    uint8_t latest[KNXDpt<5, 1>::LENGTH];
+    KNXDpt<5, 1>::encode(60, latest);
+    bool latestSent = false;
+    for (const std::vector<uint8_t>& frame : gateway.frames) {
+        if (frame.size() > 10 && ((frame[6] << 8) | frame[7]) == dimmerGroup(0)) {
+            latestSent = frame.back() == latest[1];
+        }
+    }
+    benchNote("  tunnel wait", "%zu telegrams queued while connecting, %zu at the gateway, %u dropped",
+        ADDRESSES, gateway.frames.size(), stats.dropped);
+    if (gateway.frames.size() != ADDRESSES || stats.sent != ADDRESSES || stats.dropped != 0 || !latestSent) {
+        benchFail("after connecting: %zu at the gateway, %u sent, %u dropped", gateway.frames.size(),
+            stats.sent, stats.dropped);
+    }
+}
+
+void runTxQueueBenchmark() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+
+    KNXTxQueueConfig config;
+    config.capacity = 32;
+    config.telegramsPerSecond = RATE;
+    config.burst = 2;
+    module.enableTxQueue(config);
+
+    Capture capture;
+    AsyncUDPLoopback::setTap([&capture](const uint8_t* data, size_t length, const IPAddress&, uint16_t) {
+        // cEMI starts after the 6-byte header of a routing indication
+        if (length < 17) return;
+        uint16_t dst = (data[12] << 8) | data[13];
+        capture.frames++;
+        if (dst == ALARM_GROUP) {
+            capture.alarmSeen = true;
+            return;
+        }
+        if (!capture.alarmSeen) capture.framesBeforeAlarm++;
+        for (size_t i = 0; i < DIMMERS; i++) {
+            if (dst == dimmerGroup(i)) capture.lastValue[i] = data[length - 1];
+        }
+    });
+
+    // Simulated one second of a controller updating every dimmer constantly
+    BenchLatency latency(UPDATES);
+    uint8_t finalValue[DIMMERS] = {};
+    unsigned long start = millis();
+    for (size_t i = 0; i < UPDATES; i++) {
+        size_t dimmer = i % DIMMERS;
+        uint8_t value = (uint8_t)((i / DIMMERS) % 101);
+        uint8_t encoded[KNXDpt<5, 1>::LENGTH];
+        KNXDpt<5, 1>::encode(value, encoded);
+        finalValue[dimmer] = encoded[1];
+        uint64_t t0 = benchNowNs();
+        module.sendPercentage(dimmerGroup(dimmer), value);
+        latency.add(benchNowNs() - t0);
+        if (i % (UPDATES / 100) == 0) {
+            nativeAdvanceClock(10);
+            module.loop();
+        }
+    }
+
+    // An alarm queued behind pending low-priority writes must go out first
+    const uint8_t alarm[] = {0x81};
+    module.sendKNXMessage(ALARM_GROUP, alarm, sizeof(alarm), KNX_PRIORITY_URGENT);
+    uint32_t framesWhenAlarmQueued = capture.frames;
+
+    // Drain
+    for (int i = 0; i < 200 && module.getTxQueueStats().depth > 0; i++) {
+        nativeAdvanceClock(20);
+        module.loop();
+    }
+    unsigned long elapsed = millis() - start;
+    KNXTxQueueStats stats = module.getTxQueueStats();
+    AsyncUDPLoopback::setTap(nullptr);
+    AsyncUDPLoopback::discardPending();
+
+    latency.report("tx enqueue (coalescing, paced)");
+    benchNote("  tx queue", "queued %u coalesced %u sent %u dropped %u high-water %u/%u",
+        stats.queued, stats.coalesced, stats.sent, stats.dropped, stats.highWater, stats.capacity);
+    benchNote("  on the wire", "%u telegrams in %lu ms for %zu updates", capture.frames, elapsed, UPDATES);
+
+    uint32_t budget = (uint32_t)(elapsed * RATE / 1000) + config.burst + 1;
+    if (capture.frames > budget) benchFail("%u telegrams exceed the %u budget", capture.frames, budget);
+    for (size_t i = 0; i < DIMMERS; i++) {
+        if (capture.lastValue[i] != finalValue[i]) {
+            benchFail("dimmer %zu ended at %u, expected %u", i, capture.lastValue[i], finalValue[i]);
+        }
+    }
+    if (!capture.alarmSeen) benchFail("urgent telegram never sent");
+    if (capture.framesBeforeAlarm > framesWhenAlarmQueued) {
+        benchFail("urgent telegram waited behind %u low-priority telegrams",
+            capture.framesBeforeAlarm - framesWhenAlarmQueued);
+    }
+
+    checkMixedServices();
+    checkTunnelWait();
+}
+
+} // namespace
+
+BENCH_SUITE("txqueue", runTxQueueBenchmark);
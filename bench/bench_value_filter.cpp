@@ -0,0 +1,214 @@
+//==== bench/bench_value_filter.cpp ====
+
+// Value filters: checks each stage (change of value, deadband, minimum
+// interval, averaging, downsampling) on a scripted telegram sequence, then
+// replays ten simulated minutes of jittering temperature sensors - one per
+// filter slot, up to 64, sending every 2 s - and compares the callbacks the application
+// sees and the receive cost with and without a deadband and interval filter.
+
+#include "bench.h"
+#include "knx_ip_module.h"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const uint16_t GROUP = (6 << 11) | (1 << 8) | 1;
+// Every sensor needs a filter slot
+const size_t SENSORS = KNX_MAX_VALUE_FILTERS < 64 ? KNX_MAX_VALUE_FILTERS : 64;
+const uint32_t SENSOR_PERIOD_MS = 2000;
+const uint32_t SIMULATED_MS = 10 * 60 * 1000;
+
+void injectWrite(uint16_t group, const uint8_t* data, size_t length) {
+    uint8_t frame[64];
+    // data is in the telegram layout: the 6-bit value joins the APCI octet
+    size_t frameLength = benchRoutingFrame(frame, 0x1105, group, data + 1, length - 1);
+    frame[16] |= data[0] & 0x3F;
+    benchInject(frame, frameLength);
+}
+
+template <typename Dpt>
+void injectValue(uint16_t group, const typename Dpt::Value& value) {
+    uint8_t data[Dpt::LENGTH];
+    Dpt::encode(value, data);
+    injectWrite(group, data, Dpt::LENGTH);
+}
+
+bool checkSequence(const char* name, const std::vector<float>& seen, const std::vector<float>& expected) {
+    bool ok = seen.size() == expected.size();
+    for (size_t i = 0; ok && i < seen.size(); i++) ok = std::fabs(seen[i] - expected[i]) < 0.01f;
+    if (!ok) {
+        benchFail("filter %s: %zu values forwarded, %zu expected", name, seen.size(), expected.size());
+    }
+    return ok;
+}
+
+void checkStages() {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    size_t correct = 0;
+
+    // Change of value, on the raw data of a DPT 1 switch
+    {
+        std::vector<float> seen;
+        KNXValueFilter filter;
+        filter.onChange = true;
+        module.onGroupValue<KNXDpt<1, 1>>(GROUP, filter, [&](bool value, const KNXTelegram&) {
+            seen.push_back(value);
+        });
+        for (bool value : {true, true, false, false, false, true}) injectValue<KNXDpt<1, 1>>(GROUP, value);
+        correct += checkSequence("change of value", seen, {1, 0, 1});
+        module.removeCallback(GROUP);
+    }
+
+    // Deadband of 0.5 K on a DPT 9 temperature, against the last value forwarded
+    {
+        std::vector<float> seen;
+        KNXValueFilter filter;
+        filter.deadband = 0.5f;
+        module.onGroupValue<KNXDpt<9, 1>>(GROUP, filter, [&](float value, const KNXTelegram&) {
+            seen.push_back(value);
+        });
+        for (float value : {21.0f, 21.2f, 21.4f, 21.6f, 21.3f, 21.0f, 20.9f}) {
+            injectValue<KNXDpt<9, 1>>(GROUP, value);
+        }
+        correct += checkSequence("deadband", seen, {21.0f, 21.6f, 21.0f});
+        module.removeCallback(GROUP);
+    }
+
+    // Minimum interval of 1 s with a telegram every 100 ms
+    {
+        std::vector<float> seen;
+        KNXValueFilter filter;
+        filter.minIntervalMs = 1000;
+        module.onGroupValue<KNXDpt<5, 10>>(GROUP, filter, [&](uint8_t value, const KNXTelegram&) {
+            seen.push_back(value);
+        });
+        for (uint8_t i = 0; i < 25; i++) {
+            injectValue<KNXDpt<5, 10>>(GROUP, i);
+            nativeAdvanceClock(100);
+        }
+        correct += checkSequence("minimum interval", seen, {0, 10, 20});
+        module.removeCallback(GROUP);
+    }
+
+    // Mean of four, rounded to the DPT's resolution
+    {
+        std::vector<float> seen;
+        KNXValueFilter filter;
+        filter.average = 4;
+        module.onGroupValue<KNXDpt<7, 1>>(GROUP, filter, [&](uint16_t value, const KNXTelegram&) {
+            seen.push_back(value);
+        });
+        for (uint16_t value : {10, 20, 30, 41, 100, 100, 100, 100, 7}) injectValue<KNXDpt<7, 1>>(GROUP, value);
+        correct += checkSequence("average", seen, {25, 100});
+        module.removeCallback(GROUP);
+    }
+
+    // Every third telegram; a GroupValue_Read passes unfiltered
+    {
+        std::vector<float> seen;
+        size_t reads = 0;
+        KNXValueFilter filter;
+        filter.downsample = 3;
+        module.onGroupAddress(GROUP, filter, [&](const KNXTelegram& telegram) {
+            if (telegram.command == KNX_APCI_GROUP_VALUE_READ) {
+                reads++;
+            } else {
+                seen.push_back(telegram.data[1]);
+            }
+        });
+        for (uint8_t i = 1; i <= 9; i++) injectValue<KNXDpt<5, 10>>(GROUP, i);
+        uint8_t frame[64];
+        size_t length = benchRoutingFrame(frame, 0x1105, GROUP, frame, 0);
+        frame[16] = 0x00; // GroupValue_Read
+        benchInject(frame, length);
+        correct += checkSequence("downsample", seen, {3, 6, 9}) && reads == 1;
+        if (reads != 1) benchFail("filter downsample: %zu reads forwarded", reads);
+        module.removeCallback(GROUP);
+    }
+
+    // Numeric stages without a codec are refused; removed filters free their slot
+    KNXValueFilter numeric;
+    numeric.deadband = 1;
+    bool refused = !module.onGroupAddress(GROUP, numeric, [](const KNXTelegram&) {});
+    KNXValueFilterStats stats = module.getValueFilterStats();
+    if (!refused || stats.filters != 0) {
+        benchFail("filter registration: %s without codec, %u filters left", refused ? "refused" : "accepted",
+            stats.filters);
+    }
+    benchNote("filter stages", "%zu of 5 correct; %u evaluated, %u forwarded, %u windowed, %u rate limited, "
+        "%u unchanged", correct, stats.evaluated, stats.forwarded, stats.windowed, stats.rateLimited,
+        stats.unchanged);
+}
+
+// Temperature of sensor i at time t: a slow drift of +-2 K plus +-0.15 K
+// of measurement jitter
+float sensorValue(size_t sensor, uint32_t t) {
+    uint32_t noise = (uint32_t)(sensor * 2654435761U) ^ (t * 40503U);
+    noise ^= noise >> 13;
+    noise *= 0x5bd1e995;
+    float jitter = ((noise >> 8) % 31 - 15) / 100.0f;
+    return 20.0f + sensor * 0.05f + 2.0f * std::sin(t / 120000.0f + sensor) + jitter;
+}
+
+void runSensors(const char* name, bool filtered) {
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    module.beginMulticast(1, 1, 10);
+    size_t calls = 0;
+    for (size_t i = 0; i < SENSORS; i++) {
+        uint16_t group = (uint16_t)((6 << 11) | (2 << 8) | i);
+        auto callback = [&calls](float, const KNXTelegram&) { calls++; };
+        bool registered;
+        if (filtered) {
+            KNXValueFilter filter;
+            filter.deadband = 0.3f;
+            filter.minIntervalMs = 10000;
+            registered = module.onGroupValue<KNXDpt<9, 1>>(group, filter, callback);
+        } else {
+            registered = module.onGroupValue<KNXDpt<9, 1>>(group, callback);
+        }
+        if (!registered) {
+            benchFail("%s: sensor %zu of %zu not registered", name, i + 1, SENSORS);
+            return;
+        }
+    }
+
+    size_t telegrams = (SIMULATED_MS / SENSOR_PERIOD_MS) * SENSORS;
+    BenchLatency latency(telegrams);
+    uint64_t wallStart = benchNowNs();
+    uint32_t step = SENSOR_PERIOD_MS / SENSORS;
+    for (uint32_t t = 0; t < SIMULATED_MS; t += SENSOR_PERIOD_MS) {
+        for (size_t i = 0; i < SENSORS; i++) {
+            uint8_t data[KNXDpt<9, 1>::LENGTH];
+            KNXDpt<9, 1>::encode(sensorValue(i, t), data);
+            uint16_t group = (uint16_t)((6 << 11) | (2 << 8) | i);
+            uint64_t t0 = benchNowNs();
+            injectWrite(group, data, sizeof(data));
+            latency.add(benchNowNs() - t0);
+            nativeAdvanceClock(step);
+        }
+    }
+    latency.setWallTime(benchNowNs() - wallStart);
+    latency.report(name);
+    benchNote("  callbacks", "%zu of %zu telegrams (%.1f%%)", calls, telegrams, 100.0 * calls / telegrams);
+    // About one in seven with this drift and jitter (see README)
+    if (filtered && (calls * 10 < telegrams || calls * 5 > telegrams)) {
+        benchFail("%s: %zu of %zu telegrams forwarded", name, calls, telegrams);
+    }
+    if (!filtered && calls != telegrams) {
+        benchFail("%s: %zu of %zu telegrams delivered", name, calls, telegrams);
+    }
+}
+
+void runValueFilterBenchmark() {
+    checkStages();
+    runSensors("sensors, unfiltered", false);
+    runSensors("sensors, deadband 0.3 K, 10 s", true);
+}
+
+} // namespace
+
+BENCH_SUITE("filter", runValueFilterBenchmark);
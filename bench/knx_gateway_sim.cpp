@@ -0,0 +1,427 @@
+//==== bench/knx_gateway_sim.cpp ====
+
+#include "knx_gateway_sim.h"
+#include "knx_protocol.h"
+
+KNXGatewaySim::KNXGatewaySim(const IPAddress& ip) : ip(ip) {
+    udp.listen(ip, KNX_PORT);
+    udp.onPacket([this](AsyncUDPPacket& packet) { handle(packet); });
+    searchUdp.listenMulticast(KNX_MULTICAST_IP, KNX_PORT);
+    searchUdp.onPacket([this](AsyncUDPPacket& packet) {
+        if (silent || knxServiceType(packet.data(), packet.length()) != KNXNETIP_SEARCH_REQUEST) return;
+        searches++;
+        respond(KNXNETIP_SEARCH_RESPONSE, packet.data(), packet.length(), true);
+    });
+}
+
+void KNXGatewaySim::respond(uint16_t serviceType, const uint8_t* request, size_t length,
+                            bool withEndpoint) {
+    IPAddress replyIP;
+    uint16_t replyPort;
+    if (!knxReadHpai(request + 6, length - 6, replyIP, replyPort)) return;
+
+    std::vector<uint8_t> response(256);
+    size_t n = KNXNETIP_HEADER_LENGTH;
+    if (withEndpoint) n += knxWriteHpai(&response[n], ip, KNX_PORT);
+
+    // Device information: KNX TP, individual address 1.1.0, friendly name
+    uint8_t* dib = &response[n];
+    memset(dib, 0, 54);
+    dib[0] = 54;
+    dib[1] = KNXNETIP_DIB_DEVICE_INFO;
+    dib[2] = 0x02;
+    dib[4] = 0x11;
+    for (int i = 0; i < 4; i++) dib[14 + i] = KNX_MULTICAST_IP[i];
+    strncpy((char*)dib + 24, name, 30);
+    n += 54;
+
+    // Core, device management and tunnelling, version 1
+    const uint8_t families[] = {8, KNXNETIP_DIB_SUPP_SVC_FAMILIES, 0x02, 1, 0x03, 1, KNXNETIP_FAMILY_TUNNELING, 1};
+    memcpy(&response[n], families, sizeof(families));
+    n += sizeof(families);
+
+    if (slots > 0 && serviceType == KNXNETIP_DESCRIPTION_RESPONSE) {
+        response[n] = (uint8_t)(4 + 4 * slots);
+        response[n + 1] = KNXNETIP_DIB_TUNNELING_INFO;
+        response[n + 2] = 0x00; // Maximum APDU length 254
+        response[n + 3] = 0xFE;
+        for (uint8_t i = 0; i < slots; i++) {
+            uint8_t* slot = &response[n + 4 + 4 * i];
+            slot[0] = 0x11;
+            slot[1] = (uint8_t)(240 + i);
+            slot[2] = 0x00;
+            slot[3] = i < freeSlots ? 0x07 : 0x06; // Usable, authorised, free
+        }
+        n += 4 + 4 * slots;
+    }
+    knxWriteHeader(response.data(), serviceType, (uint16_t)n);
+    response.resize(n);
+
+    if (responseDelayMs == 0) {
+        udp.writeTo(response.data(), response.size(), replyIP, replyPort);
+    } else {
+        delayed.push_back({(uint32_t)millis() + responseDelayMs, response, replyIP, replyPort});
+    }
+}
+
+void KNXGatewaySim::handle(AsyncUDPPacket& packet) {
+    if (silent) return;
+    if (secure && knxServiceType(packet.data(), packet.length()) != KNXNETIP_DESCRIPTION_REQUEST) {
+        handleSecure(packet.data(), packet.length(), packet.remoteIP(), packet.remotePort());
+        return;
+    }
+    handleFrame(packet.data(), packet.length(), packet.remoteIP(), packet.remotePort());
+}
+
+void KNXGatewaySim::handleFrame(const uint8_t* data, size_t length, const IPAddress& remoteIP,
+                                uint16_t remotePort) {
+    uint16_t serviceType = knxServiceType(data, length);
+
+    switch (serviceType) {
+    case KNXNETIP_DESCRIPTION_REQUEST:
+        if (length < 14) return;
+        descriptions++;
+        respond(KNXNETIP_DESCRIPTION_RESPONSE, data, length, false);
+        break;
+
+    case KNXNETIP_CONNECT_REQUEST: {
+        if (length < 26) return;
+        // Endpoints of 0.0.0.0:0 mean "reply to the sender" (route back)
+        if (!knxReadHpai(data + 6, length - 6, clientControlIP, clientControlPort) ||
+            clientControlIP == IPAddress()) {
+            clientControlIP = remoteIP;
+            clientControlPort = remotePort;
+        }
+        if (!knxReadHpai(data + 14, length - 14, clientDataIP, clientDataPort) ||
+            clientDataIP == IPAddress()) {
+            clientDataIP = remoteIP;
+            clientDataPort = remotePort;
+        }
+
+        uint8_t response[20];
+        knxWriteHeader(response, KNXNETIP_CONNECT_RESPONSE, sizeof(response));
+        if (slots > 0 && freeSlots == 0) {
+            knxWriteHeader(response, KNXNETIP_CONNECT_RESPONSE, 8);
+            response[6] = 0;
+            response[7] = KNXNETIP_E_NO_MORE_CONNECTIONS;
+            sendToClient(response, 8, clientControlIP, clientControlPort);
+            refused++;
+            break;
+        }
+        response[6] = CHANNEL;
+        response[7] = KNXNETIP_E_NO_ERROR;
+        knxWriteHpai(response + 8, ip, KNX_PORT);
+        response[16] = 0x04;
+        response[17] = KNXNETIP_TUNNEL_CONNECTION;
+        response[18] = TUNNEL_ADDRESS >> 8;
+        response[19] = TUNNEL_ADDRESS & 0xFF;
+        sendToClient(response, sizeof(response), clientControlIP, clientControlPort);
+
+        isConnected = true;
+        expectedSequence = 0;
+        sendSequence = 0;
+        pendingAcks.clear();
+        connects++;
+        break;
+    }
+
+    case KNXNETIP_CONNECTIONSTATE_REQUEST:
+    case KNXNETIP_DISCONNECT_REQUEST: {
+        if (length < 8) return;
+        bool disconnect = serviceType == KNXNETIP_DISCONNECT_REQUEST;
+        uint8_t response[8];
+        knxWriteHeader(response, disconnect ? KNXNETIP_DISCONNECT_RESPONSE
+                                            : KNXNETIP_CONNECTIONSTATE_RESPONSE, sizeof(response));
+        response[6] = data[6];
+        response[7] = (isConnected && data[6] == CHANNEL) ? KNXNETIP_E_NO_ERROR
+                                                          : KNXNETIP_E_CONNECTION_ID;
+        sendToClient(response, sizeof(response), clientControlIP, clientControlPort);
+        if (disconnect) {
+            isConnected = false;
+        } else {
+            heartbeats++;
+        }
+        break;
+    }
+
+    case KNXNETIP_TUNNELING_REQUEST: {
+        if (!isConnected || length < 11 || data[7] != CHANNEL) return;
+        uint8_t sequence = data[8];
+        requests++;
+        uint8_t behind = expectedSequence - sequence;
+        if (behind >= 1 && behind <= 8) {
+            // Repeat of a request whose ACK the client missed. Accepting more
+            // than the last one tolerates clients with a window above one.
+            repeats++;
+            sendAck(sequence);
+            return;
+        }
+        if (sequence != expectedSequence) return;
+        expectedSequence++;
+
+        if (dropAckEvery > 0 && requests % dropAckEvery == 0) {
+            acksDropped++;
+        } else if (ackDelayMs == 0) {
+            sendAck(sequence);
+        } else {
+            pendingAcks.push_back({(uint32_t)millis() + ackDelayMs, sequence});
+            if (pendingAcks.size() > maxOutstanding) maxOutstanding = pendingAcks.size();
+        }
+
+        const uint8_t* cemi = data + 10;
+        size_t cemiLength = length - 10;
+        frames.emplace_back(cemi, cemi + cemiLength);
+        if (confirm && cemi[0] == KNX_CEMI_L_DATA_REQ) {
+            std::vector<uint8_t> con(cemi, cemi + cemiLength);
+            con[0] = KNX_CEMI_L_DATA_CON;
+            sendTunnelingRequest(con.data(), con.size());
+        }
+        if (readResponder) answerRead(cemi, cemiLength);
+        break;
+    }
+
+    case KNXNETIP_TUNNELING_ACK:
+        if (length >= 10 && data[7] == CHANNEL) acksReceived++;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void KNXGatewaySim::sendAck(uint8_t sequence) {
+    uint8_t ack[10];
+    knxWriteHeader(ack, KNXNETIP_TUNNELING_ACK, sizeof(ack));
+    ack[6] = 0x04;
+    ack[7] = CHANNEL;
+    ack[8] = sequence;
+    ack[9] = KNXNETIP_E_NO_ERROR;
+    sendToClient(ack, sizeof(ack), clientDataIP, clientDataPort);
+}
+
+void KNXGatewaySim::sendTunnelingRequest(const uint8_t* cemi, size_t length) {
+    lastRequest.resize(10 + length);
+    knxWriteHeader(lastRequest.data(), KNXNETIP_TUNNELING_REQUEST, lastRequest.size());
+    lastRequest[6] = 0x04;
+    lastRequest[7] = CHANNEL;
+    lastRequest[8] = sendSequence++;
+    lastRequest[9] = 0x00;
+    memcpy(lastRequest.data() + 10, cemi, length);
+    sendToClient(lastRequest.data(), lastRequest.size(), clientDataIP, clientDataPort);
+}
+
+void KNXGatewaySim::indicate(uint16_t groupAddress, const uint8_t* payload, size_t length) {
+    uint8_t cemi[32];
+    size_t n = 0;
+    cemi[n++] = KNX_CEMI_L_DATA_IND;
+    cemi[n++] = 0x00;
+    cemi[n++] = 0xBC;
+    cemi[n++] = 0xE0;
+    cemi[n++] = 0x11; // Source 1.1.5
+    cemi[n++] = 0x05;
+    cemi[n++] = groupAddress >> 8;
+    cemi[n++] = groupAddress & 0xFF;
+    cemi[n++] = (uint8_t)length;
+    cemi[n++] = 0x00;
+    memcpy(cemi + n, payload, length);
+    sendTunnelingRequest(cemi, n + length);
+}
+
+void KNXGatewaySim::answerRead(const uint8_t* cemi, size_t length) {
+    // GroupValue_Read: group destination, APCI 0x000, no additional info
+    if (length < 11 || cemi[1] != 0 || !(cemi[3] & 0x80) || (cemi[9] & 0x03) || (cemi[10] & 0xC0)) return;
+    uint16_t groupAddress = (cemi[6] << 8) | cemi[7];
+    uint8_t apdu[16];
+    size_t apduLength = readResponder(groupAddress, apdu);
+    if (apduLength == 0) return;
+
+    uint32_t due = (uint32_t)millis() + responseLatencyMs;
+    if (!responses.empty() && (int32_t)(lastResponseDue + responseSpacingMs - due) > 0) {
+        due = lastResponseDue + responseSpacingMs;
+    }
+    lastResponseDue = due;
+    responses.push_back({due, groupAddress, std::vector<uint8_t>(apdu, apdu + apduLength)});
+}
+
+void KNXGatewaySim::repeatLast() {
+    if (lastRequest.empty()) return;
+    sendToClient(lastRequest.data(), lastRequest.size(), clientDataIP, clientDataPort);
+}
+
+void KNXGatewaySim::poll(uint32_t nowMs) {
+    size_t kept = 0;
+    for (size_t i = 0; i < pendingAcks.size(); i++) {
+        if ((int32_t)(nowMs - pendingAcks[i].due) >= 0) {
+            if (!silent) sendAck(pendingAcks[i].sequence);
+        } else {
+            pendingAcks[kept++] = pendingAcks[i];
+        }
+    }
+    pendingAcks.resize(kept);
+
+    kept = 0;
+    for (size_t i = 0; i < delayed.size(); i++) {
+        if ((int32_t)(nowMs - delayed[i].due) >= 0) {
+            if (!silent) udp.writeTo(delayed[i].data.data(), delayed[i].data.size(), delayed[i].ip, delayed[i].port);
+        } else {
+            delayed[kept++] = delayed[i];
+        }
+    }
+    delayed.resize(kept);
+
+    kept = 0;
+    for (size_t i = 0; i < responses.size(); i++) {
+        if ((int32_t)(nowMs - responses[i].due) >= 0) {
+            if (!silent && isConnected) {
+                indicate(responses[i].groupAddress, responses[i].apdu.data(), responses[i].apdu.size());
+                readsAnswered++;
+            }
+        } else {
+            responses[kept++] = responses[i];
+        }
+    }
+    responses.resize(kept);
+}
+
+void KNXGatewaySim::setSecure(const uint8_t deviceAuthenticationCode[16], uint8_t userId,
+                              const uint8_t userPasswordKey[16]) {
+    secure = true;
+    memcpy(deviceCode, deviceAuthenticationCode, sizeof(deviceCode));
+    secureUser = userId;
+    memcpy(userKey, userPasswordKey, sizeof(userKey));
+}
+
+void KNXGatewaySim::sendToClient(const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port) {
+    if (!secure || sessionState == SESSION_NONE) {
+        udp.writeTo(data, length, ip, port);
+        return;
+    }
+    static const uint8_t serial[6] = {0x00, 0xFA, 0x12, 0x34, 0x56, 0x78};
+    KNXSecureHeader header;
+    header.sessionId = SESSION_ID;
+    header.sequence = sessionSendSequence++;
+    memcpy(header.serial, serial, sizeof(serial));
+    header.tag = 0xAFFE;
+    lastWrapped.resize(KNX_SECURE_WRAPPER_OVERHEAD + length);
+    size_t wrapped = knxSecureWrap(sessionKey, header, data, length, lastWrapped.data(), lastWrapped.size());
+    udp.writeTo(lastWrapped.data(), wrapped, ip, port);
+}
+
+void KNXGatewaySim::replayLastDatagram() {
+    if (!lastWrapped.empty()) udp.writeTo(lastWrapped.data(), lastWrapped.size(), sessionIP, sessionPort);
+}
+
+void KNXGatewaySim::openSession(const uint8_t* data, size_t length, const IPAddress& remoteIP,
+                                uint16_t remotePort) {
+    // Header, HPAI, client public key
+    if (length != 46) return;
+    const uint8_t* clientPublic = data + 14;
+    uint8_t privateKey[32];
+    uint8_t serverPublic[32];
+    uint8_t secret[32];
+    uint8_t digest[32];
+    knxRandomBytes(privateKey, sizeof(privateKey));
+    knxX25519Base(serverPublic, privateKey);
+    knxX25519(secret, privateKey, clientPublic);
+    KNXSha256 hash;
+    hash.update(secret, sizeof(secret));
+    hash.finish(digest);
+    sessionKey.setKey(digest);
+    for (size_t i = 0; i < sizeof(publicKeys); i++) publicKeys[i] = clientPublic[i] ^ serverPublic[i];
+
+    uint8_t response[56];
+    knxWriteHeader(response, KNXNETIP_SESSION_RESPONSE, sizeof(response));
+    response[6] = SESSION_ID >> 8;
+    response[7] = SESSION_ID & 0xFF;
+    memcpy(response + 8, serverPublic, sizeof(serverPublic));
+    uint8_t associated[40];
+    memcpy(associated, response, 8);
+    memcpy(associated + 8, publicKeys, sizeof(publicKeys));
+    KNXAes128 device;
+    device.setKey(deviceCode);
+    knxSecureHandshakeMac(device, associated, sizeof(associated), response + 40);
+    udp.writeTo(response, sizeof(response), remoteIP, remotePort);
+
+    sessionState = SESSION_KEYED;
+    sessionSendSequence = 0;
+    sessionReceiveSequence = 0;
+    sessionIP = remoteIP;
+    sessionPort = remotePort;
+}
+
+void KNXGatewaySim::sendStatus(uint8_t status) {
+    uint8_t frame[8];
+    knxWriteHeader(frame, KNXNETIP_SESSION_STATUS, sizeof(frame));
+    frame[6] = status;
+    frame[7] = 0x00;
+    sendToClient(frame, sizeof(frame), sessionIP, sessionPort);
+}
+
+void KNXGatewaySim::closeSession() {
+    if (sessionState == SESSION_NONE) return;
+    sendStatus(KNXNETIP_SECURE_CLOSE);
+    sessionState = SESSION_NONE;
+    isConnected = false;
+}
+
+void KNXGatewaySim::handleSecure(const uint8_t* data, size_t length, const IPAddress& remoteIP,
+                                 uint16_t remotePort) {
+    uint16_t serviceType = knxServiceType(data, length);
+    if (serviceType == KNXNETIP_SESSION_REQUEST) {
+        openSession(data, length, remoteIP, remotePort);
+        return;
+    }
+    if (serviceType != KNXNETIP_SECURE_WRAPPER) {
+        plainRefused++;
+        return;
+    }
+    uint8_t plain[KNX_SECURE_FRAME_SIZE];
+    KNXSecureHeader header;
+    size_t plainLength = sessionState == SESSION_NONE ? 0 :
+        knxSecureUnwrap(sessionKey, data, length, plain, sizeof(plain), header);
+    if (plainLength == 0 || header.sessionId != SESSION_ID || header.sequence < sessionReceiveSequence) {
+        return;
+    }
+    sessionReceiveSequence = header.sequence + 1;
+
+    switch (knxServiceType(plain, plainLength)) {
+    case KNXNETIP_SESSION_AUTHENTICATE: {
+        if (plainLength != 24) return;
+        uint8_t associated[40];
+        memcpy(associated, plain, 8);
+        memcpy(associated + 8, publicKeys, sizeof(publicKeys));
+        KNXAes128 user;
+        user.setKey(userKey);
+        uint8_t mac[KNX_SECURE_MAC_LENGTH];
+        knxSecureHandshakeMac(user, associated, sizeof(associated), mac);
+        if (plain[7] != secureUser || memcmp(mac, plain + 8, sizeof(mac)) != 0) {
+            sessionsRefused++;
+            sendStatus(KNXNETIP_SECURE_AUTH_FAILED);
+            sessionState = SESSION_NONE;
+            return;
+        }
+        sessionState = SESSION_AUTHENTICATED;
+        sessions++;
+        sendStatus(KNXNETIP_SECURE_AUTH_SUCCESS);
+        break;
+    }
+
+    case KNXNETIP_SESSION_STATUS:
+        if (plainLength < 8) return;
+        if (plain[6] == KNXNETIP_SECURE_KEEPALIVE) {
+            keepalives++;
+        } else if (plain[6] == KNXNETIP_SECURE_CLOSE) {
+            sessionCloses++;
+            sessionState = SESSION_NONE;
+        }
+        break;
+
+    default:
+        if (sessionState != SESSION_AUTHENTICATED) {
+            sendStatus(KNXNETIP_SECURE_UNAUTHENTICATED);
+            return;
+        }
+        handleFrame(plain, plainLength, remoteIP, remotePort);
+        break;
+    }
+}
@@ -0,0 +1,177 @@
+//==== bench/knx_gateway_sim.h ====
+
+// Minimal KNXnet/IP tunnelling server on the loopback network, standing in
+// for a real interface in the tunnel benchmarks. Serves one connection,
+// acknowledges TUNNELING_REQUESTs (optionally after a delay, or not at all
+// for every n-th request), answers heartbeats, confirms each request with an
+// L_Data.con and can push L_Data.ind frames to the client. Answers
+// SEARCH_REQUESTs and DESCRIPTION_REQUESTs (optionally after a delay, to
+// stand for network latency) and can report a number of free tunnel slots.
+// Optionally answers GroupValue_Reads on behalf of devices on the bus, and
+// optionally serves KNX IP Secure tunnelling: a session handshake precedes the
+// connection and every tunnelling frame is wrapped with the session key.
+
+#ifndef KNX_GATEWAY_SIM_H
+#define KNX_GATEWAY_SIM_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include "knx_secure.h"
+#include <functional>
+#include <vector>
+
+class KNXGatewaySim {
+public:
+    static const uint8_t CHANNEL = 17;
+    static const uint16_t TUNNEL_ADDRESS = (1 << 12) | (1 << 8) | 250; // 1.1.250
+
+    explicit KNXGatewaySim(const IPAddress& ip = IPAddress(192, 168, 178, 2));
+
+    const IPAddress& address() const { return ip; }
+
+    // Delay before a TUNNELING_ACK is sent, in simulated milliseconds
+    void setAckDelay(uint32_t ms) { ackDelayMs = ms; }
+    // Swallow the ACK of every n-th request (0 = never)
+    void setDropAckEvery(uint32_t n) { dropAckEvery = n; }
+    // Ignore every datagram, as if the gateway lost power
+    void setSilent(bool silent) { this->silent = silent; }
+    // Reply to L_Data.req with L_Data.con
+    void setConfirm(bool confirm) { this->confirm = confirm; }
+    // Delay of SEARCH_RESPONSE and DESCRIPTION_RESPONSE, in simulated milliseconds
+    void setResponseDelay(uint32_t ms) { responseDelayMs = ms; }
+    // Tunnel slots in the tunnelling info DIB (0: no DIB); with none free,
+    // connection requests are refused
+    void setTunnelSlots(uint8_t total, uint8_t free) {
+        slots = total;
+        freeSlots = free;
+    }
+    void setName(const char* name) { this->name = name; }
+
+    // Fills the APDU (APCI octet first) of the response to a GroupValue_Read
+    // and returns its length; 0 leaves the read unanswered.
+    using ReadResponder = std::function<size_t(uint16_t groupAddress, uint8_t* apdu)>;
+    // Responses follow a read after delayMs and are spaced by spacingMs, the
+    // bus time of one telegram.
+    void setReadResponder(const ReadResponder& responder, uint32_t delayMs, uint32_t spacingMs) {
+        readResponder = responder;
+        responseLatencyMs = delayMs;
+        responseSpacingMs = spacingMs;
+    }
+
+    // Sends a GroupValue_Write indication to the client; repeatLast() sends the
+    // previous TUNNELING_REQUEST again with the same sequence number.
+    void indicate(uint16_t groupAddress, const uint8_t* payload, size_t length);
+    void repeatLast();
+
+    // Requires a secure session: SESSION_RESPONSE authenticated with the
+    // device authentication code, SESSION_AUTHENTICATE checked against the
+    // password key of userId. Plain tunnelling frames are ignored.
+    void setSecure(const uint8_t deviceAuthenticationCode[16], uint8_t userId,
+                   const uint8_t userPasswordKey[16]);
+    // Ends the session with SESSION_STATUS close, as after a server timeout
+    void closeSession();
+    // Sends the last wrapped datagram again unchanged (a replay)
+    void replayLastDatagram();
+    bool sessionAuthenticated() const { return sessionState == SESSION_AUTHENTICATED; }
+
+    // Sends delayed ACKs that are due.
+    void poll(uint32_t nowMs);
+
+    bool connected() const { return isConnected; }
+
+    // cEMI frames received from the client, each exactly once in order
+    std::vector<std::vector<uint8_t>> frames;
+    uint32_t connects = 0;
+    uint32_t refused = 0;      // Connection requests without a free slot
+    uint32_t heartbeats = 0;
+    uint32_t requests = 0;     // TUNNELING_REQUESTs including repeats
+    uint32_t repeats = 0;      // Requests with the previous sequence number
+    uint32_t acksDropped = 0;
+    uint32_t acksReceived = 0; // Client ACKs for our own requests
+    uint32_t maxOutstanding = 0;
+    uint32_t searches = 0;
+    uint32_t descriptions = 0;
+    uint32_t readsAnswered = 0;
+    uint32_t sessions = 0;          // Sessions authenticated
+    uint32_t sessionsRefused = 0;   // SESSION_AUTHENTICATEs with a wrong MAC
+    uint32_t plainRefused = 0;      // Unwrapped tunnelling frames in secure mode
+    uint32_t keepalives = 0;
+    uint32_t sessionCloses = 0;     // SESSION_STATUS close from the client
+
+private:
+    struct PendingAck {
+        uint32_t due;
+        uint8_t sequence;
+    };
+
+    struct PendingResponse {
+        uint32_t due;
+        uint16_t groupAddress;
+        std::vector<uint8_t> apdu;
+    };
+
+    struct DelayedDatagram {
+        uint32_t due;
+        std::vector<uint8_t> data;
+        IPAddress ip;
+        uint16_t port;
+    };
+
+    enum SessionState { SESSION_NONE, SESSION_KEYED, SESSION_AUTHENTICATED };
+    static const uint16_t SESSION_ID = 1;
+
+    AsyncUDP udp;
+    AsyncUDP searchUdp;
+    IPAddress ip;
+    IPAddress clientControlIP;
+    uint16_t clientControlPort = 0;
+    IPAddress clientDataIP;
+    uint16_t clientDataPort = 0;
+    bool isConnected = false;
+    uint8_t expectedSequence = 0;
+    uint8_t sendSequence = 0;
+    std::vector<uint8_t> lastRequest;
+    std::vector<PendingAck> pendingAcks;
+    std::vector<DelayedDatagram> delayed;
+    std::vector<PendingResponse> responses;
+
+    uint32_t ackDelayMs = 0;
+    uint32_t dropAckEvery = 0;
+    bool silent = false;
+    bool confirm = true;
+    uint32_t responseDelayMs = 0;
+    uint8_t slots = 0;
+    uint8_t freeSlots = 0;
+    const char* name = "KNX IP Gateway";
+    ReadResponder readResponder;
+    uint32_t responseLatencyMs = 0;
+    uint32_t responseSpacingMs = 0;
+    uint32_t lastResponseDue = 0;
+
+    bool secure = false;
+    uint8_t deviceCode[16];
+    uint8_t secureUser = 0;
+    uint8_t userKey[16];
+    SessionState sessionState = SESSION_NONE;
+    KNXAes128 sessionKey;
+    uint8_t publicKeys[32];  // Client XOR server public key
+    uint64_t sessionSendSequence = 0;
+    uint64_t sessionReceiveSequence = 0;
+    IPAddress sessionIP;
+    uint16_t sessionPort = 0;
+    std::vector<uint8_t> lastWrapped;
+
+    void handle(AsyncUDPPacket& packet);
+    void handleFrame(const uint8_t* data, size_t length, const IPAddress& remoteIP, uint16_t remotePort);
+    void handleSecure(const uint8_t* data, size_t length, const IPAddress& remoteIP, uint16_t remotePort);
+    void openSession(const uint8_t* data, size_t length, const IPAddress& remoteIP, uint16_t remotePort);
+    void sendStatus(uint8_t status);
+    // Wraps the frame while a session is open
+    void sendToClient(const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port);
+    void sendAck(uint8_t sequence);
+    void sendTunnelingRequest(const uint8_t* cemi, size_t length);
+    void answerRead(const uint8_t* cemi, size_t length);
+    void respond(uint16_t serviceType, const uint8_t* request, size_t length, bool withEndpoint);
+};
+
+#endif // KNX_GATEWAY_SIM_H
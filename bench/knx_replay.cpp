@@ -0,0 +1,147 @@
+//==== bench/knx_replay.cpp ====
+
+#include "knx_replay.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace {
+
+const uint32_t LINKTYPE_ETHERNET = 1;
+const uint32_t LINKTYPE_RAW = 101;
+const uint32_t LINKTYPE_LINUX_SLL = 113;
+const uint32_t LINKTYPE_IPV4 = 228;
+
+uint16_t read16be(const uint8_t* data) {
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+uint32_t read32(const uint8_t* data, bool swapped) {
+    if (swapped) {
+        return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+    }
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+} // namespace
+
+bool KNXPcapReader::fail(const char* text) {
+    message = text;
+    list.clear();
+    return false;
+}
+
+bool KNXPcapReader::load(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return fail("cannot open file");
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return parseBytes();
+}
+
+bool KNXPcapReader::parse(const uint8_t* data, size_t length) {
+    bytes.assign(data, data + length);
+    return parseBytes();
+}
+
+bool KNXPcapReader::parseBytes() {
+    list.clear();
+    skippedRecords = 0;
+    message.clear();
+    if (bytes.size() < 24) return fail("too short for a pcap header");
+
+    // Magic in either byte order, microsecond or nanosecond timestamps
+    uint32_t magic = read32(bytes.data(), false);
+    bool swapped;
+    bool nanoseconds;
+    if (magic == 0xA1B2C3D4 || magic == 0xA1B23C4D) {
+        swapped = false;
+        nanoseconds = magic == 0xA1B23C4D;
+    } else if (magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1) {
+        swapped = true;
+        nanoseconds = magic == 0x4D3CB2A1;
+    } else {
+        return fail("not a pcap file (pcapng is not supported)");
+    }
+
+    uint32_t linkType = read32(bytes.data() + 20, swapped) & 0xFFFF;
+    if (linkType != LINKTYPE_ETHERNET && linkType != LINKTYPE_RAW &&
+        linkType != LINKTYPE_LINUX_SLL && linkType != LINKTYPE_IPV4) {
+        return fail("unsupported link type");
+    }
+
+    uint64_t firstUs = 0;
+    size_t offset = 24;
+    while (offset + 16 <= bytes.size()) {
+        const uint8_t* record = bytes.data() + offset;
+        uint64_t seconds = read32(record, swapped);
+        uint64_t fraction = read32(record + 4, swapped);
+        uint32_t included = read32(record + 8, swapped);
+        if (offset + 16 + included > bytes.size()) return fail("truncated record");
+        offset += 16 + included;
+
+        const uint8_t* packet = record + 16;
+        size_t length = included;
+        if (linkType == LINKTYPE_ETHERNET || linkType == LINKTYPE_LINUX_SLL) {
+            size_t header = linkType == LINKTYPE_ETHERNET ? 14 : 16;
+            if (length < header) { skippedRecords++; continue; }
+            uint16_t etherType = read16be(packet + header - 2);
+            if (linkType == LINKTYPE_ETHERNET && etherType == 0x8100 && length >= 18) {
+                header = 18; // 802.1Q tag
+                etherType = read16be(packet + 16);
+            }
+            if (etherType != 0x0800) { skippedRecords++; continue; }
+            packet += header;
+            length -= header;
+        }
+
+        // IPv4, UDP, not fragmented
+        if (length < 20 || (packet[0] >> 4) != 4) { skippedRecords++; continue; }
+        size_t ipHeader = (packet[0] & 0x0F) * 4;
+        if (packet[9] != 17 || (read16be(packet + 6) & 0x3FFF) != 0 || length < ipHeader + 8) {
+            skippedRecords++;
+            continue;
+        }
+        const uint8_t* udp = packet + ipHeader;
+        size_t udpLength = read16be(udp + 4);
+        if (udpLength < 8 || ipHeader + udpLength > length) { skippedRecords++; continue; }
+
+        uint64_t timestampUs = seconds * 1000000 + (nanoseconds ? fraction / 1000 : fraction);
+        if (list.empty()) firstUs = timestampUs;
+
+        KNXReplayDatagram datagram;
+        datagram.timestampUs = timestampUs - firstUs;
+        datagram.srcIP = IPAddress(packet[12], packet[13], packet[14], packet[15]);
+        datagram.srcPort = read16be(udp);
+        datagram.dstIP = IPAddress(packet[16], packet[17], packet[18], packet[19]);
+        datagram.dstPort = read16be(udp + 2);
+        datagram.data = udp + 8;
+        datagram.length = udpLength - 8;
+        list.push_back(datagram);
+    }
+    return true;
+}
+
+size_t knxReplay(const std::vector<KNXReplayDatagram>& datagrams, const KNXReplayOptions& options) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    size_t delivered = 0;
+
+    for (const KNXReplayDatagram& datagram : datagrams) {
+        if (options.skipSource != IPAddress() && datagram.srcIP == options.skipSource) continue;
+        if (options.speed > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(
+                (uint64_t)(datagram.timestampUs / options.speed)));
+        }
+
+        Clock::time_point t0 = Clock::now();
+        AsyncUDPLoopback::deliver(datagram.data, datagram.length, datagram.srcIP, datagram.srcPort,
+                                  datagram.dstIP, datagram.dstPort);
+        if (options.deliveryNs) {
+            options.deliveryNs->push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - t0).count());
+        }
+        delivered++;
+    }
+    return delivered;
+}
@@ -0,0 +1,55 @@
+//==== bench/knx_replay.h ====
+
+// Host-side replay of packet captures: reads pcap files (link types RAW,
+// Ethernet, Linux cooked and IPv4), extracts the UDP datagrams and delivers
+// them to the loopback network the way lwIP would, so a KNXIPModule listening
+// there processes them as live traffic. Used by the "capture" bench suite
+// and by the replay tool (tools/knx_replay_main.cpp).
+
+#ifndef KNX_REPLAY_H
+#define KNX_REPLAY_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <string>
+#include <vector>
+
+struct KNXReplayDatagram {
+    uint64_t timestampUs; // Since the first datagram of the capture
+    IPAddress srcIP;
+    uint16_t srcPort;
+    IPAddress dstIP;
+    uint16_t dstPort;
+    const uint8_t* data;
+    size_t length;
+};
+
+class KNXPcapReader {
+public:
+    bool load(const char* path);
+    bool parse(const uint8_t* data, size_t length);
+
+    const std::vector<KNXReplayDatagram>& datagrams() const { return list; }
+    uint32_t skipped() const { return skippedRecords; } // Not IPv4/UDP, fragmented or truncated
+    const std::string& error() const { return message; }
+
+private:
+    std::vector<uint8_t> bytes;
+    std::vector<KNXReplayDatagram> list;
+    uint32_t skippedRecords = 0;
+    std::string message;
+
+    bool fail(const char* text);
+    bool parseBytes();
+};
+
+struct KNXReplayOptions {
+    double speed = 0;             // Timestamp scale: 1 = real time, 10 = ten times faster, 0 = no pacing
+    IPAddress skipSource;         // Datagrams from this address are not replayed (the capturing device)
+    std::vector<uint64_t>* deliveryNs = nullptr; // Optional: time spent in each delivery
+};
+
+// Replays the datagrams once; returns how many were delivered.
+size_t knxReplay(const std::vector<KNXReplayDatagram>& datagrams, const KNXReplayOptions& options);
+
+#endif // KNX_REPLAY_H
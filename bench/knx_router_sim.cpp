@@ -0,0 +1,76 @@
+//==== bench/knx_router_sim.cpp ====
+
+#include "knx_router_sim.h"
+#include "knx_protocol.h"
+
+namespace {
+
+// Minimum spacing of two ROUTING_BUSY frames from one router
+const uint32_t BUSY_SPACING_MS = 10;
+
+} // namespace
+
+KNXRouterSim::KNXRouterSim(const IPAddress& ip) : ip(ip) {
+    rx.listenMulticast(KNX_MULTICAST_IP, KNX_PORT);
+    rx.onPacket([this](AsyncUDPPacket& packet) { handle(packet); });
+    tx.listen(ip, KNX_PORT);
+}
+
+void KNXRouterSim::handle(AsyncUDPPacket& packet) {
+    if (packet.remoteIP() == ip) return;
+    if (knxServiceType(packet.data(), packet.length()) != KNXNETIP_ROUTING_INDICATION) return;
+
+    received++;
+    if (depth == capacity) {
+        lost++;
+        pendingLost++;
+        return;
+    }
+    if (depth == 0) lastDrain = now;
+    depth++;
+    if (depth > maxDepth) maxDepth = depth;
+
+    if (emitBusy && depth >= busyThreshold &&
+        (!busyBefore || now - lastBusy >= BUSY_SPACING_MS)) {
+        sendBusy(busyWaitMs);
+        busyBefore = true;
+        lastBusy = now;
+    }
+}
+
+void KNXRouterSim::sendBusy(uint16_t waitMs, uint16_t control) {
+    uint8_t frame[12];
+    knxWriteHeader(frame, KNXNETIP_ROUTING_BUSY, sizeof(frame));
+    frame[6] = 6;    // Structure length
+    frame[7] = 0x00; // Device state
+    frame[8] = waitMs >> 8;
+    frame[9] = waitMs & 0xFF;
+    frame[10] = control >> 8;
+    frame[11] = control & 0xFF;
+    tx.writeTo(frame, sizeof(frame), KNX_MULTICAST_IP, KNX_PORT);
+    busySent++;
+}
+
+void KNXRouterSim::sendLostMessage(uint16_t count) {
+    uint8_t frame[10];
+    knxWriteHeader(frame, KNXNETIP_ROUTING_LOST_MESSAGE, sizeof(frame));
+    frame[6] = 4;    // Structure length
+    frame[7] = 0x00; // Device state
+    frame[8] = count >> 8;
+    frame[9] = count & 0xFF;
+    tx.writeTo(frame, sizeof(frame), KNX_MULTICAST_IP, KNX_PORT);
+    lostReports++;
+}
+
+void KNXRouterSim::poll(uint32_t nowMs) {
+    now = nowMs;
+    while (depth > 0 && nowMs - lastDrain >= drainMs) {
+        depth--;
+        forwarded++;
+        lastDrain += drainMs;
+    }
+    if (pendingLost > 0) {
+        sendLostMessage(pendingLost);
+        pendingLost = 0;
+    }
+}
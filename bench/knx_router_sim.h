@@ -0,0 +1,65 @@
+//==== bench/knx_router_sim.h ====
+
+// KNXnet/IP router on the loopback network, standing in for an IP router
+// whose TP line drains routing indications at a fixed rate. Indications wait
+// in a bounded queue; at the busy threshold the router multicasts
+// ROUTING_BUSY, when the queue overflows it loses the indication and reports
+// the count in a ROUTING_LOST_MESSAGE.
+
+#ifndef KNX_ROUTER_SIM_H
+#define KNX_ROUTER_SIM_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+
+class KNXRouterSim {
+public:
+    explicit KNXRouterSim(const IPAddress& ip = IPAddress(192, 168, 178, 3));
+
+    const IPAddress& address() const { return ip; }
+
+    // Queue slots and the depth at which ROUTING_BUSY is sent
+    void setQueue(size_t capacity, size_t busyThreshold) {
+        this->capacity = capacity;
+        this->busyThreshold = busyThreshold;
+    }
+    // Time the TP line needs per telegram (20 ms = 50 telegrams/s)
+    void setDrainInterval(uint32_t ms) { drainMs = ms; }
+    void setBusyWait(uint16_t ms) { busyWaitMs = ms; }
+    // Without busy frames only lost message reports tell senders to slow down
+    void setEmitBusy(bool emit) { emitBusy = emit; }
+
+    void sendBusy(uint16_t waitMs, uint16_t control = 0);
+    void sendLostMessage(uint16_t lost);
+
+    // Drains the queue and reports losses; call once per simulated millisecond.
+    void poll(uint32_t nowMs);
+
+    size_t depth = 0;
+    size_t maxDepth = 0;
+    uint32_t received = 0;  // Routing indications from other devices
+    uint32_t forwarded = 0; // Drained onto the TP line
+    uint32_t lost = 0;
+    uint32_t busySent = 0;
+    uint32_t lostReports = 0;
+
+private:
+    AsyncUDP rx; // Multicast group member
+    AsyncUDP tx; // Sends with the router's own source address
+    IPAddress ip;
+    size_t capacity = 40;
+    size_t busyThreshold = 10;
+    uint32_t drainMs = 20;
+    uint16_t busyWaitMs = 20;
+    bool emitBusy = true;
+
+    uint32_t now = 0;
+    uint32_t lastDrain = 0;
+    uint32_t lastBusy = 0;
+    bool busyBefore = false;
+    uint16_t pendingLost = 0;
+
+    void handle(AsyncUDPPacket& packet);
+};
+
+#endif // KNX_ROUTER_SIM_H
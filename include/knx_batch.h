@@ -0,0 +1,88 @@
+//==== include/knx_batch.h ====
+
+#ifndef KNX_BATCH_H
+#define KNX_BATCH_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_telegram.h"
+
+enum KNXBatchOrder {
+    KNX_BATCH_IN_ORDER,    // As added
+    KNX_BATCH_BY_PRIORITY  // System, urgent, normal, low; in order within a class
+};
+
+enum KNXBatchStatus {
+    KNX_BATCH_PENDING, // Not submitted yet
+    KNX_BATCH_SENT,    // Handed to the network (multicast) or the tunnel client
+    KNX_BATCH_QUEUED,  // Accepted by the transmit queue
+    KNX_BATCH_FAILED   // Rejected: full queue, flow control pause, not connected
+};
+
+// Group writes sent together, e.g. the 20-40 addresses of a scene. Frames are
+// encoded once, when added, into one arena allocated by begin();
+// KNXIPModule::sendBatch() then only copies each frame next to its KNXnet/IP
+// header, stamps the source address and sends it. A batch can be sent any
+// number of times and keeps the status of each entry from the last send.
+//
+//     KNXBatch scene;
+//     scene.begin(32);
+//     scene.add<KNXDpt<1, 1>>(lightGroup, true);
+//     scene.add<KNXDpt<5, 1>>(blindGroup, 40);
+//     knx.sendBatch(scene);
+class KNXBatch {
+public:
+    KNXBatch();
+    ~KNXBatch();
+    KNXBatch(const KNXBatch&) = delete;
+    KNXBatch& operator=(const KNXBatch&) = delete;
+
+    // arenaSize 0 reserves 16 bytes per entry, enough for values up to 4 bytes
+    bool begin(size_t maxEntries, size_t arenaSize = 0);
+    void end();
+    // Removes all entries, keeping the arena
+    void clear();
+
+    // Returns false if the entry does not fit the arena or the entry table, or
+    // dataLength is not 1..KNX_TELEGRAM_MAX_DATA (longer than
+    // KNX_CEMI_STANDARD_APDU makes an extended frame).
+    bool add(int groupAddress, const uint8_t* data, size_t dataLength,
+             KNXPriority priority = KNX_PRIORITY_LOW);
+
+    template <typename Dpt>
+    bool add(int groupAddress, const typename Dpt::Value& value,
+             KNXPriority priority = KNX_PRIORITY_LOW) {
+        uint8_t data[Dpt::LENGTH];
+        size_t length = Dpt::encode(value, data);
+        return add(groupAddress, data, length, priority);
+    }
+
+    size_t size() const { return count; }
+    size_t arenaUsed() const { return used; }
+    KNXBatchStatus status(size_t index) const { return (KNXBatchStatus)entries[index].status; }
+    KNXPriority priority(size_t index) const { return (KNXPriority)entries[index].priority; }
+    uint16_t groupAddress(size_t index) const { return entries[index].groupAddress; }
+
+    // The pre-encoded cEMI frame of an entry (L_Data.ind, source 0)
+    const uint8_t* frame(size_t index) const { return arena + entries[index].offset; }
+    size_t frameLength(size_t index) const { return 10 + frame(index)[8]; }
+
+    void setStatus(size_t index, KNXBatchStatus status) { entries[index].status = (uint8_t)status; }
+
+private:
+    struct Entry {
+        uint16_t offset;
+        uint16_t groupAddress;
+        uint8_t priority;
+        uint8_t status;
+    };
+
+    Entry* entries;
+    uint8_t* arena;
+    size_t capacity;
+    size_t arenaSize;
+    size_t count;
+    size_t used;
+};
+
+#endif // KNX_BATCH_H
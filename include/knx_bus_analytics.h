@@ -0,0 +1,159 @@
+//==== include/knx_bus_analytics.h ====
+
+#ifndef KNX_BUS_ANALYTICS_H
+#define KNX_BUS_ANALYTICS_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_memory.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+
+// Bus time of a TP1 frame: every octet is an 11-bit character plus 2 bit
+// times of pause, the line is idle for 50 bit times before a frame and the
+// acknowledge (11 bits) follows after 15. A GroupValue_Write of a switch (9
+// octets) takes 193 bit times, 20 ms at 9600 bit/s.
+#define KNX_TP1_BITS_PER_OCTET 13
+#define KNX_TP1_FRAME_OVERHEAD_BITS (50 + 15 + 11)
+
+// Settings of the bus analytics (see KNXIPModule::enableBusAnalytics)
+struct KNXBusAnalyticsConfig {
+    size_t topSources = 16;  // Source addresses counted by the top talker summary
+    size_t topGroups = 32;   // Group addresses counted by theirs
+    uint32_t bitRate = 9600; // Of the TP1 line the load is estimated for
+};
+
+// One address of a top talker summary. The true count lies between
+// count - error and count: an address that entered the summary by replacing
+// the least counted one inherits its count as error.
+struct KNXTopAddress {
+    uint16_t address;
+    uint32_t count;
+    uint32_t error;
+};
+
+struct KNXBusStats {
+    uint32_t frames;             // L_Data frames seen, our own sends included
+    uint32_t groupFrames;        // To group addresses
+    uint32_t extendedFrames;
+    uint32_t repeatedFrames;     // Repetitions after a missing acknowledge
+    uint32_t controlFrames;      // Transport layer control (connect, ACK), no APCI
+    uint32_t apci[16];           // Data frames by 4-bit APCI, e.g. apci[KNX_APCI_GROUP_VALUE_WRITE]
+    uint32_t framesLastSecond;   // In the last complete second
+    uint32_t framesLastMinute;   // In the last 60 complete seconds
+    uint32_t peakFramesPerSecond;
+    float loadLastSecond;        // Percent of the line's bit time, last complete second
+    float loadLastMinute;        // Percent, last 60 complete seconds
+    float peakLoad;              // Highest per-second load
+};
+
+// Space-saving summary of the most frequent 16-bit addresses in a fixed
+// number of counters (Metwally et al., Stream-Summary). Counters with equal
+// counts share a bucket and the buckets form a list in count order, so
+// counting an address, or replacing the least counted one with a new
+// address, is O(1); a hash index finds the counter of an address. Any address
+// seen more often than frames / capacity is guaranteed to be in the summary.
+// Not synchronized, see KNXBusAnalytics.
+class KNXTopCounter {
+public:
+    KNXTopCounter();
+    ~KNXTopCounter();
+
+    bool begin(size_t capacity);
+    void end();
+    bool isActive() const { return counters != nullptr; }
+    // Exchanges the contents of two summaries, so one can be set up outside a lock
+    void swap(KNXTopCounter& other);
+
+    void count(uint16_t address);
+    void clear();
+    // Most frequent first; returns the number of entries written
+    size_t top(KNXTopAddress* entries, size_t maxEntries) const;
+
+private:
+    static const uint16_t NONE = 0xFFFF;
+
+    struct Counter {
+        uint32_t count;
+        uint32_t error;
+        uint16_t address;
+        uint16_t bucket;
+        uint16_t prev;     // Within the bucket
+        uint16_t next;
+        uint16_t hashNext;
+    };
+    struct Bucket {
+        uint32_t count;
+        uint16_t head;     // Counters with this count
+        uint16_t prev;     // Bucket list, lowest count first
+        uint16_t next;
+    };
+
+    Counter* counters;
+    Bucket* buckets;
+    uint16_t* hash;
+    size_t capacity;
+    uint16_t hashMask;
+    uint16_t used;
+    uint16_t lowest;      // Bucket with the lowest count
+    uint16_t highest;
+    uint16_t freeBucket;
+
+    uint16_t find(uint16_t address) const;
+    void index(uint16_t counter);
+    void unindex(uint16_t counter);
+    void increment(uint16_t counter);
+    void attach(uint16_t counter, uint16_t bucket);
+    void detach(uint16_t counter);
+    uint16_t newBucket(uint32_t count, uint16_t after);
+    void freeBucketIfEmpty(uint16_t bucket);
+};
+
+// Streaming statistics of the bus traffic the module sees: frame and APCI
+// counters, frames per second and per minute, the TP1 bus load estimated
+// from frame lengths, and the top source and group addresses. Every frame
+// costs a constant amount of work under a short lock, whatever the traffic,
+// and the memory is fixed by the configuration.
+class KNXBusAnalytics {
+public:
+    KNXBusAnalytics();
+
+    bool begin(const KNXBusAnalyticsConfig& config, uint32_t nowMs);
+    void end();
+    bool isActive() const { return topSources.isActive(); }
+
+    // Counts one L_Data frame (see knxParseCemi)
+    void record(const KNXCemiFrame& frame, uint32_t nowMs);
+
+    KNXBusStats stats(uint32_t nowMs);
+    size_t topSourceAddresses(KNXTopAddress* entries, size_t maxEntries);
+    size_t topGroupAddresses(KNXTopAddress* entries, size_t maxEntries);
+    void reset(uint32_t nowMs);
+
+private:
+    static const uint8_t SECONDS = 60;
+
+    KNXLock lock;
+    KNXBusAnalyticsConfig config;
+    KNXTopCounter topSources;
+    KNXTopCounter topGroups;
+    KNXBusStats counters;
+
+    // Per-second frames and bus bits of the last minute, as a ring
+    uint32_t secondFrames[SECONDS];
+    uint32_t secondBits[SECONDS];
+    uint8_t secondHead;
+    uint32_t secondStart;   // millis() at which the current second began
+    uint32_t currentFrames;
+    uint32_t currentBits;
+    uint32_t minuteFrames;  // Sums over the ring
+    uint32_t minuteBits;
+    uint32_t lastSecondBits;
+    uint32_t peakBits;
+
+    void advance(uint32_t nowMs);
+    void closeSecond();
+    void clearWindows(uint32_t nowMs);
+};
+
+#endif // KNX_BUS_ANALYTICS_H
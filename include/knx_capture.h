@@ -0,0 +1,81 @@
+//==== include/knx_capture.h ====
+
+#ifndef KNX_CAPTURE_H
+#define KNX_CAPTURE_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+
+// Settings of the optional packet capture (see KNXIPModule::enableCapture)
+struct KNXCaptureConfig {
+    size_t bufferSize = 16384;   // Bytes of pcap records kept in RAM
+    uint16_t snapLength = 256;   // KNXnet/IP bytes stored per datagram
+    bool overwrite = true;       // Full buffer: drop the oldest records (false: the newest)
+    bool preferPsram = true;     // Allocate from PSRAM when the board has it (not in the static profile)
+    IPAddress streamIP;          // Non-zero: loop() streams the capture here over UDP
+    uint16_t streamPort = 0;
+};
+
+struct KNXCaptureStats {
+    uint32_t captured;    // Datagrams recorded
+    uint32_t dropped;     // Records lost to a full buffer
+    uint32_t truncated;   // Datagrams longer than the snap length
+    uint32_t records;     // Records waiting in the buffer
+    uint32_t bytesUsed;
+    uint32_t bufferSize;
+    uint32_t streamed;    // Records sent out by streaming or dumps
+};
+
+// Ring buffer of KNXnet/IP datagrams in pcap format. Every record carries a
+// synthesized IPv4/UDP header (link type RAW), so Wireshark decodes the
+// capture with its KNXnet/IP dissector as if taken on the wire. Timestamps
+// count from begin(), offset by the system time if it has been set.
+//
+// The buffer holds complete pcap records; read() hands out whole records, so
+// any split of the output (UDP datagrams, TCP writes) concatenates to a valid
+// file once prefixed with writeFileHeader().
+class KNXCaptureBuffer {
+public:
+    static const size_t FILE_HEADER_SIZE = 24;
+    static const size_t RECORD_OVERHEAD = 16 + 20 + 8; // pcap record, IPv4, UDP headers
+    static const uint32_t LINKTYPE_RAW = 101;
+
+    KNXCaptureBuffer();
+    ~KNXCaptureBuffer();
+
+    bool begin(const KNXCaptureConfig& config);
+    void end();
+    bool isActive() const { return buffer != nullptr; }
+
+    void record(const uint8_t* data, size_t length, const IPAddress& srcIP, uint16_t srcPort,
+                const IPAddress& dstIP, uint16_t dstPort);
+
+    // Moves whole records into out, at most maxLength bytes; returns the bytes copied.
+    size_t read(uint8_t* out, size_t maxLength);
+
+    // Writes the pcap file header; returns FILE_HEADER_SIZE.
+    static size_t writeFileHeader(uint8_t* out, uint32_t snapLength);
+    uint32_t snapLength() const { return config.snapLength + 20 + 8; }
+
+    KNXCaptureStats stats();
+
+private:
+    KNXLock lock;
+    KNXCaptureConfig config;
+    uint8_t* buffer;
+    bool inPsram;
+    size_t head;  // Oldest record
+    size_t used;
+    uint32_t baseSeconds;
+    uint32_t lastMicros;
+    uint64_t elapsedMicros;
+    KNXCaptureStats counters;
+
+    void copyIn(size_t offset, const uint8_t* data, size_t length);
+    void copyOut(size_t offset, uint8_t* data, size_t length) const;
+    size_t recordLengthAt(size_t offset) const;
+    void dropOldest();
+};
+
+#endif // KNX_CAPTURE_H
@@ -0,0 +1,120 @@
+//==== include/knx_config.h ====
+
+#ifndef KNX_CONFIG_H
+#define KNX_CONFIG_H
+
+// Compile-time limits of the KNX stack. Every value can be overridden from
+// platformio.ini, e.g. build_flags = -DKNX_TELEGRAM_MAX_DATA=32
+
+// Longest APDU the stack handles end to end: application data bytes held
+// inline by a KNXTelegram (the APCI-masked first byte plus payload), and the
+// longest data sendKNXMessage, KNXBatch and the transmit queue accept. A
+// standard frame carries at most 15, an extended frame up to 254. Received
+// telegrams with more data are counted as truncated and not delivered.
+#ifndef KNX_TELEGRAM_MAX_DATA
+#define KNX_TELEGRAM_MAX_DATA 16
+#endif
+
+// Size of one slot of the dispatch task's receive queue. The additional info
+// is not queued, so a slot holds frames of up to KNX_RX_QUEUE_FRAME_SIZE - 10
+// APDU octets; longer ones are counted as dropped.
+#ifndef KNX_RX_QUEUE_FRAME_SIZE
+#define KNX_RX_QUEUE_FRAME_SIZE 64
+#endif
+
+// Largest cEMI frame the tunnelling client sends, and how many outgoing frames
+// it buffers (in flight plus waiting for the window).
+#ifndef KNX_TUNNEL_FRAME_SIZE
+#define KNX_TUNNEL_FRAME_SIZE 64
+#endif
+#ifndef KNX_TUNNEL_BACKLOG
+#define KNX_TUNNEL_BACKLOG 8
+#endif
+
+// A telegram that fits KNX_TELEGRAM_MAX_DATA must also fit the queues it
+// passes through, or long APDUs would be sent or delivered on one path only
+#if KNX_TELEGRAM_MAX_DATA < 1 || KNX_TELEGRAM_MAX_DATA > 254
+#error "KNX_TELEGRAM_MAX_DATA must be 1..254"
+#endif
+#if KNX_RX_QUEUE_FRAME_SIZE < 10 + KNX_TELEGRAM_MAX_DATA
+#error "KNX_RX_QUEUE_FRAME_SIZE must be at least 10 + KNX_TELEGRAM_MAX_DATA"
+#endif
+#if KNX_TUNNEL_FRAME_SIZE < 10 + KNX_TELEGRAM_MAX_DATA
+#error "KNX_TUNNEL_FRAME_SIZE must be at least 10 + KNX_TELEGRAM_MAX_DATA"
+#endif
+
+// Leading bytes of a datagram or telegram payload kept in each trace record
+#ifndef KNX_TRACE_DATA
+#define KNX_TRACE_DATA 16
+#endif
+
+// Per-stage counters and latency histograms (KNXIPModule::getStats). Set to 0
+// to compile the instrumentation out.
+#ifndef KNX_STATS
+#define KNX_STATS 1
+#endif
+
+// KNXnet/IP routers whose BUSY and LOST_MESSAGE reports are tracked separately
+#ifndef KNX_ROUTING_PEERS
+#define KNX_ROUTING_PEERS 4
+#endif
+
+// Reply buffer of the UDP stats endpoint; large enough for either format
+#ifndef KNX_STATS_REPLY_SIZE
+#define KNX_STATS_REPLY_SIZE 1024
+#endif
+
+// KNXnet/IP servers remembered by gateway discovery
+#ifndef KNX_DISCOVERY_GATEWAYS
+#define KNX_DISCOVERY_GATEWAYS 8
+#endif
+
+// Senders whose last routing timer secure routing remembers (replay check)
+#ifndef KNX_SECURE_PEERS
+#define KNX_SECURE_PEERS 16
+#endif
+
+// Longest sleep KNXIPModule::poll() suggests while work without a known
+// deadline is active (gateway discovery, secure routing, capture streaming)
+#ifndef KNX_POLL_MAX_MS
+#define KNX_POLL_MAX_MS 1000
+#endif
+
+// Static allocation profile: the stack takes no memory from the heap. The
+// buffers of enable*() come from a fixed pool, callback tables and filter
+// rules have fixed capacities, callbacks are stored inline and FreeRTOS
+// objects are created static. KNXIPModule::printRamReport() shows the result.
+#ifndef KNX_STATIC_ALLOCATION
+#define KNX_STATIC_ALLOCATION 0
+#endif
+
+// Size of that pool; KNXIPModule::getRamReport() shows the high-water mark
+#ifndef KNX_STATIC_POOL_SIZE
+#define KNX_STATIC_POOL_SIZE 32768
+#endif
+
+// Capacities in the static profile: exact address callbacks, main/middle
+// group callbacks, and rules of one router filter
+#ifndef KNX_MAX_CALLBACKS
+#define KNX_MAX_CALLBACKS 64
+#endif
+#ifndef KNX_MAX_RANGE_CALLBACKS
+#define KNX_MAX_RANGE_CALLBACKS 8
+#endif
+#ifndef KNX_MAX_FILTER_RULES
+#define KNX_MAX_FILTER_RULES 16
+#endif
+
+// Filtered subscriptions (onGroupAddress with a KNXValueFilter); their slots
+// are allocated together with the first one
+#ifndef KNX_MAX_VALUE_FILTERS
+#define KNX_MAX_VALUE_FILTERS 32
+#endif
+
+// Bytes of captured state a callback may hold in the static profile; larger
+// lambdas fail to compile
+#ifndef KNX_CALLBACK_SIZE
+#define KNX_CALLBACK_SIZE 32
+#endif
+
+#endif // KNX_CONFIG_H
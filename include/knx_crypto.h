@@ -0,0 +1,98 @@
+//==== include/knx_crypto.h ====
+
+#ifndef KNX_CRYPTO_H
+#define KNX_CRYPTO_H
+
+#include <Arduino.h>
+
+// The AES peripheral of the ESP32 through the IDF driver when the core ships
+// it, a table-driven software AES otherwise (and on the host)
+#if defined(ESP32) && defined(__has_include)
+#if __has_include(<aes/esp_aes.h>)
+#include <aes/esp_aes.h>
+#define KNX_AES_HARDWARE 1
+#endif
+#endif
+#ifndef KNX_AES_HARDWARE
+#define KNX_AES_HARDWARE 0
+#endif
+
+// AES-128 encryption with the key schedule expanded once by setKey(). KNX IP
+// Secure only uses the forward cipher (CBC-MAC and counter mode). Encryption
+// does not modify the object, so one key can be used from several tasks.
+class KNXAes128 {
+public:
+    static const size_t BLOCK = 16;
+
+    KNXAes128();
+    ~KNXAes128();
+    KNXAes128(const KNXAes128&) = delete;
+    KNXAes128& operator=(const KNXAes128&) = delete;
+
+    void setKey(const uint8_t key[16]);
+    // Wipes the key schedule
+    void clear();
+    bool hasKey() const { return keyed; }
+    static bool hardware() { return KNX_AES_HARDWARE != 0; }
+
+    void encryptBlock(const uint8_t in[16], uint8_t out[16]) const;
+    // CBC-MAC over `blocks` blocks: state is the chaining value (zero to
+    // start) and ends up as the last cipher block.
+    void cbcMac(uint8_t state[16], const uint8_t* data, size_t blocks) const;
+    // Counter mode with a 128-bit big-endian counter, which is left at the
+    // block after the last one used. in and out may be the same buffer.
+    void ctr(uint8_t counter[16], const uint8_t* in, uint8_t* out, size_t length) const;
+
+private:
+    bool keyed;
+#if KNX_AES_HARDWARE
+    mutable esp_aes_context context;
+#else
+    uint32_t roundKeys[44];
+#endif
+};
+
+struct KNXSha256 {
+    uint32_t state[8];
+    uint64_t length; // Bytes hashed so far
+    uint8_t buffer[64];
+
+    KNXSha256() { reset(); }
+    void reset();
+    void update(const uint8_t* data, size_t length);
+    void finish(uint8_t digest[32]);
+};
+
+// HMAC-SHA256 with the padded key hashed once: every message costs two
+// compressions plus its own blocks.
+class KNXHmacSha256 {
+public:
+    explicit KNXHmacSha256(const uint8_t* key, size_t keyLength);
+    void compute(const uint8_t* message, size_t length, uint8_t mac[32]) const;
+    // MAC of the concatenation of two parts
+    void compute(const uint8_t* first, size_t firstLength, const uint8_t* second, size_t secondLength,
+                 uint8_t mac[32]) const;
+
+private:
+    KNXSha256 inner;
+    KNXSha256 outer;
+};
+
+void knxPbkdf2Sha256(const uint8_t* password, size_t passwordLength, const uint8_t* salt,
+                     size_t saltLength, uint32_t iterations, uint8_t* out, size_t outLength);
+
+// Curve25519 Diffie-Hellman (RFC 7748): out = scalar * point, both
+// little-endian. Constant time, in software on every platform.
+void knxX25519(uint8_t out[32], const uint8_t scalar[32], const uint8_t point[32]);
+// out = scalar * 9, the public key of a private scalar
+void knxX25519Base(uint8_t out[32], const uint8_t scalar[32]);
+
+// Cryptographically strong random bytes (the hardware RNG on the ESP32, with
+// the radio on)
+void knxRandomBytes(uint8_t* out, size_t length);
+
+// Compares without an early exit, so the time does not reveal the position of
+// the first difference
+bool knxEqualConstantTime(const uint8_t* a, const uint8_t* b, size_t length);
+
+#endif // KNX_CRYPTO_H
@@ -0,0 +1,62 @@
+//==== include/knx_dedup.h ====
+
+#ifndef KNX_DEDUP_H
+#define KNX_DEDUP_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+
+// Settings of the optional receive dedup stage (see KNXIPModule::enableDedup)
+struct KNXDedupConfig {
+    size_t capacity = 64;       // Fingerprints remembered (rounded up to a power of two, at least 8)
+    uint16_t windowMs = 200;    // Identical frames within this time count as one
+    bool dropOwnFrames = true;  // Drop frames sent from our own individual address
+};
+
+struct KNXDedupStats {
+    uint32_t checked;    // Frames looked at
+    uint32_t ownFrames;  // Dropped: our own routing indications
+    uint32_t duplicates; // Dropped: fingerprint seen within the window
+    uint32_t evictions;  // Live fingerprints pushed out by newer ones
+    uint32_t capacity;
+};
+
+// Suppresses multicast echoes and repeated frames. Each frame is reduced to a
+// 32-bit fingerprint of source, destination, address type and APDU - the
+// fields routers and TP repeats leave alone - and looked up in a small
+// set-associative table: four slots per bucket, so a check touches at most
+// four entries. Entries expire after the window; a full bucket replaces its
+// oldest entry.
+class KNXDedupFilter {
+public:
+    KNXDedupFilter();
+    ~KNXDedupFilter();
+
+    bool begin(const KNXDedupConfig& config);
+    void end();
+    bool isActive() const { return slots != nullptr; }
+
+    // True if the cEMI frame should be dropped. Remembers frames that pass.
+    bool isDuplicate(const uint8_t* data, size_t length, uint16_t ownAddress, uint32_t nowMs);
+
+    KNXDedupStats stats();
+
+private:
+    static const uint8_t WAYS = 4;
+
+    struct Slot {
+        uint32_t fingerprint; // 0 = empty
+        uint32_t timestamp;
+    };
+
+    KNXLock lock;
+    KNXDedupConfig config;
+    Slot* slots;
+    uint8_t shift; // 32 - log2(buckets)
+    KNXDedupStats counters;
+
+    static uint32_t fingerprintOf(const uint8_t* frame, size_t length);
+};
+
+#endif // KNX_DEDUP_H
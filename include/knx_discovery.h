@@ -0,0 +1,97 @@
+//==== include/knx_discovery.h ====
+
+#ifndef KNX_DISCOVERY_H
+#define KNX_DISCOVERY_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+
+// Settings of gateway discovery (see KNXIPModule::beginDiscovery)
+struct KNXDiscoveryConfig {
+    uint16_t searchTimeoutMs = 2000;   // Time to collect SEARCH_RESPONSEs
+    uint8_t probes = 3;                // DESCRIPTION_REQUESTs per gateway
+    uint16_t probeIntervalMs = 100;    // A gateway is probed again once it replied
+    uint16_t probeTimeoutMs = 1000;    // Wait for a reply before probing again, and after the last probe
+    uint32_t failureHoldoffMs = 60000; // A failed gateway ranks last for this long
+};
+
+// A KNXnet/IP server found by a search or added by hand
+struct KNXGatewayInfo {
+    IPAddress ip;               // Control endpoint
+    uint16_t port;
+    uint16_t individualAddress;
+    char name[31];
+    bool tunnelling;            // Supports the tunnelling service family
+    int8_t freeSlots;           // Free tunnel slots, -1 if the device does not report them
+    uint32_t rttMicros;         // Fastest DESCRIPTION round trip, 0 without a reply
+    uint8_t probeReplies;
+    uint16_t failures;          // Connections lost or refused
+    uint32_t failedAt;          // millis() of the last failure
+};
+
+// Finds tunnelling servers with SEARCH_REQUEST, probes each with
+// DESCRIPTION_REQUESTs for round-trip time and free tunnel slots (from the
+// tunnelling info DIB of KNXnet/IP 2 devices) and ranks them. Each gateway
+// has at most one probe outstanding until probeTimeoutMs, so a slow reply is
+// timed from the request it answers, not from a later one. Gateways that
+// failed recently rank last, so failover moves on to the next one and comes
+// back once every alternative has failed too.
+class KNXGatewayDiscovery {
+public:
+    KNXGatewayDiscovery();
+
+    // Requests go out on udp; responses are addressed to the local endpoint.
+    void begin(AsyncUDP* udp, const IPAddress& localIP, uint16_t localPort,
+               const KNXDiscoveryConfig& config);
+    void end();
+    bool isActive() const { return udp != nullptr; }
+
+    // Known gateway, e.g. where multicast does not reach the interfaces
+    bool addGateway(const IPAddress& ip, uint16_t port = KNX_PORT);
+
+    // Sends a SEARCH_REQUEST; probing follows once the search timeout passed.
+    void search(uint32_t nowMs);
+    // Sends due probes and ends the search and probe phases.
+    void poll(uint32_t nowMs);
+    // True when no search or probing is in progress
+    bool idle();
+
+    // Consumes SEARCH_RESPONSE and DESCRIPTION_RESPONSE frames.
+    bool handlePacket(uint16_t serviceType, const uint8_t* data, size_t length,
+                      const IPAddress& remoteIP);
+
+    // Best gateway to connect to; false if none supports tunnelling.
+    bool best(KNXGatewayInfo& gateway, uint32_t nowMs);
+    void markFailed(const IPAddress& ip, uint32_t nowMs);
+
+    size_t gateways(KNXGatewayInfo* out, size_t maxGateways);
+
+private:
+    enum Phase { IDLE, SEARCHING, PROBING };
+
+    AsyncUDP* udp;
+    KNXLock lock;
+    KNXDiscoveryConfig config;
+    IPAddress localIP;
+    uint16_t localPort;
+
+    Phase phase;
+    uint32_t phaseSince;
+    uint8_t probesSent;
+    uint32_t lastProbe;
+
+    KNXGatewayInfo table[KNX_DISCOVERY_GATEWAYS];
+    uint32_t probeSentAt[KNX_DISCOVERY_GATEWAYS]; // micros()
+    bool probePending[KNX_DISCOVERY_GATEWAYS];    // Sent, neither answered nor timed out
+    uint8_t count;
+
+    int findOrAdd(const IPAddress& ip, uint16_t port);
+    void parseDibs(KNXGatewayInfo& gateway, const uint8_t* data, size_t length);
+    void sendProbes();
+    bool ranksBefore(const KNXGatewayInfo& a, const KNXGatewayInfo& b, uint32_t nowMs) const;
+};
+
+#endif // KNX_DISCOVERY_H
@@ -0,0 +1,393 @@
+//==== include/knx_dpt.h ====
+
+#ifndef KNX_DPT_H
+#define KNX_DPT_H
+
+#include <Arduino.h>
+
+// Datapoint type codecs.
+//
+// KNXDpt<Main, Sub> describes how a value of DPT Main.Sub is laid out in the
+// application data of a group telegram:
+//   Value                 C++ type of the value
+//   LENGTH                bytes written by encode(), including the APCI octet
+//   encode(value, data)   writes GroupValue_Write data (data[0] = 0x80 | 6-bit
+//                         short value) into a caller buffer of LENGTH bytes
+//   decode(data, length, value)
+//                         reads KNXTelegram::data (data[0] = 6-bit short value,
+//                         payload from data[1]); false if the length is wrong
+//
+// Types of 6 bits or less (DPT 1, 2, 3) travel inside the APCI octet, all
+// others follow it. Encoding and decoding use integer arithmetic only; the
+// float types convert at the edge of the API.
+//
+//   uint8_t data[KNXDpt<9, 1>::LENGTH];
+//   size_t length = KNXDpt<9, 1>::encode(21.5f, data);
+
+template <uint16_t Main>
+struct KNXDptCodec;
+
+template <uint16_t Main, uint16_t Sub = 1>
+struct KNXDpt : KNXDptCodec<Main> {};
+
+namespace knx_dpt_detail {
+
+inline uint16_t read16(const uint8_t* data) {
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+inline uint32_t read32(const uint8_t* data) {
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+}
+
+inline void write16(uint8_t* data, uint16_t value) {
+    data[0] = value >> 8;
+    data[1] = value & 0xFF;
+}
+
+inline void write32(uint8_t* data, uint32_t value) {
+    data[0] = value >> 24;
+    data[1] = (value >> 16) & 0xFF;
+    data[2] = (value >> 8) & 0xFF;
+    data[3] = value & 0xFF;
+}
+
+// Codec for types carried in the 6 data bits of the APCI octet
+template <typename T, uint8_t Bits>
+struct ShortCodec {
+    using Value = T;
+    static constexpr size_t LENGTH = 1;
+    static constexpr uint8_t MASK = (1 << Bits) - 1;
+};
+
+} // namespace knx_dpt_detail
+
+// DPT 1.xxx: boolean (switch, up/down, open/close, ...)
+template <>
+struct KNXDptCodec<1> : knx_dpt_detail::ShortCodec<bool, 1> {
+    static size_t encode(bool value, uint8_t* data) {
+        data[0] = 0x80 | (value ? 1 : 0);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, bool& value) {
+        if (length != LENGTH) return false;
+        value = (data[0] & MASK) != 0;
+        return true;
+    }
+};
+
+// DPT 2.xxx: boolean with priority control
+struct KNXDpt2Value {
+    bool control;
+    bool value;
+};
+
+template <>
+struct KNXDptCodec<2> : knx_dpt_detail::ShortCodec<KNXDpt2Value, 2> {
+    static size_t encode(const KNXDpt2Value& value, uint8_t* data) {
+        data[0] = 0x80 | (value.control ? 0x02 : 0) | (value.value ? 0x01 : 0);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXDpt2Value& value) {
+        if (length != LENGTH) return false;
+        value.control = (data[0] & 0x02) != 0;
+        value.value = (data[0] & 0x01) != 0;
+        return true;
+    }
+};
+
+// DPT 3.xxx: relative dimming / blinds control. stepCode 0 stops, 1..7 select
+// an interval of 100% / 2^(stepCode - 1).
+struct KNXDpt3Value {
+    bool increase;
+    uint8_t stepCode;
+};
+
+template <>
+struct KNXDptCodec<3> : knx_dpt_detail::ShortCodec<KNXDpt3Value, 4> {
+    static size_t encode(const KNXDpt3Value& value, uint8_t* data) {
+        data[0] = 0x80 | (value.increase ? 0x08 : 0) | (value.stepCode & 0x07);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXDpt3Value& value) {
+        if (length != LENGTH) return false;
+        value.increase = (data[0] & 0x08) != 0;
+        value.stepCode = data[0] & 0x07;
+        return true;
+    }
+};
+
+// Codec for types that follow the APCI octet as big-endian integers
+template <typename T, size_t Bytes>
+struct KNXDptIntegerCodec {
+    using Value = T;
+    static constexpr size_t LENGTH = 1 + Bytes;
+
+    static size_t encode(T value, uint8_t* data) {
+        data[0] = 0x80;
+        uint32_t raw = (uint32_t)value;
+        for (size_t i = 0; i < Bytes; i++) {
+            data[Bytes - i] = (raw >> (8 * i)) & 0xFF;
+        }
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, T& value) {
+        if (length != LENGTH) return false;
+        uint32_t raw = 0;
+        for (size_t i = 1; i <= Bytes; i++) raw = (raw << 8) | data[i];
+        value = (T)raw;
+        return true;
+    }
+};
+
+// DPT 5.xxx: 8-bit unsigned, raw (5.004 percent 0..255, 5.010 counter, ...)
+template <> struct KNXDptCodec<5> : KNXDptIntegerCodec<uint8_t, 1> {};
+// DPT 6.xxx: 8-bit signed
+template <> struct KNXDptCodec<6> : KNXDptIntegerCodec<int8_t, 1> {};
+// DPT 7.xxx: 16-bit unsigned
+template <> struct KNXDptCodec<7> : KNXDptIntegerCodec<uint16_t, 2> {};
+// DPT 8.xxx: 16-bit signed
+template <> struct KNXDptCodec<8> : KNXDptIntegerCodec<int16_t, 2> {};
+// DPT 12.xxx: 32-bit unsigned
+template <> struct KNXDptCodec<12> : KNXDptIntegerCodec<uint32_t, 4> {};
+// DPT 13.xxx: 32-bit signed
+template <> struct KNXDptCodec<13> : KNXDptIntegerCodec<int32_t, 4> {};
+// DPT 17.xxx: scene number 0..63
+template <> struct KNXDptCodec<17> : KNXDptIntegerCodec<uint8_t, 1> {};
+// DPT 20.xxx: 8-bit enumeration (HVAC mode, ...)
+template <> struct KNXDptCodec<20> : KNXDptIntegerCodec<uint8_t, 1> {};
+
+// DPT 5.001 (0..100 %) and 5.003 (0..360 degrees) scale the range onto 0..255,
+// rounding to the nearest step.
+template <uint16_t Range>
+struct KNXDptScaledCodec {
+    using Value = uint16_t;
+    static constexpr size_t LENGTH = 2;
+
+    static size_t encode(uint16_t value, uint8_t* data) {
+        if (value > Range) value = Range;
+        data[0] = 0x80;
+        data[1] = (uint8_t)((value * 255U + Range / 2) / Range);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, uint16_t& value) {
+        if (length != LENGTH) return false;
+        value = (uint16_t)((data[1] * Range + 127U) / 255U);
+        return true;
+    }
+};
+
+template <> struct KNXDpt<5, 1> : KNXDptScaledCodec<100> {};
+template <> struct KNXDpt<5, 3> : KNXDptScaledCodec<360> {};
+
+// DPT 9.xxx: 2-byte float, value = 0.01 * M * 2^E with a 12-bit two's
+// complement mantissa M (sign in bit 15, low bits in 0..10) and a 4-bit
+// exponent E. The integer core works in hundredths of the unit. The code
+// 0x7FFF is reserved for invalid data (e.g. a broken sensor): NaN encodes to
+// it and decode() rejects it, so the largest value is 0x7FFE.
+template <>
+struct KNXDptCodec<9> {
+    using Value = float;
+    static constexpr size_t LENGTH = 3;
+    static constexpr int32_t MIN_HUNDREDTHS = -2048L * 32768; // -671088.64
+    static constexpr int32_t MAX_HUNDREDTHS = 2046L * 32768;  //  670433.28
+    static constexpr uint16_t INVALID = 0x7FFF;
+
+    // Smallest exponent whose rounded mantissa fits; halves round away from zero.
+    static uint16_t toRaw(int32_t hundredths) {
+        if (hundredths < MIN_HUNDREDTHS) hundredths = MIN_HUNDREDTHS;
+        if (hundredths > MAX_HUNDREDTHS) hundredths = MAX_HUNDREDTHS;
+        bool negative = hundredths < 0;
+        uint32_t magnitude = negative ? (uint32_t)(-hundredths) : (uint32_t)hundredths;
+
+        uint8_t exponent = 0;
+        uint32_t mantissa = magnitude;
+        while (negative ? mantissa > 2048 : mantissa > 2047) {
+            exponent++;
+            mantissa = (magnitude + (1UL << (exponent - 1))) >> exponent;
+        }
+        int32_t signedMantissa = negative ? -(int32_t)mantissa : (int32_t)mantissa;
+        return (negative ? 0x8000 : 0) | (exponent << 11) | (signedMantissa & 0x07FF);
+    }
+
+    static int32_t fromRaw(uint16_t raw) {
+        int32_t mantissa = raw & 0x07FF;
+        if (raw & 0x8000) mantissa -= 2048;
+        return mantissa * (int32_t)(1L << ((raw >> 11) & 0x0F));
+    }
+
+    static size_t encodeHundredths(int32_t hundredths, uint8_t* data) {
+        data[0] = 0x80;
+        knx_dpt_detail::write16(data + 1, toRaw(hundredths));
+        return LENGTH;
+    }
+    static bool decodeHundredths(const uint8_t* data, size_t length, int32_t& hundredths) {
+        if (length != LENGTH) return false;
+        uint16_t raw = knx_dpt_detail::read16(data + 1);
+        if (raw == INVALID) return false;
+        hundredths = fromRaw(raw);
+        return true;
+    }
+
+    static size_t encode(float value, uint8_t* data) {
+        // NaN fails every comparison below, and its conversion is undefined
+        if (value != value) {
+            data[0] = 0x80;
+            knx_dpt_detail::write16(data + 1, INVALID);
+            return LENGTH;
+        }
+        float scaled = value * 100.0f;
+        int32_t hundredths;
+        if (scaled >= (float)MAX_HUNDREDTHS) {
+            hundredths = MAX_HUNDREDTHS;
+        } else if (scaled <= (float)MIN_HUNDREDTHS) {
+            hundredths = MIN_HUNDREDTHS;
+        } else {
+            hundredths = (int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        }
+        return encodeHundredths(hundredths, data);
+    }
+    static bool decode(const uint8_t* data, size_t length, float& value) {
+        int32_t hundredths;
+        if (!decodeHundredths(data, length, hundredths)) return false;
+        value = hundredths / 100.0f;
+        return true;
+    }
+};
+
+// DPT 10.001: time of day. dayOfWeek 1 = Monday .. 7 = Sunday, 0 = no day.
+struct KNXTimeOfDay {
+    uint8_t dayOfWeek;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+};
+
+template <>
+struct KNXDptCodec<10> {
+    using Value = KNXTimeOfDay;
+    static constexpr size_t LENGTH = 4;
+
+    static size_t encode(const KNXTimeOfDay& value, uint8_t* data) {
+        data[0] = 0x80;
+        data[1] = ((value.dayOfWeek & 0x07) << 5) | (value.hour & 0x1F);
+        data[2] = value.minute & 0x3F;
+        data[3] = value.second & 0x3F;
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXTimeOfDay& value) {
+        if (length != LENGTH) return false;
+        value.dayOfWeek = data[1] >> 5;
+        value.hour = data[1] & 0x1F;
+        value.minute = data[2] & 0x3F;
+        value.second = data[3] & 0x3F;
+        return true;
+    }
+};
+
+// DPT 11.001: date, years 1990..2089
+struct KNXDate {
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+};
+
+template <>
+struct KNXDptCodec<11> {
+    using Value = KNXDate;
+    static constexpr size_t LENGTH = 4;
+
+    static size_t encode(const KNXDate& value, uint8_t* data) {
+        data[0] = 0x80;
+        data[1] = value.day & 0x1F;
+        data[2] = value.month & 0x0F;
+        data[3] = (value.year % 100) & 0x7F;
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXDate& value) {
+        if (length != LENGTH) return false;
+        uint8_t year = data[3] & 0x7F;
+        value.day = data[1] & 0x1F;
+        value.month = data[2] & 0x0F;
+        value.year = year >= 90 ? 1900 + year : 2000 + year;
+        return true;
+    }
+};
+
+// DPT 14.xxx: IEEE 754 single precision
+template <>
+struct KNXDptCodec<14> {
+    using Value = float;
+    static constexpr size_t LENGTH = 5;
+
+    static size_t encode(float value, uint8_t* data) {
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        data[0] = 0x80;
+        knx_dpt_detail::write32(data + 1, raw);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, float& value) {
+        if (length != LENGTH) return false;
+        uint32_t raw = knx_dpt_detail::read32(data + 1);
+        memcpy(&value, &raw, sizeof(value));
+        return true;
+    }
+};
+
+// DPT 16.000/16.001: up to 14 characters (ASCII / ISO 8859-1), zero padded
+struct KNXDptString {
+    char text[15];
+
+    KNXDptString() { text[0] = '\0'; }
+    KNXDptString(const char* source) {
+        strncpy(text, source, sizeof(text) - 1);
+        text[sizeof(text) - 1] = '\0';
+    }
+};
+
+template <>
+struct KNXDptCodec<16> {
+    using Value = KNXDptString;
+    static constexpr size_t LENGTH = 15;
+
+    static size_t encode(const KNXDptString& value, uint8_t* data) {
+        data[0] = 0x80;
+        size_t i = 0;
+        for (; i < 14 && value.text[i] != '\0'; i++) data[1 + i] = (uint8_t)value.text[i];
+        for (; i < 14; i++) data[1 + i] = 0;
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXDptString& value) {
+        if (length != LENGTH) return false;
+        memcpy(value.text, data + 1, 14);
+        value.text[14] = '\0';
+        return true;
+    }
+};
+
+// DPT 18.001: scene control, activate or learn scene 0..63
+struct KNXSceneControl {
+    bool learn;
+    uint8_t scene;
+};
+
+template <>
+struct KNXDptCodec<18> {
+    using Value = KNXSceneControl;
+    static constexpr size_t LENGTH = 2;
+
+    static size_t encode(const KNXSceneControl& value, uint8_t* data) {
+        data[0] = 0x80;
+        data[1] = (value.learn ? 0x80 : 0) | (value.scene & 0x3F);
+        return LENGTH;
+    }
+    static bool decode(const uint8_t* data, size_t length, KNXSceneControl& value) {
+        if (length != LENGTH) return false;
+        value.learn = (data[1] & 0x80) != 0;
+        value.scene = data[1] & 0x3F;
+        return true;
+    }
+};
+
+#endif // KNX_DPT_H
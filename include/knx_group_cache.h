@@ -0,0 +1,108 @@
+//==== include/knx_group_cache.h ====
+
+#ifndef KNX_GROUP_CACHE_H
+#define KNX_GROUP_CACHE_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+#include "knx_telegram.h"
+
+// Settings of the optional group value cache (see KNXIPModule::enableGroupCache)
+struct KNXGroupCacheConfig {
+    size_t capacity = 64;      // Group addresses tracked (table: next power of two >= total * 4/3)
+    size_t ownedCapacity = 16; // Further slots only owned addresses may take
+    bool answerReads = true; // Answer GroupValue_Read for owned addresses from the cache
+};
+
+// Last value seen for a group address. `data` follows the KNXTelegram layout:
+// data[0] holds the 6 data bits of the APCI octet, then the payload.
+struct KNXCachedValue {
+    uint16_t groupAddress;
+    uint16_t sourceAddress; // Sender of the last write or response
+    uint32_t timestamp;     // millis() of the last update
+    uint32_t count;         // Telegrams that updated the value; 0 if restored from a snapshot
+    uint8_t length;
+    uint8_t data[KNX_TELEGRAM_MAX_DATA];
+};
+
+struct KNXGroupCacheStats {
+    uint32_t entries;       // Group addresses in the table
+    uint32_t owned;         // Of them, owned by this device
+    uint32_t capacity;      // Without the slots kept for owned addresses
+    uint32_t updates;
+    uint32_t rejected;      // Updates dropped because the table was full
+    uint32_t hits;          // Lookups answered from the cache
+    uint32_t misses;
+    uint32_t readsAnswered; // GroupValue_Reads answered locally
+};
+
+// Group address -> last value table. Open addressing with linear probing in a
+// power-of-two table allocated once; entries are never removed, so a full
+// table simply stops taking new addresses. Owned addresses count against
+// capacity + ownedCapacity, all others against capacity alone, so bus traffic
+// cannot crowd out setOwned().
+class KNXGroupCache {
+public:
+    KNXGroupCache();
+    ~KNXGroupCache();
+
+    bool begin(const KNXGroupCacheConfig& config);
+    void end();
+    bool isActive() const { return slots != nullptr; }
+    bool answersReads() const { return config.answerReads; }
+
+    // Stores a value seen on the bus or sent by this device.
+    void update(uint16_t groupAddress, uint16_t sourceAddress, const uint8_t* data, size_t length,
+                uint32_t timestamp);
+
+    // Copies the cached value; false if the address has no value yet.
+    bool lookup(uint16_t groupAddress, KNXCachedValue& value);
+
+    // Marks an address as owned by this device: reads of it are answered from
+    // the cache. Returns false if the table is full.
+    bool setOwned(uint16_t groupAddress, bool owned);
+
+    // Copies the value of an owned address for a read response.
+    bool lookupOwned(uint16_t groupAddress, KNXCachedValue& value);
+
+    bool isOwned(uint16_t groupAddress);
+
+    // Sets a value read back from a snapshot. Addresses seen on the bus since
+    // keep their value. The value is not marked as changed.
+    bool restore(uint16_t groupAddress, const uint8_t* data, size_t length, uint32_t timestamp);
+    // Walks the restored values not yet updated from the bus (start at 0)
+    bool nextRestored(uint32_t& cursor, KNXCachedValue& value);
+
+    // Walks the table from cursor (start at 0): copies the next value, or the
+    // next one changed since it was last taken, and clears its changed flag.
+    bool nextValue(uint32_t& cursor, KNXCachedValue& value, bool changedOnly);
+    // Flags a value as changed again, e.g. after persisting it failed.
+    void markChanged(uint16_t groupAddress);
+
+    KNXGroupCacheStats stats();
+
+private:
+    struct Slot {
+        bool used;
+        bool owned;
+        bool changed; // Value differs from the one last taken by nextValue()
+        KNXCachedValue value;
+    };
+
+    KNXLock lock;
+    KNXGroupCacheConfig config;
+    Slot* slots;
+    uint32_t mask;  // Table size - 1
+    uint8_t shift;  // 32 - log2(table size), for Fibonacci hashing
+    KNXGroupCacheStats counters;
+
+    // Group addresses cluster in a few main/middle groups; Fibonacci hashing spreads them
+    uint32_t indexOf(uint16_t groupAddress) const {
+        return (uint32_t)(groupAddress * 2654435769U) >> shift;
+    }
+    Slot* find(uint16_t groupAddress);
+    Slot* findOrInsert(uint16_t groupAddress, bool owned);
+};
+
+#endif // KNX_GROUP_CACHE_H
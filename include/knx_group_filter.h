@@ -0,0 +1,58 @@
+//==== include/knx_group_filter.h ====
+
+#ifndef KNX_GROUP_FILTER_H
+#define KNX_GROUP_FILTER_H
+
+#include <Arduino.h>
+#include "knx_group_table.h"
+#include "knx_memory.h"
+
+// Group address filter rules of a router path, e.g.
+//     KNXGroupFilter().passMainGroup(1).block(1 << 11 | 7 << 8 | 1)
+// Rules apply in order, later ones override earlier ones; an address no rule
+// covers is blocked. compile() turns the rules into a bitmap so the forward
+// path costs one bit test however many rules there are. In the static
+// allocation profile a filter holds at most KNX_MAX_FILTER_RULES rules.
+class KNXGroupFilter {
+public:
+    KNXGroupFilter() : individual(false), overflow(false) {}
+
+    KNXGroupFilter& passAll() { return addRule(0, 0xFFFF, true); }
+    KNXGroupFilter& pass(uint16_t groupAddress) { return addRule(groupAddress, groupAddress, true); }
+    KNXGroupFilter& passRange(uint16_t first, uint16_t last) { return addRule(first, last, true); }
+    KNXGroupFilter& passMainGroup(uint8_t mainGroup);
+    KNXGroupFilter& passMiddleGroup(uint8_t mainGroup, uint8_t middleGroup);
+
+    KNXGroupFilter& block(uint16_t groupAddress) { return addRule(groupAddress, groupAddress, false); }
+    KNXGroupFilter& blockRange(uint16_t first, uint16_t last) { return addRule(first, last, false); }
+    KNXGroupFilter& blockMainGroup(uint8_t mainGroup);
+    KNXGroupFilter& blockMiddleGroup(uint8_t mainGroup, uint8_t middleGroup);
+
+    // Frames to individual addresses (device management) carry no group
+    // address; they are forwarded only when enabled here.
+    KNXGroupFilter& passIndividual(bool enabled = true) {
+        individual = enabled;
+        return *this;
+    }
+    bool passesIndividual() const { return individual; }
+
+    void compile(KNXGroupAddressBitmap& bitmap) const;
+    size_t ruleCount() const { return rules.size(); }
+    // Rules were dropped because the static rule table was full
+    bool overflowed() const { return overflow; }
+
+private:
+    struct Rule {
+        uint16_t first;
+        uint16_t last;
+        bool pass;
+    };
+
+    KNXVector<Rule, KNX_MAX_FILTER_RULES> rules;
+    bool individual;
+    bool overflow;
+
+    KNXGroupFilter& addRule(uint16_t first, uint16_t last, bool pass);
+};
+
+#endif // KNX_GROUP_FILTER_H
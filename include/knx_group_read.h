@@ -0,0 +1,134 @@
+//==== include/knx_group_read.h ====
+
+#ifndef KNX_GROUP_READ_H
+#define KNX_GROUP_READ_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_memory.h"
+#include "knx_platform.h"
+#include "knx_telegram.h"
+
+// Settings of asynchronous group reads (see KNXIPModule::enableGroupReads)
+struct KNXGroupReadConfig {
+    size_t capacity = 64;      // Reads queued or outstanding
+    uint8_t window = 8;        // GroupValue_Reads awaiting a response at once
+    uint16_t timeoutMs = 2000; // Default wait for the response to one transmission
+    uint8_t retries = 1;       // Repeats of a read that got no response
+    KNXPriority priority = KNX_PRIORITY_LOW;
+};
+
+enum KNXReadStatus {
+    KNX_READ_QUEUED,      // Waiting for room in the window
+    KNX_READ_OUTSTANDING, // Sent, waiting for the GroupValue_Response
+    KNX_READ_DONE,
+    KNX_READ_TIMEOUT,     // No response after the last retry
+    KNX_READ_CANCELLED
+};
+
+// Outcome of a read. `data` follows the KNXTelegram layout: data[0] holds the
+// 6 data bits of the APCI octet, then the payload.
+struct KNXReadResult {
+    uint16_t groupAddress;
+    KNXReadStatus status;
+    uint16_t sourceAddress; // Device that responded
+    uint32_t latencyMs;     // From the first transmission to the response
+    uint8_t attempts;       // Transmissions
+    uint8_t length;
+    uint8_t data[KNX_TELEGRAM_MAX_DATA];
+};
+
+struct KNXGroupReadStats {
+    uint32_t requested;
+    uint32_t rejected;    // Requests refused because every slot was taken
+    uint32_t sent;        // GroupValue_Reads transmitted, retries included
+    uint32_t retries;
+    uint32_t completed;   // Reads answered by a GroupValue_Response
+    uint32_t timeouts;
+    uint32_t cancelled;
+    uint32_t queued;      // Reads currently waiting for the window
+    uint32_t outstanding; // Reads currently awaiting a response
+    uint32_t capacity;
+};
+
+// Identifies a read; 0 is never a valid handle
+typedef uint32_t KNXReadHandle;
+typedef KNXFunction<void(const KNXReadResult& result)> KNXReadCallback;
+
+// Tracks GroupValue_Reads so many can be in flight at once. Requests wait in
+// a FIFO until the window has room; each response completes every read of its
+// address, queued ones included, and reads without a response are repeated
+// and finally time out. Completed slots go to the back of the free list, so a
+// result stays available through its handle until the slot is reused.
+//
+// The module sends the reads (takeDue) and delivers completions outside the
+// lock, so callbacks may start new reads.
+class KNXGroupReader {
+public:
+    KNXGroupReader();
+    ~KNXGroupReader();
+
+    bool begin(const KNXGroupReadConfig& config);
+    void end();
+    bool isActive() const { return entries != nullptr; }
+    KNXPriority priority() const { return config.priority; }
+
+    // Returns 0 if every slot is taken. timeoutMs 0 uses the configured one.
+    KNXReadHandle request(uint16_t groupAddress, uint16_t timeoutMs, const KNXReadCallback& callback);
+    // False once the slot has been reused for another read.
+    bool result(KNXReadHandle handle, KNXReadResult& result);
+    bool cancel(KNXReadHandle handle);
+
+    // Next read to transmit, a new one or a repeat: it is outstanding from now
+    // on. False if none is due or the window is full.
+    bool takeDue(uint32_t nowMs, KNXReadHandle& handle, uint16_t& groupAddress);
+    // The transmission of a taken read failed: it goes back to the queue head.
+    void sendFailed(KNXReadHandle handle);
+    // Completes one read whose last transmission went unanswered.
+    bool takeExpired(uint32_t nowMs, KNXReadResult& result, KNXReadCallback& callback);
+    // Milliseconds until takeDue() or takeExpired() has work, UINT32_MAX if
+    // none; queued reads count only when the connection can take them
+    uint32_t msUntilDue(uint32_t nowMs, bool canSend);
+
+    // Whether a response to this address would complete a read
+    bool awaiting(uint16_t groupAddress);
+    // Completes one read of the address with a GroupValue_Response; call until
+    // it returns false.
+    bool complete(uint16_t groupAddress, uint16_t sourceAddress, const uint8_t* data, size_t length,
+                  uint32_t nowMs, KNXReadResult& result, KNXReadCallback& callback);
+
+    KNXGroupReadStats stats();
+
+private:
+    static const uint16_t NONE = 0xFFFF;
+
+    struct Entry {
+        uint16_t groupAddress;
+        uint16_t generation;
+        uint16_t next;       // Queue or free list link
+        uint16_t timeoutMs;
+        uint8_t status;      // KNXReadStatus, or FREE
+        uint8_t attempts;
+        uint32_t firstSent;
+        uint32_t deadline;
+        KNXReadResult result;
+        KNXReadCallback callback;
+    };
+    static const uint8_t FREE = 0xFF;
+
+    KNXLock lock;
+    KNXGroupReadConfig config;
+    Entry* entries;
+    uint16_t* outstanding;   // Indices of the reads in the window
+    uint8_t outstandingCount;
+    uint16_t queueHead, queueTail;
+    uint16_t freeHead, freeTail;
+    KNXGroupReadStats counters;
+
+    Entry* lookup(KNXReadHandle handle, uint16_t& index);
+    void release(uint16_t index, KNXReadStatus status, KNXReadResult& result, KNXReadCallback& callback);
+    void removeOutstanding(uint8_t position);
+    void unlinkQueued(uint16_t index);
+};
+
+#endif // KNX_GROUP_READ_H
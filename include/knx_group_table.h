@@ -0,0 +1,103 @@
+//==== include/knx_group_table.h ====
+
+#ifndef KNX_GROUP_TABLE_H
+#define KNX_GROUP_TABLE_H
+
+#include <Arduino.h>
+#include "knx_memory.h"
+#include "knx_telegram.h"
+
+// Callback definition for group address notifications
+using KNXGroupAddressCallback = KNXFunction<void(const KNXTelegram& telegram)>;
+
+// One bit per 16-bit group address (8 KB).
+class KNXGroupAddressBitmap {
+public:
+    static constexpr size_t WORDS = 65536 / 32;
+
+    KNXGroupAddressBitmap() { clear(); }
+
+    bool test(uint16_t address) const {
+        return (words[address >> 5] >> (address & 31)) & 1;
+    }
+    void set(uint16_t address) { words[address >> 5] |= 1UL << (address & 31); }
+    void reset(uint16_t address) { words[address >> 5] &= ~(1UL << (address & 31)); }
+    void clear() { memset(words, 0, sizeof(words)); }
+
+    // Sets or clears every address in [first, last].
+    void setRange(uint16_t first, uint16_t last) {
+        for (uint32_t address = first; address <= last; address++) set((uint16_t)address);
+    }
+    void resetRange(uint16_t first, uint16_t last) {
+        for (uint32_t address = first; address <= last; address++) reset((uint16_t)address);
+    }
+
+    uint32_t word(size_t index) const { return words[index]; }
+
+private:
+    uint32_t words[WORDS];
+};
+
+// Group address -> callbacks dispatch structure.
+//
+// Exact subscriptions are kept in a bitmap plus a per-word rank index: the
+// rank of a set bit is the slot of that address in a compact, address-sorted
+// callback array, so a lookup is two memory reads and a popcount regardless of
+// how many addresses are registered. Whole main groups (x/-/-) and middle
+// groups (x/y/-) are tracked in small masks so they need no per-address
+// registration. accepts() is cheap enough to reject unsubscribed traffic
+// before a frame is parsed.
+class KNXGroupDispatchTable {
+public:
+    KNXGroupDispatchTable();
+
+    // Return false once the table is full (static allocation profile)
+    bool add(uint16_t groupAddress, KNXGroupAddressCallback callback);
+    bool addMainGroup(uint8_t mainGroup, KNXGroupAddressCallback callback);
+    bool addMiddleGroup(uint8_t mainGroup, uint8_t middleGroup, KNXGroupAddressCallback callback);
+
+    void remove(uint16_t groupAddress);
+    void removeMainGroup(uint8_t mainGroup);
+    void removeMiddleGroup(uint8_t mainGroup, uint8_t middleGroup);
+
+    bool accepts(uint16_t groupAddress) const {
+        return exact.test(groupAddress) ||
+            ((mainGroups >> (groupAddress >> 11)) & 1) ||
+            ((middleGroups[groupAddress >> 13] >> ((groupAddress >> 8) & 31)) & 1);
+    }
+
+    // Calls exact, middle group and main group callbacks, in that order.
+    void dispatch(const KNXTelegram& telegram) const;
+
+    size_t addressCount() const { return slotStart.size() - 1; }
+    size_t callbackCount() const { return entries.size() + ranges.size(); }
+
+private:
+    struct Entry {
+        uint16_t groupAddress;
+        KNXGroupAddressCallback callback;
+    };
+
+    // Range subscription key: main group in bits 8..12, middle group in bits
+    // 0..2, RANGE_MAIN_ONLY set for whole main groups.
+    static constexpr uint16_t RANGE_MAIN_ONLY = 0x8000;
+    struct RangeEntry {
+        uint16_t key;
+        KNXGroupAddressCallback callback;
+    };
+
+    KNXGroupAddressBitmap exact;
+    uint16_t rank[KNXGroupAddressBitmap::WORDS]; // Set bits in all preceding words
+    KNXVector<Entry, KNX_MAX_CALLBACKS> entries;           // Sorted by group address
+    KNXVector<uint32_t, KNX_MAX_CALLBACKS + 1> slotStart;  // First entry of each subscribed address
+
+    uint32_t mainGroups;      // Bit per main group with a range subscription
+    uint32_t middleGroups[8]; // Bit per (main, middle) pair, indexed by address >> 8
+    KNXVector<RangeEntry, KNX_MAX_RANGE_CALLBACKS> ranges;
+
+    void rebuildIndex();
+    void rebuildRangeMasks();
+    size_t slotOf(uint16_t groupAddress) const;
+};
+
+#endif // KNX_GROUP_TABLE_H
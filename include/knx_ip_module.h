@@ -7,12 +7,30 @@
 #include <WiFi.h>
 #include <AsyncUDP.h>
 #include <functional>
-#include <map>
 #include <vector>
-
-// KNX Constants
-#define KNX_PORT 3671
-#define KNX_MULTICAST_IP IPAddress(224, 0, 23, 12)
+#include "knx_memory.h"
+#include "knx_telegram.h"
+#include "knx_group_table.h"
+#include "knx_platform.h"
+#include "knx_rx_queue.h"
+#include "knx_tx_queue.h"
+#include "knx_protocol.h"
+#include "knx_tunnel.h"
+#include "knx_group_cache.h"
+#include "knx_dpt.h"
+#include "knx_trace.h"
+#include "knx_stats.h"
+#include "knx_routing_flow.h"
+#include "knx_dedup.h"
+#include "knx_capture.h"
+#include "knx_batch.h"
+#include "knx_discovery.h"
+#include "knx_group_read.h"
+#include "knx_snapshot.h"
+#include "knx_secure.h"
+#include "knx_value_filter.h"
+#include "knx_scheduler.h"
+#include "knx_bus_analytics.h"
 
 // Communication Modes
 enum KNXConnectionType {
@@ -20,54 +38,300 @@ enum KNXConnectionType {
     KNX_CONNECTION_MULTICAST  // Multicast mode for monitoring
 };
 
-// DPT Types (partial list)
+// DPT Types of the legacy helpers below; knx_dpt.h covers the full set
 enum KNXDataPointType {
     KNX_DPT_1_001,  // 1-bit boolean
     KNX_DPT_5_001,  // 8-bit unsigned (percentage)
     KNX_DPT_9_001   // 2-byte float (temperature)
-    // Add more as needed
 };
 
-// KNX Telegram structure for better parsing
-struct KNXTelegram {
-    uint16_t sourceAddress;
-    uint16_t targetAddress;
-    bool isGroupAddress;
-    uint8_t routingCounter;
-    uint8_t command;
-    std::vector<uint8_t> data;
-    
-    String toString() const;
+// RAM held by the KNX stack (see KNXIPModule::getRamReport). The module object
+// holds the fixed tables; buffers sized by the enable*() configurations are
+// counted in `buffers`.
+struct KNXRamReport {
+    bool staticProfile;     // Built with KNX_STATIC_ALLOCATION
+    uint32_t moduleBytes;   // sizeof(KNXIPModule)
+    uint32_t callbackBytes; // Callback tables, part of moduleBytes
+    KNXMemoryStats buffers; // Pool (static profile) or heap blocks of the stack
 };
 
-// Callback definition for group address notifications
-using KNXGroupAddressCallback = std::function<void(const KNXTelegram& telegram)>;
-
 class KNXIPModule {
 public:
     KNXIPModule(); 
+    ~KNXIPModule();
     
     // Setup functions
     bool begin(const IPAddress& gatewayIP, int knxArea, int knxLine, int knxMember);
     bool beginMulticast(int knxArea, int knxLine, int knxMember);
+    
+    // Tunnelling without a fixed gateway: searches the network for KNXnet/IP
+    // servers, probes them for round-trip time and free tunnel slots and
+    // connects to the best. When the connection is refused or lost (heartbeat
+    // or ACK timeouts), loop() fails over to the next best gateway; frames not
+    // yet acknowledged go out on the new connection.
+    bool beginDiscovery(int knxArea, int knxLine, int knxMember,
+                        const KNXDiscoveryConfig& config = KNXDiscoveryConfig());
+    // Candidate that a search may not find, e.g. behind a router without
+    // multicast forwarding. Call before beginDiscovery().
+    bool addGateway(const IPAddress& gatewayIP, uint16_t port = KNX_PORT);
+    size_t getGateways(KNXGatewayInfo* gateways, size_t maxGateways);
+    IPAddress getGatewayIP() const { return gatewayIP; }
     void setDebugLevel(uint8_t level);
     
+    // Tunnelling connection used in unicast mode. The configuration applies
+    // from the next begin().
+    void setTunnelConfig(const KNXTunnelConfig& config);
+    bool isConnected() const;
+    KNXTunnelStats getTunnelStats();
+    
+    // Routing flow control in multicast mode: ROUTING_BUSY from an IP router
+    // pauses our routing indications, ROUTING_LOST_MESSAGE reports widen the
+    // spacing between them. Without a transmit queue, sends during a pause
+    // fail; with one, they wait in the queue.
+    void setRoutingFlowConfig(const KNXRoutingFlowConfig& config);
+    KNXRoutingFlowState getRoutingFlowState();
+    
+    // KNX IP Secure. Secure routing wraps every routing frame with the
+    // backbone key, keeps the routing timer in step with the other devices
+    // (TIMER_NOTIFY from loop()) and refuses plain routing frames; call before
+    // beginMulticast(). A secure tunnel opens an authenticated session before
+    // each connection and wraps all of its frames; call before begin() or
+    // beginDiscovery(). Keys come from the ETS keyring, passwords through
+    // knxSecureUserPasswordKey() and knxSecureDeviceAuthenticationCode().
+    bool enableSecureRouting(const KNXSecureRoutingConfig& config);
+    void disableSecureRouting();
+    KNXSecureStats getSecureRoutingStats();
+    bool enableSecureTunnel(const KNXSecureTunnelConfig& config);
+    void disableSecureTunnel();
+    KNXSecureStats getSecureTunnelStats();
+    
+    // Optional dispatch task: the AsyncUDP callback only queues raw cEMI frames
+    // and a separate task parses them and runs the callbacks, so slow callbacks
+    // cannot stall the network task. Call before begin()/beginMulticast().
+    bool enableDispatchTask(const KNXDispatchTaskConfig& config = KNXDispatchTaskConfig());
+    void disableDispatchTask();
+    KNXRxQueueStats getRxQueueStats() const;
+    
+    // Optional transmit scheduler: group writes are queued per priority class,
+    // pending writes to the same address are coalesced and transmission is
+    // paced to a telegrams/s budget. Queued telegrams go out from loop().
+    bool enableTxQueue(const KNXTxQueueConfig& config = KNXTxQueueConfig());
+    void disableTxQueue();
+    KNXTxQueueStats getTxQueueStats();
+    
+    // Optional group value cache: keeps the last value of the subscribed and
+    // owned group addresses, as seen on the bus or sent by this device, so
+    // state can be read without a bus round-trip. GroupValue_Reads of owned
+    // addresses are answered from the cache. Call before begin()/beginMulticast().
+    bool enableGroupCache(const KNXGroupCacheConfig& config = KNXGroupCacheConfig());
+    void disableGroupCache();
+    bool getCachedValue(int groupAddress, KNXCachedValue& value);
+    bool setOwnedAddress(int groupAddress, bool owned = true);
+    KNXGroupCacheStats getGroupCacheStats();
+    
+    // Optional group state snapshot: values in the group cache are persisted
+    // to flash from loop() (only changed ones, at most every intervalMs) and
+    // restored by begin()/beginMulticast(), so getCachedValue() and the
+    // callbacks registered before begin have values right after boot.
+    // Restored values have a count of 0. Call after enableGroupCache().
+    bool enableSnapshot(KNXFlashStore& store, const KNXSnapshotConfig& config = KNXSnapshotConfig());
+    void disableSnapshot();
+    // Persists changed values now, e.g. before an OTA update restarts the chip
+    bool saveSnapshot();
+    KNXSnapshotStats getSnapshotStats();
+    
+    // Optional dedup stage for multicast reception: drops our own routing
+    // indications coming back through multicast loopback and frames repeated
+    // by several routers or TP repeaters, so each bus event reaches the
+    // callbacks once. Call before beginMulticast().
+    bool enableDedup(const KNXDedupConfig& config = KNXDedupConfig());
+    void disableDedup();
+    KNXDedupStats getDedupStats();
+    
+    // Optional trace buffer: with a debug level set, datagrams and telegrams are
+    // recorded as compact binary records instead of being printed from the
+    // network task. A low-priority task prints them, or dumpTrace() on demand.
+    bool enableTrace(const KNXTraceConfig& config = KNXTraceConfig());
+    void disableTrace();
+    size_t dumpTrace(Print& output, size_t maxRecords = SIZE_MAX);
+    KNXTraceStats getTraceStats();
+    
+    // Optional packet capture: every KNXnet/IP datagram sent or received is
+    // kept as a pcap record in a RAM ring buffer. dumpCapture() writes a
+    // complete pcap file to any Print (Serial, a WiFiClient); with a stream
+    // address configured, loop() sends the records there over UDP instead,
+    // starting with the pcap file header.
+    bool enableCapture(const KNXCaptureConfig& config = KNXCaptureConfig());
+    void disableCapture();
+    size_t dumpCapture(Print& output);
+    KNXCaptureStats getCaptureStats();
+    
+    // Per-stage counters and latency histograms of the receive and send paths.
+    // enableStatsEndpoint() answers any datagram to the given port with a
+    // snapshot, so the numbers can be polled from a PC on the same network.
+    KNXStats getStats();
+    void resetStats();
+    bool enableStatsEndpoint(uint16_t port, KNXStatsFormat format = KNX_STATS_JSON);
+    void disableStatsEndpoint();
+    
+    // Optional bus analytics, to find out who floods the bus: frame and APCI
+    // counters, frames per second and minute, the TP1 bus load estimated from
+    // frame lengths, and the top source and group addresses by a fixed-size
+    // summary. Counts every frame received, subscribed or not, and our own
+    // sends, at constant cost per frame. In multicast mode, enable dedup too
+    // when several routers forward the same frames.
+    bool enableBusAnalytics(const KNXBusAnalyticsConfig& config = KNXBusAnalyticsConfig());
+    void disableBusAnalytics();
+    KNXBusStats getBusStats();
+    // Most frequent first; return the number of entries written
+    size_t getTopSources(KNXTopAddress* entries, size_t maxEntries);
+    size_t getTopGroupAddresses(KNXTopAddress* entries, size_t maxEntries);
+    void resetBusAnalytics();
+    
+    // RAM used by the stack, e.g. to size KNX_STATIC_POOL_SIZE from the pool
+    // high-water mark. printRamReport() adds the size of each component.
+    KNXRamReport getRamReport() const;
+    void printRamReport(Print& output) const;
+    
+    // Services background work (tunnel timers, the transmit queue); call from
+    // the sketch's loop()
+    void loop();
+    // loop(), then the milliseconds until it has work again (scheduler
+    // entries, tunnel timers, read timeouts, queued telegrams), so the sketch
+    // can sleep instead of spinning: delay(min(module.poll(), 100)). Received
+    // telegrams do not wait for it, they are dispatched by the network task, or
+    // the dispatch task after enableDispatchTask().
+    uint32_t poll();
+    
     // Communication functions
-    bool sendKNXMessage(int groupAddress, const uint8_t* data, size_t dataLength);
+    bool sendKNXMessage(int groupAddress, const uint8_t* data, size_t dataLength,
+                        KNXPriority priority = KNX_PRIORITY_LOW);
+    
+    // Typed group write, e.g. send<KNXDpt<9, 1>>(ga, 21.5f). Encodes on the stack.
+    template <typename Dpt>
+    bool send(int groupAddress, const typename Dpt::Value& value,
+              KNXPriority priority = KNX_PRIORITY_LOW) {
+        uint8_t data[Dpt::LENGTH];
+        size_t length = Dpt::encode(value, data);
+        return sendKNXMessage(groupAddress, data, length, priority);
+    }
+    
+    // Sends the pre-encoded group writes of a batch (e.g. a scene) back-to-back
+    // and records each entry's status in the batch. With the transmit queue
+    // enabled the entries are queued instead. Returns the entries sent or queued.
+    size_t sendBatch(KNXBatch& batch, KNXBatchOrder order = KNX_BATCH_IN_ORDER);
+    
+    // Asynchronous GroupValue_Reads: readGroupValue() queues a read and returns
+    // at once; up to `window` reads are on the bus together and each
+    // GroupValue_Response completes the reads of its address. The callback
+    // runs where responses are dispatched (network or dispatch task), or in
+    // loop() on timeout. Reads wait in the queue while the connection is down.
+    bool enableGroupReads(const KNXGroupReadConfig& config = KNXGroupReadConfig());
+    void disableGroupReads();
+    // Returns 0 if the read queue is full or reads are not enabled
+    KNXReadHandle readGroupValue(int groupAddress, KNXReadCallback callback = nullptr,
+                                 uint16_t timeoutMs = 0);
+    bool getReadResult(KNXReadHandle handle, KNXReadResult& result);
+    bool cancelRead(KNXReadHandle handle);
+    KNXGroupReadStats getGroupReadStats();
+    
+    // Optional scheduler for timed work, on one hierarchical timer wheel:
+    // one-shot timeouts, cyclic group sends whose value comes from a provider,
+    // and send objects that go out when their value changes (at most every
+    // minIntervalMs) and are repeated every refreshMs. Due entries run from
+    // loop()/poll(), or from a task of their own with config.task.
+    bool enableScheduler(const KNXSchedulerConfig& config = KNXSchedulerConfig());
+    void disableScheduler();
+    // Return 0 if the scheduler is full or not enabled
+    KNXTimerHandle setTimeout(uint32_t delayMs, KNXTimerCallback callback);
+    KNXTimerHandle sendCyclic(int groupAddress, uint32_t periodMs, KNXValueProvider provider,
+                              KNXPriority priority = KNX_PRIORITY_LOW);
+    // Typed cyclic send: provider() returns the value, e.g.
+    // sendCyclic<KNXDpt<9, 1>>(ga, 60000, [] { return readTemperature(); })
+    template <typename Dpt, typename Provider>
+    KNXTimerHandle sendCyclic(int groupAddress, uint32_t periodMs, Provider provider,
+                              KNXPriority priority = KNX_PRIORITY_LOW) {
+        static_assert(Dpt::LENGTH <= KNX_CEMI_STANDARD_APDU, "value does not fit a standard frame");
+        return sendCyclic(groupAddress, periodMs, [provider](uint8_t* data) -> size_t {
+            return Dpt::encode(provider(), data);
+        }, priority);
+    }
+    // refreshMs 0 sends on change only
+    KNXTimerHandle addSendObject(int groupAddress, uint32_t refreshMs, uint32_t minIntervalMs = 0,
+                                 KNXPriority priority = KNX_PRIORITY_LOW);
+    // Sets the value of a send object (sendKNXMessage layout) and sends it if
+    // it changed and the minimum interval allows. False for unknown handles.
+    bool updateSendObject(KNXTimerHandle handle, const uint8_t* data, size_t dataLength);
+    template <typename Dpt>
+    bool updateSendObject(KNXTimerHandle handle, const typename Dpt::Value& value) {
+        uint8_t data[Dpt::LENGTH];
+        size_t length = Dpt::encode(value, data);
+        return updateSendObject(handle, data, length);
+    }
+    bool cancelTimer(KNXTimerHandle handle);
+    KNXSchedulerStats getSchedulerStats();
     
     // Higher-level functions with DPT support
     bool sendBool(int groupAddress, bool value);  // DPT 1.001
-    bool sendPercentage(int groupAddress, uint8_t percentage);  // DPT 5.001
+    bool sendPercentage(int groupAddress, uint8_t percentage);  // DPT 5.001 (0-100)
     bool sendTemperature(int groupAddress, float temperature);  // DPT 9.001
     
-    // Callback registration
-    void onGroupAddress(int groupAddress, KNXGroupAddressCallback callback);
+    // Callback registration. Returns false once the callback table is full
+    // (static allocation profile).
+    bool onGroupAddress(int groupAddress, KNXGroupAddressCallback callback);
     void removeCallback(int groupAddress);
     
-    // DPT conversion utilities
+    // Filtered subscription: GroupValue_Writes and _Responses reach the
+    // callback only if they pass the filter (change of value, deadband,
+    // minimum interval, averaging, downsampling); reads pass unfiltered. The
+    // numeric stages need the codec of the address's DPT, knxValueCodec<Dpt>().
+    // Returns false if the filter table is full or a needed codec is missing.
+    bool onGroupAddress(int groupAddress, const KNXValueFilter& filter, KNXGroupAddressCallback callback,
+                        const KNXValueCodec* codec = nullptr);
+    KNXValueFilterStats getValueFilterStats();
+    
+    // Typed callback for writes and read responses whose data decodes as Dpt;
+    // telegrams of the wrong length are skipped. The callback is called as
+    // callback(const Dpt::Value& value, const KNXTelegram& telegram).
+    template <typename Dpt, typename Callback>
+    bool onGroupValue(int groupAddress, Callback callback) {
+        return onGroupAddress(groupAddress, [callback](const KNXTelegram& telegram) {
+            if (telegram.command != KNX_APCI_GROUP_VALUE_WRITE &&
+                telegram.command != KNX_APCI_GROUP_VALUE_RESPONSE) return;
+            typename Dpt::Value value = typename Dpt::Value();
+            if (Dpt::decode(telegram.data.data(), telegram.data.size(), value)) {
+                callback(value, telegram);
+            }
+        });
+    }
+    
+    // Typed and filtered, e.g. a temperature forwarded when it moved 0.2 K:
+    // onGroupValue<KNXDpt<9, 1>>(ga, filter, callback) with filter.deadband = 0.2
+    template <typename Dpt, typename Callback>
+    bool onGroupValue(int groupAddress, const KNXValueFilter& filter, Callback callback) {
+        return onGroupAddress(groupAddress, filter, [callback](const KNXTelegram& telegram) {
+            if (telegram.command != KNX_APCI_GROUP_VALUE_WRITE &&
+                telegram.command != KNX_APCI_GROUP_VALUE_RESPONSE) return;
+            typename Dpt::Value value = typename Dpt::Value();
+            if (Dpt::decode(telegram.data.data(), telegram.data.size(), value)) {
+                callback(value, telegram);
+            }
+        }, knxValueCodec<Dpt>());
+    }
+    
+    // Range subscriptions: every address of main group x/-/- or middle group x/y/-
+    bool onMainGroup(int mainGroup, KNXGroupAddressCallback callback);
+    bool onMiddleGroup(int mainGroup, int middleGroup, KNXGroupAddressCallback callback);
+    void removeMainGroupCallback(int mainGroup);
+    void removeMiddleGroupCallback(int mainGroup, int middleGroup);
+    
+    // DPT conversion utilities (see knx_dpt.h for the allocation-free codecs;
+    // the encoders return heap vectors and are left out of the static profile)
+#if !KNX_STATIC_ALLOCATION
     static std::vector<uint8_t> encodeDPT1(bool value);
     static std::vector<uint8_t> encodeDPT5(uint8_t value);
     static std::vector<uint8_t> encodeDPT9(float value);
+#endif
     
     static bool decodeDPT1(const uint8_t* data, size_t length);
     static uint8_t decodeDPT5(const uint8_t* data, size_t length);
@@ -83,11 +347,80 @@ private:
     KNXConnectionType connectionType;
     uint8_t debugLevel; // 0=minimal, 1=normal, 2=verbose
     
-    std::map<int, std::vector<KNXGroupAddressCallback>> callbacks;
+    KNXGroupDispatchTable callbacks;
+    KNXValueFilterTable valueFilters;
+    KNXRxQueue rxQueue;
+    KNXTask dispatchTask;
+    KNXTxQueue txQueue;
+    KNXTunnelClient tunnel;
+    KNXTunnelConfig tunnelConfig;
+    KNXRoutingFlowControl routingFlow;
+    KNXSecureRouting secureRouting;
+    KNXGroupCache groupCache;
+    KNXGroupReader groupReads;
+    KNXScheduler scheduler;
+    KNXTask schedulerTask;
+    KNXGroupSnapshot snapshot;
+    KNXDedupFilter dedup;
+    KNXTraceBuffer trace;
+    KNXTask traceTask;
+    Print* traceOutput;
+    KNXStatsCollector statistics;
+    KNXBusAnalytics busAnalytics;
+    AsyncUDP statsUdp;
+    KNXStatsFormat statsFormat;
+    uint8_t* statsReply;
+    KNXGatewayDiscovery discovery;
+    bool gatewaySelected;
+    KNXTunnelState lastTunnelState;
+    KNXCaptureBuffer capture;
+    AsyncUDP captureUdp;
+    IPAddress captureStreamIP;
+    uint16_t captureStreamPort;
+    bool captureHeaderSent;
+    uint8_t* captureChunk;
+    size_t captureChunkSize;
     
-    void processUdpData(AsyncUDPPacket packet);
+    bool startTunnelListener();
+    void manageGateway(uint32_t nowMs);
+    void selectGateway(uint32_t nowMs);
+    void processUdpData(AsyncUDPPacket& packet);
+    void processRoutingService(uint16_t serviceType, const uint8_t* data, size_t length,
+                               const IPAddress& remoteIP);
+    void handleTunnelPacket(uint8_t* data, size_t length, const IPAddress& remoteIP);
+    void sendTimerNotify(uint32_t nowMs);
+    bool isSubscribed(const uint8_t* data, size_t length);
+    void handleCemiFrame(const uint8_t* data, size_t length);
+    void dispatchCemiFrame(const uint8_t* data, size_t length);
+    static void dispatchTaskEntry(void* module);
+    void runDispatchTask();
+    static void traceTaskEntry(void* module);
+    void runTraceTask();
+    void answerStatsRequest(AsyncUDPPacket& packet);
+    void recordBusFrame(const uint8_t* cemi, size_t length, bool received);
+    void streamCapture();
+    void flushTxQueue();
+    void restoreSnapshot();
+    void flushSnapshot(uint32_t nowMs);
+    void sendDueReads(uint32_t nowMs);
+    void expireReads(uint32_t nowMs);
+    void completeReads(const KNXTelegram& telegram);
+    void runScheduler(uint32_t nowMs);
+    static void schedulerTaskEntry(void* module);
+    void runSchedulerTask();
+    bool transmitGroupWrite(int groupAddress, const uint8_t* data, size_t dataLength,
+                            KNXPriority priority);
+    bool transmitFrame(uint8_t* buffer, size_t cemiLength);
+    bool submitBatchEntry(KNXBatch& batch, size_t index);
+    size_t buildCemiFrame(uint8_t* buffer, int groupAddress, const uint8_t* data,
+                          size_t dataLength, KNXPriority priority);
+    void stampCemiFrame(uint8_t* cemi) const;
+    void cacheSentFrame(const uint8_t* cemi);
+    // Subscribed or owned: the addresses the group cache keeps
+    bool isCachedAddress(uint16_t groupAddress);
     KNXTelegram parseTelegram(const uint8_t* data, size_t length);
     void notifyCallbacks(const KNXTelegram& telegram);
+    void updateGroupCache(const KNXTelegram& telegram);
     void logTelegram(const KNXTelegram& telegram, bool outgoing);
 };
 
@@ -0,0 +1,116 @@
+//==== include/knx_ip_router.h ====
+
+#ifndef KNX_IP_ROUTER_H
+#define KNX_IP_ROUTER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <AsyncUDP.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+#include "knx_tunnel.h"
+#include "knx_routing_flow.h"
+#include "knx_group_filter.h"
+
+enum KNXRouterSideType {
+    KNX_ROUTER_MULTICAST, // KNXnet/IP routing on one network interface
+    KNX_ROUTER_TUNNEL     // Tunnelling connection to a KNXnet/IP interface
+};
+
+enum KNXRouterSide {
+    KNX_ROUTER_SIDE_A,
+    KNX_ROUTER_SIDE_B
+};
+
+// A path is named after the side its frames come from
+enum KNXRouterPath {
+    KNX_ROUTER_A_TO_B,
+    KNX_ROUTER_B_TO_A
+};
+
+// One of the two networks a KNXIPRouter bridges, e.g. routing multicast on
+// the WT32-ETH01's Ethernet port (TCPIP_ADAPTER_IF_ETH) and a tunnel over WiFi.
+struct KNXRouterSideConfig {
+    KNXRouterSideType type = KNX_ROUTER_MULTICAST;
+    tcpip_adapter_if_t interface = TCPIP_ADAPTER_IF_MAX; // Multicast: interface to join on
+    IPAddress localIP;     // Our address on this side, to drop our own multicast echoes;
+                           // empty: WiFi.localIP()
+    IPAddress gatewayIP;   // Tunnel: the KNXnet/IP interface
+    KNXTunnelConfig tunnel;  // Tunnel: tunnel.localPort must differ from KNX_PORT
+                             // when the other side is multicast
+};
+
+struct KNXRouterPathStats {
+    uint32_t received;     // Frames that entered the path
+    uint32_t forwarded;
+    uint32_t filtered;     // Blocked by the filter table
+    uint32_t hopLimit;     // Routing counter used up
+    uint32_t flowControl;  // Dropped while the outgoing routing side was paused by ROUTING_BUSY
+    uint32_t sendFailures;
+};
+
+struct KNXRouterStats {
+    KNXRouterPathStats paths[2]; // Indexed by KNXRouterPath
+    uint32_t ownEchoes;          // Our forwarded multicast frames seen again
+    uint32_t invalid;            // Malformed datagrams and frames
+};
+
+// Lightweight KNXnet/IP router/coupler bridging two networks, each either
+// routing multicast on a given interface or a tunnel. Every path has its own
+// group address filter, compiled to a bitmap.
+//
+// Forwarding never builds a KNXTelegram: the network task reads the
+// destination address from the cEMI frame, tests one bit, decrements the
+// routing counter in place and hands the received datagram itself to the
+// other side. Only tunnel sends copy the cEMI frame, into the tunnel client's
+// retransmit backlog.
+class KNXIPRouter {
+public:
+    KNXIPRouter();
+    ~KNXIPRouter();
+
+    // Replaces the filter of a path; may be called while running. Paths
+    // without a filter block all group traffic.
+    bool setFilter(KNXRouterPath path, const KNXGroupFilter& filter);
+
+    // Routed frames keep their original source address; nothing is sent in
+    // the router's own name.
+    bool begin(const KNXRouterSideConfig& sideA, const KNXRouterSideConfig& sideB);
+    void end();
+    void setDebugLevel(uint8_t level);
+
+    // Services tunnel timers; call from the sketch's loop()
+    void loop();
+
+    // True when every tunnel side is connected
+    bool isConnected() const;
+    KNXRouterStats getStats();
+    void resetStats();
+    KNXTunnelStats getTunnelStats(KNXRouterSide side);
+    KNXRoutingFlowState getRoutingFlowState(KNXRouterSide side);
+
+private:
+    struct Side {
+        KNXRouterSideConfig config;
+        AsyncUDP udp;
+        KNXTunnelClient tunnel;
+        KNXRoutingFlowControl flow;
+        IPAddress ownIP;
+        bool active;
+    };
+
+    Side sides[2];
+    KNXLock lock;
+    KNXGroupAddressBitmap* filters[2]; // Indexed by path
+    bool passIndividual[2];
+    KNXRouterStats counters;
+    uint8_t debugLevel;
+
+    bool startSide(uint8_t index);
+    void processDatagram(uint8_t index, AsyncUDPPacket& packet);
+    void forward(uint8_t from, uint8_t* cemi, size_t length);
+    void count(uint8_t path, uint32_t KNXRouterPathStats::* counter);
+};
+
+#endif // KNX_IP_ROUTER_H
@@ -0,0 +1,237 @@
+//==== include/knx_memory.h ====
+
+#ifndef KNX_MEMORY_H
+#define KNX_MEMORY_H
+
+#include <Arduino.h>
+#include <algorithm>
+#include <functional>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "knx_config.h"
+
+// Buffers of the KNX stack (queues, tables, rings) are taken once by the
+// enable*() calls and given back by the disable*() calls. With
+// KNX_STATIC_ALLOCATION they come from a fixed pool of KNX_STATIC_POOL_SIZE
+// bytes in .bss, otherwise from the heap. Either way they are counted, so the
+// RAM report shows what the stack holds.
+struct KNXMemoryStats {
+    bool staticPool;      // Static allocation profile
+    uint32_t capacity;    // Pool size; 0 for the heap
+    uint32_t used;        // Bytes held, block headers included
+    uint32_t highWater;
+    uint32_t blocks;      // Buffers currently held
+    uint32_t failures;    // Requests that could not be served
+};
+
+// Returns nullptr when the pool (or the heap) is exhausted. Blocks are aligned
+// for any type.
+void* knxAllocate(size_t size);
+void knxRelease(void* block);
+KNXMemoryStats knxMemoryStats();
+
+// new (std::nothrow) T[count] / delete[] on top of knxAllocate
+template <typename T>
+T* knxNewArray(size_t count) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+    const size_t header = alignof(std::max_align_t);
+    uint8_t* block = static_cast<uint8_t*>(knxAllocate(header + count * sizeof(T)));
+    if (!block) return nullptr;
+    *reinterpret_cast<size_t*>(block) = count;
+    T* array = reinterpret_cast<T*>(block + header);
+    for (size_t i = 0; i < count; i++) new (array + i) T();
+    return array;
+}
+
+template <typename T>
+void knxDeleteArray(T* array) {
+    if (!array) return;
+    uint8_t* block = reinterpret_cast<uint8_t*>(array) - alignof(std::max_align_t);
+    size_t count = *reinterpret_cast<size_t*>(block);
+    for (size_t i = count; i > 0; i--) array[i - 1].~T();
+    knxRelease(block);
+}
+
+// Vector of at most N elements stored inline. Keeps the subset of the
+// std::vector interface the stack uses; push_back() and insert() drop the
+// element once the capacity is exhausted (check with knxIsFull()).
+template <typename T, size_t N>
+class KNXFixedVector {
+public:
+    KNXFixedVector() : count(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    static constexpr size_t capacity() { return N; }
+    void reserve(size_t) {}
+
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+    T& back() { return items[count - 1]; }
+
+    void push_back(const T& value) {
+        if (count < N) items[count++] = value;
+    }
+    T* insert(T* position, const T& value) {
+        if (count >= N) return end();
+        std::move_backward(position, end(), end() + 1);
+        *position = value;
+        count++;
+        return position;
+    }
+    T* erase(T* first, T* last) {
+        T* kept = std::move(last, end(), first);
+        // Release what the moved-from tail still holds, e.g. callbacks
+        for (T* item = kept; item != end(); item++) *item = T();
+        count = kept - items;
+        return first;
+    }
+    void clear() { erase(begin(), end()); }
+
+private:
+    T items[N];
+    size_t count;
+};
+
+template <typename T, size_t N>
+bool knxIsFull(const KNXFixedVector<T, N>& vector) {
+    return vector.size() >= N;
+}
+
+template <typename T>
+bool knxIsFull(const std::vector<T>&) {
+    return false;
+}
+
+// Callable stored inline in Capacity bytes, like std::function without the
+// heap. Callables with larger captures fail to compile.
+template <typename Signature, size_t Capacity>
+class KNXInlineFunction;
+
+template <typename R, typename... Args, size_t Capacity>
+class KNXInlineFunction<R(Args...), Capacity> {
+public:
+    KNXInlineFunction() : invoker(nullptr), manager(nullptr) {}
+    KNXInlineFunction(std::nullptr_t) : invoker(nullptr), manager(nullptr) {}
+
+    template <typename F, typename = typename std::enable_if<
+        !std::is_same<typename std::decay<F>::type, KNXInlineFunction>::value>::type>
+    KNXInlineFunction(F&& callable) : invoker(nullptr), manager(nullptr) {
+        assign(std::forward<F>(callable));
+    }
+
+    KNXInlineFunction(const KNXInlineFunction& other) : invoker(nullptr), manager(nullptr) {
+        copyFrom(other);
+    }
+    KNXInlineFunction(KNXInlineFunction&& other) : invoker(nullptr), manager(nullptr) {
+        moveFrom(other);
+    }
+    ~KNXInlineFunction() { reset(); }
+
+    KNXInlineFunction& operator=(const KNXInlineFunction& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+    KNXInlineFunction& operator=(KNXInlineFunction&& other) {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+    KNXInlineFunction& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    explicit operator bool() const { return invoker != nullptr; }
+
+    R operator()(Args... args) const {
+        return invoker(const_cast<unsigned char*>(storage), std::forward<Args>(args)...);
+    }
+
+    void swap(KNXInlineFunction& other) {
+        KNXInlineFunction held(std::move(other));
+        other = std::move(*this);
+        *this = std::move(held);
+    }
+
+private:
+    enum Operation { COPY, MOVE, DESTROY };
+
+    alignas(std::max_align_t) unsigned char storage[Capacity];
+    R (*invoker)(void* callable, Args&&... args);
+    void (*manager)(Operation operation, void* target, void* source);
+
+    template <typename F>
+    void assign(F&& callable) {
+        using Callable = typename std::decay<F>::type;
+        static_assert(sizeof(Callable) <= Capacity, "callback captures exceed KNX_CALLBACK_SIZE");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "over-aligned callback");
+        new (storage) Callable(std::forward<F>(callable));
+        invoker = [](void* target, Args&&... args) -> R {
+            return (*static_cast<Callable*>(target))(std::forward<Args>(args)...);
+        };
+        manager = [](Operation operation, void* target, void* source) {
+            switch (operation) {
+            case COPY:
+                new (target) Callable(*static_cast<const Callable*>(source));
+                break;
+            case MOVE:
+                new (target) Callable(std::move(*static_cast<Callable*>(source)));
+                static_cast<Callable*>(source)->~Callable();
+                break;
+            case DESTROY:
+                static_cast<Callable*>(target)->~Callable();
+                break;
+            }
+        };
+    }
+
+    void copyFrom(const KNXInlineFunction& other) {
+        if (!other.manager) return;
+        other.manager(COPY, storage, const_cast<unsigned char*>(other.storage));
+        invoker = other.invoker;
+        manager = other.manager;
+    }
+
+    void moveFrom(KNXInlineFunction& other) {
+        if (!other.manager) return;
+        other.manager(MOVE, storage, other.storage);
+        invoker = other.invoker;
+        manager = other.manager;
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+
+    void reset() {
+        if (manager) manager(DESTROY, storage, nullptr);
+        invoker = nullptr;
+        manager = nullptr;
+    }
+};
+
+// Containers and callables of the stack, by allocation profile
+#if KNX_STATIC_ALLOCATION
+template <typename T, size_t N>
+using KNXVector = KNXFixedVector<T, N>;
+template <typename Signature>
+using KNXFunction = KNXInlineFunction<Signature, KNX_CALLBACK_SIZE>;
+#else
+template <typename T, size_t N>
+using KNXVector = std::vector<T>;
+template <typename Signature>
+using KNXFunction = std::function<Signature>;
+#endif
+
+#endif // KNX_MEMORY_H
@@ -0,0 +1,170 @@
+//==== include/knx_platform.h ====
+
+#ifndef KNX_PLATFORM_H
+#define KNX_PLATFORM_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "knx_config.h"
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Free-running counter for latency measurements: CPU cycles on the ESP32,
+// nanoseconds on the host. Differences stay valid across the 32-bit wrap.
+inline uint32_t knxCycleCount() {
+#if defined(ESP32)
+    return ESP.getCycleCount();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline uint32_t knxCyclesPerMicrosecond() {
+#if defined(ESP32)
+    return ESP.getCpuFreqMHz();
+#else
+    return 1000;
+#endif
+}
+
+// Short critical section shared between the network task, the dispatch task
+// and the application task. A spinlock on the ESP32, so keep the guarded code
+// tiny and never call into lwIP or user callbacks while holding it. Nothing
+// is allocated or freed under it either, callables included: new storage is
+// set up beforehand and swapped in, and what it replaces is freed after the
+// guard is released.
+class KNXLock {
+public:
+#if defined(ESP32)
+    KNXLock() : mux(portMUX_INITIALIZER_UNLOCKED) {}
+    void lock() { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+#else
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+#endif
+
+private:
+#if defined(ESP32)
+    portMUX_TYPE mux;
+#else
+    std::mutex mutex;
+#endif
+};
+
+class KNXLockGuard {
+public:
+    explicit KNXLockGuard(KNXLock& lock) : guarded(lock) { guarded.lock(); }
+    ~KNXLockGuard() { guarded.unlock(); }
+    KNXLockGuard(const KNXLockGuard&) = delete;
+    KNXLockGuard& operator=(const KNXLockGuard&) = delete;
+
+private:
+    KNXLock& guarded;
+};
+
+// Recursive mutex for state whose owner may block while holding it (e.g. in
+// AsyncUDP::writeTo). Not usable from interrupts. The static profile keeps the
+// FreeRTOS object inside the KNXMutex instead of on the heap.
+class KNXMutex {
+public:
+#if defined(ESP32)
+#if KNX_STATIC_ALLOCATION
+    KNXMutex() : handle(xSemaphoreCreateRecursiveMutexStatic(&buffer)) {}
+#else
+    KNXMutex() : handle(xSemaphoreCreateRecursiveMutex()) {}
+#endif
+    ~KNXMutex() { vSemaphoreDelete(handle); }
+    void lock() { xSemaphoreTakeRecursive(handle, portMAX_DELAY); }
+    void unlock() { xSemaphoreGiveRecursive(handle); }
+#else
+    KNXMutex() = default;
+    void lock() { mutex.lock(); }
+    void unlock() { mutex.unlock(); }
+#endif
+    KNXMutex(const KNXMutex&) = delete;
+    KNXMutex& operator=(const KNXMutex&) = delete;
+
+private:
+#if defined(ESP32)
+#if KNX_STATIC_ALLOCATION
+    StaticSemaphore_t buffer;
+#endif
+    SemaphoreHandle_t handle;
+#else
+    std::recursive_mutex mutex;
+#endif
+};
+
+class KNXMutexGuard {
+public:
+    explicit KNXMutexGuard(KNXMutex& mutex) : guarded(mutex) { guarded.lock(); }
+    ~KNXMutexGuard() { guarded.unlock(); }
+    KNXMutexGuard(const KNXMutexGuard&) = delete;
+    KNXMutexGuard& operator=(const KNXMutexGuard&) = delete;
+
+private:
+    KNXMutex& guarded;
+};
+
+// Background task used by the KNX stack: a FreeRTOS task pinned to a core on
+// the ESP32, a std::thread on the host. The task body runs until stop() is
+// called and typically sleeps in wait() until another context calls notify().
+// In the static profile the ESP32 task's stack comes from the KNX pool.
+class KNXTask {
+public:
+    using Entry = void (*)(void* argument);
+
+    KNXTask();
+    ~KNXTask();
+
+    // core is ignored on the host; pass -1 for no affinity on the ESP32.
+    bool start(const char* name, Entry entry, void* argument,
+               uint32_t stackSize, uint8_t priority, int core);
+
+    // Requests the task to finish and blocks until its entry function returned.
+    void stop();
+
+    bool running() const { return active; }
+    bool stopRequested() const { return stopping; }
+
+    // Wakes the task; safe to call from any task.
+    void notify();
+
+    // Called by the task itself: blocks until notified or the timeout expires.
+    // Returns true when woken by notify().
+    bool wait(uint32_t timeoutMs);
+
+private:
+    Entry entry;
+    void* argument;
+    std::atomic<bool> active;
+    std::atomic<bool> stopping;
+
+#if defined(ESP32)
+    TaskHandle_t handle;
+    std::atomic<bool> finished;
+#if KNX_STATIC_ALLOCATION
+    StaticTask_t control;
+    StackType_t* stack;
+#endif
+    static void run(void* self);
+#else
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool notified;
+#endif
+};
+
+#endif // KNX_PLATFORM_H
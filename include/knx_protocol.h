@@ -0,0 +1,198 @@
+//==== include/knx_protocol.h ====
+
+#ifndef KNX_PROTOCOL_H
+#define KNX_PROTOCOL_H
+
+#include <Arduino.h>
+
+// KNX Constants
+#define KNX_PORT 3671
+#define KNX_MULTICAST_IP IPAddress(224, 0, 23, 12)
+
+// KNXnet/IP header
+#define KNXNETIP_HEADER_LENGTH 0x06
+#define KNXNETIP_VERSION 0x10
+
+// KNXnet/IP service types
+#define KNXNETIP_SEARCH_REQUEST 0x0201
+#define KNXNETIP_SEARCH_RESPONSE 0x0202
+#define KNXNETIP_DESCRIPTION_REQUEST 0x0203
+#define KNXNETIP_DESCRIPTION_RESPONSE 0x0204
+#define KNXNETIP_CONNECT_REQUEST 0x0205
+#define KNXNETIP_CONNECT_RESPONSE 0x0206
+#define KNXNETIP_CONNECTIONSTATE_REQUEST 0x0207
+#define KNXNETIP_CONNECTIONSTATE_RESPONSE 0x0208
+#define KNXNETIP_DISCONNECT_REQUEST 0x0209
+#define KNXNETIP_DISCONNECT_RESPONSE 0x020A
+#define KNXNETIP_TUNNELING_REQUEST 0x0420
+#define KNXNETIP_TUNNELING_ACK 0x0421
+#define KNXNETIP_ROUTING_INDICATION 0x0530
+#define KNXNETIP_ROUTING_LOST_MESSAGE 0x0531
+#define KNXNETIP_ROUTING_BUSY 0x0532
+#define KNXNETIP_SECURE_WRAPPER 0x0950
+#define KNXNETIP_SESSION_REQUEST 0x0951
+#define KNXNETIP_SESSION_RESPONSE 0x0952
+#define KNXNETIP_SESSION_AUTHENTICATE 0x0953
+#define KNXNETIP_SESSION_STATUS 0x0954
+#define KNXNETIP_TIMER_NOTIFY 0x0955
+
+// KNXnet/IP status codes
+#define KNXNETIP_E_NO_ERROR 0x00
+#define KNXNETIP_E_CONNECTION_ID 0x21
+#define KNXNETIP_E_SEQUENCE_NUMBER 0x04
+#define KNXNETIP_E_NO_MORE_CONNECTIONS 0x24
+#define KNXNETIP_E_CONNECTION_TYPE 0x22
+#define KNXNETIP_E_DATA_CONNECTION 0x26
+#define KNXNETIP_E_KNX_CONNECTION 0x27
+
+// SESSION_STATUS codes
+#define KNXNETIP_SECURE_AUTH_SUCCESS 0x00
+#define KNXNETIP_SECURE_AUTH_FAILED 0x01
+#define KNXNETIP_SECURE_UNAUTHENTICATED 0x02
+#define KNXNETIP_SECURE_TIMEOUT 0x03
+#define KNXNETIP_SECURE_KEEPALIVE 0x04
+#define KNXNETIP_SECURE_CLOSE 0x05
+
+// Description information block types and service families
+#define KNXNETIP_DIB_DEVICE_INFO 0x01
+#define KNXNETIP_DIB_SUPP_SVC_FAMILIES 0x02
+#define KNXNETIP_DIB_TUNNELING_INFO 0x07
+#define KNXNETIP_FAMILY_TUNNELING 0x04
+
+// Connection request information
+#define KNXNETIP_TUNNEL_CONNECTION 0x04
+#define KNXNETIP_TUNNEL_LINKLAYER 0x02
+#define KNXNETIP_IPV4_UDP 0x01
+
+// cEMI message codes
+#define KNX_CEMI_L_DATA_REQ 0x11
+#define KNX_CEMI_L_DATA_CON 0x2E
+#define KNX_CEMI_L_DATA_IND 0x29
+
+// APDU octets following the TPCI: the 4-bit length of a standard frame, the
+// length octet of an extended frame (255 is reserved)
+#define KNX_CEMI_STANDARD_APDU 15
+#define KNX_CEMI_EXTENDED_APDU 254
+// Longest L_Data frame this stack builds: message code, additional info
+// length, control fields, addresses, length, TPCI and the APDU
+#define KNX_CEMI_MAX_FRAME (10 + KNX_CEMI_EXTENDED_APDU)
+
+// Group value services (KNXTelegram::command, the 4 high APCI bits)
+#define KNX_APCI_GROUP_VALUE_READ 0x0
+#define KNX_APCI_GROUP_VALUE_RESPONSE 0x1
+#define KNX_APCI_GROUP_VALUE_WRITE 0x2
+
+// Writes a KNXnet/IP header; returns the header length.
+inline size_t knxWriteHeader(uint8_t* buffer, uint16_t serviceType, uint16_t totalLength) {
+    buffer[0] = KNXNETIP_HEADER_LENGTH;
+    buffer[1] = KNXNETIP_VERSION;
+    buffer[2] = serviceType >> 8;
+    buffer[3] = serviceType & 0xFF;
+    buffer[4] = totalLength >> 8;
+    buffer[5] = totalLength & 0xFF;
+    return KNXNETIP_HEADER_LENGTH;
+}
+
+// Returns the service type of a KNXnet/IP frame, or 0 if the header is invalid.
+inline uint16_t knxServiceType(const uint8_t* data, size_t length) {
+    if (length < KNXNETIP_HEADER_LENGTH || data[0] != KNXNETIP_HEADER_LENGTH ||
+        data[1] != KNXNETIP_VERSION) {
+        return 0;
+    }
+    return (data[2] << 8) | data[3];
+}
+
+// Fields of a cEMI L_Data frame (L_Data.req, .con or .ind), standard or
+// extended. Both share one layout; bit 7 of control field 1 tells them apart.
+struct KNXCemiFrame {
+    uint8_t messageCode;
+    uint8_t ctrl1;
+    uint8_t ctrl2;          // Address type, hop count, extended frame format
+    uint16_t source;
+    uint16_t destination;
+    const uint8_t* tpdu;    // TPCI octet, then the APDU
+    size_t apduLength;      // Octets following the TPCI
+
+    bool isExtended() const { return (ctrl1 & 0x80) == 0; }
+    bool isGroupAddress() const { return (ctrl2 & 0x80) != 0; }
+    uint8_t hopCount() const { return (ctrl2 >> 4) & 0x07; }
+    // L_Data.con reporting that the frame was not sent
+    bool isNegativeConfirm() const { return messageCode == KNX_CEMI_L_DATA_CON && (ctrl1 & 0x01); }
+};
+
+// Reads an L_Data frame. Returns false unless data holds exactly one frame of
+// the L_Data family whose length octet fits its frame type and matches the
+// bytes received.
+inline bool knxParseCemi(const uint8_t* data, size_t length, KNXCemiFrame& frame) {
+    if (length < 2) return false;
+    uint8_t messageCode = data[0];
+    if (messageCode != KNX_CEMI_L_DATA_REQ && messageCode != KNX_CEMI_L_DATA_CON &&
+        messageCode != KNX_CEMI_L_DATA_IND) {
+        return false;
+    }
+    // Message code, additional info, then eight octets up to the TPCI
+    size_t offset = 2 + data[1];
+    if (length < offset + 8) return false;
+    const uint8_t* info = data + offset;
+    size_t apduLength = info[6];
+    bool extended = (info[0] & 0x80) == 0;
+    if (apduLength > (extended ? KNX_CEMI_EXTENDED_APDU : KNX_CEMI_STANDARD_APDU) ||
+        length != offset + 8 + apduLength) {
+        return false;
+    }
+    frame.messageCode = messageCode;
+    frame.ctrl1 = info[0];
+    frame.ctrl2 = info[1];
+    frame.source = (info[2] << 8) | info[3];
+    frame.destination = (info[4] << 8) | info[5];
+    frame.tpdu = info + 7;
+    frame.apduLength = apduLength;
+    return true;
+}
+
+// Writes a cEMI frame from source to a group address, priority as in
+// KNXPriority. data starts with the APCI octet (e.g. 0x80 | value for a
+// GroupValue_Write of a short value). Up to KNX_CEMI_STANDARD_APDU octets go
+// in a standard frame, longer data (at most KNX_CEMI_EXTENDED_APDU, checked by
+// the caller) in an extended frame. Returns the frame length, 10 + dataLength.
+inline size_t knxWriteGroupFrame(uint8_t* buffer, uint8_t messageCode, uint16_t source,
+                                 uint16_t groupAddress, uint8_t priority,
+                                 const uint8_t* data, size_t dataLength) {
+    // Frame type, no repeat, broadcast, priority
+    uint8_t frameType = dataLength > KNX_CEMI_STANDARD_APDU ? 0x00 : 0x80;
+    buffer[0] = messageCode;
+    buffer[1] = 0x00;                     // No additional info
+    buffer[2] = frameType | 0x30 | (priority << 2);
+    buffer[3] = 0xE0;                     // Group address, hop count 6
+    buffer[4] = source >> 8;
+    buffer[5] = source & 0xFF;
+    buffer[6] = groupAddress >> 8;
+    buffer[7] = groupAddress & 0xFF;
+    buffer[8] = (uint8_t)dataLength;      // APDU length (octets following the TPCI)
+    buffer[9] = 0x00;                     // TPCI, APCI high bits (group value service)
+    memcpy(buffer + 10, data, dataLength);
+    return 10 + dataLength;
+}
+
+// Writes an IPv4/UDP host protocol address information block; returns 8.
+inline size_t knxWriteHpai(uint8_t* buffer, const IPAddress& ip, uint16_t port) {
+    buffer[0] = 0x08;
+    buffer[1] = KNXNETIP_IPV4_UDP;
+    buffer[2] = ip[0];
+    buffer[3] = ip[1];
+    buffer[4] = ip[2];
+    buffer[5] = ip[3];
+    buffer[6] = port >> 8;
+    buffer[7] = port & 0xFF;
+    return 8;
+}
+
+// Reads an HPAI; returns false if it is not a well-formed IPv4/UDP block.
+inline bool knxReadHpai(const uint8_t* data, size_t length, IPAddress& ip, uint16_t& port) {
+    if (length < 8 || data[0] != 0x08 || data[1] != KNXNETIP_IPV4_UDP) return false;
+    ip = IPAddress(data[2], data[3], data[4], data[5]);
+    port = (data[6] << 8) | data[7];
+    return true;
+}
+
+#endif // KNX_PROTOCOL_H
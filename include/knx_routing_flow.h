@@ -0,0 +1,87 @@
+//==== include/knx_routing_flow.h ====
+
+#ifndef KNX_ROUTING_FLOW_H
+#define KNX_ROUTING_FLOW_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+
+// Timing follows the flow control rules of the KNXnet/IP routing
+// specification by default
+struct KNXRoutingFlowConfig {
+    uint16_t maxWaitMs = 100;         // Upper bound for the wait time of a ROUTING_BUSY
+    uint16_t randomWaitMs = 50;       // Random extra wait, up to this times the busy count
+    uint16_t slowdownPerBusyMs = 100; // After a pause the busy count holds for count x this
+    uint16_t decrementMs = 5;         // ... and then drops by one per step
+    uint16_t lossIntervalMs = 20;     // Send spacing after the first lost message report
+    uint16_t maxIntervalMs = 500;     // Send spacing ceiling under repeated losses
+    uint16_t recoveryMs = 2000;       // Quiet time after which the spacing halves
+};
+
+// BUSY and LOST_MESSAGE reports of one router
+struct KNXRoutingPeer {
+    IPAddress address;
+    uint8_t deviceState;   // Last reported device state (bit 0: KNX fault, bit 1: IP fault)
+    uint32_t busyFrames;
+    uint32_t lostReports;
+    uint32_t lostMessages; // Sum of the reported counts
+};
+
+struct KNXRoutingFlowState {
+    bool paused;             // A ROUTING_BUSY wait is running
+    uint32_t resumeInMs;     // Until the next routing indication may go out
+    uint8_t busyCount;       // Busy count N of the specification
+    uint16_t sendIntervalMs; // Adaptive spacing from lost message reports, 0 = none
+    uint32_t busyFrames;
+    uint32_t busyIgnored;    // BUSY frames addressed to other devices
+    uint32_t pauses;         // BUSY frames that extended the pause
+    uint32_t lostReports;
+    uint32_t lostMessages;
+    uint8_t peerCount;
+    KNXRoutingPeer peers[KNX_ROUTING_PEERS];
+};
+
+// Sender side of KNXnet/IP routing flow control. A ROUTING_BUSY stops routing
+// indications for the wait time it announces plus a random share of
+// randomWaitMs x N, where N counts the BUSY frames received more than 10 ms
+// apart and decays once the pause is over. ROUTING_LOST_MESSAGE reports mean
+// a router's queue overflowed without warning; they double a minimum spacing
+// between our indications, which halves again after recoveryMs without loss.
+class KNXRoutingFlowControl {
+public:
+    KNXRoutingFlowControl();
+
+    void setConfig(const KNXRoutingFlowConfig& config);
+    void reset();
+
+    // Take the whole datagram; false if the frame is malformed.
+    bool handleBusy(const uint8_t* data, size_t length, const IPAddress& router, uint32_t nowMs);
+    bool handleLostMessage(const uint8_t* data, size_t length, const IPAddress& router, uint32_t nowMs);
+
+    // Whether a routing indication may go out now
+    bool canSend(uint32_t nowMs);
+    void sent(uint32_t nowMs);
+    uint32_t msUntilSend(uint32_t nowMs);
+
+    KNXRoutingFlowState state(uint32_t nowMs);
+
+private:
+    KNXLock lock;
+    KNXRoutingFlowConfig config;
+    KNXRoutingFlowState counters;
+
+    bool busySeen;
+    uint32_t lastBusy;
+    uint32_t pauseUntil;
+    uint32_t decayAt;   // Next busy count decrement
+    uint32_t recoverAt; // Next halving of the send spacing
+    bool sentBefore;
+    uint32_t lastSend;
+
+    void update(uint32_t nowMs);
+    uint32_t waitFor(uint32_t nowMs) const;
+    KNXRoutingPeer* peerFor(const IPAddress& router);
+};
+
+#endif // KNX_ROUTING_FLOW_H
@@ -0,0 +1,80 @@
+//==== include/knx_rx_queue.h ====
+
+#ifndef KNX_RX_QUEUE_H
+#define KNX_RX_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "knx_config.h"
+
+// What to do when a frame arrives while the receive queue is full
+enum KNXRxDropPolicy {
+    KNX_RX_DROP_OLDEST, // Overwrite the oldest queued frame (latest state wins)
+    KNX_RX_DROP_NEWEST  // Discard the arriving frame
+};
+
+// Settings of the optional dispatch task (see KNXIPModule::enableDispatchTask)
+struct KNXDispatchTaskConfig {
+    size_t queueDepth = 32;                         // Rounded up to a power of two
+    KNXRxDropPolicy dropPolicy = KNX_RX_DROP_OLDEST;
+    int core = 1;                                   // ESP32 core, -1 for no affinity
+    uint8_t priority = 2;                           // FreeRTOS priority
+    uint32_t stackSize = 4096;                      // Bytes
+};
+
+struct KNXRxQueueStats {
+    uint32_t received;   // Frames offered by the network task
+    uint32_t dispatched; // Frames taken by the dispatch task
+    uint32_t dropped;    // Frames lost to the drop policy or oversize
+    uint32_t highWater;  // Highest queue occupancy seen
+    uint32_t depth;      // Queue capacity in frames
+};
+
+// Single-producer/single-consumer ring of raw cEMI frames. The producer (the
+// AsyncUDP callback) only copies bytes into a preallocated slot; the consumer
+// (the dispatch task) parses and dispatches. Both sides are lock-free.
+//
+// With KNX_RX_DROP_OLDEST the producer reclaims the oldest slot by advancing
+// the tail with a compare-and-swap. The consumer copies a slot out before
+// claiming it with the same compare-and-swap, and discards the copy if the
+// producer reclaimed the slot in the meantime, so it never returns a frame
+// that was overwritten while it was being read.
+class KNXRxQueue {
+public:
+    KNXRxQueue();
+    ~KNXRxQueue();
+
+    bool begin(size_t depth, KNXRxDropPolicy policy);
+    void end();
+    bool isActive() const { return slots != nullptr; }
+
+    // Producer side: queues a cEMI frame without its additional info. Returns
+    // false if the frame was dropped.
+    bool push(const uint8_t* data, size_t length);
+
+    // Consumer side. Copies the oldest frame into buffer (which must hold
+    // KNX_RX_QUEUE_FRAME_SIZE bytes) and returns its length, 0 when empty.
+    size_t pop(uint8_t* buffer);
+
+    KNXRxQueueStats stats() const;
+
+private:
+    struct Slot {
+        uint16_t length;
+        uint8_t data[KNX_RX_QUEUE_FRAME_SIZE];
+    };
+
+    Slot* slots;
+    uint32_t mask;
+    KNXRxDropPolicy policy;
+
+    std::atomic<uint32_t> head; // Next slot to write, owned by the producer
+    std::atomic<uint32_t> tail; // Next slot to read
+
+    std::atomic<uint32_t> received;
+    std::atomic<uint32_t> dispatched;
+    std::atomic<uint32_t> dropped;
+    std::atomic<uint32_t> highWater;
+};
+
+#endif // KNX_RX_QUEUE_H
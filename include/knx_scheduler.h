@@ -0,0 +1,205 @@
+//==== include/knx_scheduler.h ====
+
+#ifndef KNX_SCHEDULER_H
+#define KNX_SCHEDULER_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_memory.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+#include "knx_telegram.h"
+
+// Hierarchical timer wheel with 1 ms ticks: four levels of 64 slots cover
+// 2^24 ms (4.6 hours), later deadlines wait in an overflow list that is looked
+// at every 2^24 ms. A timer sits in the slot of the highest 6-bit digit in
+// which its deadline differs from the current time, and moves down a level
+// when the clock reaches that slot, so arming, cancelling and expiring are
+// O(1) per timer. A bitmap per level marks the occupied slots: advancing over
+// an idle stretch jumps straight to the next occupied slot instead of
+// stepping through every millisecond.
+//
+// Timers are identified by their index (0 .. capacity - 1); the caller keeps
+// whatever they stand for. Not synchronized, see KNXScheduler.
+class KNXTimerWheel {
+public:
+    static const uint16_t NONE = 0xFFFF;
+
+    KNXTimerWheel();
+    ~KNXTimerWheel();
+
+    bool begin(size_t capacity, uint32_t nowMs);
+    void end();
+    bool isActive() const { return nodes != nullptr; }
+    // Exchanges the timers of two wheels, so one can be set up outside a lock
+    void swap(KNXTimerWheel& other);
+
+    // Arms (or re-arms) timer id to expire delayMs after nowMs
+    void schedule(uint16_t id, uint32_t nowMs, uint32_t delayMs);
+    void cancel(uint16_t id);
+    bool armed(uint16_t id) const { return nodes[id].list != UNARMED; }
+
+    // Advances the clock to nowMs and returns the next expired timer (now
+    // disarmed), NONE when none is left. Call until it returns NONE.
+    uint16_t expire(uint32_t nowMs);
+    // Milliseconds until the next timer expires, UINT32_MAX if none is armed.
+    // Looks through the timers of one slot, not all of them.
+    uint32_t msUntilNext(uint32_t nowMs) const;
+
+private:
+    static const uint8_t LEVELS = 4;
+    static const uint8_t SLOT_BITS = 6;
+    static const uint16_t SLOTS = 1 << SLOT_BITS;
+    static const uint16_t DUE = LEVELS * SLOTS;  // Expired, waiting for expire()
+    static const uint16_t BEYOND = DUE + 1;      // Beyond the top level
+    static const uint16_t LISTS = BEYOND + 1;
+    static const uint16_t UNARMED = 0xFFFF;
+    static const uint8_t SPAN_BITS = LEVELS * SLOT_BITS;
+
+    struct Node {
+        uint64_t deadline;
+        uint16_t next;
+        uint16_t prev;
+        uint16_t list;
+    };
+
+    Node* nodes;
+    size_t capacity;
+    uint16_t heads[LISTS];
+    uint64_t occupied[LEVELS]; // Bit per non-empty slot
+    uint64_t current;          // Wheel time in ms; millis() extended to 64 bits
+
+    uint64_t wheelTime(uint32_t nowMs) const;
+    void insert(uint16_t id);
+    void link(uint16_t id, uint16_t list);
+    void unlink(uint16_t id);
+    void requeue(uint16_t list);
+    // Next time after `current` at which a slot is reached, UINT64_MAX if none
+    uint64_t nextEvent() const;
+    uint64_t nextDeadline() const;
+};
+
+// Settings of the scheduler (see KNXIPModule::enableScheduler)
+struct KNXSchedulerConfig {
+    size_t capacity = 32;     // Timeouts, cyclic sends and send objects together
+    bool task = false;        // Run due entries from a task of their own instead of loop()/poll()
+    int core = 1;             // ESP32 core of that task, -1 for no affinity
+    uint8_t priority = 1;     // FreeRTOS priority
+    uint32_t stackSize = 4096; // Bytes; callbacks and value providers run on it
+};
+
+struct KNXSchedulerStats {
+    uint32_t timeouts;    // One-shot callbacks run
+    uint32_t cyclicSends; // Values sent by cyclic entries
+    uint32_t objectSends; // Values sent by send objects, on change or refresh
+    uint32_t unchanged;   // Send object updates with the value already sent
+    uint32_t missed;      // Cycles skipped because the scheduler ran late
+    uint32_t rejected;    // Entries refused because every slot was taken
+    uint32_t active;      // Entries currently registered
+    uint32_t capacity;
+};
+
+// Identifies a scheduler entry; 0 is never a valid handle
+typedef uint32_t KNXTimerHandle;
+typedef KNXFunction<void()> KNXTimerCallback;
+// Fills the group value to send (sendKNXMessage layout, APCI octet first,
+// at most KNX_CEMI_STANDARD_APDU bytes) and returns its length; 0 skips the
+// cycle.
+typedef KNXFunction<size_t(uint8_t* data)> KNXValueProvider;
+
+// Timed work of the module on one timer wheel: one-shot timeouts, cyclic
+// group sends whose value comes from a provider callback, and send objects
+// that go out when their value changes (no more often than a minimum
+// interval) and are repeated every refresh period otherwise. Cyclic entries
+// keep their phase: the next send is due one period after the previous
+// deadline, not after the time it actually ran.
+//
+// The module takes due entries and runs callbacks, providers and sends
+// outside the lock, so they may add or cancel entries.
+class KNXScheduler {
+public:
+    enum Kind : uint8_t { FREE, TIMEOUT, CYCLIC, OBJECT };
+
+    // A due entry, as taken by takeDue()
+    struct Action {
+        Kind kind;
+        KNXTimerHandle handle;
+        uint16_t groupAddress;
+        KNXPriority priority;
+        uint8_t length;              // OBJECT: the value to send
+        uint8_t data[KNX_CEMI_STANDARD_APDU];
+        KNXTimerCallback callback;   // TIMEOUT
+        KNXValueProvider provider;   // CYCLIC, lent until finishCyclic()
+    };
+
+    KNXScheduler();
+    ~KNXScheduler();
+
+    bool begin(const KNXSchedulerConfig& config, uint32_t nowMs);
+    void end();
+    bool isActive() const { return entries != nullptr; }
+    const KNXSchedulerConfig& settings() const { return config; }
+
+    // Return 0 if every slot is taken or the scheduler is not active
+    KNXTimerHandle timeout(uint32_t delayMs, const KNXTimerCallback& callback, uint32_t nowMs);
+    KNXTimerHandle cyclic(uint16_t groupAddress, uint32_t periodMs, const KNXValueProvider& provider,
+                          KNXPriority priority, uint32_t nowMs);
+    KNXTimerHandle object(uint16_t groupAddress, uint32_t refreshMs, uint32_t minIntervalMs,
+                          KNXPriority priority);
+    // Stores the value of a send object (false for unknown handles and data
+    // longer than a standard frame). If it changed, or is the first, and the
+    // minimum interval has passed, it is to be sent now: send is filled in,
+    // otherwise send.length is 0. A change within the interval is sent when
+    // the interval ends.
+    bool update(KNXTimerHandle handle, const uint8_t* data, size_t length, uint32_t nowMs,
+                Action& send);
+    bool cancel(KNXTimerHandle handle);
+
+    // Next due entry; false when none is due. Cyclic entries and send objects
+    // are re-armed for their next period. The provider of a cyclic entry
+    // moves into the action and goes back with finishCyclic(), so nothing is
+    // copied under the lock.
+    bool takeDue(uint32_t nowMs, Action& action);
+    void finishCyclic(Action& action, bool sent);
+    uint32_t msUntilNext(uint32_t nowMs);
+
+    KNXSchedulerStats stats();
+
+private:
+    struct Entry {
+        Kind kind;
+        bool hasValue;   // OBJECT: data holds a value
+        bool hasSent;    // OBJECT: lastSent is valid
+        bool pending;    // OBJECT: data changed and waits for the minimum interval
+        uint8_t length;
+        KNXPriority priority;
+        uint16_t generation;
+        uint16_t groupAddress;
+        uint16_t nextFree;
+        uint32_t periodMs;      // CYCLIC period, OBJECT refresh (0: none)
+        uint32_t minIntervalMs; // OBJECT
+        uint32_t due;           // CYCLIC: deadline of the next send
+        uint32_t lastSent;
+        uint8_t data[KNX_CEMI_STANDARD_APDU];
+        KNXTimerCallback callback;
+        KNXValueProvider provider;
+    };
+
+    KNXLock lock;
+    KNXSchedulerConfig config;
+    KNXTimerWheel wheel;
+    Entry* entries;
+    uint16_t freeHead;
+    KNXSchedulerStats counters;
+
+    Entry* allocate(Kind kind, uint16_t& index);
+    Entry* lookup(KNXTimerHandle handle, uint16_t& index);
+    // Frees the slot; its callables move out to be destroyed outside the lock
+    void release(uint16_t index, KNXTimerCallback& callback, KNXValueProvider& provider);
+    void fillSend(Entry& entry, Action& action, uint32_t nowMs);
+    static KNXTimerHandle handleOf(uint16_t index, const Entry& entry) {
+        return ((uint32_t)entry.generation << 16) | index;
+    }
+};
+
+#endif // KNX_SCHEDULER_H
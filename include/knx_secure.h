@@ -0,0 +1,224 @@
+//==== include/knx_secure.h ====
+
+#ifndef KNX_SECURE_H
+#define KNX_SECURE_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_crypto.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+
+// SECURE_WRAPPER: header, session id (2), sequence number or timer (6),
+// serial number (6), message tag (2), the encrypted frame and its MAC (16)
+#define KNX_SECURE_WRAPPER_OVERHEAD 38
+#define KNX_SECURE_MAC_LENGTH 16
+#define KNX_SECURE_TIMER_NOTIFY_LENGTH 36
+// Largest plain KNXnet/IP frame carried in a wrapper: a tunnelling request
+// with the longest cEMI frame and some additional info
+#define KNX_SECURE_FRAME_SIZE (KNXNETIP_HEADER_LENGTH + 4 + KNX_CEMI_MAX_FRAME + 16)
+
+// Fields of a SECURE_WRAPPER or TIMER_NOTIFY in front of the encrypted part.
+// They form the first 14 bytes of both CCM blocks: B0 ends with the payload
+// length, the first counter block with FF 00.
+struct KNXSecureHeader {
+    uint16_t sessionId;  // 0 for routing
+    uint64_t sequence;   // Sequence number of a session, timer value of routing (48 bits)
+    uint8_t serial[6];   // KNX serial number of the sender
+    uint16_t tag;        // Message tag
+};
+
+// Encrypts a plain KNXnet/IP frame into a SECURE_WRAPPER. Returns the length
+// of the wrapper, 0 if it does not fit into outSize.
+size_t knxSecureWrap(const KNXAes128& key, const KNXSecureHeader& header, const uint8_t* frame,
+                     size_t length, uint8_t* out, size_t outSize);
+// Decrypts a SECURE_WRAPPER into out and checks its MAC. Returns the length of
+// the plain frame, 0 if the wrapper is malformed, too long or not authentic.
+size_t knxSecureUnwrap(const KNXAes128& key, const uint8_t* datagram, size_t length, uint8_t* out,
+                       size_t outSize, KNXSecureHeader& header);
+// Reads the clear fields of a SECURE_WRAPPER or TIMER_NOTIFY
+bool knxSecureReadHeader(const uint8_t* datagram, size_t length, KNXSecureHeader& header);
+
+// TIMER_NOTIFY of routing: header.sequence is the timer value
+size_t knxSecureTimerNotify(const KNXAes128& key, const KNXSecureHeader& header, uint8_t* out);
+bool knxSecureCheckTimerNotify(const KNXAes128& key, const uint8_t* datagram, size_t length,
+                               KNXSecureHeader& header);
+
+// MAC of SESSION_RESPONSE and SESSION_AUTHENTICATE: CCM with an all-zero B0
+// over the associated data (frame header, the fields before the MAC, and the
+// XOR of both public keys)
+void knxSecureHandshakeMac(const KNXAes128& key, const uint8_t* associated, size_t length,
+                           uint8_t mac[KNX_SECURE_MAC_LENGTH]);
+
+// Keys from the ETS project passwords (PBKDF2-HMAC-SHA256, 65536 rounds; takes
+// around a second on the ESP32, so derive once and keep the result)
+void knxSecureDeviceAuthenticationCode(const char* password, uint8_t code[16]);
+void knxSecureUserPasswordKey(const char* password, uint8_t key[16]);
+
+struct KNXSecureStats {
+    uint32_t wrapped;          // Frames encrypted
+    uint32_t unwrapped;        // Frames authenticated and decrypted
+    uint32_t authFailures;     // Wrong MAC: another key, or tampered with
+    uint32_t replayed;         // Sequence number or timer not newer than the last one seen
+    uint32_t outdated;         // Routing timer beyond the latency tolerance
+    uint32_t plainDropped;     // Unsecured frames refused
+    uint32_t malformed;
+    uint32_t timerSyncs;       // Local routing timer moved to a newer one received
+    uint32_t notifiesSent;
+    uint32_t notifiesReceived;
+    uint32_t sessions;         // Secure tunnelling sessions authenticated
+    uint32_t sessionFailures;  // Handshakes refused or timed out
+};
+
+// Settings of secure routing (see KNXIPModule::enableSecureRouting)
+struct KNXSecureRoutingConfig {
+    uint8_t backboneKey[16];          // From the ETS keyring
+    uint8_t serialNumber[6];          // KNX serial number of this device
+    uint16_t latencyToleranceMs = 2000; // How far a received timer may lag behind ours
+    uint32_t notifyIntervalMs = 10000;  // Periodic TIMER_NOTIFY; 0: at start and on demand only
+};
+
+// Secure routing over the backbone key. Every routing frame travels in a
+// SECURE_WRAPPER whose timer value takes the place of a sequence number: the
+// devices keep their timers in step (a newer timer received is adopted, an
+// outdated sender is answered with a TIMER_NOTIFY) and refuse frames whose
+// timer lags more than the latency tolerance. The last timer and tag of each
+// sender are remembered, so a frame seen before is refused even within the
+// tolerance.
+//
+// The key schedule is expanded once by begin(); the B0 and counter blocks of
+// a frame are the wrapper's own header fields, so a frame costs its block
+// operations and nothing else. Crypto runs outside the lock.
+class KNXSecureRouting {
+public:
+    KNXSecureRouting();
+
+    bool begin(const KNXSecureRoutingConfig& config, uint32_t nowMs);
+    void end();
+    bool isActive() const { return active; }
+
+    // Wraps a plain routing frame (KNXnet/IP header included). Returns the
+    // length of the wrapper, 0 if it does not fit.
+    size_t wrap(const uint8_t* frame, size_t length, uint8_t* out, size_t outSize, uint32_t nowMs);
+    // Authenticates a SECURE_WRAPPER and checks its timer. Returns the length
+    // of the plain frame in out, 0 if it is refused.
+    size_t unwrap(const uint8_t* datagram, size_t length, uint8_t* out, size_t outSize, uint32_t nowMs);
+    void handleTimerNotify(const uint8_t* datagram, size_t length, uint32_t nowMs);
+    // A routing frame that arrived without a wrapper
+    void refusePlain();
+
+    // Builds a TIMER_NOTIFY when one is due (after begin, periodically, or to
+    // answer an outdated sender). Returns its length or 0.
+    size_t poll(uint8_t* out, size_t outSize, uint32_t nowMs);
+
+    uint64_t timer(uint32_t nowMs);
+    // A timer from another device has been seen within the tolerance
+    bool synchronized() const { return synced; }
+    KNXSecureStats stats();
+
+private:
+    static const uint32_t NOTIFY_SPACING_MS = 100; // Between notifies answering outdated senders
+
+    struct Peer {
+        uint8_t serial[6];
+        uint64_t timer;
+        uint16_t tag;
+        uint32_t lastSeen;
+        bool used;
+    };
+
+    KNXLock lock;
+    KNXAes128 key;
+    KNXSecureRoutingConfig config;
+    bool active;
+    bool synced;
+    uint64_t timerBase;   // Timer value at timerBaseMs
+    uint32_t timerBaseMs;
+    uint64_t lastSent;    // Timers of sent frames strictly increase
+    uint32_t lastNotify;
+    bool notifyDue;
+    uint16_t notifyTag;   // Of our last TIMER_NOTIFY, to skip its echo
+    Peer peers[KNX_SECURE_PEERS];
+    KNXSecureStats counters;
+
+    uint64_t advance(uint32_t nowMs);
+    void adopt(uint64_t received, uint32_t nowMs);
+    Peer* findPeer(const uint8_t serial[6], bool create, uint32_t nowMs);
+};
+
+// Settings of a secure tunnelling session (see KNXIPModule::enableSecureTunnel)
+struct KNXSecureTunnelConfig {
+    uint8_t userId = 2;                  // Tunnel user from the ETS keyring (1 is the management user)
+    uint8_t userPasswordKey[16];         // knxSecureUserPasswordKey() of the tunnel password
+    uint8_t deviceAuthenticationCode[16]; // knxSecureDeviceAuthenticationCode() of the interface
+    uint8_t serialNumber[6];             // KNX serial number of this device
+    uint32_t keepaliveMs = 30000;        // SESSION_STATUS keepalive; servers close idle sessions after 60 s
+};
+
+// Client side of a KNXnet/IP secure session: X25519 key agreement in
+// SESSION_REQUEST / SESSION_RESPONSE (the response is authenticated with the
+// device authentication code), then SESSION_AUTHENTICATE with the user
+// password key. Afterwards every frame of the tunnel is wrapped with the
+// session key and a 48-bit sequence number that must increase in both
+// directions. Used by KNXTunnelClient under its mutex.
+class KNXSecureSession {
+public:
+    enum State {
+        IDLE,
+        REQUESTED,      // SESSION_REQUEST sent
+        AUTHENTICATING, // Session key agreed, SESSION_AUTHENTICATE sent
+        ESTABLISHED
+    };
+
+    KNXSecureSession();
+
+    void begin(const KNXSecureTunnelConfig& config);
+    void end();
+    bool isActive() const { return active; }
+    State state() const { return currentState; }
+    // Outgoing frames are wrapped once the session key is agreed
+    bool hasKey() const { return currentState == AUTHENTICATING || currentState == ESTABLISHED; }
+    bool established() const { return currentState == ESTABLISHED; }
+
+    // Drops the session key and builds a SESSION_REQUEST with a new key pair
+    size_t request(uint8_t* out, const IPAddress& ip, uint16_t port);
+    // Checks a SESSION_RESPONSE and derives the session key. Returns the
+    // SESSION_AUTHENTICATE to send (wrapped like any other frame), 0 if the
+    // response is not authentic.
+    size_t respond(const uint8_t* data, size_t length, uint8_t* out);
+    // Handles a decrypted SESSION_STATUS and returns its status code
+    uint8_t handleStatus(const uint8_t* frame, size_t length);
+    size_t buildStatus(uint8_t status, uint8_t* out);
+
+    size_t wrap(const uint8_t* frame, size_t length, uint8_t* out, size_t outSize, uint32_t nowMs);
+    size_t unwrap(const uint8_t* datagram, size_t length, uint8_t* out, size_t outSize);
+    bool keepaliveDue(uint32_t nowMs) const {
+        return established() && nowMs - lastSent >= config.keepaliveMs;
+    }
+    uint32_t msUntilKeepalive(uint32_t nowMs) const {
+        if (!established()) return UINT32_MAX;
+        uint32_t idle = nowMs - lastSent;
+        return idle >= config.keepaliveMs ? 0 : config.keepaliveMs - idle;
+    }
+    // Forgets the session key
+    void reset();
+    void countPlainDropped() { counters.plainDropped++; }
+    void countFailure() { counters.sessionFailures++; }
+    KNXSecureStats stats() const { return counters; }
+
+private:
+    KNXSecureTunnelConfig config;
+    bool active;
+    State currentState;
+    KNXAes128 sessionKey;
+    uint8_t privateKey[32];
+    uint8_t publicKeys[32];  // Ours XOR the server's, part of the handshake MACs
+    uint8_t clientPublic[32];
+    uint16_t sessionId;
+    uint64_t sendSequence;
+    uint64_t receiveSequence; // Lowest sequence number accepted next
+    uint32_t lastSent;
+    KNXSecureStats counters;
+};
+
+#endif // KNX_SECURE_H
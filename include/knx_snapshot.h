@@ -0,0 +1,143 @@
+//==== include/knx_snapshot.h ====
+
+#ifndef KNX_SNAPSHOT_H
+#define KNX_SNAPSHOT_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_group_cache.h"
+#include "knx_memory.h"
+
+#if defined(ESP32)
+#include <esp_partition.h>
+#endif
+
+// NOR flash region holding the snapshot: erase sets a sector to 0xFF, write
+// only clears bits. KNXPartitionFlash on the ESP32, KNXFileFlash on the host.
+class KNXFlashStore {
+public:
+    virtual ~KNXFlashStore() {}
+    virtual size_t size() = 0;
+    virtual size_t sectorSize() = 0;
+    virtual bool read(size_t offset, void* data, size_t length) = 0;
+    virtual bool write(size_t offset, const void* data, size_t length) = 0;
+    virtual bool erase(size_t offset, size_t length) = 0; // Sector aligned
+};
+
+#if defined(ESP32)
+// Data partition from the partition table, e.g. a line
+//   knxstate, data, 0x99, , 0x4000
+// in the board's partitions CSV. Not usable with flash encryption: records are
+// written with byte granularity.
+class KNXPartitionFlash : public KNXFlashStore {
+public:
+    explicit KNXPartitionFlash(const char* label = "knxstate") : label(label), partition(nullptr) {}
+
+    size_t size() override { return find() ? partition->size : 0; }
+    size_t sectorSize() override { return SPI_FLASH_SEC_SIZE; }
+    bool read(size_t offset, void* data, size_t length) override;
+    bool write(size_t offset, const void* data, size_t length) override;
+    bool erase(size_t offset, size_t length) override;
+
+private:
+    const char* label;
+    const esp_partition_t* partition;
+
+    bool find();
+};
+#endif
+
+// Settings of the group state snapshot (see KNXIPModule::enableSnapshot)
+struct KNXSnapshotConfig {
+    uint32_t intervalMs = 60000; // Changed values are persisted at most this often
+    bool subscribedOnly = true;  // Only addresses with a callback or owned by this device
+    bool notifyRestored = true;  // Pass restored values to the callbacks as GroupValue_Responses
+};
+
+struct KNXSnapshotStats {
+    uint32_t restored;      // Records read back by the last restore
+    uint32_t restoreMicros; // Duration of the last restore
+    uint32_t flushes;
+    uint32_t records;       // Value records written, checkpoints included
+    uint32_t bytesWritten;
+    uint32_t checkpoints;   // Sector changes, each starting with every value
+    uint32_t erases;
+    uint32_t skipped;       // Values that did not fit into a sector
+    uint32_t errors;        // Failed flash operations and torn records found on restore
+    uint32_t sector;        // Sector being appended to
+    uint32_t sectorUsed;    // Bytes used in it
+    uint32_t sectorSize;
+    uint32_t sectors;
+};
+
+// Persists group values as a log of small records in a ring of flash sectors.
+//
+// Each sector starts with a header (magic, format version, sequence number)
+// and a checkpoint: a record for every value. The checkpoint is sealed by
+// clearing a byte of the header, then changed values are appended as they
+// come. When the sector is full the next one in the ring is erased and gets a
+// new checkpoint, so every sector is erased once per turn of the ring and a
+// flush only writes the records of changed values.
+//
+// Restore reads the sealed sector with the highest sequence number. A sector
+// interrupted while its checkpoint was written is never sealed, so the
+// previous one is used; a torn record ends the log and the next flush starts
+// a new sector.
+class KNXGroupSnapshot {
+public:
+    static const uint8_t VERSION = 1;
+
+    // Decides which addresses are persisted
+    using Filter = KNXFunction<bool(uint16_t groupAddress)>;
+    // Receives each restored value
+    using RestoreHandler = KNXFunction<void(uint16_t groupAddress, const uint8_t* data, size_t length)>;
+
+    KNXGroupSnapshot();
+
+    // Fails if the store has fewer than two sectors or is not sector aligned
+    bool begin(KNXFlashStore* store, const KNXSnapshotConfig& config);
+    void end();
+    bool isActive() const { return store != nullptr; }
+    const KNXSnapshotConfig& settings() const { return config; }
+
+    // Reads the newest sector and passes its values, oldest record first (a
+    // later record of the same address overrides an earlier one).
+    size_t restore(const RestoreHandler& handler);
+
+    // Whether the interval has passed since the last flush
+    bool due(uint32_t nowMs) const { return (uint32_t)(nowMs - lastFlush) >= config.intervalMs; }
+    uint32_t msUntilDue(uint32_t nowMs) const {
+        uint32_t elapsed = nowMs - lastFlush;
+        return elapsed >= config.intervalMs ? 0 : config.intervalMs - elapsed;
+    }
+    // Appends the values changed in the cache since the last flush, starting a
+    // new sector when needed. Returns the records written.
+    size_t flush(KNXGroupCache& cache, const Filter& filter, uint32_t nowMs);
+
+    KNXSnapshotStats stats() const;
+
+private:
+    static const size_t HEADER_SIZE = 16;
+    static const size_t SEAL_OFFSET = 12;
+    static const size_t RECORD_HEADER = 4; // Length, group address, CRC-8
+
+    KNXFlashStore* store;
+    KNXSnapshotConfig config;
+    size_t sectorSize;
+    size_t sectors;
+    size_t sector;     // Sector being appended to
+    size_t offset;     // Next free byte in it
+    uint32_t sequence; // Of the current sector
+    bool sealed;       // The current sector holds a complete checkpoint
+    bool needCheckpoint;
+    uint32_t lastFlush;
+    KNXSnapshotStats counters;
+
+    bool readHeader(size_t index, uint32_t& sequence);
+    bool checkpoint(KNXGroupCache& cache, const Filter& filter);
+    // 1: written, 0: sector full, -1: flash error
+    int append(const KNXCachedValue& value);
+    static uint8_t crc8(const uint8_t* data, size_t length, uint8_t crc = 0);
+};
+
+#endif // KNX_SNAPSHOT_H
@@ -0,0 +1,106 @@
+//==== include/knx_stats.h ====
+
+#ifndef KNX_STATS_H
+#define KNX_STATS_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+
+// Instrumented stages of the module
+enum KNXStatsStage {
+    KNX_STAGE_RECEIVE,   // processUdpData, whole datagram
+    KNX_STAGE_PARSE,     // parseTelegram on the receive path
+    KNX_STAGE_CALLBACKS, // notifyCallbacks
+    KNX_STAGE_SEND,      // sendKNXMessage as seen by the caller
+    KNX_STAGE_COUNT
+};
+
+// Latency distribution in log2 buckets of cycles: bucket i counts samples in
+// [2^i, 2^(i+1)), the last bucket everything above.
+struct KNXLatencyHistogram {
+    static constexpr size_t BUCKETS = 24;
+
+    uint32_t count;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+    uint32_t buckets[BUCKETS];
+
+    // Upper bound of the bucket holding the given quantile (0..1), in cycles
+    uint32_t percentileCycles(float quantile) const;
+};
+
+struct KNXStats {
+    uint32_t cyclesPerMicrosecond; // Divide histogram values by this for microseconds
+
+    uint32_t packetsReceived;    // Datagrams handed to the module
+    uint32_t packetsInvalid;     // Not a KNXnet/IP frame
+    uint32_t unknownServices;    // Valid header, service not handled
+    uint32_t telegramsFiltered;  // Skipped before parsing (no subscriber)
+    uint32_t telegramsParsed;    // Receive path, including parse errors
+    uint32_t parseErrors;        // Not an L_Data frame, or its length octet does not match
+    uint32_t telegramsTruncated; // Data beyond KNX_TELEGRAM_MAX_DATA, not delivered
+    uint32_t telegramsDispatched;
+    uint32_t telegramsSent;      // Handed to the network
+    uint32_t sendFailures;       // Rejected by AsyncUDP, the tunnel or the transmit queue
+
+    KNXLatencyHistogram stages[KNX_STAGE_COUNT];
+};
+
+// Reply format of the stats endpoint
+enum KNXStatsFormat {
+    KNX_STATS_BINARY, // "KNXS", version, then the fields of KNXStats, little-endian
+    KNX_STATS_JSON
+};
+
+// Serializes a snapshot; returns the length or 0 if the buffer is too small.
+size_t knxStatsToBinary(const KNXStats& stats, uint8_t* buffer, size_t size);
+size_t knxStatsToJson(const KNXStats& stats, char* buffer, size_t size);
+
+// Counter and histogram storage shared by the network, dispatch and
+// application tasks. Updates are relaxed atomic operations and take no lock;
+// the lock only keeps snapshot() and reset() apart, so a snapshot taken while
+// telegrams flow may count an update in one field and not yet in another.
+// With KNX_STATS set to 0 every update compiles to nothing.
+class KNXStatsCollector {
+public:
+    using Counter = uint32_t KNXStats::*;
+
+    KNXStatsCollector() { reset(); }
+
+#if KNX_STATS
+    void increment(Counter counter) {
+        __atomic_fetch_add(&(data.*counter), 1, __ATOMIC_RELAXED);
+    }
+    void record(KNXStatsStage stage, uint32_t cycles);
+#else
+    void increment(Counter) {}
+    void record(KNXStatsStage, uint32_t) {}
+#endif
+
+    KNXStats snapshot();
+    void reset();
+
+private:
+    KNXLock lock;
+    KNXStats data; // Fields are only accessed with __atomic builtins
+};
+
+// Records the lifetime of a scope as one sample of a stage.
+class KNXStageTimer {
+public:
+#if KNX_STATS
+    KNXStageTimer(KNXStatsCollector& stats, KNXStatsStage stage)
+        : stats(stats), stage(stage), start(knxCycleCount()) {}
+    ~KNXStageTimer() { stats.record(stage, knxCycleCount() - start); }
+
+private:
+    KNXStatsCollector& stats;
+    KNXStatsStage stage;
+    uint32_t start;
+#else
+    KNXStageTimer(KNXStatsCollector&, KNXStatsStage) {}
+#endif
+};
+
+#endif // KNX_STATS_H
@@ -0,0 +1,85 @@
+//==== include/knx_telegram.h ====
+
+#ifndef KNX_TELEGRAM_H
+#define KNX_TELEGRAM_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+
+// Telegram priority as encoded in bits 3..2 of the cEMI control field 1
+enum KNXPriority {
+    KNX_PRIORITY_SYSTEM = 0,
+    KNX_PRIORITY_NORMAL = 1,
+    KNX_PRIORITY_URGENT = 2,
+    KNX_PRIORITY_LOW = 3
+};
+
+// Fixed-capacity byte buffer used for telegram payloads. It keeps the subset of
+// the std::vector interface that callbacks use (size(), data(), operator[],
+// range-for) but stores its bytes inline, so building a telegram on the receive
+// path never touches the heap.
+class KNXPayload {
+public:
+    static constexpr size_t CAPACITY = KNX_TELEGRAM_MAX_DATA;
+    static_assert(CAPACITY > 0 && CAPACITY <= 254, "KNX_TELEGRAM_MAX_DATA must be 1..254");
+
+    KNXPayload() : length(0) {}
+
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    static constexpr size_t capacity() { return CAPACITY; }
+
+    uint8_t* data() { return bytes; }
+    const uint8_t* data() const { return bytes; }
+    uint8_t& operator[](size_t index) { return bytes[index]; }
+    const uint8_t& operator[](size_t index) const { return bytes[index]; }
+
+    uint8_t* begin() { return bytes; }
+    uint8_t* end() { return bytes + length; }
+    const uint8_t* begin() const { return bytes; }
+    const uint8_t* end() const { return bytes + length; }
+
+    void clear() { length = 0; }
+
+    // Returns false (and drops the byte) once the capacity is exhausted.
+    bool push_back(uint8_t value) {
+        if (length >= CAPACITY) return false;
+        bytes[length++] = value;
+        return true;
+    }
+
+    // Copies up to CAPACITY bytes and returns the number stored.
+    size_t assign(const uint8_t* source, size_t count) {
+        if (count > CAPACITY) count = CAPACITY;
+        memcpy(bytes, source, count);
+        length = (uint8_t)count;
+        return count;
+    }
+
+private:
+    uint8_t bytes[CAPACITY];
+    uint8_t length;
+};
+
+// KNX Telegram structure for better parsing
+struct KNXTelegram {
+    uint8_t messageCode = 0;     // cEMI L_Data.ind, .req or .con
+    uint16_t sourceAddress = 0;
+    uint16_t targetAddress = 0;
+    bool isGroupAddress = false;
+    bool extendedFrame = false;  // APDU longer than a standard frame carries
+    uint8_t routingCounter = 0;
+    uint8_t command = 0;
+    uint8_t apduLength = 0;      // Data bytes in the frame, data.size() unless truncated
+    bool truncated = false;      // More than KNX_TELEGRAM_MAX_DATA; data holds the first ones
+    KNXPayload data;
+
+    // "src=1.1.5, dst=1/2/3, cmd=0x80, data=00 01" into buffer, truncated to
+    // size; returns the length of the full text like snprintf
+    size_t toString(char* buffer, size_t size) const;
+#if !KNX_STATIC_ALLOCATION
+    String toString() const;
+#endif
+};
+
+#endif // KNX_TELEGRAM_H
@@ -0,0 +1,86 @@
+//==== include/knx_trace.h ====
+
+#ifndef KNX_TRACE_H
+#define KNX_TRACE_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+#include "knx_telegram.h"
+
+// Settings of the optional trace buffer (see KNXIPModule::enableTrace)
+struct KNXTraceConfig {
+    size_t capacity = 128;    // Records (32 bytes each with the default KNX_TRACE_DATA)
+    bool drainTask = true;    // Format and print records from a background task
+    Print* output = &Serial;  // Where the drain task prints
+    int core = 0;             // ESP32 core, -1 for no affinity
+    uint8_t priority = 1;     // FreeRTOS priority, below the network and dispatch tasks
+    uint32_t stackSize = 3072;
+};
+
+enum KNXTraceKind : uint8_t {
+    KNX_TRACE_RX_DATAGRAM, // Raw KNXnet/IP datagram (debug level 2)
+    KNX_TRACE_RX_TELEGRAM,
+    KNX_TRACE_TX_TELEGRAM
+};
+
+struct KNXTraceRecord {
+    uint32_t timestamp;     // micros()
+    uint16_t serviceType;   // KNXnet/IP service carrying the frame
+    uint16_t sourceAddress;
+    uint16_t targetAddress;
+    uint16_t length;        // Bytes before truncation to KNX_TRACE_DATA
+    uint8_t kind;           // KNXTraceKind
+    uint8_t command;        // APCI of telegrams
+    uint8_t isGroupAddress;
+    uint8_t captured;       // Bytes stored in data
+    uint8_t data[KNX_TRACE_DATA];
+};
+
+struct KNXTraceStats {
+    uint32_t recorded;  // Records written
+    uint32_t overflows; // Records lost because the buffer was full
+    uint32_t depth;     // Records waiting to be printed
+    uint32_t capacity;
+};
+
+// Preallocated ring of fixed-size binary trace records. Recording copies a
+// few dozen bytes under a short lock and never formats or blocks; text is
+// produced later by drain(), from a low-priority task or on demand. When the
+// ring is full new records are dropped and counted, so a slow reader never
+// stalls the network task.
+class KNXTraceBuffer {
+public:
+    KNXTraceBuffer();
+    ~KNXTraceBuffer();
+
+    bool begin(size_t capacity);
+    void end();
+    bool isActive() const { return records != nullptr; }
+
+    void recordDatagram(const uint8_t* data, size_t length);
+    void recordTelegram(const KNXTelegram& telegram, uint16_t serviceType, bool outgoing);
+
+    // Removes the oldest record; false if the ring is empty.
+    bool pop(KNXTraceRecord& record);
+
+    // Prints up to maxRecords records, oldest first; returns the number printed.
+    size_t drain(Print& output, size_t maxRecords = SIZE_MAX);
+
+    static void format(const KNXTraceRecord& record, Print& output);
+
+    KNXTraceStats stats();
+
+private:
+    KNXLock lock;
+    KNXTraceRecord* records;
+    uint32_t capacity;
+    uint32_t head;  // Next record to read
+    uint32_t count;
+    uint32_t lastOverflows; // Overflow count already reported by drain(), under the lock
+    KNXTraceStats counters;
+
+    void push(const KNXTraceRecord& record);
+};
+
+#endif // KNX_TRACE_H
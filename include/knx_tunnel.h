@@ -0,0 +1,171 @@
+//==== include/knx_tunnel.h ====
+
+#ifndef KNX_TUNNEL_H
+#define KNX_TUNNEL_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include "knx_config.h"
+#include "knx_memory.h"
+#include "knx_platform.h"
+#include "knx_protocol.h"
+#include "knx_secure.h"
+
+enum KNXTunnelState {
+    KNX_TUNNEL_DISCONNECTED,
+    KNX_TUNNEL_CONNECTING,
+    KNX_TUNNEL_CONNECTED,
+    KNX_TUNNEL_DISCONNECTING
+};
+
+// Timing follows the KNXnet/IP tunnelling specification by default
+struct KNXTunnelConfig {
+    uint8_t window = 1;                  // TUNNELING_REQUESTs awaiting an ACK at once (spec: 1)
+    uint16_t ackTimeoutMs = 1000;        // TUNNELING_ACK timeout
+    uint8_t maxRetransmits = 1;          // Repeats before the connection is considered lost
+    uint32_t heartbeatIntervalMs = 60000;
+    uint16_t heartbeatTimeoutMs = 10000; // CONNECTIONSTATE_RESPONSE timeout
+    uint8_t heartbeatRetries = 3;
+    uint16_t connectTimeoutMs = 10000;
+    uint16_t reconnectDelayMs = 5000;    // 0 disables automatic reconnection
+    bool routeBack = false;              // Send 0.0.0.0:0 endpoints (NAT traversal)
+    IPAddress localIP;                   // Endpoint sent to the gateway; empty: WiFi.localIP()
+    uint16_t localPort = KNX_PORT;       // Must match the port the AsyncUDP listens on
+};
+
+struct KNXTunnelStats {
+    KNXTunnelState state;
+    uint8_t channelId;
+    uint16_t tunnelAddress; // Individual address assigned by the gateway
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t sent;          // TUNNELING_REQUESTs acknowledged by the gateway
+    uint32_t retransmits;
+    uint32_t ackTimeouts;   // Requests given up after the last retransmit
+    uint32_t rejected;      // Requests refused (full backlog, too long, not connected)
+    uint32_t received;      // Inbound TUNNELING_REQUESTs delivered
+    uint32_t duplicates;    // Inbound repeats acknowledged but not delivered
+    uint32_t outOfSequence; // Inbound requests discarded for a bad sequence number
+    uint32_t heartbeatFailures;
+    uint8_t inFlight;
+    uint8_t backlog;
+};
+
+// KNXnet/IP tunnelling client. Owns the connection state machine (connect,
+// CONNECTIONSTATE heartbeat, disconnect, reconnect), numbers outgoing cEMI
+// frames, matches TUNNELING_ACKs by sequence number and retransmits on
+// timeout, and acknowledges inbound TUNNELING_REQUESTs.
+//
+// Outgoing frames are kept in a small backlog; the first `window` of them
+// are on the wire. The specification mandates a window of one, larger values
+// pipeline requests for gateways that tolerate it.
+//
+// With enableSecure() every connection starts with a KNX IP Secure session
+// handshake, and all frames of the connection travel in SECURE_WRAPPERs;
+// plain tunnelling frames from the gateway are refused.
+class KNXTunnelClient {
+public:
+    using FrameHandler = KNXFunction<void(uint8_t* cemi, size_t length)>;
+    using Tap = KNXFunction<void(const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port)>;
+
+    KNXTunnelClient();
+
+    void begin(AsyncUDP* udp, const IPAddress& gatewayIP, uint16_t gatewayPort,
+               const KNXTunnelConfig& config);
+    void setConfig(const KNXTunnelConfig& config);
+    void setDebugLevel(uint8_t level) { debugLevel = level; }
+    // Sees every datagram the client sends (packet capture)
+    void setTap(const Tap& tap) { this->tap = tap; }
+
+    // Takes effect from the next connect()
+    void enableSecure(const KNXSecureTunnelConfig& config);
+    void disableSecure();
+    bool isSecure() const { return session.isActive(); }
+    KNXSecureStats secureStats();
+
+    bool connect();
+    void disconnect();
+
+    // Queues a cEMI frame. Returns false if it cannot be accepted.
+    bool send(const uint8_t* cemi, size_t length);
+    // Connected with room in the backlog: a frame sent now goes out soon
+    bool canSend();
+
+    // Consumes tunnelling and connection management services from the gateway.
+    // Inbound cEMI frames are passed to onFrame. Returns false for frames that
+    // are not meant for this client. The frame lies in data or, on a secure
+    // connection, in a buffer of this call, after its 10 header octets; onFrame
+    // may rewrite both until it returns.
+    bool handlePacket(uint8_t* data, size_t length, const IPAddress& remoteIP,
+                      const FrameHandler& onFrame);
+
+    // Drives timeouts, heartbeats and reconnection.
+    void poll(uint32_t nowMs);
+    // Milliseconds until poll() has work, UINT32_MAX if it has none
+    uint32_t msUntilDue(uint32_t nowMs);
+
+    KNXTunnelState state() const { return currentState; }
+    bool isConnected() const { return currentState == KNX_TUNNEL_CONNECTED; }
+    uint16_t tunnelAddress() const { return assignedAddress; }
+    KNXTunnelStats stats();
+
+private:
+    struct Request {
+        uint16_t length;
+        uint8_t sequence;
+        uint8_t attempts;
+        bool inFlight;
+        uint32_t sentAt;
+        uint8_t cemi[KNX_TUNNEL_FRAME_SIZE];
+    };
+
+    AsyncUDP* udp;
+    KNXMutex mutex;
+    KNXTunnelConfig config;
+    uint8_t debugLevel;
+    Tap tap;
+
+    IPAddress controlIP;
+    uint16_t controlPort;
+    IPAddress dataIP;
+    uint16_t dataPort;
+
+    volatile KNXTunnelState currentState;
+    uint8_t channelId;
+    uint16_t assignedAddress;
+    uint8_t sendSequence;
+    uint8_t receiveSequence;
+
+    uint32_t stateSince;        // When the current state was entered
+    uint32_t lastHeartbeat;     // When the last CONNECTIONSTATE_REQUEST was sent
+    bool heartbeatPending;
+    uint8_t heartbeatFailures;
+
+    Request backlog[KNX_TUNNEL_BACKLOG]; // Oldest first
+    uint8_t backlogCount;
+    bool started;                        // begin() called and no disconnect() since
+
+    KNXTunnelStats counters;
+    KNXSecureSession session;
+
+    void enterState(KNXTunnelState state, uint32_t nowMs);
+    // Sends the SESSION_REQUEST of a secure connection, else the CONNECT_REQUEST
+    void startConnect(uint32_t nowMs);
+    bool processSession(uint16_t serviceType, const uint8_t* data, size_t length, uint32_t now);
+    IPAddress localEndpointIP() const;
+    bool processService(uint16_t serviceType, const uint8_t* data, size_t length,
+                        uint32_t now, bool& deliver);
+    size_t buildConnectRequest(uint8_t* buffer);
+    size_t buildControlRequest(uint8_t* buffer, uint16_t serviceType);
+    size_t buildTunnelingRequest(uint8_t* buffer, const Request& request);
+    void sendToControl(const uint8_t* buffer, size_t length);
+    void sendToData(const uint8_t* buffer, size_t length);
+    // Wraps the frame once a secure session has its key
+    void transmit(const uint8_t* buffer, size_t length, const IPAddress& ip, uint16_t port);
+    void sendAck(uint8_t sequence, uint8_t status);
+    void connectionLost(uint32_t nowMs, const char* reason);
+    void sendPending(uint32_t nowMs);
+    void removeRequest(uint8_t index);
+};
+
+#endif // KNX_TUNNEL_H
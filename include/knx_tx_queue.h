@@ -0,0 +1,92 @@
+//==== include/knx_tx_queue.h ====
+
+#ifndef KNX_TX_QUEUE_H
+#define KNX_TX_QUEUE_H
+
+#include <Arduino.h>
+#include "knx_config.h"
+#include "knx_platform.h"
+#include "knx_telegram.h"
+
+// Settings of the optional transmit scheduler (see KNXIPModule::enableTxQueue)
+struct KNXTxQueueConfig {
+    size_t capacity = 32;             // Pending telegrams
+    uint16_t telegramsPerSecond = 40; // Budget, below the ~50/s a TP line carries
+    uint8_t burst = 4;                // Telegrams that may go out back-to-back
+    bool coalesce = true;             // Replace a pending write to the same address
+};
+
+struct KNXTxQueueStats {
+    uint32_t queued;    // Telegrams accepted into the queue
+    uint32_t coalesced; // Pending writes overwritten by a newer value
+    uint32_t sent;      // Telegrams released and accepted by the network
+    uint32_t dropped;   // Rejected because the queue was full, or released and refused
+    uint32_t depth;     // Telegrams currently pending
+    uint32_t highWater; // Highest number pending at once
+    uint32_t capacity;
+};
+
+// Outgoing group write scheduler. Pending writes are kept per priority class
+// (system, urgent, normal, low - the order the bus arbitrates them in) and
+// released under a token bucket. A new write to an address with a write still
+// pending replaces the queued value in place, so only the latest value of a
+// rapidly changing address reaches the bus. Reads and responses are never
+// merged.
+class KNXTxQueue {
+public:
+    struct Entry {
+        uint16_t groupAddress;
+        KNXPriority priority;
+        uint8_t length;
+        uint8_t data[KNX_TELEGRAM_MAX_DATA];
+    };
+
+    KNXTxQueue();
+    ~KNXTxQueue();
+
+    bool begin(const KNXTxQueueConfig& config);
+    void end();
+    bool isActive() const { return entries != nullptr; }
+
+    // Returns false if the telegram does not fit or the queue is full.
+    bool push(uint16_t groupAddress, const uint8_t* data, size_t length, KNXPriority priority);
+
+    // Takes the next telegram if one is pending and the rate budget allows it.
+    // Report what became of it with released().
+    bool pop(uint32_t nowMicros, Entry& entry);
+    // Counts the telegram pop() returned as sent, or as dropped.
+    void released(bool sent);
+
+    // Microseconds until pop() can release the next telegram, 0 if it can now,
+    // UINT32_MAX if nothing is pending.
+    uint32_t microsUntilNext(uint32_t nowMicros);
+
+    KNXTxQueueStats stats();
+
+private:
+    static const uint8_t NONE = 0xFF;
+    static const uint8_t PRIORITY_CLASSES = 4;
+
+    KNXLock lock;
+    Entry* entries;
+    uint8_t* next;                  // Per entry: next in its list or NONE
+    uint8_t first[PRIORITY_CLASSES]; // Per transmission rank: FIFO head
+    uint8_t last[PRIORITY_CLASSES];
+    uint8_t freeList;
+    KNXTxQueueConfig config;
+
+    uint32_t costMicros;   // Budget consumed by one telegram
+    uint32_t creditMicros; // Accumulated budget, capped at burst * costMicros
+    uint32_t lastRefill;
+
+    KNXTxQueueStats counters;
+
+    static uint8_t rankOf(KNXPriority priority);
+    static bool isWrite(const uint8_t* data, size_t length);
+    uint8_t findPendingWrite(uint16_t groupAddress, uint8_t& rank, uint8_t& previous) const;
+    void unlink(uint8_t rank, uint8_t index, uint8_t previous);
+    void append(uint8_t rank, uint8_t index);
+    void refill(uint32_t nowMicros);
+};
+
+#endif // KNX_TX_QUEUE_H
@@ -0,0 +1,132 @@
+//==== include/knx_value_filter.h ====
+
+#ifndef KNX_VALUE_FILTER_H
+#define KNX_VALUE_FILTER_H
+
+#include <Arduino.h>
+#include <cmath>
+#include <type_traits>
+#include "knx_config.h"
+#include "knx_memory.h"
+#include "knx_platform.h"
+#include "knx_group_table.h"
+
+// Which GroupValue_Writes and _Responses of an address reach a filtered
+// callback (see KNXIPModule::onGroupAddress). The stages run in this order:
+// downsample, average, minimum interval, then deadband or change of value
+// against the last value forwarded. All zero forwards everything.
+struct KNXValueFilter {
+    uint8_t downsample = 0;     // Forward every n-th telegram only
+    uint8_t average = 0;        // Numeric: forward the mean of every n values
+    uint32_t minIntervalMs = 0; // Drop telegrams within this time of the last one forwarded
+    float deadband = 0;         // Numeric: forward when the value moved at least this far
+    bool onChange = false;      // Forward when the data differs (non-numeric, or no deadband)
+};
+
+// Numeric view of a DPT for the deadband and averaging stages. Data is in the
+// KNXTelegram::data layout (6-bit value in data[0], payload from data[1]).
+struct KNXValueCodec {
+    bool (*decode)(const uint8_t* data, size_t length, double& value);
+    size_t (*encode)(double value, uint8_t* data);
+};
+
+namespace knx_value_filter_detail {
+
+template <typename Dpt>
+struct NumericCodec {
+    using Value = typename Dpt::Value;
+
+    static bool decode(const uint8_t* data, size_t length, double& value) {
+        Value decoded = Value();
+        if (!Dpt::decode(data, length, decoded)) return false;
+        value = (double)decoded;
+        return true;
+    }
+    static size_t encode(double value, uint8_t* data) {
+        Value encoded = std::is_integral<Value>::value ? (Value)std::lround(value) : (Value)value;
+        size_t length = Dpt::encode(encoded, data);
+        data[0] &= 0x3F; // APCI bits are not part of the telegram data
+        return length;
+    }
+
+    static const KNXValueCodec codec;
+};
+
+template <typename Dpt>
+const KNXValueCodec NumericCodec<Dpt>::codec = {&NumericCodec<Dpt>::decode, &NumericCodec<Dpt>::encode};
+
+} // namespace knx_value_filter_detail
+
+// Codec of a DPT whose value is a number, nullptr for the others (strings,
+// dates, scene control), which can only be filtered on change
+template <typename Dpt>
+const KNXValueCodec* knxValueCodec() {
+    if constexpr (std::is_arithmetic<typename Dpt::Value>::value) {
+        return &knx_value_filter_detail::NumericCodec<Dpt>::codec;
+    } else {
+        return nullptr;
+    }
+}
+
+struct KNXValueFilterStats {
+    uint32_t evaluated;   // Writes and responses looked at
+    uint32_t forwarded;
+    uint32_t windowed;    // Absorbed by downsampling or an averaging window
+    uint32_t rateLimited; // Within the minimum interval
+    uint32_t unchanged;   // Same data, or within the deadband
+    uint32_t filters;     // Filtered subscriptions registered
+};
+
+// State of the filtered subscriptions. Each one owns a fixed-size slot (the
+// callback, its filter, the last value forwarded and the running window), and
+// its dispatch table entry forwards to deliver() with the slot index, so the
+// filter runs in the dispatch path before the application sees the telegram.
+// The KNX_MAX_VALUE_FILTERS slots are allocated with the first subscription
+// and never move, so deliver() can run a callback outside the lock while
+// another task subscribes. Freed slots are reused; indices stay valid while
+// registered.
+class KNXValueFilterTable {
+public:
+    KNXValueFilterTable();
+    ~KNXValueFilterTable();
+
+    // Returns the slot index, -1 if the table is full or the filter needs a
+    // codec it was not given.
+    int add(uint16_t groupAddress, const KNXValueFilter& filter, const KNXValueCodec* codec,
+            KNXGroupAddressCallback callback);
+    void release(int slot);
+    // Frees the slots of an address (KNXIPModule::removeCallback)
+    void remove(uint16_t groupAddress);
+
+    // Runs the filter of the slot and calls its callback if the telegram passes
+    void deliver(int slot, const KNXTelegram& telegram, uint32_t nowMs);
+
+    KNXValueFilterStats stats();
+
+private:
+    struct Slot {
+        KNXGroupAddressCallback callback;
+        KNXValueFilter filter;
+        const KNXValueCodec* codec = nullptr;
+        uint16_t groupAddress = 0;
+        bool used = false;
+        bool forwarded = false;  // lastData, lastValue and lastForwardMs are set
+        uint8_t phase = 0;       // Telegrams seen since the last one downsampling passed
+        uint8_t samples = 0;     // Values in the averaging window
+        double sum = 0;
+        double lastValue = 0;
+        uint32_t lastForwardMs = 0;
+        KNXPayload lastData;
+    };
+
+    KNXLock lock;
+    Slot* slots; // KNX_MAX_VALUE_FILTERS of them, nullptr before the first add()
+    KNXValueFilterStats counters;
+
+    // Returns the telegram to forward (the window mean is built in scratch),
+    // nullptr to drop it
+    const KNXTelegram* evaluate(Slot& slot, const KNXTelegram& telegram, KNXTelegram& scratch,
+                                uint32_t nowMs);
+};
+
+#endif // KNX_VALUE_FILTER_H
@@ -0,0 +1,138 @@
+//==== native/AsyncUDP.h ====
+
+// In-process AsyncUDP stand-in for the env:native build. All AsyncUDP
+// instances in the process share one loopback "network": writeTo() queues a
+// datagram, AsyncUDPLoopback::poll() hands queued datagrams to every socket
+// listening on the destination, and AsyncUDPLoopback::deliver() injects a
+// datagram synchronously (used by benchmarks to time the receive path).
+
+#ifndef NATIVE_ASYNC_UDP_H
+#define NATIVE_ASYNC_UDP_H
+
+#include "Arduino.h"
+#include <functional>
+
+typedef enum {
+    TCPIP_ADAPTER_IF_STA = 0,
+    TCPIP_ADAPTER_IF_AP,
+    TCPIP_ADAPTER_IF_ETH,
+    TCPIP_ADAPTER_IF_MAX
+} tcpip_adapter_if_t;
+
+class AsyncUDP;
+
+class AsyncUDPPacket {
+public:
+    AsyncUDPPacket(AsyncUDP* udp, const uint8_t* data, size_t length,
+                   const IPAddress& localIP, uint16_t localPort,
+                   const IPAddress& remoteIP, uint16_t remotePort,
+                   bool multicast, tcpip_adapter_if_t iface)
+        : udp(udp), buffer(const_cast<uint8_t*>(data)), len(length),
+          local(localIP), localPortNum(localPort),
+          remote(remoteIP), remotePortNum(remotePort),
+          multicast(multicast), iface(iface) {}
+
+    uint8_t* data() { return buffer; }
+    size_t length() { return len; }
+    bool isBroadcast() { return false; }
+    bool isMulticast() { return multicast; }
+    bool isIPv6() { return false; }
+    tcpip_adapter_if_t interface() { return iface; }
+
+    IPAddress localIP() { return local; }
+    uint16_t localPort() { return localPortNum; }
+    IPAddress remoteIP() { return remote; }
+    uint16_t remotePort() { return remotePortNum; }
+
+    size_t send(const uint8_t* data, size_t length);
+
+private:
+    AsyncUDP* udp;
+    uint8_t* buffer;
+    size_t len;
+    IPAddress local;
+    uint16_t localPortNum;
+    IPAddress remote;
+    uint16_t remotePortNum;
+    bool multicast;
+    tcpip_adapter_if_t iface;
+};
+
+typedef std::function<void(AsyncUDPPacket& packet)> AuPacketHandlerFunction;
+
+class AsyncUDP : public Print {
+public:
+    AsyncUDP();
+    ~AsyncUDP();
+
+    void onPacket(AuPacketHandlerFunction cb) { handler = cb; }
+
+    bool listen(const IPAddress addr, uint16_t port);
+    bool listen(uint16_t port);
+    bool listenMulticast(const IPAddress addr, uint16_t port, uint8_t ttl = 1,
+                         tcpip_adapter_if_t tcpip_if = TCPIP_ADAPTER_IF_MAX);
+    void close();
+
+    size_t writeTo(const uint8_t* data, size_t len, const IPAddress addr, uint16_t port,
+                   tcpip_adapter_if_t tcpip_if = TCPIP_ADAPTER_IF_MAX);
+
+    size_t write(uint8_t c) override { (void)c; return 0; }
+    using Print::write;
+
+    operator bool() const { return listening; }
+
+private:
+    friend class AsyncUDPLoopback;
+
+    AuPacketHandlerFunction handler;
+    IPAddress boundIP;
+    IPAddress multicastGroup;
+    uint16_t port;
+    uint16_t ephemeralPort;
+    tcpip_adapter_if_t iface;
+    bool listening;
+};
+
+// Host-side control of the shared loopback network.
+class AsyncUDPLoopback {
+public:
+    struct Stats {
+        uint32_t sent;       // Datagrams accepted by writeTo()
+        uint32_t delivered;  // Datagram deliveries to listening sockets
+        uint32_t unroutable; // Datagrams no socket was listening for
+        uint32_t dropped;    // Datagrams lost because the queue was full
+    };
+
+    // Synchronously deliver a datagram to every matching socket and return the
+    // number of sockets it reached. Safe to call from any thread.
+    static size_t deliver(const uint8_t* data, size_t len,
+                          const IPAddress& srcIP, uint16_t srcPort,
+                          const IPAddress& dstIP, uint16_t dstPort,
+                          tcpip_adapter_if_t iface = TCPIP_ADAPTER_IF_MAX);
+
+    // Deliver up to maxDatagrams queued datagrams, returns how many were handled.
+    static size_t poll(size_t maxDatagrams = (size_t)-1);
+    static size_t pending();
+    static void discardPending();
+
+    // Whether multicast datagrams are also delivered back to the sending
+    // socket, as lwIP does with IP_MULTICAST_LOOP enabled (the default).
+    static void setMulticastLoop(bool enabled);
+
+    // Optional observer invoked for every datagram passed to writeTo().
+    using Tap = std::function<void(const uint8_t* data, size_t len,
+                                   const IPAddress& dstIP, uint16_t dstPort)>;
+    static void setTap(Tap tap);
+
+    static Stats stats();
+    static void resetStats();
+
+private:
+    friend class AsyncUDP;
+    static void registerSocket(AsyncUDP* socket);
+    static void unregisterSocket(AsyncUDP* socket);
+    static size_t enqueue(AsyncUDP* from, const uint8_t* data, size_t len,
+                          const IPAddress& dstIP, uint16_t dstPort, tcpip_adapter_if_t iface);
+};
+
+#endif // NATIVE_ASYNC_UDP_H
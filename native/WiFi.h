@@ -0,0 +1,39 @@
+//==== native/WiFi.h ====
+
+// WiFi stand-in for the env:native build. The host is always "connected" and
+// reports a fixed station address that the loopback network uses as the source
+// of outgoing datagrams.
+
+#ifndef NATIVE_WIFI_H
+#define NATIVE_WIFI_H
+
+#include "Arduino.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    wl_status_t begin(const char* ssid, const char* password = nullptr) {
+        (void)ssid;
+        (void)password;
+        return WL_CONNECTED;
+    }
+    wl_status_t status() const { return WL_CONNECTED; }
+    IPAddress localIP() const { return local; }
+
+    // Host-only: change the address reported by localIP().
+    void setLocalIP(const IPAddress& ip) { local = ip; }
+
+private:
+    IPAddress local = IPAddress(127, 0, 0, 1);
+};
+
+extern WiFiClass WiFi;
+
+#endif // NATIVE_WIFI_H
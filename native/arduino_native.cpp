@@ -0,0 +1,89 @@
+//==== native/arduino_native.cpp ====
+
+#include "Arduino.h"
+#include "WiFi.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
+
+namespace {
+
+const std::chrono::steady_clock::time_point clockStart = std::chrono::steady_clock::now();
+std::atomic<unsigned long> clockOffsetMs(0);
+std::mt19937 randomEngine(1);
+
+} // namespace
+
+unsigned long micros() {
+    auto elapsed = std::chrono::steady_clock::now() - clockStart;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()
+        + clockOffsetMs.load(std::memory_order_relaxed) * 1000UL;
+}
+
+unsigned long millis() {
+    return micros() / 1000UL;
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void nativeAdvanceClock(unsigned long ms) {
+    clockOffsetMs.fetch_add(ms, std::memory_order_relaxed);
+}
+
+long random(long max) {
+    return random(0, max);
+}
+
+long random(long min, long max) {
+    if (max <= min) return min;
+    std::uniform_int_distribution<long> distribution(min, max - 1);
+    return distribution(randomEngine);
+}
+
+void randomSeed(unsigned long seed) {
+    randomEngine.seed(seed);
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) return 0;
+    if ((size_t)length >= sizeof(buffer)) length = sizeof(buffer) - 1;
+    return write((const uint8_t*)buffer, (size_t)length);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    written++;
+    if (outputEnabled) fputc(c, stdout);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    written += size;
+    if (outputEnabled) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u",
+        (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return String(buffer);
+}
+
+size_t IPAddress::printTo(Print& p) const {
+    return p.print(toString());
+}
@@ -0,0 +1,245 @@
+//==== native/async_udp_loopback.cpp ====
+
+#include "AsyncUDP.h"
+#include "WiFi.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const size_t QUEUE_DEPTH = 256;
+const size_t MAX_DATAGRAM = 1472;
+
+struct QueuedDatagram {
+    uint8_t data[MAX_DATAGRAM];
+    size_t length;
+    IPAddress srcIP;
+    uint16_t srcPort;
+    IPAddress dstIP;
+    uint16_t dstPort;
+    tcpip_adapter_if_t iface;
+};
+
+struct Network {
+    std::recursive_mutex lock;
+    std::vector<AsyncUDP*> sockets;
+    std::vector<QueuedDatagram> queue = std::vector<QueuedDatagram>(QUEUE_DEPTH);
+    size_t head = 0;
+    size_t count = 0;
+    uint16_t nextEphemeralPort = 49152;
+    bool multicastLoop = true;
+    AsyncUDPLoopback::Tap tap;
+    AsyncUDPLoopback::Stats stats = {};
+};
+
+Network& network() {
+    static Network instance;
+    return instance;
+}
+
+bool isMulticast(const IPAddress& ip) {
+    return (ip[0] & 0xF0) == 0xE0;
+}
+
+bool isLocal(const IPAddress& ip) {
+    return ip == IPAddress(127, 0, 0, 1) || ip == WiFi.localIP();
+}
+
+} // namespace
+
+size_t AsyncUDPPacket::send(const uint8_t* data, size_t length) {
+    return udp ? udp->writeTo(data, length, remote, remotePortNum, iface) : 0;
+}
+
+AsyncUDP::AsyncUDP()
+    : port(0), ephemeralPort(0), iface(TCPIP_ADAPTER_IF_MAX), listening(false) {
+    AsyncUDPLoopback::registerSocket(this);
+}
+
+AsyncUDP::~AsyncUDP() {
+    AsyncUDPLoopback::unregisterSocket(this);
+}
+
+bool AsyncUDP::listen(const IPAddress addr, uint16_t port) {
+    std::lock_guard<std::recursive_mutex> guard(network().lock);
+    boundIP = addr;
+    multicastGroup = IPAddress();
+    this->port = port;
+    iface = TCPIP_ADAPTER_IF_MAX;
+    listening = true;
+    return true;
+}
+
+bool AsyncUDP::listen(uint16_t port) {
+    return listen(IPAddress(), port);
+}
+
+bool AsyncUDP::listenMulticast(const IPAddress addr, uint16_t port, uint8_t ttl,
+                               tcpip_adapter_if_t tcpip_if) {
+    (void)ttl;
+    if (!isMulticast(addr)) return false;
+    std::lock_guard<std::recursive_mutex> guard(network().lock);
+    boundIP = IPAddress();
+    multicastGroup = addr;
+    this->port = port;
+    iface = tcpip_if;
+    listening = true;
+    return true;
+}
+
+void AsyncUDP::close() {
+    std::lock_guard<std::recursive_mutex> guard(network().lock);
+    listening = false;
+}
+
+size_t AsyncUDP::writeTo(const uint8_t* data, size_t len, const IPAddress addr, uint16_t port,
+                         tcpip_adapter_if_t tcpip_if) {
+    return AsyncUDPLoopback::enqueue(this, data, len, addr, port, tcpip_if);
+}
+
+void AsyncUDPLoopback::registerSocket(AsyncUDP* socket) {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    socket->ephemeralPort = net.nextEphemeralPort++;
+    net.sockets.push_back(socket);
+}
+
+void AsyncUDPLoopback::unregisterSocket(AsyncUDP* socket) {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    for (size_t i = 0; i < net.sockets.size(); i++) {
+        if (net.sockets[i] == socket) {
+            net.sockets.erase(net.sockets.begin() + i);
+            break;
+        }
+    }
+}
+
+size_t AsyncUDPLoopback::enqueue(AsyncUDP* from, const uint8_t* data, size_t len,
+                                 const IPAddress& dstIP, uint16_t dstPort,
+                                 tcpip_adapter_if_t iface) {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    if (len > MAX_DATAGRAM) return 0;
+    net.stats.sent++;
+    if (net.tap) net.tap(data, len, dstIP, dstPort);
+
+    if (net.count == QUEUE_DEPTH) {
+        net.stats.dropped++;
+        return len; // Like UDP, a lost datagram still counts as sent
+    }
+
+    QueuedDatagram& slot = net.queue[(net.head + net.count) % QUEUE_DEPTH];
+    memcpy(slot.data, data, len);
+    slot.length = len;
+    slot.srcIP = from->boundIP != IPAddress() ? from->boundIP : WiFi.localIP();
+    slot.srcPort = from->listening && from->port ? from->port : from->ephemeralPort;
+    slot.dstIP = dstIP;
+    slot.dstPort = dstPort;
+    slot.iface = iface;
+    net.count++;
+    return len;
+}
+
+size_t AsyncUDPLoopback::deliver(const uint8_t* data, size_t len,
+                                 const IPAddress& srcIP, uint16_t srcPort,
+                                 const IPAddress& dstIP, uint16_t dstPort,
+                                 tcpip_adapter_if_t iface) {
+    Network& net = network();
+    std::unique_lock<std::recursive_mutex> guard(net.lock);
+    bool multicast = isMulticast(dstIP);
+    size_t receivers = 0;
+
+    // Collect receivers first so handlers may open or close sockets.
+    AsyncUDP* targets[16];
+    size_t targetCount = 0;
+    for (AsyncUDP* socket : net.sockets) {
+        if (!socket->listening || socket->port != dstPort || !socket->handler) continue;
+        bool match;
+        if (multicast) {
+            match = socket->multicastGroup == dstIP &&
+                (socket->iface == TCPIP_ADAPTER_IF_MAX || iface == TCPIP_ADAPTER_IF_MAX ||
+                 socket->iface == iface);
+            if (match && !net.multicastLoop && srcPort == socket->port && isLocal(srcIP)) {
+                match = false;
+            }
+        } else if (socket->boundIP != IPAddress()) {
+            match = socket->boundIP == dstIP;
+        } else {
+            match = isLocal(dstIP);
+        }
+        if (match && targetCount < sizeof(targets) / sizeof(targets[0])) {
+            targets[targetCount++] = socket;
+        }
+    }
+    guard.unlock();
+
+    for (size_t i = 0; i < targetCount; i++) {
+        AsyncUDP* socket = targets[i];
+        IPAddress localIP = multicast ? dstIP : (socket->boundIP != IPAddress() ? socket->boundIP : dstIP);
+        AsyncUDPPacket packet(socket, data, len, localIP, socket->port, srcIP, srcPort, multicast, iface);
+        socket->handler(packet);
+        receivers++;
+    }
+
+    guard.lock();
+    net.stats.delivered += receivers;
+    if (receivers == 0) net.stats.unroutable++;
+    return receivers;
+}
+
+size_t AsyncUDPLoopback::poll(size_t maxDatagrams) {
+    Network& net = network();
+    size_t handled = 0;
+    QueuedDatagram datagram;
+    while (handled < maxDatagrams) {
+        {
+            std::lock_guard<std::recursive_mutex> guard(net.lock);
+            if (net.count == 0) break;
+            datagram = net.queue[net.head];
+            net.head = (net.head + 1) % QUEUE_DEPTH;
+            net.count--;
+        }
+        deliver(datagram.data, datagram.length, datagram.srcIP, datagram.srcPort,
+                datagram.dstIP, datagram.dstPort, datagram.iface);
+        handled++;
+    }
+    return handled;
+}
+
+size_t AsyncUDPLoopback::pending() {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    return net.count;
+}
+
+void AsyncUDPLoopback::discardPending() {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    net.head = 0;
+    net.count = 0;
+}
+
+void AsyncUDPLoopback::setMulticastLoop(bool enabled) {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    net.multicastLoop = enabled;
+}
+
+void AsyncUDPLoopback::setTap(Tap tap) {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    net.tap = tap;
+}
+
+AsyncUDPLoopback::Stats AsyncUDPLoopback::stats() {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    return net.stats;
+}
+
+void AsyncUDPLoopback::resetStats() {
+    Network& net = network();
+    std::lock_guard<std::recursive_mutex> guard(net.lock);
+    net.stats = Stats();
+}
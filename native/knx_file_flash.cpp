@@ -0,0 +1,63 @@
+//==== native/knx_file_flash.cpp ====
+
+#include "knx_file_flash.h"
+#include <stdint.h>
+
+KNXFileFlash::KNXFileFlash(const char* path, size_t size, size_t sectorSize)
+    : file(nullptr), totalSize(size), sector(sectorSize), budget(SIZE_MAX), written(0),
+      erases(size / sectorSize, 0) {
+    file = fopen(path, "r+b");
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        if ((size_t)ftell(file) != size) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+    if (!file) {
+        file = fopen(path, "w+b");
+        if (!file) return;
+        std::vector<uint8_t> erased(size, 0xFF);
+        fwrite(erased.data(), 1, size, file);
+        fflush(file);
+    }
+}
+
+KNXFileFlash::~KNXFileFlash() {
+    if (file) fclose(file);
+}
+
+bool KNXFileFlash::read(size_t offset, void* data, size_t length) {
+    if (!file || offset + length > totalSize) return false;
+    fseek(file, (long)offset, SEEK_SET);
+    return fread(data, 1, length, file) == length;
+}
+
+bool KNXFileFlash::write(size_t offset, const void* data, size_t length) {
+    if (!file || offset + length > totalSize) return false;
+    size_t allowed = length < budget ? length : budget;
+    std::vector<uint8_t> bytes(allowed);
+    if (!read(offset, bytes.data(), allowed)) return false;
+    for (size_t i = 0; i < allowed; i++) {
+        bytes[i] &= ((const uint8_t*)data)[i];
+    }
+    fseek(file, (long)offset, SEEK_SET);
+    fwrite(bytes.data(), 1, allowed, file);
+    fflush(file);
+    if (budget != SIZE_MAX) budget -= allowed;
+    written += allowed;
+    return allowed == length;
+}
+
+bool KNXFileFlash::erase(size_t offset, size_t length) {
+    if (!file || offset % sector != 0 || length % sector != 0 || offset + length > totalSize) {
+        return false;
+    }
+    if (budget == 0) return false;
+    std::vector<uint8_t> erased(length, 0xFF);
+    fseek(file, (long)offset, SEEK_SET);
+    fwrite(erased.data(), 1, length, file);
+    fflush(file);
+    for (size_t i = offset / sector; i < (offset + length) / sector; i++) erases[i]++;
+    return true;
+}
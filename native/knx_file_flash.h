@@ -0,0 +1,44 @@
+//==== native/knx_file_flash.h ====
+
+// File-backed stand-in for a flash partition in the env:native build. The
+// file keeps its contents across KNXFileFlash instances, so a benchmark can
+// "reboot" by creating a new module and store on the same path. Writes follow
+// NOR semantics (they can only clear bits), erases are counted per sector, and
+// a write budget cuts a write short to simulate power loss.
+
+#ifndef NATIVE_KNX_FILE_FLASH_H
+#define NATIVE_KNX_FILE_FLASH_H
+
+#include "knx_snapshot.h"
+#include <stdio.h>
+#include <vector>
+
+class KNXFileFlash : public KNXFlashStore {
+public:
+    // Creates the file, erased, if it does not exist or has another size
+    KNXFileFlash(const char* path, size_t size, size_t sectorSize = 4096);
+    ~KNXFileFlash();
+
+    size_t size() override { return totalSize; }
+    size_t sectorSize() override { return sector; }
+    bool read(size_t offset, void* data, size_t length) override;
+    bool write(size_t offset, const void* data, size_t length) override;
+    bool erase(size_t offset, size_t length) override;
+
+    // Bytes still written before every write fails, as if power was lost;
+    // SIZE_MAX for no limit
+    void setWriteBudget(size_t bytes) { budget = bytes; }
+
+    const std::vector<uint32_t>& eraseCounts() const { return erases; }
+    uint64_t bytesWritten() const { return written; }
+
+private:
+    FILE* file;
+    size_t totalSize;
+    size_t sector;
+    size_t budget;
+    uint64_t written;
+    std::vector<uint32_t> erases;
+};
+
+#endif // NATIVE_KNX_FILE_FLASH_H
@@ -0,0 +1,40 @@
+//==== native/native_heap.cpp ====
+
+#include "native_heap.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocationCount(0);
+
+void* countedAllocate(size_t size) {
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer) throw std::bad_alloc();
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return pointer;
+}
+
+} // namespace
+
+uint64_t nativeHeapAllocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    void* pointer = malloc(size ? size : 1);
+    if (pointer) allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return pointer;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept { free(pointer); }
+void operator delete[](void* pointer) noexcept { free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { free(pointer); }
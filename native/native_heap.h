@@ -0,0 +1,15 @@
+//==== native/native_heap.h ====
+
+// Heap accounting for the env:native build. native_heap.cpp replaces the
+// global operator new/delete so benchmarks can prove that a code path performs
+// no heap allocations.
+
+#ifndef NATIVE_HEAP_H
+#define NATIVE_HEAP_H
+
+#include <stdint.h>
+
+// Number of successful operator new calls since program start, across threads.
+uint64_t nativeHeapAllocations();
+
+#endif // NATIVE_HEAP_H
@@ -0,0 +1,63 @@
+//==== src/knx_batch.cpp ====
+
+#include "knx_batch.h"
+#include "knx_protocol.h"
+#include "knx_memory.h"
+
+KNXBatch::KNXBatch()
+    : entries(nullptr), arena(nullptr), capacity(0), arenaSize(0), count(0), used(0) {}
+
+KNXBatch::~KNXBatch() {
+    end();
+}
+
+bool KNXBatch::begin(size_t maxEntries, size_t arenaSize) {
+    end();
+    if (arenaSize == 0) arenaSize = maxEntries * 16;
+    if (maxEntries == 0 || arenaSize > 0xFFFF) return false;
+
+    entries = knxNewArray<Entry>(maxEntries);
+    arena = knxNewArray<uint8_t>(arenaSize);
+    if (!entries || !arena) {
+        end();
+        return false;
+    }
+    capacity = maxEntries;
+    this->arenaSize = arenaSize;
+    return true;
+}
+
+void KNXBatch::end() {
+    knxDeleteArray(entries);
+    knxDeleteArray(arena);
+    entries = nullptr;
+    arena = nullptr;
+    capacity = 0;
+    arenaSize = 0;
+    count = 0;
+    used = 0;
+}
+
+void KNXBatch::clear() {
+    count = 0;
+    used = 0;
+}
+
+bool KNXBatch::add(int groupAddress, const uint8_t* data, size_t dataLength, KNXPriority priority) {
+    size_t length = 10 + dataLength;
+    if (count == capacity || dataLength == 0 || dataLength > KNX_TELEGRAM_MAX_DATA ||
+        used + length > arenaSize) {
+        return false;
+    }
+
+    // The source address depends on the connection and is stamped when sent
+    knxWriteGroupFrame(arena + used, KNX_CEMI_L_DATA_IND, 0, (uint16_t)groupAddress,
+                       priority, data, dataLength);
+    Entry& entry = entries[count++];
+    entry.offset = (uint16_t)used;
+    entry.groupAddress = (uint16_t)groupAddress;
+    entry.priority = (uint8_t)priority;
+    entry.status = KNX_BATCH_PENDING;
+    used += length;
+    return true;
+}
@@ -0,0 +1,338 @@
+//==== src/knx_bus_analytics.cpp ====
+
+#include "knx_bus_analytics.h"
+#include <utility>
+
+KNXTopCounter::KNXTopCounter()
+    : counters(nullptr), buckets(nullptr), hash(nullptr), capacity(0), hashMask(0), used(0),
+      lowest(NONE), highest(NONE), freeBucket(NONE) {}
+
+KNXTopCounter::~KNXTopCounter() {
+    end();
+}
+
+bool KNXTopCounter::begin(size_t capacity) {
+    end();
+    if (capacity == 0) capacity = 1;
+    if (capacity > 4096) capacity = 4096;
+    // Chains of the hash index stay short at half load
+    size_t hashSize = 1;
+    while (hashSize < capacity * 2) hashSize <<= 1;
+
+    counters = knxNewArray<Counter>(capacity);
+    buckets = knxNewArray<Bucket>(capacity);
+    hash = knxNewArray<uint16_t>(hashSize);
+    if (!counters || !buckets || !hash) {
+        end();
+        return false;
+    }
+    this->capacity = capacity;
+    hashMask = (uint16_t)(hashSize - 1);
+    clear();
+    return true;
+}
+
+void KNXTopCounter::end() {
+    knxDeleteArray(counters);
+    knxDeleteArray(buckets);
+    knxDeleteArray(hash);
+    counters = nullptr;
+    buckets = nullptr;
+    hash = nullptr;
+    capacity = 0;
+    used = 0;
+}
+
+void KNXTopCounter::swap(KNXTopCounter& other) {
+    std::swap(counters, other.counters);
+    std::swap(buckets, other.buckets);
+    std::swap(hash, other.hash);
+    std::swap(capacity, other.capacity);
+    std::swap(hashMask, other.hashMask);
+    std::swap(used, other.used);
+    std::swap(lowest, other.lowest);
+    std::swap(highest, other.highest);
+    std::swap(freeBucket, other.freeBucket);
+}
+
+void KNXTopCounter::clear() {
+    if (!counters) return;
+    used = 0;
+    lowest = highest = NONE;
+    for (size_t i = 0; i <= hashMask; i++) hash[i] = NONE;
+    for (size_t i = 0; i < capacity; i++) {
+        buckets[i].next = (i + 1 < capacity) ? (uint16_t)(i + 1) : NONE;
+    }
+    freeBucket = 0;
+}
+
+namespace {
+
+inline uint16_t hashOf(uint16_t address, uint16_t mask) {
+    return (uint16_t)(((uint32_t)address * 2654435761U) >> 16) & mask;
+}
+
+} // namespace
+
+uint16_t KNXTopCounter::find(uint16_t address) const {
+    for (uint16_t i = hash[hashOf(address, hashMask)]; i != NONE; i = counters[i].hashNext) {
+        if (counters[i].address == address) return i;
+    }
+    return NONE;
+}
+
+void KNXTopCounter::index(uint16_t counter) {
+    uint16_t& head = hash[hashOf(counters[counter].address, hashMask)];
+    counters[counter].hashNext = head;
+    head = counter;
+}
+
+void KNXTopCounter::unindex(uint16_t counter) {
+    uint16_t* link = &hash[hashOf(counters[counter].address, hashMask)];
+    while (*link != counter) link = &counters[*link].hashNext;
+    *link = counters[counter].hashNext;
+}
+
+void KNXTopCounter::count(uint16_t address) {
+    if (!counters) return;
+    uint16_t counter = find(address);
+    if (counter != NONE) {
+        increment(counter);
+        return;
+    }
+
+    if (used < capacity) {
+        counter = used++;
+        Counter& entry = counters[counter];
+        entry.address = address;
+        entry.count = 1;
+        entry.error = 0;
+        index(counter);
+        uint16_t bucket = lowest != NONE && buckets[lowest].count == 1 ? lowest : newBucket(1, NONE);
+        attach(counter, bucket);
+        return;
+    }
+
+    // Full: the address takes over the least counted one, and its count as error
+    counter = buckets[lowest].head;
+    unindex(counter);
+    counters[counter].address = address;
+    counters[counter].error = counters[counter].count;
+    index(counter);
+    increment(counter);
+}
+
+void KNXTopCounter::increment(uint16_t counter) {
+    Counter& entry = counters[counter];
+    uint16_t bucket = entry.bucket;
+    uint16_t next = buckets[bucket].next;
+    entry.count++;
+
+    if (next != NONE && buckets[next].count == entry.count) {
+        detach(counter);
+        attach(counter, next);
+        freeBucketIfEmpty(bucket);
+    } else if (buckets[bucket].head == counter && entry.next == NONE) {
+        // Alone in its bucket: the bucket moves up with it
+        buckets[bucket].count = entry.count;
+    } else {
+        detach(counter);
+        attach(counter, newBucket(entry.count, bucket));
+    }
+}
+
+void KNXTopCounter::attach(uint16_t counter, uint16_t bucket) {
+    Counter& entry = counters[counter];
+    entry.bucket = bucket;
+    entry.prev = NONE;
+    entry.next = buckets[bucket].head;
+    if (entry.next != NONE) counters[entry.next].prev = counter;
+    buckets[bucket].head = counter;
+}
+
+void KNXTopCounter::detach(uint16_t counter) {
+    Counter& entry = counters[counter];
+    if (entry.prev != NONE) {
+        counters[entry.prev].next = entry.next;
+    } else {
+        buckets[entry.bucket].head = entry.next;
+    }
+    if (entry.next != NONE) counters[entry.next].prev = entry.prev;
+}
+
+uint16_t KNXTopCounter::newBucket(uint32_t count, uint16_t after) {
+    // There are never more buckets than counters in use
+    uint16_t bucket = freeBucket;
+    Bucket& entry = buckets[bucket];
+    freeBucket = entry.next;
+    entry.count = count;
+    entry.head = NONE;
+    entry.prev = after;
+    entry.next = after != NONE ? buckets[after].next : lowest;
+    if (entry.next != NONE) {
+        buckets[entry.next].prev = bucket;
+    } else {
+        highest = bucket;
+    }
+    if (after != NONE) {
+        buckets[after].next = bucket;
+    } else {
+        lowest = bucket;
+    }
+    return bucket;
+}
+
+void KNXTopCounter::freeBucketIfEmpty(uint16_t bucket) {
+    Bucket& entry = buckets[bucket];
+    if (entry.head != NONE) return;
+    if (entry.prev != NONE) {
+        buckets[entry.prev].next = entry.next;
+    } else {
+        lowest = entry.next;
+    }
+    if (entry.next != NONE) {
+        buckets[entry.next].prev = entry.prev;
+    } else {
+        highest = entry.prev;
+    }
+    entry.next = freeBucket;
+    freeBucket = bucket;
+}
+
+size_t KNXTopCounter::top(KNXTopAddress* entries, size_t maxEntries) const {
+    if (!counters) return 0;
+    size_t written = 0;
+    for (uint16_t bucket = highest; bucket != NONE && written < maxEntries; bucket = buckets[bucket].prev) {
+        for (uint16_t i = buckets[bucket].head; i != NONE && written < maxEntries; i = counters[i].next) {
+            entries[written].address = counters[i].address;
+            entries[written].count = counters[i].count;
+            entries[written].error = counters[i].error;
+            written++;
+        }
+    }
+    return written;
+}
+
+KNXBusAnalytics::KNXBusAnalytics() {
+    clearWindows(0);
+}
+
+bool KNXBusAnalytics::begin(const KNXBusAnalyticsConfig& config, uint32_t nowMs) {
+    end();
+
+    KNXTopCounter sources, groups;
+    if (!sources.begin(config.topSources) || !groups.begin(config.topGroups)) return false;
+
+    KNXLockGuard guard(lock);
+    this->config = config;
+    if (this->config.bitRate == 0) this->config.bitRate = 9600;
+    topSources.swap(sources);
+    topGroups.swap(groups);
+    clearWindows(nowMs);
+    return true;
+}
+
+void KNXBusAnalytics::end() {
+    // Declared before the guard, so freed after it
+    KNXTopCounter sources, groups;
+    KNXLockGuard guard(lock);
+    topSources.swap(sources);
+    topGroups.swap(groups);
+}
+
+void KNXBusAnalytics::record(const KNXCemiFrame& frame, uint32_t nowMs) {
+    size_t octets = frame.apduLength + (frame.isExtended() ? 9 : 8);
+    uint32_t bits = KNX_TP1_FRAME_OVERHEAD_BITS + KNX_TP1_BITS_PER_OCTET * (uint32_t)octets;
+    // Data frames carry the 4-bit APCI in the TPCI octet and the next
+    int apci = -1;
+    if ((frame.tpdu[0] & 0x80) == 0 && frame.apduLength > 0) {
+        apci = ((frame.tpdu[0] & 0x03) << 2) | (frame.tpdu[1] >> 6);
+    }
+
+    KNXLockGuard guard(lock);
+    if (!topSources.isActive()) return;
+    advance(nowMs);
+    counters.frames++;
+    if (frame.isGroupAddress()) counters.groupFrames++;
+    if (frame.isExtended()) counters.extendedFrames++;
+    // Cleared repeat flag of an indication: the sender repeated the frame
+    if (frame.messageCode == KNX_CEMI_L_DATA_IND && (frame.ctrl1 & 0x20) == 0) counters.repeatedFrames++;
+    if (apci < 0) {
+        counters.controlFrames++;
+    } else {
+        counters.apci[apci]++;
+    }
+    currentFrames++;
+    currentBits += bits;
+
+    topSources.count(frame.source);
+    if (frame.isGroupAddress()) topGroups.count(frame.destination);
+}
+
+void KNXBusAnalytics::advance(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - secondStart;
+    // A caller that read millis() before another one advanced the window
+    if ((int32_t)elapsed < 1000) return;
+    uint32_t seconds = elapsed / 1000;
+    // After a silent minute the ring holds nothing but zeros
+    uint32_t closes = seconds > SECONDS ? SECONDS + 1 : seconds;
+    for (uint32_t i = 0; i < closes; i++) closeSecond();
+    secondStart += seconds * 1000;
+}
+
+void KNXBusAnalytics::closeSecond() {
+    minuteFrames += currentFrames - secondFrames[secondHead];
+    minuteBits += currentBits - secondBits[secondHead];
+    secondFrames[secondHead] = currentFrames;
+    secondBits[secondHead] = currentBits;
+    secondHead = (secondHead + 1) % SECONDS;
+
+    counters.framesLastSecond = currentFrames;
+    counters.framesLastMinute = minuteFrames;
+    if (currentFrames > counters.peakFramesPerSecond) counters.peakFramesPerSecond = currentFrames;
+    lastSecondBits = currentBits;
+    if (currentBits > peakBits) peakBits = currentBits;
+    currentFrames = 0;
+    currentBits = 0;
+}
+
+void KNXBusAnalytics::clearWindows(uint32_t nowMs) {
+    counters = KNXBusStats();
+    for (uint8_t i = 0; i < SECONDS; i++) {
+        secondFrames[i] = 0;
+        secondBits[i] = 0;
+    }
+    secondHead = 0;
+    secondStart = nowMs;
+    currentFrames = currentBits = 0;
+    minuteFrames = minuteBits = 0;
+    lastSecondBits = peakBits = 0;
+}
+
+KNXBusStats KNXBusAnalytics::stats(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    if (topSources.isActive()) advance(nowMs);
+    KNXBusStats snapshot = counters;
+    float bitsPerSecond = (float)config.bitRate;
+    snapshot.loadLastSecond = 100.0f * lastSecondBits / bitsPerSecond;
+    snapshot.loadLastMinute = 100.0f * minuteBits / (bitsPerSecond * SECONDS);
+    snapshot.peakLoad = 100.0f * peakBits / bitsPerSecond;
+    return snapshot;
+}
+
+size_t KNXBusAnalytics::topSourceAddresses(KNXTopAddress* entries, size_t maxEntries) {
+    KNXLockGuard guard(lock);
+    return topSources.top(entries, maxEntries);
+}
+
+size_t KNXBusAnalytics::topGroupAddresses(KNXTopAddress* entries, size_t maxEntries) {
+    KNXLockGuard guard(lock);
+    return topGroups.top(entries, maxEntries);
+}
+
+void KNXBusAnalytics::reset(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    topSources.clear();
+    topGroups.clear();
+    clearWindows(nowMs);
+}
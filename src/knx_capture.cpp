@@ -0,0 +1,208 @@
+//==== src/knx_capture.cpp ====
+
+#include "knx_capture.h"
+#include "knx_memory.h"
+#include <time.h>
+
+namespace {
+
+// Below this the clock has not been set (SNTP) and timestamps start at zero
+const time_t VALID_TIME = 1577836800; // 2020-01-01
+
+void put16be(uint8_t* out, uint16_t value) {
+    out[0] = value >> 8;
+    out[1] = value & 0xFF;
+}
+
+void put16le(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+void put32le(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (value >> (8 * i)) & 0xFF;
+}
+
+uint16_t ipv4Checksum(const uint8_t* header) {
+    uint32_t sum = 0;
+    for (int i = 0; i < 20; i += 2) sum += (header[i] << 8) | header[i + 1];
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+} // namespace
+
+KNXCaptureBuffer::KNXCaptureBuffer()
+    : buffer(nullptr), inPsram(false), head(0), used(0), baseSeconds(0), lastMicros(0), elapsedMicros(0), counters() {}
+
+KNXCaptureBuffer::~KNXCaptureBuffer() {
+    end();
+}
+
+bool KNXCaptureBuffer::begin(const KNXCaptureConfig& config) {
+    end();
+    size_t size = config.bufferSize < 256 ? 256 : config.bufferSize;
+
+    uint8_t* allocated = nullptr;
+    bool psram = false;
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM) && !KNX_STATIC_ALLOCATION
+    if (config.preferPsram) allocated = (uint8_t*)ps_malloc(size);
+    psram = allocated != nullptr;
+#endif
+    if (!allocated) allocated = knxNewArray<uint8_t>(size);
+    if (!allocated) return false;
+
+    time_t now = time(nullptr);
+    KNXLockGuard guard(lock);
+    this->config = config;
+    this->config.bufferSize = size;
+    buffer = allocated;
+    inPsram = psram;
+    head = 0;
+    used = 0;
+    baseSeconds = now >= VALID_TIME ? (uint32_t)now : 0;
+    lastMicros = micros();
+    elapsedMicros = 0;
+    counters = KNXCaptureStats();
+    counters.bufferSize = size;
+    return true;
+}
+
+void KNXCaptureBuffer::end() {
+    uint8_t* released;
+    bool psram;
+    {
+        KNXLockGuard guard(lock);
+        released = buffer;
+        psram = inPsram;
+        buffer = nullptr;
+        used = 0;
+    }
+    if (psram) {
+        free(released);
+    } else {
+        knxDeleteArray(released);
+    }
+}
+
+size_t KNXCaptureBuffer::writeFileHeader(uint8_t* out, uint32_t snapLength) {
+    put32le(out, 0xA1B2C3D4);  // Magic, microsecond timestamps
+    put16le(out + 4, 2);       // Version 2.4
+    put16le(out + 6, 4);
+    put32le(out + 8, 0);       // Time zone offset
+    put32le(out + 12, 0);      // Timestamp accuracy
+    put32le(out + 16, snapLength);
+    put32le(out + 20, LINKTYPE_RAW);
+    return FILE_HEADER_SIZE;
+}
+
+void KNXCaptureBuffer::copyIn(size_t offset, const uint8_t* data, size_t length) {
+    offset %= config.bufferSize;
+    size_t first = config.bufferSize - offset;
+    if (first > length) first = length;
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, data + first, length - first);
+}
+
+void KNXCaptureBuffer::copyOut(size_t offset, uint8_t* data, size_t length) const {
+    offset %= config.bufferSize;
+    size_t first = config.bufferSize - offset;
+    if (first > length) first = length;
+    memcpy(data, buffer + offset, first);
+    memcpy(data + first, buffer, length - first);
+}
+
+size_t KNXCaptureBuffer::recordLengthAt(size_t offset) const {
+    uint8_t field[4];
+    copyOut(offset + 8, field, sizeof(field)); // Included length
+    return 16 + (field[0] | (field[1] << 8) | (field[2] << 16) | ((uint32_t)field[3] << 24));
+}
+
+void KNXCaptureBuffer::dropOldest() {
+    size_t length = recordLengthAt(head);
+    head = (head + length) % config.bufferSize;
+    used -= length;
+    counters.records--;
+    counters.dropped++;
+}
+
+void KNXCaptureBuffer::record(const uint8_t* data, size_t length, const IPAddress& srcIP,
+                              uint16_t srcPort, const IPAddress& dstIP, uint16_t dstPort) {
+    size_t stored = length < config.snapLength ? length : config.snapLength;
+    size_t recordLength = RECORD_OVERHEAD + stored;
+
+    KNXLockGuard guard(lock);
+    if (!buffer) return;
+    if (recordLength > config.bufferSize) {
+        counters.dropped++;
+        return;
+    }
+    while (used + recordLength > config.bufferSize) {
+        if (!config.overwrite) {
+            counters.dropped++;
+            return;
+        }
+        dropOldest();
+    }
+
+    uint32_t now = micros();
+    elapsedMicros += (uint32_t)(now - lastMicros);
+    lastMicros = now;
+
+    uint8_t header[RECORD_OVERHEAD];
+    put32le(header, baseSeconds + (uint32_t)(elapsedMicros / 1000000));
+    put32le(header + 4, (uint32_t)(elapsedMicros % 1000000));
+    put32le(header + 8, (uint32_t)(stored + 28));
+    put32le(header + 12, (uint32_t)(length + 28));
+
+    uint8_t* ip = header + 16;
+    ip[0] = 0x45;                      // IPv4, 20-byte header
+    ip[1] = 0x00;
+    put16be(ip + 2, (uint16_t)(length + 28));
+    put16be(ip + 4, 0);                // Identification
+    put16be(ip + 6, 0x4000);           // Don't fragment
+    ip[8] = 64;                        // TTL
+    ip[9] = 17;                        // UDP
+    put16be(ip + 10, 0);
+    for (int i = 0; i < 4; i++) {
+        ip[12 + i] = srcIP[i];
+        ip[16 + i] = dstIP[i];
+    }
+    put16be(ip + 10, ipv4Checksum(ip));
+
+    uint8_t* udp = ip + 20;
+    put16be(udp, srcPort);
+    put16be(udp + 2, dstPort);
+    put16be(udp + 4, (uint16_t)(length + 8));
+    put16be(udp + 6, 0);               // No checksum
+
+    copyIn(head + used, header, sizeof(header));
+    copyIn(head + used + sizeof(header), data, stored);
+    used += recordLength;
+    counters.records++;
+    counters.captured++;
+    if (stored < length) counters.truncated++;
+}
+
+size_t KNXCaptureBuffer::read(uint8_t* out, size_t maxLength) {
+    KNXLockGuard guard(lock);
+    size_t copied = 0;
+    while (buffer && used > 0) {
+        size_t length = recordLengthAt(head);
+        if (copied + length > maxLength) break;
+        copyOut(head, out + copied, length);
+        head = (head + length) % config.bufferSize;
+        used -= length;
+        copied += length;
+        counters.records--;
+        counters.streamed++;
+    }
+    return copied;
+}
+
+KNXCaptureStats KNXCaptureBuffer::stats() {
+    KNXLockGuard guard(lock);
+    KNXCaptureStats snapshot = counters;
+    snapshot.bytesUsed = used;
+    return snapshot;
+}
@@ -0,0 +1,501 @@
+//==== src/knx_crypto.cpp ====
+
+#include "knx_crypto.h"
+
+#if defined(ESP32)
+#include <esp_system.h>
+#else
+#include <random>
+#endif
+
+namespace {
+
+inline uint32_t load32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+inline void store32(uint8_t* p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+inline uint32_t rotr(uint32_t value, unsigned bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+void incrementCounter(uint8_t counter[16]) {
+    for (int i = 15; i >= 0; i--) {
+        if (++counter[i] != 0) break;
+    }
+}
+
+#if !KNX_AES_HARDWARE
+// S-box and the first round table, derived on first use from the field
+// arithmetic instead of 1.3 KB of constants. The other three round tables are
+// rotations of the first.
+struct AesTables {
+    uint8_t sbox[256];
+    uint32_t round[256];
+
+    AesTables() {
+        uint8_t p = 1, q = 1;
+        do {
+            // p runs through the multiplicative group, q through the inverses
+            p = p ^ (uint8_t)(p << 1) ^ ((p & 0x80) ? 0x1B : 0);
+            q ^= q << 1;
+            q ^= q << 2;
+            q ^= q << 4;
+            if (q & 0x80) q ^= 0x09;
+            uint8_t x = q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4);
+            sbox[p] = x ^ 0x63;
+        } while (p != 1);
+        sbox[0] = 0x63;
+
+        for (int i = 0; i < 256; i++) {
+            uint8_t s = sbox[i];
+            uint8_t s2 = (uint8_t)(s << 1) ^ ((s & 0x80) ? 0x1B : 0);
+            round[i] = ((uint32_t)s2 << 24) | ((uint32_t)s << 16) | ((uint32_t)s << 8) | (uint8_t)(s2 ^ s);
+        }
+    }
+
+    static uint8_t rotl8(uint8_t x, unsigned bits) {
+        return (uint8_t)((x << bits) | (x >> (8 - bits)));
+    }
+};
+
+const AesTables& aesTables() {
+    static const AesTables tables;
+    return tables;
+}
+#endif
+
+} // namespace
+
+#if KNX_AES_HARDWARE
+
+KNXAes128::KNXAes128() : keyed(false) {
+    esp_aes_init(&context);
+}
+
+KNXAes128::~KNXAes128() {
+    esp_aes_free(&context);
+}
+
+void KNXAes128::setKey(const uint8_t key[16]) {
+    esp_aes_setkey(&context, key, 128);
+    keyed = true;
+}
+
+void KNXAes128::clear() {
+    esp_aes_free(&context);
+    esp_aes_init(&context);
+    keyed = false;
+}
+
+void KNXAes128::encryptBlock(const uint8_t in[16], uint8_t out[16]) const {
+    esp_aes_crypt_ecb(&context, ESP_AES_ENCRYPT, in, out);
+}
+
+void KNXAes128::cbcMac(uint8_t state[16], const uint8_t* data, size_t blocks) const {
+    // The driver writes every cipher block; only the last one (left in state
+    // as the next IV) is wanted
+    uint8_t scratch[4 * BLOCK];
+    while (blocks > 0) {
+        size_t n = blocks < 4 ? blocks : 4;
+        esp_aes_crypt_cbc(&context, ESP_AES_ENCRYPT, n * BLOCK, state, data, scratch);
+        data += n * BLOCK;
+        blocks -= n;
+    }
+}
+
+void KNXAes128::ctr(uint8_t counter[16], const uint8_t* in, uint8_t* out, size_t length) const {
+    size_t offset = 0;
+    uint8_t stream[BLOCK];
+    esp_aes_crypt_ctr(&context, length, &offset, counter, stream, in, out);
+}
+
+#else
+
+KNXAes128::KNXAes128() : keyed(false), roundKeys() {}
+
+KNXAes128::~KNXAes128() {
+    clear();
+}
+
+void KNXAes128::setKey(const uint8_t key[16]) {
+    const uint8_t* sbox = aesTables().sbox;
+    uint32_t rcon = 0x01;
+    for (int i = 0; i < 4; i++) roundKeys[i] = load32(key + 4 * i);
+    for (int i = 4; i < 44; i++) {
+        uint32_t t = roundKeys[i - 1];
+        if (i % 4 == 0) {
+            t = ((uint32_t)sbox[(t >> 16) & 0xFF] << 24) | ((uint32_t)sbox[(t >> 8) & 0xFF] << 16) |
+                ((uint32_t)sbox[t & 0xFF] << 8) | sbox[t >> 24];
+            t ^= rcon << 24;
+            rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x11B : 0);
+        }
+        roundKeys[i] = roundKeys[i - 4] ^ t;
+    }
+    keyed = true;
+}
+
+void KNXAes128::clear() {
+    volatile uint32_t* keys = roundKeys;
+    for (int i = 0; i < 44; i++) keys[i] = 0;
+    keyed = false;
+}
+
+void KNXAes128::encryptBlock(const uint8_t in[16], uint8_t out[16]) const {
+    const AesTables& tables = aesTables();
+    const uint32_t* te = tables.round;
+    const uint32_t* rk = roundKeys;
+    uint32_t s0 = load32(in) ^ rk[0];
+    uint32_t s1 = load32(in + 4) ^ rk[1];
+    uint32_t s2 = load32(in + 8) ^ rk[2];
+    uint32_t s3 = load32(in + 12) ^ rk[3];
+
+    for (int round = 1; round < 10; round++) {
+        rk += 4;
+        uint32_t t0 = te[s0 >> 24] ^ rotr(te[(s1 >> 16) & 0xFF], 8) ^
+                      rotr(te[(s2 >> 8) & 0xFF], 16) ^ rotr(te[s3 & 0xFF], 24) ^ rk[0];
+        uint32_t t1 = te[s1 >> 24] ^ rotr(te[(s2 >> 16) & 0xFF], 8) ^
+                      rotr(te[(s3 >> 8) & 0xFF], 16) ^ rotr(te[s0 & 0xFF], 24) ^ rk[1];
+        uint32_t t2 = te[s2 >> 24] ^ rotr(te[(s3 >> 16) & 0xFF], 8) ^
+                      rotr(te[(s0 >> 8) & 0xFF], 16) ^ rotr(te[s1 & 0xFF], 24) ^ rk[2];
+        uint32_t t3 = te[s3 >> 24] ^ rotr(te[(s0 >> 16) & 0xFF], 8) ^
+                      rotr(te[(s1 >> 8) & 0xFF], 16) ^ rotr(te[s2 & 0xFF], 24) ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Last round: no MixColumns
+    const uint8_t* sbox = tables.sbox;
+    rk += 4;
+    auto last = [sbox](uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        return ((uint32_t)sbox[a >> 24] << 24) | ((uint32_t)sbox[(b >> 16) & 0xFF] << 16) |
+               ((uint32_t)sbox[(c >> 8) & 0xFF] << 8) | sbox[d & 0xFF];
+    };
+    store32(out, last(s0, s1, s2, s3) ^ rk[0]);
+    store32(out + 4, last(s1, s2, s3, s0) ^ rk[1]);
+    store32(out + 8, last(s2, s3, s0, s1) ^ rk[2]);
+    store32(out + 12, last(s3, s0, s1, s2) ^ rk[3]);
+}
+
+void KNXAes128::cbcMac(uint8_t state[16], const uint8_t* data, size_t blocks) const {
+    for (size_t b = 0; b < blocks; b++, data += BLOCK) {
+        for (size_t i = 0; i < BLOCK; i++) state[i] ^= data[i];
+        encryptBlock(state, state);
+    }
+}
+
+void KNXAes128::ctr(uint8_t counter[16], const uint8_t* in, uint8_t* out, size_t length) const {
+    uint8_t stream[BLOCK];
+    while (length > 0) {
+        encryptBlock(counter, stream);
+        incrementCounter(counter);
+        size_t n = length < BLOCK ? length : BLOCK;
+        for (size_t i = 0; i < n; i++) out[i] = in[i] ^ stream[i];
+        in += n;
+        out += n;
+        length -= n;
+    }
+}
+
+#endif
+
+namespace {
+
+const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+void sha256Compress(uint32_t state[8], const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) w[i] = load32(block + 4 * i);
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + SHA256_K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+} // namespace
+
+void KNXSha256::reset() {
+    static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(state, initial, sizeof(state));
+    length = 0;
+}
+
+void KNXSha256::update(const uint8_t* data, size_t size) {
+    size_t used = length % 64;
+    length += size;
+    if (used > 0) {
+        size_t n = 64 - used < size ? 64 - used : size;
+        memcpy(buffer + used, data, n);
+        data += n;
+        size -= n;
+        if (used + n < 64) return;
+        sha256Compress(state, buffer);
+    }
+    for (; size >= 64; data += 64, size -= 64) sha256Compress(state, data);
+    memcpy(buffer, data, size);
+}
+
+void KNXSha256::finish(uint8_t digest[32]) {
+    uint64_t bits = length * 8;
+    size_t used = length % 64;
+    buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(buffer + used, 0, 64 - used);
+        sha256Compress(state, buffer);
+        used = 0;
+    }
+    memset(buffer + used, 0, 56 - used);
+    for (int i = 0; i < 8; i++) buffer[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha256Compress(state, buffer);
+    for (int i = 0; i < 8; i++) store32(digest + 4 * i, state[i]);
+}
+
+KNXHmacSha256::KNXHmacSha256(const uint8_t* key, size_t keyLength) {
+    uint8_t block[64] = {0};
+    if (keyLength > sizeof(block)) {
+        KNXSha256 hash;
+        hash.update(key, keyLength);
+        hash.finish(block);
+    } else {
+        memcpy(block, key, keyLength);
+    }
+    for (size_t i = 0; i < sizeof(block); i++) block[i] ^= 0x36;
+    inner.update(block, sizeof(block));
+    for (size_t i = 0; i < sizeof(block); i++) block[i] ^= 0x36 ^ 0x5C;
+    outer.update(block, sizeof(block));
+}
+
+void KNXHmacSha256::compute(const uint8_t* message, size_t length, uint8_t mac[32]) const {
+    compute(message, length, nullptr, 0, mac);
+}
+
+void KNXHmacSha256::compute(const uint8_t* first, size_t firstLength, const uint8_t* second,
+                            size_t secondLength, uint8_t mac[32]) const {
+    KNXSha256 hash = inner;
+    hash.update(first, firstLength);
+    if (secondLength > 0) hash.update(second, secondLength);
+    hash.finish(mac);
+    hash = outer;
+    hash.update(mac, 32);
+    hash.finish(mac);
+}
+
+void knxPbkdf2Sha256(const uint8_t* password, size_t passwordLength, const uint8_t* salt,
+                     size_t saltLength, uint32_t iterations, uint8_t* out, size_t outLength) {
+    KNXHmacSha256 hmac(password, passwordLength);
+    for (uint32_t blockIndex = 1; outLength > 0; blockIndex++) {
+        uint8_t index[4];
+        store32(index, blockIndex);
+        uint8_t u[32];
+        uint8_t block[32];
+        hmac.compute(salt, saltLength, index, sizeof(index), u);
+        memcpy(block, u, sizeof(block));
+        for (uint32_t i = 1; i < iterations; i++) {
+            hmac.compute(u, sizeof(u), u);
+            for (size_t j = 0; j < sizeof(block); j++) block[j] ^= u[j];
+        }
+        size_t n = outLength < sizeof(block) ? outLength : sizeof(block);
+        memcpy(out, block, n);
+        out += n;
+        outLength -= n;
+    }
+}
+
+// X25519: field elements mod 2^255 - 19 in sixteen 16-bit limbs held in 64-bit
+// words, so products need no carries until the reduction
+
+namespace {
+
+typedef int64_t Field[16];
+
+void carry(Field o) {
+    for (int i = 0; i < 16; i++) {
+        o[i] += (int64_t)1 << 16;
+        int64_t c = o[i] >> 16;
+        if (i < 15) {
+            o[i + 1] += c - 1;
+        } else {
+            o[0] += 38 * (c - 1); // 2^256 = 38 mod p
+        }
+        o[i] -= c * 65536;
+    }
+}
+
+// Swaps p and q if bit is 1, without branching on it
+void conditionalSwap(Field p, Field q, int bit) {
+    int64_t mask = ~((int64_t)bit - 1);
+    for (int i = 0; i < 16; i++) {
+        int64_t t = mask & (p[i] ^ q[i]);
+        p[i] ^= t;
+        q[i] ^= t;
+    }
+}
+
+void pack(uint8_t out[32], const Field n) {
+    Field t, m;
+    for (int i = 0; i < 16; i++) t[i] = n[i];
+    carry(t);
+    carry(t);
+    carry(t);
+    for (int pass = 0; pass < 2; pass++) {
+        // Subtract p and keep the result unless it went negative
+        m[0] = t[0] - 0xFFED;
+        for (int i = 1; i < 15; i++) {
+            m[i] = t[i] - 0xFFFF - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xFFFF;
+        }
+        m[15] = t[15] - 0x7FFF - ((m[14] >> 16) & 1);
+        int borrow = (m[15] >> 16) & 1;
+        m[14] &= 0xFFFF;
+        conditionalSwap(t, m, 1 - borrow);
+    }
+    for (int i = 0; i < 16; i++) {
+        out[2 * i] = t[i] & 0xFF;
+        out[2 * i + 1] = (t[i] >> 8) & 0xFF;
+    }
+}
+
+void unpack(Field o, const uint8_t in[32]) {
+    for (int i = 0; i < 16; i++) o[i] = in[2 * i] + ((int64_t)in[2 * i + 1] << 8);
+    o[15] &= 0x7FFF;
+}
+
+void add(Field o, const Field a, const Field b) {
+    for (int i = 0; i < 16; i++) o[i] = a[i] + b[i];
+}
+
+void subtract(Field o, const Field a, const Field b) {
+    for (int i = 0; i < 16; i++) o[i] = a[i] - b[i];
+}
+
+void multiply(Field o, const Field a, const Field b) {
+    int64_t t[31] = {0};
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) t[i + j] += a[i] * b[j];
+    }
+    for (int i = 0; i < 15; i++) t[i] += 38 * t[i + 16];
+    for (int i = 0; i < 16; i++) o[i] = t[i];
+    carry(o);
+    carry(o);
+}
+
+void square(Field o, const Field a) {
+    multiply(o, a, a);
+}
+
+// a^(p-2)
+void invert(Field o, const Field in) {
+    Field c;
+    for (int i = 0; i < 16; i++) c[i] = in[i];
+    for (int a = 253; a >= 0; a--) {
+        square(c, c);
+        if (a != 2 && a != 4) multiply(c, c, in);
+    }
+    for (int i = 0; i < 16; i++) o[i] = c[i];
+}
+
+} // namespace
+
+void knxX25519(uint8_t out[32], const uint8_t scalar[32], const uint8_t point[32]) {
+    static const Field a24 = {0xDB41, 1}; // (486662 - 2) / 4
+    uint8_t z[32];
+    memcpy(z, scalar, 32);
+    z[31] = (z[31] & 127) | 64;
+    z[0] &= 248;
+
+    // Montgomery ladder over (x2 : z2) = a : c and (x3 : z3) = b : d
+    Field x, a = {0}, b, c = {0}, d = {0}, e, f;
+    unpack(x, point);
+    for (int i = 0; i < 16; i++) b[i] = x[i];
+    a[0] = d[0] = 1;
+    for (int i = 254; i >= 0; i--) {
+        int bit = (z[i >> 3] >> (i & 7)) & 1;
+        conditionalSwap(a, b, bit);
+        conditionalSwap(c, d, bit);
+        add(e, a, c);
+        subtract(a, a, c);
+        add(c, b, d);
+        subtract(b, b, d);
+        square(d, e);
+        square(f, a);
+        multiply(a, c, a);
+        multiply(c, b, e);
+        add(e, a, c);
+        subtract(a, a, c);
+        square(b, a);
+        subtract(c, d, f);
+        multiply(a, c, a24);
+        add(a, a, d);
+        multiply(c, c, a);
+        multiply(a, d, f);
+        multiply(d, b, x);
+        square(b, e);
+        conditionalSwap(a, b, bit);
+        conditionalSwap(c, d, bit);
+    }
+    invert(c, c);
+    multiply(a, a, c);
+    pack(out, a);
+    memset(z, 0, sizeof(z));
+}
+
+void knxX25519Base(uint8_t out[32], const uint8_t scalar[32]) {
+    static const uint8_t basePoint[32] = {9};
+    knxX25519(out, scalar, basePoint);
+}
+
+void knxRandomBytes(uint8_t* out, size_t length) {
+#if defined(ESP32)
+    esp_fill_random(out, length);
+#else
+    static std::random_device device;
+    for (size_t i = 0; i < length; i++) out[i] = (uint8_t)device();
+#endif
+}
+
+bool knxEqualConstantTime(const uint8_t* a, const uint8_t* b, size_t length) {
+    uint8_t difference = 0;
+    for (size_t i = 0; i < length; i++) difference |= a[i] ^ b[i];
+    return difference == 0;
+}
@@ -0,0 +1,114 @@
+//==== src/knx_dedup.cpp ====
+
+#include "knx_dedup.h"
+#include "knx_protocol.h"
+#include "knx_memory.h"
+
+KNXDedupFilter::KNXDedupFilter() : slots(nullptr), shift(32), counters() {}
+
+KNXDedupFilter::~KNXDedupFilter() {
+    end();
+}
+
+bool KNXDedupFilter::begin(const KNXDedupConfig& config) {
+    end();
+
+    uint32_t buckets = 2;
+    uint8_t bits = 1;
+    while (buckets * WAYS < config.capacity && bits < 16) {
+        buckets <<= 1;
+        bits++;
+    }
+
+    Slot* created = knxNewArray<Slot>(buckets * WAYS);
+    if (!created) return false;
+    memset(created, 0, sizeof(Slot) * buckets * WAYS);
+
+    Slot* previous;
+    {
+        KNXLockGuard guard(lock);
+        this->config = config;
+        previous = slots;
+        slots = created;
+        shift = 32 - bits;
+
+        counters = KNXDedupStats();
+        counters.capacity = buckets * WAYS;
+    }
+    knxDeleteArray(previous);
+    return true;
+}
+
+void KNXDedupFilter::end() {
+    Slot* previous;
+    {
+        KNXLockGuard guard(lock);
+        previous = slots;
+        slots = nullptr;
+    }
+    knxDeleteArray(previous);
+}
+
+uint32_t KNXDedupFilter::fingerprintOf(const uint8_t* frame, size_t length) {
+    // FNV-1a over source, destination, address type and TPCI/APCI/payload.
+    // Control field 1 (repeat flag, priority) and the hop count are skipped:
+    // they differ between a frame and its repeats.
+    uint32_t hash = 2166136261U;
+    auto mix = [&hash](uint8_t byte) {
+        hash = (hash ^ byte) * 16777619U;
+    };
+    for (size_t i = 2; i < 6; i++) mix(frame[i]);
+    mix(frame[1] & 0x80);
+    for (size_t i = 6; i < length; i++) mix(frame[i]);
+    return hash ? hash : 1;
+}
+
+bool KNXDedupFilter::isDuplicate(const uint8_t* data, size_t length, uint16_t ownAddress,
+                                 uint32_t nowMs) {
+    // Malformed frames are left to the parser
+    KNXCemiFrame cemi;
+    if (!knxParseCemi(data, length, cemi)) return false;
+    // Control fields through the APDU, without the additional info
+    const uint8_t* frame = cemi.tpdu - 7;
+    size_t frameLength = 8 + cemi.apduLength;
+
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    counters.checked++;
+
+    uint16_t sourceAddress = (frame[2] << 8) | frame[3];
+    if (config.dropOwnFrames && sourceAddress == ownAddress) {
+        counters.ownFrames++;
+        return true;
+    }
+
+    uint32_t fingerprint = fingerprintOf(frame, frameLength);
+    Slot* bucket = slots + ((uint32_t)(fingerprint * 2654435769U) >> shift) * WAYS;
+    Slot* victim = bucket;
+    uint32_t victimAge = 0;
+    for (uint8_t i = 0; i < WAYS; i++) {
+        Slot& slot = bucket[i];
+        uint32_t age = nowMs - slot.timestamp;
+        bool live = slot.fingerprint != 0 && age < config.windowMs;
+        if (live && slot.fingerprint == fingerprint) {
+            counters.duplicates++;
+            return true;
+        }
+        // Prefer a free or expired slot, then the oldest
+        uint32_t rank = live ? age : UINT32_MAX;
+        if (i == 0 || rank > victimAge) {
+            victim = &slot;
+            victimAge = rank;
+        }
+    }
+
+    if (victimAge != UINT32_MAX) counters.evictions++;
+    victim->fingerprint = fingerprint;
+    victim->timestamp = nowMs;
+    return false;
+}
+
+KNXDedupStats KNXDedupFilter::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
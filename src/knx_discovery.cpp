@@ -0,0 +1,260 @@
+//==== src/knx_discovery.cpp ====
+
+#include "knx_discovery.h"
+
+namespace {
+
+// Tunnelling slot status flags (tunnelling info DIB)
+const uint8_t SLOT_FREE = 0x01;
+const uint8_t SLOT_USABLE = 0x04;
+
+size_t buildRequest(uint8_t* buffer, uint16_t serviceType, const IPAddress& ip, uint16_t port) {
+    size_t length = KNXNETIP_HEADER_LENGTH;
+    length += knxWriteHpai(buffer + length, ip, port);
+    knxWriteHeader(buffer, serviceType, length);
+    return length;
+}
+
+} // namespace
+
+KNXGatewayDiscovery::KNXGatewayDiscovery()
+    : udp(nullptr), localPort(KNX_PORT), phase(IDLE), phaseSince(0), probesSent(0),
+      lastProbe(0), count(0) {}
+
+void KNXGatewayDiscovery::begin(AsyncUDP* udp, const IPAddress& localIP, uint16_t localPort,
+                                const KNXDiscoveryConfig& config) {
+    KNXLockGuard guard(lock);
+    this->udp = udp;
+    this->localIP = localIP;
+    this->localPort = localPort;
+    this->config = config;
+    phase = IDLE;
+}
+
+void KNXGatewayDiscovery::end() {
+    KNXLockGuard guard(lock);
+    udp = nullptr;
+    phase = IDLE;
+    count = 0;
+}
+
+int KNXGatewayDiscovery::findOrAdd(const IPAddress& ip, uint16_t port) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].ip == ip) {
+            table[i].port = port;
+            return i;
+        }
+    }
+    if (count == KNX_DISCOVERY_GATEWAYS) return -1;
+    KNXGatewayInfo& gateway = table[count];
+    gateway = KNXGatewayInfo();
+    gateway.ip = ip;
+    gateway.port = port;
+    gateway.freeSlots = -1;
+    probeSentAt[count] = 0;
+    probePending[count] = false;
+    return count++;
+}
+
+bool KNXGatewayDiscovery::addGateway(const IPAddress& ip, uint16_t port) {
+    KNXLockGuard guard(lock);
+    int index = findOrAdd(ip, port);
+    if (index < 0) return false;
+    // Trusted until a description says otherwise
+    table[index].tunnelling = true;
+    return true;
+}
+
+void KNXGatewayDiscovery::search(uint32_t nowMs) {
+    {
+        KNXLockGuard guard(lock);
+        if (!udp) return;
+        phase = SEARCHING;
+        phaseSince = nowMs;
+        probesSent = 0;
+    }
+    uint8_t request[14];
+    size_t length = buildRequest(request, KNXNETIP_SEARCH_REQUEST, localIP, localPort);
+    udp->writeTo(request, length, KNX_MULTICAST_IP, KNX_PORT);
+}
+
+void KNXGatewayDiscovery::poll(uint32_t nowMs) {
+    bool probe = false;
+    {
+        KNXLockGuard guard(lock);
+        if (phase == SEARCHING && nowMs - phaseSince >= config.searchTimeoutMs) {
+            phase = count > 0 && config.probes > 0 ? PROBING : IDLE;
+            probesSent = 0;
+            lastProbe = nowMs - config.probeIntervalMs;
+            for (uint8_t i = 0; i < count; i++) probePending[i] = false;
+        }
+        if (phase == PROBING) {
+            if (probesSent < config.probes && nowMs - lastProbe >= config.probeIntervalMs) {
+                probesSent++;
+                lastProbe = nowMs;
+                probe = true;
+            } else if (probesSent == config.probes && nowMs - lastProbe >= config.probeTimeoutMs) {
+                phase = IDLE;
+            }
+        }
+    }
+    if (probe) {
+        sendProbes();
+    }
+}
+
+void KNXGatewayDiscovery::sendProbes() {
+    IPAddress targets[KNX_DISCOVERY_GATEWAYS];
+    uint16_t ports[KNX_DISCOVERY_GATEWAYS];
+    uint8_t targetCount = 0;
+    {
+        KNXLockGuard guard(lock);
+        uint32_t now = micros();
+        for (uint8_t i = 0; i < count; i++) {
+            // A gateway still working on the previous probe is skipped: its
+            // reply would be timed from this one
+            if (probePending[i] && now - probeSentAt[i] < config.probeTimeoutMs * 1000UL) continue;
+            probeSentAt[i] = now;
+            probePending[i] = true;
+            targets[targetCount] = table[i].ip;
+            ports[targetCount] = table[i].port;
+            targetCount++;
+        }
+    }
+
+    uint8_t request[14];
+    size_t length = buildRequest(request, KNXNETIP_DESCRIPTION_REQUEST, localIP, localPort);
+    for (uint8_t i = 0; i < targetCount; i++) {
+        udp->writeTo(request, length, targets[i], ports[i]);
+    }
+}
+
+bool KNXGatewayDiscovery::idle() {
+    KNXLockGuard guard(lock);
+    return phase == IDLE;
+}
+
+bool KNXGatewayDiscovery::handlePacket(uint16_t serviceType, const uint8_t* data, size_t length,
+                                       const IPAddress& remoteIP) {
+    if (serviceType == KNXNETIP_SEARCH_RESPONSE) {
+        IPAddress ip;
+        uint16_t port;
+        if (length < 14 || !knxReadHpai(data + 6, length - 6, ip, port)) return false;
+        // 0.0.0.0 means "the sender" (NAT)
+        if (ip == IPAddress()) ip = remoteIP;
+        if (port == 0) port = KNX_PORT;
+
+        KNXLockGuard guard(lock);
+        int index = findOrAdd(ip, port);
+        if (index < 0) return true;
+        parseDibs(table[index], data + 14, length - 14);
+        return true;
+    }
+
+    if (serviceType == KNXNETIP_DESCRIPTION_RESPONSE) {
+        uint32_t now = micros();
+        KNXLockGuard guard(lock);
+        for (uint8_t i = 0; i < count; i++) {
+            KNXGatewayInfo& gateway = table[i];
+            if (gateway.ip != remoteIP) continue;
+            // A reply to a probe given up on has no send time to go by
+            if (probePending[i]) {
+                probePending[i] = false;
+                uint32_t rtt = now - probeSentAt[i];
+                if (rtt == 0) rtt = 1;
+                if (gateway.rttMicros == 0 || rtt < gateway.rttMicros) gateway.rttMicros = rtt;
+                if (gateway.probeReplies < 255) gateway.probeReplies++;
+            }
+            gateway.tunnelling = false; // Reported again by the service families DIB
+            parseDibs(gateway, data + 6, length - 6);
+            return true;
+        }
+    }
+    return false;
+}
+
+void KNXGatewayDiscovery::parseDibs(KNXGatewayInfo& gateway, const uint8_t* data, size_t length) {
+    size_t offset = 0;
+    while (offset + 2 <= length) {
+        size_t dibLength = data[offset];
+        if (dibLength < 2 || offset + dibLength > length) break;
+        const uint8_t* dib = data + offset;
+
+        switch (dib[1]) {
+        case KNXNETIP_DIB_DEVICE_INFO:
+            // Medium, status, individual address, project, serial number,
+            // multicast address, MAC address, 30-byte friendly name
+            if (dibLength >= 54) {
+                gateway.individualAddress = (dib[4] << 8) | dib[5];
+                memcpy(gateway.name, dib + 24, 30);
+                gateway.name[30] = '\0';
+            }
+            break;
+
+        case KNXNETIP_DIB_SUPP_SVC_FAMILIES:
+            for (size_t i = 2; i + 1 < dibLength; i += 2) {
+                if (dib[i] == KNXNETIP_FAMILY_TUNNELING) gateway.tunnelling = true;
+            }
+            break;
+
+        case KNXNETIP_DIB_TUNNELING_INFO: {
+            // Maximum APDU length, then individual address and status per slot
+            int freeSlots = 0;
+            for (size_t i = 4; i + 3 < dibLength; i += 4) {
+                uint8_t status = dib[i + 3];
+                if ((status & (SLOT_FREE | SLOT_USABLE)) == (SLOT_FREE | SLOT_USABLE)) freeSlots++;
+            }
+            gateway.freeSlots = (int8_t)(freeSlots < 127 ? freeSlots : 127);
+            break;
+        }
+
+        default:
+            break;
+        }
+        offset += dibLength;
+    }
+}
+
+bool KNXGatewayDiscovery::ranksBefore(const KNXGatewayInfo& a, const KNXGatewayInfo& b,
+                                      uint32_t nowMs) const {
+    bool aFailed = a.failures > 0 && nowMs - a.failedAt < config.failureHoldoffMs;
+    bool bFailed = b.failures > 0 && nowMs - b.failedAt < config.failureHoldoffMs;
+    if (aFailed != bFailed) return !aFailed;
+    if (aFailed) return (int32_t)(a.failedAt - b.failedAt) < 0; // Longest ago first
+
+    bool aFull = a.freeSlots == 0;
+    bool bFull = b.freeSlots == 0;
+    if (aFull != bFull) return !aFull;
+
+    if ((a.probeReplies > 0) != (b.probeReplies > 0)) return a.probeReplies > 0;
+    return a.probeReplies > 0 && a.rttMicros < b.rttMicros;
+}
+
+bool KNXGatewayDiscovery::best(KNXGatewayInfo& gateway, uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    int chosen = -1;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!table[i].tunnelling) continue;
+        if (chosen < 0 || ranksBefore(table[i], table[chosen], nowMs)) chosen = i;
+    }
+    if (chosen < 0) return false;
+    gateway = table[chosen];
+    return true;
+}
+
+void KNXGatewayDiscovery::markFailed(const IPAddress& ip, uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].ip == ip) {
+            table[i].failures++;
+            table[i].failedAt = nowMs;
+        }
+    }
+}
+
+size_t KNXGatewayDiscovery::gateways(KNXGatewayInfo* out, size_t maxGateways) {
+    KNXLockGuard guard(lock);
+    size_t n = count < maxGateways ? count : maxGateways;
+    for (size_t i = 0; i < n; i++) out[i] = table[i];
+    return n;
+}
@@ -0,0 +1,219 @@
+//==== src/knx_group_cache.cpp ====
+
+#include "knx_group_cache.h"
+#include "knx_memory.h"
+
+KNXGroupCache::KNXGroupCache() : slots(nullptr), mask(0), shift(32), counters() {}
+
+KNXGroupCache::~KNXGroupCache() {
+    end();
+}
+
+bool KNXGroupCache::begin(const KNXGroupCacheConfig& config) {
+    end();
+
+    size_t capacity = config.capacity;
+    if (capacity == 0) capacity = 1;
+    if (capacity > 49152) capacity = 49152; // 3/4 of the address space
+    size_t ownedCapacity = config.ownedCapacity;
+    if (ownedCapacity > 49152 - capacity) ownedCapacity = 49152 - capacity;
+
+    // Keep the load factor at or below 3/4 so probe sequences stay short
+    uint32_t size = 2;
+    uint8_t bits = 1;
+    while (size * 3 < (capacity + ownedCapacity) * 4) {
+        size <<= 1;
+        bits++;
+    }
+
+    Slot* created = knxNewArray<Slot>(size);
+    if (!created) return false;
+    memset(created, 0, sizeof(Slot) * size);
+
+    Slot* previous;
+    {
+        KNXLockGuard guard(lock);
+        this->config = config;
+        this->config.capacity = capacity;
+        this->config.ownedCapacity = ownedCapacity;
+        previous = slots;
+        slots = created;
+        mask = size - 1;
+        shift = 32 - bits;
+
+        counters = KNXGroupCacheStats();
+        counters.capacity = capacity;
+    }
+    knxDeleteArray(previous);
+    return true;
+}
+
+void KNXGroupCache::end() {
+    Slot* previous;
+    {
+        KNXLockGuard guard(lock);
+        previous = slots;
+        slots = nullptr;
+        mask = 0;
+    }
+    knxDeleteArray(previous);
+}
+
+KNXGroupCache::Slot* KNXGroupCache::find(uint16_t groupAddress) {
+    uint32_t index = indexOf(groupAddress);
+    for (;;) {
+        Slot& slot = slots[index];
+        if (!slot.used) return nullptr;
+        if (slot.value.groupAddress == groupAddress) return &slot;
+        index = (index + 1) & mask;
+    }
+}
+
+KNXGroupCache::Slot* KNXGroupCache::findOrInsert(uint16_t groupAddress, bool owned) {
+    uint32_t index = indexOf(groupAddress);
+    for (;;) {
+        Slot& slot = slots[index];
+        if (slot.used) {
+            if (slot.value.groupAddress == groupAddress) return &slot;
+            index = (index + 1) & mask;
+            continue;
+        }
+        if (counters.entries >= config.capacity + config.ownedCapacity) return nullptr;
+        if (!owned && counters.entries - counters.owned >= config.capacity) return nullptr;
+        slot.used = true;
+        slot.owned = false;
+        slot.changed = false;
+        slot.value.groupAddress = groupAddress;
+        counters.entries++;
+        return &slot;
+    }
+}
+
+void KNXGroupCache::update(uint16_t groupAddress, uint16_t sourceAddress, const uint8_t* data,
+                           size_t length, uint32_t timestamp) {
+    if (length > KNX_TELEGRAM_MAX_DATA) length = KNX_TELEGRAM_MAX_DATA;
+    KNXLockGuard guard(lock);
+    if (!slots) return;
+
+    Slot* slot = findOrInsert(groupAddress, false);
+    if (!slot) {
+        counters.rejected++;
+        return;
+    }
+    KNXCachedValue& value = slot->value;
+    if (value.length != length || memcmp(value.data, data, length) != 0) {
+        slot->changed = true;
+    }
+    value.sourceAddress = sourceAddress;
+    value.timestamp = timestamp;
+    value.count++;
+    value.length = (uint8_t)length;
+    memcpy(value.data, data, length);
+    counters.updates++;
+}
+
+bool KNXGroupCache::lookup(uint16_t groupAddress, KNXCachedValue& value) {
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    Slot* slot = find(groupAddress);
+    if (!slot || slot->value.length == 0) {
+        counters.misses++;
+        return false;
+    }
+    value = slot->value;
+    counters.hits++;
+    return true;
+}
+
+bool KNXGroupCache::setOwned(uint16_t groupAddress, bool owned) {
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    Slot* slot = owned ? findOrInsert(groupAddress, true) : find(groupAddress);
+    if (!slot) return !owned;
+    if (slot->owned != owned) {
+        slot->owned = owned;
+        if (owned) {
+            counters.owned++;
+        } else {
+            counters.owned--;
+        }
+    }
+    return true;
+}
+
+bool KNXGroupCache::lookupOwned(uint16_t groupAddress, KNXCachedValue& value) {
+    KNXLockGuard guard(lock);
+    if (!slots || !config.answerReads) return false;
+    Slot* slot = find(groupAddress);
+    if (!slot || !slot->owned || slot->value.length == 0) return false;
+    value = slot->value;
+    counters.readsAnswered++;
+    return true;
+}
+
+bool KNXGroupCache::isOwned(uint16_t groupAddress) {
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    Slot* slot = find(groupAddress);
+    return slot && slot->owned;
+}
+
+bool KNXGroupCache::restore(uint16_t groupAddress, const uint8_t* data, size_t length,
+                            uint32_t timestamp) {
+    if (length == 0) return false;
+    if (length > KNX_TELEGRAM_MAX_DATA) length = KNX_TELEGRAM_MAX_DATA;
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+
+    Slot* slot = findOrInsert(groupAddress, false);
+    if (!slot) {
+        counters.rejected++;
+        return false;
+    }
+    if (slot->value.count != 0) return false; // Seen on the bus meanwhile
+    slot->value.sourceAddress = 0;
+    slot->value.timestamp = timestamp;
+    slot->value.count = 0;
+    slot->value.length = (uint8_t)length;
+    memcpy(slot->value.data, data, length);
+    return true;
+}
+
+bool KNXGroupCache::nextValue(uint32_t& cursor, KNXCachedValue& value, bool changedOnly) {
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    for (; cursor <= mask; cursor++) {
+        Slot& slot = slots[cursor];
+        if (!slot.used || slot.value.length == 0 || (changedOnly && !slot.changed)) continue;
+        slot.changed = false;
+        value = slot.value;
+        cursor++;
+        return true;
+    }
+    return false;
+}
+
+bool KNXGroupCache::nextRestored(uint32_t& cursor, KNXCachedValue& value) {
+    KNXLockGuard guard(lock);
+    if (!slots) return false;
+    for (; cursor <= mask; cursor++) {
+        Slot& slot = slots[cursor];
+        if (!slot.used || slot.value.length == 0 || slot.value.count != 0) continue;
+        value = slot.value;
+        cursor++;
+        return true;
+    }
+    return false;
+}
+
+void KNXGroupCache::markChanged(uint16_t groupAddress) {
+    KNXLockGuard guard(lock);
+    if (!slots) return;
+    Slot* slot = find(groupAddress);
+    if (slot) slot->changed = true;
+}
+
+KNXGroupCacheStats KNXGroupCache::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
@@ -0,0 +1,56 @@
+//==== src/knx_group_filter.cpp ====
+
+#include "knx_group_filter.h"
+
+namespace {
+
+uint16_t mainGroupFirst(uint8_t mainGroup) {
+    return (uint16_t)((mainGroup & 0x1F) << 11);
+}
+
+uint16_t middleGroupFirst(uint8_t mainGroup, uint8_t middleGroup) {
+    return (uint16_t)(mainGroupFirst(mainGroup) | ((middleGroup & 0x07) << 8));
+}
+
+} // namespace
+
+KNXGroupFilter& KNXGroupFilter::addRule(uint16_t first, uint16_t last, bool pass) {
+    if (first > last) return *this;
+    if (knxIsFull(rules)) {
+        overflow = true;
+    } else {
+        rules.push_back(Rule{first, last, pass});
+    }
+    return *this;
+}
+
+KNXGroupFilter& KNXGroupFilter::passMainGroup(uint8_t mainGroup) {
+    uint16_t first = mainGroupFirst(mainGroup);
+    return addRule(first, first | 0x07FF, true);
+}
+
+KNXGroupFilter& KNXGroupFilter::passMiddleGroup(uint8_t mainGroup, uint8_t middleGroup) {
+    uint16_t first = middleGroupFirst(mainGroup, middleGroup);
+    return addRule(first, first | 0x00FF, true);
+}
+
+KNXGroupFilter& KNXGroupFilter::blockMainGroup(uint8_t mainGroup) {
+    uint16_t first = mainGroupFirst(mainGroup);
+    return addRule(first, first | 0x07FF, false);
+}
+
+KNXGroupFilter& KNXGroupFilter::blockMiddleGroup(uint8_t mainGroup, uint8_t middleGroup) {
+    uint16_t first = middleGroupFirst(mainGroup, middleGroup);
+    return addRule(first, first | 0x00FF, false);
+}
+
+void KNXGroupFilter::compile(KNXGroupAddressBitmap& bitmap) const {
+    bitmap.clear();
+    for (const Rule& rule : rules) {
+        if (rule.pass) {
+            bitmap.setRange(rule.first, rule.last);
+        } else {
+            bitmap.resetRange(rule.first, rule.last);
+        }
+    }
+}
@@ -0,0 +1,346 @@
+//==== src/knx_group_read.cpp ====
+
+#include "knx_group_read.h"
+#include "knx_memory.h"
+
+KNXGroupReader::KNXGroupReader()
+    : entries(nullptr), outstanding(nullptr), outstandingCount(0),
+      queueHead(NONE), queueTail(NONE), freeHead(NONE), freeTail(NONE), counters() {}
+
+KNXGroupReader::~KNXGroupReader() {
+    end();
+}
+
+bool KNXGroupReader::begin(const KNXGroupReadConfig& config) {
+    end();
+
+    KNXGroupReadConfig settings = config;
+    if (settings.capacity == 0) settings.capacity = 1;
+    if (settings.capacity > NONE) settings.capacity = NONE; // Indices are 16-bit
+    if (settings.window == 0) settings.window = 1;
+    if (settings.timeoutMs == 0) settings.timeoutMs = 1;
+
+    Entry* createdEntries = knxNewArray<Entry>(settings.capacity);
+    uint16_t* createdOutstanding = knxNewArray<uint16_t>(settings.window);
+    if (!createdEntries || !createdOutstanding) {
+        knxDeleteArray(createdEntries);
+        knxDeleteArray(createdOutstanding);
+        return false;
+    }
+    for (size_t i = 0; i < settings.capacity; i++) {
+        createdEntries[i].status = FREE;
+        createdEntries[i].generation = 0;
+        createdEntries[i].next = (i + 1 < settings.capacity) ? (uint16_t)(i + 1) : NONE;
+    }
+
+    Entry* previousEntries;
+    uint16_t* previousOutstanding;
+    {
+        KNXLockGuard guard(lock);
+        this->config = settings;
+        previousEntries = entries;
+        previousOutstanding = outstanding;
+        entries = createdEntries;
+        outstanding = createdOutstanding;
+        freeHead = 0;
+        freeTail = (uint16_t)(settings.capacity - 1);
+        queueHead = queueTail = NONE;
+        outstandingCount = 0;
+
+        counters = KNXGroupReadStats();
+        counters.capacity = settings.capacity;
+    }
+    knxDeleteArray(previousEntries);
+    knxDeleteArray(previousOutstanding);
+    return true;
+}
+
+void KNXGroupReader::end() {
+    Entry* previousEntries;
+    uint16_t* previousOutstanding;
+    {
+        KNXLockGuard guard(lock);
+        previousEntries = entries;
+        previousOutstanding = outstanding;
+        entries = nullptr;
+        outstanding = nullptr;
+        outstandingCount = 0;
+        queueHead = queueTail = NONE;
+        freeHead = freeTail = NONE;
+    }
+    knxDeleteArray(previousEntries);
+    knxDeleteArray(previousOutstanding);
+}
+
+KNXReadHandle KNXGroupReader::request(uint16_t groupAddress, uint16_t timeoutMs,
+                                      const KNXReadCallback& callback) {
+    // Copied here and swapped in below: nothing allocates or frees under the lock
+    KNXReadCallback stored = callback;
+    KNXLockGuard guard(lock);
+    if (!entries) return 0;
+    if (freeHead == NONE) {
+        counters.rejected++;
+        return 0;
+    }
+
+    uint16_t index = freeHead;
+    Entry& entry = entries[index];
+    freeHead = entry.next;
+    if (freeHead == NONE) freeTail = NONE;
+
+    if (++entry.generation == 0) entry.generation = 1;
+    entry.groupAddress = groupAddress;
+    entry.timeoutMs = timeoutMs != 0 ? timeoutMs : config.timeoutMs;
+    entry.status = KNX_READ_QUEUED;
+    entry.attempts = 0;
+    entry.callback.swap(stored);
+
+    entry.next = NONE;
+    if (queueTail == NONE) {
+        queueHead = index;
+    } else {
+        entries[queueTail].next = index;
+    }
+    queueTail = index;
+
+    counters.requested++;
+    counters.queued++;
+    return ((KNXReadHandle)entry.generation << 16) | index;
+}
+
+KNXGroupReader::Entry* KNXGroupReader::lookup(KNXReadHandle handle, uint16_t& index) {
+    index = handle & 0xFFFF;
+    if (!entries || index >= config.capacity) return nullptr;
+    Entry& entry = entries[index];
+    if (entry.status == FREE || entry.generation != (handle >> 16)) return nullptr;
+    return &entry;
+}
+
+bool KNXGroupReader::result(KNXReadHandle handle, KNXReadResult& result) {
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = lookup(handle, index);
+    if (!entry) return false;
+    if (entry->status == KNX_READ_QUEUED || entry->status == KNX_READ_OUTSTANDING) {
+        // Still running: only the request is known
+        result = KNXReadResult();
+        result.groupAddress = entry->groupAddress;
+        result.attempts = entry->attempts;
+        result.status = (KNXReadStatus)entry->status;
+        return true;
+    }
+    result = entry->result;
+    return true;
+}
+
+bool KNXGroupReader::cancel(KNXReadHandle handle) {
+    KNXReadCallback dropped;
+    KNXReadResult ignored;
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = lookup(handle, index);
+    if (!entry) return false;
+
+    if (entry->status == KNX_READ_QUEUED) {
+        unlinkQueued(index);
+    } else if (entry->status == KNX_READ_OUTSTANDING) {
+        for (uint8_t i = 0; i < outstandingCount; i++) {
+            if (outstanding[i] == index) {
+                removeOutstanding(i);
+                break;
+            }
+        }
+    } else {
+        return false;
+    }
+    counters.cancelled++;
+    release(index, KNX_READ_CANCELLED, ignored, dropped);
+    return true;
+}
+
+bool KNXGroupReader::takeDue(uint32_t nowMs, KNXReadHandle& handle, uint16_t& groupAddress) {
+    KNXLockGuard guard(lock);
+    if (!entries) return false;
+
+    // Repeats first: they have waited longest
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        Entry& entry = entries[outstanding[i]];
+        if ((int32_t)(nowMs - entry.deadline) < 0 || entry.attempts > config.retries) continue;
+        entry.attempts++;
+        entry.deadline = nowMs + entry.timeoutMs;
+        counters.sent++;
+        counters.retries++;
+        handle = ((KNXReadHandle)entry.generation << 16) | outstanding[i];
+        groupAddress = entry.groupAddress;
+        return true;
+    }
+
+    if (outstandingCount >= config.window || queueHead == NONE) return false;
+    uint16_t index = queueHead;
+    Entry& entry = entries[index];
+    queueHead = entry.next;
+    if (queueHead == NONE) queueTail = NONE;
+    counters.queued--;
+
+    entry.status = KNX_READ_OUTSTANDING;
+    entry.attempts = 1;
+    entry.firstSent = nowMs;
+    entry.deadline = nowMs + entry.timeoutMs;
+    outstanding[outstandingCount++] = index;
+    counters.sent++;
+    handle = ((KNXReadHandle)entry.generation << 16) | index;
+    groupAddress = entry.groupAddress;
+    return true;
+}
+
+void KNXGroupReader::sendFailed(KNXReadHandle handle) {
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = lookup(handle, index);
+    if (!entry || entry->status != KNX_READ_OUTSTANDING) return;
+    counters.sent--;
+
+    if (entry->attempts > 1) {
+        // A repeat: due again right away
+        entry->attempts--;
+        entry->deadline -= entry->timeoutMs;
+        counters.retries--;
+        return;
+    }
+
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        if (outstanding[i] == index) {
+            removeOutstanding(i);
+            break;
+        }
+    }
+    entry->status = KNX_READ_QUEUED;
+    entry->attempts = 0;
+    entry->next = queueHead;
+    queueHead = index;
+    if (queueTail == NONE) queueTail = index;
+    counters.queued++;
+}
+
+bool KNXGroupReader::takeExpired(uint32_t nowMs, KNXReadResult& result, KNXReadCallback& callback) {
+    KNXLockGuard guard(lock);
+    if (!entries) return false;
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        uint16_t index = outstanding[i];
+        Entry& entry = entries[index];
+        if ((int32_t)(nowMs - entry.deadline) < 0 || entry.attempts <= config.retries) continue;
+        removeOutstanding(i);
+        entry.result.latencyMs = nowMs - entry.firstSent;
+        entry.result.length = 0;
+        entry.result.sourceAddress = 0;
+        counters.timeouts++;
+        release(index, KNX_READ_TIMEOUT, result, callback);
+        return true;
+    }
+    return false;
+}
+
+uint32_t KNXGroupReader::msUntilDue(uint32_t nowMs, bool canSend) {
+    KNXLockGuard guard(lock);
+    if (!entries) return UINT32_MAX;
+    if (canSend && queueHead != NONE && outstandingCount < config.window) return 0;
+    uint32_t wait = UINT32_MAX;
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        int32_t left = (int32_t)(entries[outstanding[i]].deadline - nowMs);
+        if (left <= 0) return 0;
+        if ((uint32_t)left < wait) wait = left;
+    }
+    return wait;
+}
+
+bool KNXGroupReader::awaiting(uint16_t groupAddress) {
+    KNXLockGuard guard(lock);
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        if (entries[outstanding[i]].groupAddress == groupAddress) return true;
+    }
+    return false;
+}
+
+bool KNXGroupReader::complete(uint16_t groupAddress, uint16_t sourceAddress, const uint8_t* data,
+                              size_t length, uint32_t nowMs, KNXReadResult& result,
+                              KNXReadCallback& callback) {
+    KNXLockGuard guard(lock);
+    if (!entries) return false;
+
+    uint16_t index = NONE;
+    for (uint8_t i = 0; i < outstandingCount; i++) {
+        if (entries[outstanding[i]].groupAddress == groupAddress) {
+            index = outstanding[i];
+            removeOutstanding(i);
+            break;
+        }
+    }
+    if (index == NONE) {
+        // A response seen before our read went out answers it as well
+        for (uint16_t i = queueHead; i != NONE; i = entries[i].next) {
+            if (entries[i].groupAddress == groupAddress) {
+                index = i;
+                break;
+            }
+        }
+        if (index == NONE) return false;
+        unlinkQueued(index);
+        entries[index].firstSent = nowMs;
+    }
+
+    Entry& entry = entries[index];
+    if (length > sizeof(entry.result.data)) length = sizeof(entry.result.data);
+    memcpy(entry.result.data, data, length);
+    entry.result.length = (uint8_t)length;
+    entry.result.sourceAddress = sourceAddress;
+    entry.result.latencyMs = nowMs - entry.firstSent;
+    counters.completed++;
+    release(index, KNX_READ_DONE, result, callback);
+    return true;
+}
+
+void KNXGroupReader::release(uint16_t index, KNXReadStatus status, KNXReadResult& result,
+                             KNXReadCallback& callback) {
+    Entry& entry = entries[index];
+    entry.status = (uint8_t)status;
+    entry.result.groupAddress = entry.groupAddress;
+    entry.result.status = status;
+    entry.result.attempts = entry.attempts;
+    result = entry.result;
+    callback.swap(entry.callback);
+
+    // Back of the free list: the result stays readable as long as possible
+    entry.next = NONE;
+    if (freeTail == NONE) {
+        freeHead = index;
+    } else {
+        entries[freeTail].next = index;
+    }
+    freeTail = index;
+}
+
+void KNXGroupReader::removeOutstanding(uint8_t position) {
+    outstanding[position] = outstanding[--outstandingCount];
+}
+
+void KNXGroupReader::unlinkQueued(uint16_t index) {
+    uint16_t previous = NONE;
+    for (uint16_t i = queueHead; i != NONE; previous = i, i = entries[i].next) {
+        if (i != index) continue;
+        if (previous == NONE) {
+            queueHead = entries[i].next;
+        } else {
+            entries[previous].next = entries[i].next;
+        }
+        if (queueTail == index) queueTail = previous;
+        counters.queued--;
+        return;
+    }
+}
+
+KNXGroupReadStats KNXGroupReader::stats() {
+    KNXLockGuard guard(lock);
+    KNXGroupReadStats snapshot = counters;
+    snapshot.outstanding = outstandingCount;
+    return snapshot;
+}
@@ -0,0 +1,125 @@
+//==== src/knx_group_table.cpp ====
+
+#include "knx_group_table.h"
+#include <algorithm>
+
+KNXGroupDispatchTable::KNXGroupDispatchTable() : mainGroups(0) {
+    memset(rank, 0, sizeof(rank));
+    memset(middleGroups, 0, sizeof(middleGroups));
+    slotStart.push_back(0);
+}
+
+bool KNXGroupDispatchTable::add(uint16_t groupAddress, KNXGroupAddressCallback callback) {
+    if (knxIsFull(entries)) return false;
+    // Insert after existing callbacks of the same address to keep registration order
+    auto position = std::upper_bound(entries.begin(), entries.end(), groupAddress,
+        [](uint16_t address, const Entry& entry) { return address < entry.groupAddress; });
+    entries.insert(position, Entry{groupAddress, callback});
+    exact.set(groupAddress);
+    rebuildIndex();
+    return true;
+}
+
+bool KNXGroupDispatchTable::addMainGroup(uint8_t mainGroup, KNXGroupAddressCallback callback) {
+    if (knxIsFull(ranges)) return false;
+    ranges.push_back(RangeEntry{(uint16_t)(RANGE_MAIN_ONLY | ((mainGroup & 0x1F) << 8)), callback});
+    rebuildRangeMasks();
+    return true;
+}
+
+bool KNXGroupDispatchTable::addMiddleGroup(uint8_t mainGroup, uint8_t middleGroup,
+                                           KNXGroupAddressCallback callback) {
+    if (knxIsFull(ranges)) return false;
+    ranges.push_back(RangeEntry{(uint16_t)(((mainGroup & 0x1F) << 8) | (middleGroup & 0x07)), callback});
+    rebuildRangeMasks();
+    return true;
+}
+
+void KNXGroupDispatchTable::remove(uint16_t groupAddress) {
+    if (!exact.test(groupAddress)) return;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+        [groupAddress](const Entry& entry) { return entry.groupAddress == groupAddress; }),
+        entries.end());
+    exact.reset(groupAddress);
+    rebuildIndex();
+}
+
+void KNXGroupDispatchTable::removeMainGroup(uint8_t mainGroup) {
+    uint16_t key = RANGE_MAIN_ONLY | ((mainGroup & 0x1F) << 8);
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+        [key](const RangeEntry& range) { return range.key == key; }), ranges.end());
+    rebuildRangeMasks();
+}
+
+void KNXGroupDispatchTable::removeMiddleGroup(uint8_t mainGroup, uint8_t middleGroup) {
+    uint16_t key = ((mainGroup & 0x1F) << 8) | (middleGroup & 0x07);
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(),
+        [key](const RangeEntry& range) { return range.key == key; }), ranges.end());
+    rebuildRangeMasks();
+}
+
+void KNXGroupDispatchTable::dispatch(const KNXTelegram& telegram) const {
+    uint16_t address = telegram.targetAddress;
+
+    if (exact.test(address)) {
+        size_t slot = slotOf(address);
+        for (size_t i = slotStart[slot]; i < slotStart[slot + 1]; i++) {
+            entries[i].callback(telegram);
+        }
+    }
+
+    bool middleHit = (middleGroups[address >> 13] >> ((address >> 8) & 31)) & 1;
+    bool mainHit = (mainGroups >> (address >> 11)) & 1;
+    if (!middleHit && !mainHit) return;
+
+    uint16_t middleKey = ((address >> 3) & 0x1F00) | ((address >> 8) & 0x07);
+    uint16_t mainKey = RANGE_MAIN_ONLY | ((address >> 3) & 0x1F00);
+    if (middleHit) {
+        for (const RangeEntry& range : ranges) {
+            if (range.key == middleKey) range.callback(telegram);
+        }
+    }
+    if (mainHit) {
+        for (const RangeEntry& range : ranges) {
+            if (range.key == mainKey) range.callback(telegram);
+        }
+    }
+}
+
+size_t KNXGroupDispatchTable::slotOf(uint16_t groupAddress) const {
+    size_t word = groupAddress >> 5;
+    uint32_t below = exact.word(word) & ((1UL << (groupAddress & 31)) - 1);
+    return rank[word] + __builtin_popcount(below);
+}
+
+void KNXGroupDispatchTable::rebuildIndex() {
+    uint32_t count = 0;
+    for (size_t word = 0; word < KNXGroupAddressBitmap::WORDS; word++) {
+        rank[word] = (uint16_t)count;
+        count += __builtin_popcount(exact.word(word));
+    }
+
+    slotStart.clear();
+    slotStart.reserve(count + 1);
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (i == 0 || entries[i].groupAddress != entries[i - 1].groupAddress) {
+            slotStart.push_back((uint32_t)i);
+        }
+    }
+    slotStart.push_back((uint32_t)entries.size());
+}
+
+void KNXGroupDispatchTable::rebuildRangeMasks() {
+    mainGroups = 0;
+    memset(middleGroups, 0, sizeof(middleGroups));
+    for (const RangeEntry& range : ranges) {
+        uint8_t mainGroup = (range.key >> 8) & 0x1F;
+        if (range.key & RANGE_MAIN_ONLY) {
+            mainGroups |= 1UL << mainGroup;
+        } else {
+            // (main << 3 | middle) is the high byte of the group address
+            uint8_t highByte = (mainGroup << 3) | (range.key & 0x07);
+            middleGroups[highByte >> 5] |= 1UL << (highByte & 31);
+        }
+    }
+}
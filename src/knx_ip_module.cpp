@@ -5,7 +5,33 @@
 KNXIPModule::KNXIPModule() 
     : physicalAddress(0), 
       connectionType(KNX_CONNECTION_UNICAST),
-      debugLevel(1) {}
+      debugLevel(1),
+      traceOutput(&Serial),
+      statsFormat(KNX_STATS_JSON),
+      statsReply(nullptr),
+      gatewaySelected(false),
+      lastTunnelState(KNX_TUNNEL_DISCONNECTED),
+      captureStreamPort(0),
+      captureHeaderSent(false),
+      captureChunk(nullptr),
+      captureChunkSize(0) {
+    tunnel.setTap([this](const uint8_t* data, size_t length, const IPAddress& ip, uint16_t port) {
+        if (capture.isActive()) {
+            capture.record(data, length, WiFi.localIP(), KNX_PORT, ip, port);
+        }
+    });
+}
+
+KNXIPModule::~KNXIPModule() {
+    tunnel.disconnect();
+    discovery.end();
+    udp.close();
+    disableScheduler();
+    disableDispatchTask();
+    disableTrace();
+    disableStatsEndpoint();
+    disableCapture();
+}
 
 bool KNXIPModule::begin(const IPAddress& gatewayIP, int knxArea, int knxLine, int knxMember) {
     this->gatewayIP = gatewayIP;
@@ -15,185 +41,1169 @@ bool KNXIPModule::begin(const IPAddress& gatewayIP, int knxArea, int knxLine, in
     this->connectionType = KNX_CONNECTION_UNICAST;
 
     physicalAddress = (knxArea << 12) | (knxLine << 8) | knxMember;
+    restoreSnapshot();
+
+    if (!startTunnelListener()) {
+        return false;
+    }
+    if (debugLevel > 0) {
+        Serial.print("KNX gateway IP: ");
+        Serial.println(gatewayIP);
+    }
+    tunnel.begin(&udp, gatewayIP, KNX_PORT, tunnelConfig);
+    return tunnel.connect();
+}
 
-    if (udp.listen(KNX_PORT)) {
-        udp.onPacket([this](AsyncUDPPacket packet) {
+bool KNXIPModule::beginDiscovery(int knxArea, int knxLine, int knxMember,
+                                 const KNXDiscoveryConfig& config) {
+    this->gatewayIP = IPAddress();
+    this->knxArea = knxArea;
+    this->knxLine = knxLine;
+    this->knxMember = knxMember;
+    this->connectionType = KNX_CONNECTION_UNICAST;
+
+    physicalAddress = (knxArea << 12) | (knxLine << 8) | knxMember;
+    restoreSnapshot();
+
+    if (!startTunnelListener()) {
+        return false;
+    }
+    IPAddress localIP = tunnelConfig.localIP != IPAddress() ? tunnelConfig.localIP : WiFi.localIP();
+    discovery.begin(&udp, localIP, tunnelConfig.localPort, config);
+    gatewaySelected = false;
+    lastTunnelState = tunnel.state();
+    discovery.search(millis());
+    if (debugLevel > 0) {
+        Serial.println("KNX gateway search started");
+    }
+    return true;
+}
+
+bool KNXIPModule::startTunnelListener() {
+    if (!udp.listen(tunnelConfig.localPort)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to start KNX UDP listener");
+        }
+        return false;
+    }
+    udp.onPacket([this](AsyncUDPPacket& packet) {
+        this->processUdpData(packet);
+    });
+    
+    if (debugLevel > 0) {
+        Serial.print("KNX UDP listener started on port ");
+        Serial.println(tunnelConfig.localPort);
+    }
+    tunnel.setDebugLevel(debugLevel);
+    return true;
+}
+
+bool KNXIPModule::addGateway(const IPAddress& gatewayIP, uint16_t port) {
+    return discovery.addGateway(gatewayIP, port);
+}
+
+size_t KNXIPModule::getGateways(KNXGatewayInfo* gateways, size_t maxGateways) {
+    return discovery.gateways(gateways, maxGateways);
+}
+
+void KNXIPModule::manageGateway(uint32_t nowMs) {
+    discovery.poll(nowMs);
+    
+    KNXTunnelState state = tunnel.state();
+    bool failed = gatewaySelected && state == KNX_TUNNEL_DISCONNECTED &&
+        lastTunnelState != KNX_TUNNEL_DISCONNECTED;
+    lastTunnelState = state;
+    
+    if (failed) {
+        // Refused, connect timeout, or heartbeat/ACK timeouts
+        discovery.markFailed(gatewayIP, nowMs);
+        if (debugLevel > 0) {
+            Serial.print("KNX gateway failed: ");
+            Serial.println(gatewayIP);
+        }
+        selectGateway(nowMs);
+    } else if (!gatewaySelected && discovery.idle()) {
+        selectGateway(nowMs);
+    }
+}
+
+void KNXIPModule::selectGateway(uint32_t nowMs) {
+    KNXGatewayInfo gateway;
+    if (!discovery.best(gateway, nowMs)) {
+        // Nothing found yet; keep searching
+        gatewaySelected = false;
+        if (discovery.idle()) discovery.search(nowMs);
+        return;
+    }
+    // Every gateway has failed at least once: look for new ones meanwhile
+    if (gateway.failures > 0 && discovery.idle()) {
+        discovery.search(nowMs);
+    }
+    
+    if (debugLevel > 0) {
+        Serial.printf("KNX gateway selected: %s \"%s\", %u us, %d free slots\n",
+            gateway.ip.toString().c_str(), gateway.name, (unsigned)gateway.rttMicros, gateway.freeSlots);
+    }
+    gatewayIP = gateway.ip;
+    gatewaySelected = true;
+    tunnel.begin(&udp, gateway.ip, gateway.port, tunnelConfig);
+    tunnel.connect();
+    lastTunnelState = tunnel.state();
+}
+
+bool KNXIPModule::beginMulticast(int knxArea, int knxLine, int knxMember) {
+    this->knxArea = knxArea;
+    this->knxLine = knxLine;
+    this->knxMember = knxMember;
+    this->connectionType = KNX_CONNECTION_MULTICAST;
+
+    physicalAddress = (knxArea << 12) | (knxLine << 8) | knxMember;
+    restoreSnapshot();
+
+    if (udp.listenMulticast(KNX_MULTICAST_IP, KNX_PORT)) {
+        udp.onPacket([this](AsyncUDPPacket& packet) {
             this->processUdpData(packet);
         });
         
         if (debugLevel > 0) {
-            Serial.print("KNX UDP listener started on port ");
-            Serial.print(KNX_PORT);
-            Serial.print(", gateway IP: ");
-            Serial.println(gatewayIP);
+            Serial.print("KNX Multicast listener started on ");
+            Serial.print(KNX_MULTICAST_IP);
+            Serial.print(":");
+            Serial.println(KNX_PORT);
+        }
+        return true;
+    } else {
+        if (debugLevel > 0) {
+            Serial.println("Failed to start KNX Multicast listener");
+        }
+        return false;
+    }
+}
+
+void KNXIPModule::setDebugLevel(uint8_t level) {
+    debugLevel = level;
+    tunnel.setDebugLevel(level);
+}
+
+void KNXIPModule::setTunnelConfig(const KNXTunnelConfig& config) {
+    tunnelConfig = config;
+    tunnel.setConfig(config);
+}
+
+bool KNXIPModule::isConnected() const {
+    return connectionType == KNX_CONNECTION_MULTICAST || tunnel.isConnected();
+}
+
+KNXTunnelStats KNXIPModule::getTunnelStats() {
+    return tunnel.stats();
+}
+
+void KNXIPModule::setRoutingFlowConfig(const KNXRoutingFlowConfig& config) {
+    routingFlow.setConfig(config);
+}
+
+KNXRoutingFlowState KNXIPModule::getRoutingFlowState() {
+    return routingFlow.state(millis());
+}
+
+bool KNXIPModule::enableSecureRouting(const KNXSecureRoutingConfig& config) {
+    secureRouting.begin(config, millis());
+    if (debugLevel > 0) {
+        Serial.println("KNX secure routing enabled");
+    }
+    return true;
+}
+
+void KNXIPModule::disableSecureRouting() {
+    secureRouting.end();
+}
+
+KNXSecureStats KNXIPModule::getSecureRoutingStats() {
+    return secureRouting.stats();
+}
+
+bool KNXIPModule::enableSecureTunnel(const KNXSecureTunnelConfig& config) {
+    if (tunnel.state() != KNX_TUNNEL_DISCONNECTED) {
+        if (debugLevel > 0) {
+            Serial.println("KNX secure tunnel must be enabled before the connection");
+        }
+        return false;
+    }
+    tunnel.enableSecure(config);
+    return true;
+}
+
+void KNXIPModule::disableSecureTunnel() {
+    tunnel.disableSecure();
+}
+
+KNXSecureStats KNXIPModule::getSecureTunnelStats() {
+    return tunnel.secureStats();
+}
+
+bool KNXIPModule::enableDispatchTask(const KNXDispatchTaskConfig& config) {
+    disableDispatchTask();
+    
+    if (!rxQueue.begin(config.queueDepth, config.dropPolicy)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX receive queue");
+        }
+        return false;
+    }
+    
+    if (!dispatchTask.start("knx_dispatch", dispatchTaskEntry, this,
+                            config.stackSize, config.priority, config.core)) {
+        rxQueue.end();
+        if (debugLevel > 0) {
+            Serial.println("Failed to start KNX dispatch task");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableDispatchTask() {
+    dispatchTask.stop();
+    rxQueue.end();
+}
+
+KNXRxQueueStats KNXIPModule::getRxQueueStats() const {
+    return rxQueue.stats();
+}
+
+void KNXIPModule::dispatchTaskEntry(void* module) {
+    static_cast<KNXIPModule*>(module)->runDispatchTask();
+}
+
+void KNXIPModule::runDispatchTask() {
+    uint8_t frame[KNX_RX_QUEUE_FRAME_SIZE];
+    while (!dispatchTask.stopRequested()) {
+        size_t length;
+        while ((length = rxQueue.pop(frame)) > 0) {
+            dispatchCemiFrame(frame, length);
+        }
+        dispatchTask.wait(100);
+    }
+}
+
+bool KNXIPModule::enableTrace(const KNXTraceConfig& config) {
+    disableTrace();
+    
+    if (!trace.begin(config.capacity)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX trace buffer");
+        }
+        return false;
+    }
+    
+    traceOutput = config.output ? config.output : &Serial;
+    if (config.drainTask &&
+        !traceTask.start("knx_trace", traceTaskEntry, this,
+                         config.stackSize, config.priority, config.core)) {
+        trace.end();
+        if (debugLevel > 0) {
+            Serial.println("Failed to start KNX trace task");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableTrace() {
+    traceTask.stop();
+    trace.end();
+}
+
+size_t KNXIPModule::dumpTrace(Print& output, size_t maxRecords) {
+    return trace.drain(output, maxRecords);
+}
+
+KNXTraceStats KNXIPModule::getTraceStats() {
+    return trace.stats();
+}
+
+KNXStats KNXIPModule::getStats() {
+    return statistics.snapshot();
+}
+
+void KNXIPModule::resetStats() {
+    statistics.reset();
+}
+
+KNXRamReport KNXIPModule::getRamReport() const {
+    KNXRamReport report;
+    report.staticProfile = KNX_STATIC_ALLOCATION != 0;
+    report.moduleBytes = sizeof(KNXIPModule);
+    report.callbackBytes = sizeof(callbacks) + sizeof(valueFilters);
+    report.buffers = knxMemoryStats();
+    return report;
+}
+
+void KNXIPModule::printRamReport(Print& output) const {
+    KNXRamReport report = getRamReport();
+    output.printf("KNX RAM (%s profile): module %u bytes\n",
+        report.staticProfile ? "static" : "heap", (unsigned)report.moduleBytes);
+    const struct {
+        const char* name;
+        size_t bytes;
+    } parts[] = {
+        {"callbacks", sizeof(callbacks)},
+        {"filters", sizeof(valueFilters)},
+        {"rx queue", sizeof(rxQueue)},
+        {"tx queue", sizeof(txQueue)},
+        {"tunnel", sizeof(tunnel)},
+        {"secure", sizeof(secureRouting)},
+        {"group cache", sizeof(groupCache)},
+        {"group reads", sizeof(groupReads)},
+        {"scheduler", sizeof(scheduler)},
+        {"snapshot", sizeof(snapshot)},
+        {"dedup", sizeof(dedup)},
+        {"trace", sizeof(trace)},
+        {"statistics", sizeof(statistics)},
+        {"analytics", sizeof(busAnalytics)},
+        {"discovery", sizeof(discovery)},
+        {"capture", sizeof(capture)},
+        {"tasks", sizeof(dispatchTask) + sizeof(traceTask) + sizeof(schedulerTask)},
+    };
+    for (const auto& part : parts) {
+        output.printf("  %-12s %6u bytes\n", part.name, (unsigned)part.bytes);
+    }
+    const KNXMemoryStats& buffers = report.buffers;
+    if (buffers.staticPool) {
+        output.printf("  pool         %6u of %u bytes in %u blocks, high water %u, %u failed\n",
+            (unsigned)buffers.used, (unsigned)buffers.capacity, (unsigned)buffers.blocks,
+            (unsigned)buffers.highWater, (unsigned)buffers.failures);
+    } else {
+        output.printf("  heap         %6u bytes in %u blocks, high water %u, %u failed\n",
+            (unsigned)buffers.used, (unsigned)buffers.blocks, (unsigned)buffers.highWater,
+            (unsigned)buffers.failures);
+    }
+}
+
+bool KNXIPModule::enableBusAnalytics(const KNXBusAnalyticsConfig& config) {
+    if (!busAnalytics.begin(config, millis())) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX bus analytics");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableBusAnalytics() {
+    busAnalytics.end();
+}
+
+KNXBusStats KNXIPModule::getBusStats() {
+    return busAnalytics.stats(millis());
+}
+
+size_t KNXIPModule::getTopSources(KNXTopAddress* entries, size_t maxEntries) {
+    return busAnalytics.topSourceAddresses(entries, maxEntries);
+}
+
+size_t KNXIPModule::getTopGroupAddresses(KNXTopAddress* entries, size_t maxEntries) {
+    return busAnalytics.topGroupAddresses(entries, maxEntries);
+}
+
+void KNXIPModule::resetBusAnalytics() {
+    busAnalytics.reset(millis());
+}
+
+void KNXIPModule::recordBusFrame(const uint8_t* cemi, size_t length, bool received) {
+    KNXCemiFrame frame;
+    if (!knxParseCemi(cemi, length, frame)) return;
+    // Our routing indications come back through multicast loopback; they
+    // were counted when sent
+    if (received && connectionType == KNX_CONNECTION_MULTICAST && frame.source == physicalAddress) return;
+    busAnalytics.record(frame, millis());
+}
+
+bool KNXIPModule::enableStatsEndpoint(uint16_t port, KNXStatsFormat format) {
+    disableStatsEndpoint();
+    
+    statsReply = knxNewArray<uint8_t>(KNX_STATS_REPLY_SIZE);
+    if (!statsReply || !statsUdp.listen(port)) {
+        disableStatsEndpoint();
+        if (debugLevel > 0) {
+            Serial.println("Failed to start KNX stats endpoint");
+        }
+        return false;
+    }
+    
+    statsFormat = format;
+    statsUdp.onPacket([this](AsyncUDPPacket& packet) {
+        this->answerStatsRequest(packet);
+    });
+    return true;
+}
+
+void KNXIPModule::disableStatsEndpoint() {
+    statsUdp.close();
+    knxDeleteArray(statsReply);
+    statsReply = nullptr;
+}
+
+void KNXIPModule::answerStatsRequest(AsyncUDPPacket& packet) {
+    // Any datagram is a request; the reply goes back to its sender
+    KNXStats snapshot = statistics.snapshot();
+    size_t length = statsFormat == KNX_STATS_BINARY ?
+        knxStatsToBinary(snapshot, statsReply, KNX_STATS_REPLY_SIZE) :
+        knxStatsToJson(snapshot, (char*)statsReply, KNX_STATS_REPLY_SIZE);
+    if (length > 0) {
+        packet.send(statsReply, length);
+    }
+}
+
+bool KNXIPModule::enableCapture(const KNXCaptureConfig& config) {
+    disableCapture();
+    
+    // One buffer for dumps and stream datagrams; it takes the longest record
+    size_t chunkSize = KNXCaptureBuffer::RECORD_OVERHEAD + config.snapLength;
+    if (chunkSize < 1400) chunkSize = 1400;
+    captureChunk = knxNewArray<uint8_t>(chunkSize);
+    if (!captureChunk || !capture.begin(config)) {
+        disableCapture();
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX capture buffer");
+        }
+        return false;
+    }
+    
+    captureChunkSize = chunkSize;
+    captureStreamIP = config.streamIP;
+    captureStreamPort = config.streamIP != IPAddress() ? config.streamPort : 0;
+    captureHeaderSent = false;
+    return true;
+}
+
+void KNXIPModule::disableCapture() {
+    capture.end();
+    captureStreamPort = 0;
+    knxDeleteArray(captureChunk);
+    captureChunk = nullptr;
+    captureChunkSize = 0;
+}
+
+size_t KNXIPModule::dumpCapture(Print& output) {
+    if (!capture.isActive()) return 0;
+    size_t written = output.write(captureChunk,
+        KNXCaptureBuffer::writeFileHeader(captureChunk, capture.snapLength()));
+    size_t length;
+    while ((length = capture.read(captureChunk, captureChunkSize)) > 0) {
+        written += output.write(captureChunk, length);
+    }
+    return written;
+}
+
+KNXCaptureStats KNXIPModule::getCaptureStats() {
+    return capture.stats();
+}
+
+void KNXIPModule::streamCapture() {
+    if (!capture.isActive()) return;
+    if (!captureHeaderSent) {
+        size_t length = KNXCaptureBuffer::writeFileHeader(captureChunk, capture.snapLength());
+        captureHeaderSent = captureUdp.writeTo(captureChunk, length, captureStreamIP, captureStreamPort) > 0;
+        if (!captureHeaderSent) return;
+    }
+    size_t length;
+    while ((length = capture.read(captureChunk, captureChunkSize)) > 0) {
+        captureUdp.writeTo(captureChunk, length, captureStreamIP, captureStreamPort);
+    }
+}
+
+void KNXIPModule::traceTaskEntry(void* module) {
+    static_cast<KNXIPModule*>(module)->runTraceTask();
+}
+
+void KNXIPModule::runTraceTask() {
+    while (!traceTask.stopRequested()) {
+        // Small batches keep the task preemptible between records
+        while (trace.drain(*traceOutput, 16) > 0) {}
+        traceTask.wait(50);
+    }
+}
+
+bool KNXIPModule::enableTxQueue(const KNXTxQueueConfig& config) {
+    if (!txQueue.begin(config)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX transmit queue");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableTxQueue() {
+    flushTxQueue();
+    txQueue.end();
+}
+
+KNXTxQueueStats KNXIPModule::getTxQueueStats() {
+    return txQueue.stats();
+}
+
+bool KNXIPModule::enableGroupCache(const KNXGroupCacheConfig& config) {
+    if (!groupCache.begin(config)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX group value cache");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableGroupCache() {
+    groupCache.end();
+}
+
+bool KNXIPModule::getCachedValue(int groupAddress, KNXCachedValue& value) {
+    return groupCache.lookup(groupAddress, value);
+}
+
+bool KNXIPModule::setOwnedAddress(int groupAddress, bool owned) {
+    return groupCache.setOwned(groupAddress, owned);
+}
+
+KNXGroupCacheStats KNXIPModule::getGroupCacheStats() {
+    return groupCache.stats();
+}
+
+bool KNXIPModule::enableDedup(const KNXDedupConfig& config) {
+    if (!dedup.begin(config)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX dedup table");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableDedup() {
+    dedup.end();
+}
+
+KNXDedupStats KNXIPModule::getDedupStats() {
+    return dedup.stats();
+}
+
+bool KNXIPModule::enableSnapshot(KNXFlashStore& store, const KNXSnapshotConfig& config) {
+    if (!groupCache.isActive() || !snapshot.begin(&store, config)) {
+        if (debugLevel > 0) {
+            Serial.println("KNX snapshot needs the group cache and a flash region of two or more sectors");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableSnapshot() {
+    snapshot.end();
+}
+
+bool KNXIPModule::saveSnapshot() {
+    if (!snapshot.isActive()) return false;
+    uint32_t errors = snapshot.stats().errors;
+    flushSnapshot(millis());
+    return snapshot.stats().errors == errors;
+}
+
+KNXSnapshotStats KNXIPModule::getSnapshotStats() {
+    return snapshot.stats();
+}
+
+void KNXIPModule::restoreSnapshot() {
+    if (!snapshot.isActive() || !groupCache.isActive()) return;
+    uint32_t now = millis();
+    size_t restored = snapshot.restore([this, now](uint16_t groupAddress, const uint8_t* data, size_t length) {
+        groupCache.restore(groupAddress, data, length, now);
+    });
+    if (debugLevel > 0) {
+        KNXSnapshotStats stats = snapshot.stats();
+        Serial.printf("KNX snapshot: %u values restored in %u us\n", (unsigned)restored,
+            (unsigned)stats.restoreMicros);
+    }
+    if (!snapshot.settings().notifyRestored) return;
+    
+    // Once per address, with the newest value
+    uint32_t cursor = 0;
+    KNXCachedValue value;
+    while (groupCache.nextRestored(cursor, value)) {
+        KNXTelegram telegram;
+        telegram.targetAddress = value.groupAddress;
+        telegram.isGroupAddress = true;
+        telegram.command = KNX_APCI_GROUP_VALUE_RESPONSE;
+        telegram.data.assign(value.data, value.length);
+        notifyCallbacks(telegram);
+    }
+}
+
+void KNXIPModule::flushSnapshot(uint32_t nowMs) {
+    if (snapshot.settings().subscribedOnly) {
+        snapshot.flush(groupCache, [this](uint16_t groupAddress) {
+            return isCachedAddress(groupAddress);
+        }, nowMs);
+    } else {
+        snapshot.flush(groupCache, nullptr, nowMs);
+    }
+}
+
+bool KNXIPModule::enableGroupReads(const KNXGroupReadConfig& config) {
+    if (!groupReads.begin(config)) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX group read table");
+        }
+        return false;
+    }
+    return true;
+}
+
+void KNXIPModule::disableGroupReads() {
+    groupReads.end();
+}
+
+KNXReadHandle KNXIPModule::readGroupValue(int groupAddress, KNXReadCallback callback,
+                                          uint16_t timeoutMs) {
+    KNXReadHandle handle = groupReads.request(groupAddress, timeoutMs, callback);
+    if (handle != 0) {
+        sendDueReads(millis());
+    } else if (debugLevel > 0) {
+        Serial.println("KNX read queue full or not enabled, read dropped");
+    }
+    return handle;
+}
+
+bool KNXIPModule::getReadResult(KNXReadHandle handle, KNXReadResult& result) {
+    return groupReads.result(handle, result);
+}
+
+bool KNXIPModule::cancelRead(KNXReadHandle handle) {
+    return groupReads.cancel(handle);
+}
+
+KNXGroupReadStats KNXIPModule::getGroupReadStats() {
+    return groupReads.stats();
+}
+
+void KNXIPModule::sendDueReads(uint32_t nowMs) {
+    static const uint8_t READ_APDU[] = {0x00}; // GroupValue_Read
+    KNXReadHandle handle;
+    uint16_t groupAddress;
+    while (true) {
+        // Reads wait for the connection instead of filling the tunnel backlog
+        bool ready = connectionType == KNX_CONNECTION_UNICAST ? tunnel.canSend()
+                                                              : routingFlow.canSend(nowMs);
+        if (!ready || !groupReads.takeDue(nowMs, handle, groupAddress)) break;
+        
+        uint8_t buffer[KNXNETIP_HEADER_LENGTH + KNX_CEMI_MAX_FRAME];
+        size_t cemiLength = buildCemiFrame(buffer + KNXNETIP_HEADER_LENGTH, groupAddress, READ_APDU,
+                                           sizeof(READ_APDU), groupReads.priority());
+        if (!transmitFrame(buffer, cemiLength)) {
+            groupReads.sendFailed(handle);
+            break;
+        }
+    }
+}
+
+void KNXIPModule::expireReads(uint32_t nowMs) {
+    while (true) {
+        KNXReadResult result;
+        KNXReadCallback callback;
+        if (!groupReads.takeExpired(nowMs, result, callback)) break;
+        if (debugLevel > 0) {
+            Serial.printf("KNX read of %d/%d/%d timed out\n", (result.groupAddress >> 11) & 0x1F,
+                (result.groupAddress >> 8) & 0x07, result.groupAddress & 0xFF);
+        }
+        if (callback) callback(result);
+    }
+}
+
+bool KNXIPModule::enableScheduler(const KNXSchedulerConfig& config) {
+    disableScheduler();
+    
+    if (!scheduler.begin(config, millis())) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX scheduler");
         }
-        return true;
-    } else {
+        return false;
+    }
+    
+    if (config.task &&
+        !schedulerTask.start("knx_scheduler", schedulerTaskEntry, this,
+                             config.stackSize, config.priority, config.core)) {
+        scheduler.end();
         if (debugLevel > 0) {
-            Serial.println("Failed to start KNX UDP listener");
+            Serial.println("Failed to start KNX scheduler task");
         }
         return false;
     }
+    return true;
 }
 
-bool KNXIPModule::beginMulticast(int knxArea, int knxLine, int knxMember) {
-    this->knxArea = knxArea;
-    this->knxLine = knxLine;
-    this->knxMember = knxMember;
-    this->connectionType = KNX_CONNECTION_MULTICAST;
+void KNXIPModule::disableScheduler() {
+    schedulerTask.stop();
+    scheduler.end();
+}
 
-    physicalAddress = (knxArea << 12) | (knxLine << 8) | knxMember;
+KNXTimerHandle KNXIPModule::setTimeout(uint32_t delayMs, KNXTimerCallback callback) {
+    KNXTimerHandle handle = scheduler.timeout(delayMs, callback, millis());
+    // The task recomputes its sleep
+    if (handle != 0) schedulerTask.notify();
+    return handle;
+}
 
-    if (udp.listenMulticast(KNX_MULTICAST_IP, KNX_PORT)) {
-        udp.onPacket([this](AsyncUDPPacket packet) {
-            this->processUdpData(packet);
-        });
-        
-        if (debugLevel > 0) {
-            Serial.print("KNX Multicast listener started on ");
-            Serial.print(KNX_MULTICAST_IP);
-            Serial.print(":");
-            Serial.println(KNX_PORT);
+KNXTimerHandle KNXIPModule::sendCyclic(int groupAddress, uint32_t periodMs, KNXValueProvider provider,
+                                       KNXPriority priority) {
+    KNXTimerHandle handle = scheduler.cyclic(groupAddress, periodMs, provider, priority, millis());
+    if (handle != 0) schedulerTask.notify();
+    return handle;
+}
+
+KNXTimerHandle KNXIPModule::addSendObject(int groupAddress, uint32_t refreshMs, uint32_t minIntervalMs,
+                                          KNXPriority priority) {
+    return scheduler.object(groupAddress, refreshMs, minIntervalMs, priority);
+}
+
+bool KNXIPModule::updateSendObject(KNXTimerHandle handle, const uint8_t* data, size_t dataLength) {
+    KNXScheduler::Action send;
+    if (!scheduler.update(handle, data, dataLength, millis(), send)) return false;
+    if (send.length > 0) {
+        sendKNXMessage(send.groupAddress, send.data, send.length, send.priority);
+    }
+    // A change held back by the minimum interval, or the next refresh
+    schedulerTask.notify();
+    return true;
+}
+
+bool KNXIPModule::cancelTimer(KNXTimerHandle handle) {
+    return scheduler.cancel(handle);
+}
+
+KNXSchedulerStats KNXIPModule::getSchedulerStats() {
+    return scheduler.stats();
+}
+
+void KNXIPModule::runScheduler(uint32_t nowMs) {
+    // One pass over the entries at most: a timeout that keeps re-arming
+    // itself with no delay runs again on the next call
+    for (size_t i = 0; i < scheduler.settings().capacity; i++) {
+        KNXScheduler::Action action;
+        if (!scheduler.takeDue(nowMs, action)) break;
+        switch (action.kind) {
+        case KNXScheduler::TIMEOUT:
+            if (action.callback) action.callback();
+            break;
+        case KNXScheduler::CYCLIC: {
+            uint8_t data[KNX_CEMI_STANDARD_APDU];
+            size_t length = action.provider ? action.provider(data) : 0;
+            bool sent = length > 0 && length <= sizeof(data) &&
+                sendKNXMessage(action.groupAddress, data, length, action.priority);
+            scheduler.finishCyclic(action, sent);
+            break;
         }
-        return true;
+        case KNXScheduler::OBJECT:
+            sendKNXMessage(action.groupAddress, action.data, action.length, action.priority);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void KNXIPModule::schedulerTaskEntry(void* module) {
+    static_cast<KNXIPModule*>(module)->runSchedulerTask();
+}
+
+void KNXIPModule::runSchedulerTask() {
+    while (!schedulerTask.stopRequested()) {
+        runScheduler(millis());
+        // Woken early when entries are added
+        uint32_t wait = scheduler.msUntilNext(millis());
+        schedulerTask.wait(wait < KNX_POLL_MAX_MS ? wait : KNX_POLL_MAX_MS);
+    }
+}
+
+void KNXIPModule::completeReads(const KNXTelegram& telegram) {
+    uint32_t now = millis();
+    bool completed = false;
+    while (true) {
+        KNXReadResult result;
+        KNXReadCallback callback;
+        if (!groupReads.complete(telegram.targetAddress, telegram.sourceAddress, telegram.data.data(),
+                                 telegram.data.size(), now, result, callback)) break;
+        completed = true;
+        if (callback) callback(result);
+    }
+    // The window has room again
+    if (completed) sendDueReads(now);
+}
+
+void KNXIPModule::loop() {
+    uint32_t now = millis();
+    if (connectionType == KNX_CONNECTION_UNICAST) {
+        tunnel.poll(now);
+        if (discovery.isActive()) {
+            manageGateway(now);
+        }
+    }
+    if (connectionType == KNX_CONNECTION_MULTICAST && secureRouting.isActive()) {
+        sendTimerNotify(now);
+    }
+    if (groupReads.isActive()) {
+        expireReads(now);
+        sendDueReads(now);
+    }
+    if (scheduler.isActive() && !schedulerTask.running()) {
+        runScheduler(now);
+    }
+    if (snapshot.isActive() && snapshot.due(now)) {
+        flushSnapshot(now);
+    }
+    flushTxQueue();
+    if (captureStreamPort != 0) {
+        streamCapture();
+    }
+}
+
+uint32_t KNXIPModule::poll() {
+    loop();
+    uint32_t now = millis();
+    uint32_t wait = UINT32_MAX;
+    auto until = [&wait](uint32_t ms) {
+        if (ms < wait) wait = ms;
+    };
+    
+    if (scheduler.isActive() && !schedulerTask.running()) {
+        until(scheduler.msUntilNext(now));
+    }
+    bool ready;
+    if (connectionType == KNX_CONNECTION_UNICAST) {
+        until(tunnel.msUntilDue(now));
+        if (discovery.isActive()) until(KNX_POLL_MAX_MS);
+        ready = tunnel.canSend();
     } else {
+        // TIMER_NOTIFY keeps its own timing
+        if (secureRouting.isActive()) until(KNX_POLL_MAX_MS);
+        ready = routingFlow.canSend(now);
+    }
+    if (groupReads.isActive()) {
+        until(groupReads.msUntilDue(now, ready));
+        if (!ready && connectionType == KNX_CONNECTION_MULTICAST) until(routingFlow.msUntilSend(now));
+    }
+    if (snapshot.isActive()) {
+        until(snapshot.msUntilDue(now));
+    }
+    uint32_t txMicros = txQueue.microsUntilNext(micros());
+    // A tunnel that cannot take them wakes us through its own timers
+    if (txMicros != UINT32_MAX && (ready || connectionType == KNX_CONNECTION_MULTICAST)) {
+        uint32_t txMs = (txMicros + 999) / 1000;
+        // Queued telegrams also wait out a ROUTING_BUSY pause
+        if (connectionType == KNX_CONNECTION_MULTICAST) {
+            uint32_t pause = routingFlow.msUntilSend(now);
+            if (pause > txMs) txMs = pause;
+        }
+        until(txMs);
+    }
+    if (captureStreamPort != 0) {
+        until(KNX_POLL_MAX_MS);
+    }
+    return wait;
+}
+
+void KNXIPModule::sendTimerNotify(uint32_t nowMs) {
+    uint8_t notify[KNX_SECURE_TIMER_NOTIFY_LENGTH];
+    size_t length = secureRouting.poll(notify, sizeof(notify), nowMs);
+    if (length == 0) return;
+    if (capture.isActive()) {
+        capture.record(notify, length, WiFi.localIP(), KNX_PORT, KNX_MULTICAST_IP, KNX_PORT);
+    }
+    udp.writeTo(notify, length, KNX_MULTICAST_IP, KNX_PORT);
+}
+
+void KNXIPModule::flushTxQueue() {
+    KNXTxQueue::Entry entry;
+    while (txQueue.microsUntilNext(micros()) == 0) {
+        // Queued telegrams wait out a ROUTING_BUSY pause, or for the tunnel to
+        // connect and make room in its backlog, and meanwhile keep coalescing
+        bool ready = connectionType == KNX_CONNECTION_UNICAST ? tunnel.canSend()
+                                                              : routingFlow.canSend(millis());
+        if (!ready || !txQueue.pop(micros(), entry)) break;
+        txQueue.released(transmitGroupWrite(entry.groupAddress, entry.data, entry.length, entry.priority));
+    }
+}
+
+bool KNXIPModule::sendKNXMessage(int groupAddress, const uint8_t* data, size_t dataLength,
+                                 KNXPriority priority) {
+    KNXStageTimer timer(statistics, KNX_STAGE_SEND);
+    
+    if (txQueue.isActive()) {
+        bool accepted = txQueue.push(groupAddress, data, dataLength, priority);
+        if (!accepted) {
+            statistics.increment(&KNXStats::sendFailures);
+            if (debugLevel > 0) {
+                Serial.println("KNX transmit queue full, message dropped");
+            }
+        }
+        // Send right away if the rate budget allows, otherwise loop() will
+        flushTxQueue();
+        return accepted;
+    }
+    
+    if (connectionType == KNX_CONNECTION_MULTICAST && !routingFlow.canSend(millis())) {
+        statistics.increment(&KNXStats::sendFailures);
         if (debugLevel > 0) {
-            Serial.println("Failed to start KNX Multicast listener");
+            Serial.println("KNX routing paused by flow control, message dropped");
         }
         return false;
     }
+    
+    return transmitGroupWrite(groupAddress, data, dataLength, priority);
 }
 
-void KNXIPModule::setDebugLevel(uint8_t level) {
-    debugLevel = level;
+size_t KNXIPModule::buildCemiFrame(uint8_t* buffer, int groupAddress, const uint8_t* data,
+                                   size_t dataLength, KNXPriority priority) {
+    size_t length = knxWriteGroupFrame(buffer, KNX_CEMI_L_DATA_IND, 0, groupAddress, priority,
+                                       data, dataLength);
+    stampCemiFrame(buffer);
+    return length;
 }
 
-bool KNXIPModule::sendKNXMessage(int groupAddress, const uint8_t* data, size_t dataLength) {
-    uint8_t buffer[64]; // Adjust buffer size as needed
-    size_t bufferLength = 0;
-
+void KNXIPModule::stampCemiFrame(uint8_t* cemi) const {
+    // Tunnelled frames are requests and carry the individual address assigned
+    // by the gateway; routed frames are indications from our own address
+    uint16_t sourceAddress = physicalAddress;
     if (connectionType == KNX_CONNECTION_UNICAST) {
-        // KNXnet/IP tunneling request for unicast
-        buffer[bufferLength++] = 0x06; // Header length
-        buffer[bufferLength++] = 0x10; // Protocol version
-        buffer[bufferLength++] = 0x02; // Service type (tunneling request)
-        buffer[bufferLength++] = 0x00; // Reserved
-        
-        // Total length (will be filled later)
-        buffer[bufferLength++] = 0x00; // Total length high byte
-        buffer[bufferLength++] = 0x00; // Total length low byte
-
-        // Tunneling request
-        buffer[bufferLength++] = 0x04; // Connection type (tunnel)
-        buffer[bufferLength++] = 0x00; // Reserved
-        buffer[bufferLength++] = 0x00; // Connection ID
-        buffer[bufferLength++] = 0x00; // Sequence counter
-
-        // KNX cEMI data (starts here)
-        buffer[bufferLength++] = 0x29; // Message code
-        buffer[bufferLength++] = 0x00; // Additional info length (0)
-        
-        buffer[bufferLength++] = 0x80 | 0x00; // Control field 1 - Group address + no repeat
-        buffer[bufferLength++] = 0x00; // Control field 2 - Priority & routing counter
-        
-        buffer[bufferLength++] = (physicalAddress >> 8) & 0xFF; // Source address high byte
-        buffer[bufferLength++] = physicalAddress & 0xFF; // Source address low byte
-        buffer[bufferLength++] = (groupAddress >> 8) & 0xFF; // Destination address high byte
-        buffer[bufferLength++] = groupAddress & 0xFF; // Destination address low byte
-        
-        buffer[bufferLength++] = dataLength + 1; // TPDU length (data + 1 for transport control)
-        buffer[bufferLength++] = 0x00; // TPCI/APCI (group value write)
-        
-        // Copy data
-        memcpy(buffer + bufferLength, data, dataLength);
-        bufferLength += dataLength;
-        
-        // Fill in total length
-        uint16_t totalLength = bufferLength;
-        buffer[4] = (totalLength >> 8) & 0xFF;
-        buffer[5] = totalLength & 0xFF;
-    }
-    else {
-        // KNXnet/IP routing request for multicast
-        buffer[bufferLength++] = 0x06; // Header length
-        buffer[bufferLength++] = 0x10; // Protocol version
-        buffer[bufferLength++] = 0x05; // Service type (routing indication)
-        buffer[bufferLength++] = 0x00; // Reserved
-        
-        // Total length (will be filled later)
-        buffer[bufferLength++] = 0x00; // Total length high byte
-        buffer[bufferLength++] = 0x00; // Total length low byte
+        cemi[0] = KNX_CEMI_L_DATA_REQ;
+        if (tunnel.tunnelAddress() != 0) {
+            sourceAddress = tunnel.tunnelAddress();
+        }
+    } else {
+        cemi[0] = KNX_CEMI_L_DATA_IND;
+    }
+    cemi[4] = (sourceAddress >> 8) & 0xFF;
+    cemi[5] = sourceAddress & 0xFF;
+}
 
-        // KNX cEMI data (starts here)
-        buffer[bufferLength++] = 0x29; // Message code (L_Data.req)
-        buffer[bufferLength++] = 0x00; // Additional info length (0)
-        
-        buffer[bufferLength++] = 0x80 | 0x00; // Control field 1 - Group address + no repeat
-        buffer[bufferLength++] = 0x00; // Control field 2 - Priority & routing counter
-        
-        buffer[bufferLength++] = (physicalAddress >> 8) & 0xFF; // Source address high byte
-        buffer[bufferLength++] = physicalAddress & 0xFF; // Source address low byte
-        buffer[bufferLength++] = (groupAddress >> 8) & 0xFF; // Destination address high byte
-        buffer[bufferLength++] = groupAddress & 0xFF; // Destination address low byte
-        
-        buffer[bufferLength++] = dataLength + 1; // TPDU length (data + 1 for transport control)
-        buffer[bufferLength++] = 0x00; // TPCI/APCI (group value write)
-        
-        // Copy data
-        memcpy(buffer + bufferLength, data, dataLength);
-        bufferLength += dataLength;
-        
-        // Fill in total length
-        uint16_t totalLength = bufferLength;
-        buffer[4] = (totalLength >> 8) & 0xFF;
-        buffer[5] = totalLength & 0xFF;
+bool KNXIPModule::transmitGroupWrite(int groupAddress, const uint8_t* data, size_t dataLength,
+                                     KNXPriority priority) {
+    uint8_t buffer[KNXNETIP_HEADER_LENGTH + KNX_CEMI_MAX_FRAME];
+    // The same limit as received telegrams, which the tunnel backlog and the
+    // transmit queue are sized for (see knx_config.h)
+    if (dataLength == 0 || dataLength > KNX_TELEGRAM_MAX_DATA) {
+        statistics.increment(&KNXStats::sendFailures);
+        if (debugLevel > 0) {
+            Serial.printf("KNX message of %u bytes not sent (1..%u)\n", (unsigned)dataLength,
+                (unsigned)KNX_TELEGRAM_MAX_DATA);
+        }
+        return false;
     }
 
+    size_t cemiLength = buildCemiFrame(buffer + KNXNETIP_HEADER_LENGTH, groupAddress,
+                                       data, dataLength, priority);
+    return transmitFrame(buffer, cemiLength);
+}
+
+bool KNXIPModule::transmitFrame(uint8_t* buffer, size_t cemiLength) {
+    // The cEMI frame starts after room for the KNXnet/IP header
+    const uint8_t* cemi = buffer + KNXNETIP_HEADER_LENGTH;
     bool success = false;
     if (connectionType == KNX_CONNECTION_UNICAST) {
-        success = udp.writeTo(buffer, bufferLength, gatewayIP, KNX_PORT);
+        // Tunnelling: the client adds channel and sequence number and waits for the ACK
+        success = tunnel.send(cemi, cemiLength);
     } else {
-        success = udp.writeTo(buffer, bufferLength, KNX_MULTICAST_IP, KNX_PORT);
+        // KNXnet/IP routing indication for multicast
+        size_t totalLength = KNXNETIP_HEADER_LENGTH + cemiLength;
+        knxWriteHeader(buffer, KNXNETIP_ROUTING_INDICATION, totalLength);
+        const uint8_t* datagram = buffer;
+        uint8_t wrapped[KNX_SECURE_WRAPPER_OVERHEAD + KNXNETIP_HEADER_LENGTH + KNX_CEMI_MAX_FRAME];
+        if (secureRouting.isActive()) {
+            totalLength = secureRouting.wrap(buffer, totalLength, wrapped, sizeof(wrapped), millis());
+            datagram = wrapped;
+        }
+        if (totalLength > 0 && capture.isActive()) {
+            capture.record(datagram, totalLength, WiFi.localIP(), KNX_PORT, KNX_MULTICAST_IP, KNX_PORT);
+        }
+        success = totalLength > 0 && udp.writeTo(datagram, totalLength, KNX_MULTICAST_IP, KNX_PORT);
+        if (success) {
+            routingFlow.sent(millis());
+        }
     }
 
     if (success) {
+        statistics.increment(&KNXStats::telegramsSent);
+        if (busAnalytics.isActive()) {
+            recordBusFrame(cemi, cemiLength, false);
+        }
+        if (groupCache.isActive()) {
+            cacheSentFrame(cemi);
+        }
         if (debugLevel > 0) {
-            int offset = (connectionType == KNX_CONNECTION_UNICAST) ? 10 : 6;
-            KNXTelegram telegram = parseTelegram(&buffer[offset], bufferLength - offset);
-            logTelegram(telegram, true);
+            logTelegram(parseTelegram(cemi, cemiLength), true);
+        }
+    } else {
+        statistics.increment(&KNXStats::sendFailures);
+        if (debugLevel > 0) {
+            Serial.println("Failed to send KNX message");
         }
-    } else if (debugLevel > 0) {
-        Serial.println("Failed to send KNX message");
     }
 
     return success;
 }
 
+void KNXIPModule::cacheSentFrame(const uint8_t* cemi) {
+    // Our own frames have a fixed layout, so the value is read in place
+    size_t apduLength = cemi[8];
+    if (apduLength == 0) return;
+    uint8_t command = ((cemi[9] & 0x03) << 2) | (cemi[10] >> 6);
+    if (command != KNX_APCI_GROUP_VALUE_WRITE && command != KNX_APCI_GROUP_VALUE_RESPONSE) return;
+    uint16_t groupAddress = (cemi[6] << 8) | cemi[7];
+    if (!isCachedAddress(groupAddress)) return;
+
+    uint8_t value[KNX_TELEGRAM_MAX_DATA];
+    size_t length = apduLength < sizeof(value) ? apduLength : sizeof(value);
+    memcpy(value, cemi + 10, length);
+    value[0] &= 0x3F;
+    groupCache.update(groupAddress, (cemi[4] << 8) | cemi[5], value, length, millis());
+}
+
+bool KNXIPModule::isCachedAddress(uint16_t groupAddress) {
+    return callbacks.accepts(groupAddress) || groupCache.isOwned(groupAddress);
+}
+
+size_t KNXIPModule::sendBatch(KNXBatch& batch, KNXBatchOrder order) {
+    size_t accepted = 0;
+    if (order == KNX_BATCH_IN_ORDER) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            accepted += submitBatchEntry(batch, i);
+        }
+    } else {
+        // One pass per priority class, in the order the bus arbitrates them
+        static const KNXPriority RANKS[] = {
+            KNX_PRIORITY_SYSTEM, KNX_PRIORITY_URGENT, KNX_PRIORITY_NORMAL, KNX_PRIORITY_LOW
+        };
+        for (KNXPriority priority : RANKS) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (batch.priority(i) == priority) {
+                    accepted += submitBatchEntry(batch, i);
+                }
+            }
+        }
+    }
+    
+    if (txQueue.isActive()) {
+        flushTxQueue();
+    }
+    return accepted;
+}
+
+bool KNXIPModule::submitBatchEntry(KNXBatch& batch, size_t index) {
+    const uint8_t* frame = batch.frame(index);
+    size_t length = batch.frameLength(index);
+    
+    if (txQueue.isActive()) {
+        // The queue keeps values, not frames; it rebuilds them when released
+        bool queued = txQueue.push(batch.groupAddress(index), frame + 10, frame[8], batch.priority(index));
+        if (!queued) {
+            statistics.increment(&KNXStats::sendFailures);
+        }
+        batch.setStatus(index, queued ? KNX_BATCH_QUEUED : KNX_BATCH_FAILED);
+        return queued;
+    }
+    
+    if (connectionType == KNX_CONNECTION_MULTICAST && !routingFlow.canSend(millis())) {
+        statistics.increment(&KNXStats::sendFailures);
+        batch.setStatus(index, KNX_BATCH_FAILED);
+        return false;
+    }
+    
+    uint8_t buffer[KNXNETIP_HEADER_LENGTH + KNX_CEMI_MAX_FRAME];
+    memcpy(buffer + KNXNETIP_HEADER_LENGTH, frame, length);
+    stampCemiFrame(buffer + KNXNETIP_HEADER_LENGTH);
+    bool sent = transmitFrame(buffer, length);
+    batch.setStatus(index, sent ? KNX_BATCH_SENT : KNX_BATCH_FAILED);
+    return sent;
+}
+
 bool KNXIPModule::sendBool(int groupAddress, bool value) {
-    std::vector<uint8_t> data = encodeDPT1(value);
-    return sendKNXMessage(groupAddress, data.data(), data.size());
+    return send<KNXDpt<1, 1>>(groupAddress, value);
 }
 
 bool KNXIPModule::sendPercentage(int groupAddress, uint8_t percentage) {
-    std::vector<uint8_t> data = encodeDPT5(percentage);
-    return sendKNXMessage(groupAddress, data.data(), data.size());
+    return send<KNXDpt<5, 1>>(groupAddress, percentage);
 }
 
 bool KNXIPModule::sendTemperature(int groupAddress, float temperature) {
-    std::vector<uint8_t> data = encodeDPT9(temperature);
-    return sendKNXMessage(groupAddress, data.data(), data.size());
+    return send<KNXDpt<9, 1>>(groupAddress, temperature);
+}
+
+bool KNXIPModule::onGroupAddress(int groupAddress, KNXGroupAddressCallback callback) {
+    if (!callbacks.add(groupAddress, callback)) {
+        if (debugLevel > 0) {
+            Serial.println("KNX callback table full (KNX_MAX_CALLBACKS)");
+        }
+        return false;
+    }
+    return true;
+}
+
+bool KNXIPModule::onGroupAddress(int groupAddress, const KNXValueFilter& filter,
+                                 KNXGroupAddressCallback callback, const KNXValueCodec* codec) {
+    int slot = valueFilters.add(groupAddress, filter, codec, callback);
+    if (slot < 0) {
+        if (debugLevel > 0) {
+            Serial.println(codec || (filter.deadband <= 0 && filter.average <= 1) ?
+                "KNX value filter table full (KNX_MAX_VALUE_FILTERS)" :
+                "KNX value filter: deadband and averaging need a codec");
+        }
+        return false;
+    }
+    if (!onGroupAddress(groupAddress, [this, slot](const KNXTelegram& telegram) {
+            valueFilters.deliver(slot, telegram, millis());
+        })) {
+        valueFilters.release(slot);
+        return false;
+    }
+    return true;
 }
 
-void KNXIPModule::onGroupAddress(int groupAddress, KNXGroupAddressCallback callback) {
-    callbacks[groupAddress].push_back(callback);
+KNXValueFilterStats KNXIPModule::getValueFilterStats() {
+    return valueFilters.stats();
 }
 
 void KNXIPModule::removeCallback(int groupAddress) {
-    callbacks.erase(groupAddress);
+    callbacks.remove(groupAddress);
+    valueFilters.remove(groupAddress);
+}
+
+bool KNXIPModule::onMainGroup(int mainGroup, KNXGroupAddressCallback callback) {
+    return callbacks.addMainGroup(mainGroup, callback);
+}
+
+bool KNXIPModule::onMiddleGroup(int mainGroup, int middleGroup, KNXGroupAddressCallback callback) {
+    return callbacks.addMiddleGroup(mainGroup, middleGroup, callback);
+}
+
+void KNXIPModule::removeMainGroupCallback(int mainGroup) {
+    callbacks.removeMainGroup(mainGroup);
+}
+
+void KNXIPModule::removeMiddleGroupCallback(int mainGroup, int middleGroup) {
+    callbacks.removeMiddleGroup(mainGroup, middleGroup);
 }
 
-void KNXIPModule::processUdpData(AsyncUDPPacket packet) {
-    if (debugLevel > 1) {
+void KNXIPModule::processUdpData(AsyncUDPPacket& packet) {
+    KNXStageTimer timer(statistics, KNX_STAGE_RECEIVE);
+    statistics.increment(&KNXStats::packetsReceived);
+    
+    if (capture.isActive()) {
+        capture.record(packet.data(), packet.length(), packet.remoteIP(), packet.remotePort(),
+                       packet.localIP(), packet.localPort());
+    }
+    
+    if (debugLevel > 1 && trace.isActive()) {
+        trace.recordDatagram(packet.data(), packet.length());
+    } else if (debugLevel > 1) {
         Serial.print("UDP Packet received from: ");
         Serial.print(packet.remoteIP());
         Serial.print(":");
@@ -201,9 +1211,7 @@ void KNXIPModule::processUdpData(AsyncUDPPacket packet) {
         Serial.print(", length: ");
         Serial.print(packet.length());
         Serial.println(" bytes");
-    }
-
-    if (debugLevel > 1) {
+        
         Serial.print("Raw data: ");
         for (size_t i = 0; i < packet.length(); i++) {
             Serial.printf("%02X ", packet.data()[i]);
@@ -211,129 +1219,278 @@ void KNXIPModule::processUdpData(AsyncUDPPacket packet) {
         Serial.println();
     }
 
-    // Check if it's a KNX packet
-    if (packet.length() < 6) return;
-    
-    // Check for acknowledgment
-    if (packet.data()[0] == 0x06 && packet.data()[2] == 0x04) {
-        if (debugLevel > 0) {
-            Serial.println("Acknowledgment received");
-        }
+    uint16_t serviceType = knxServiceType(packet.data(), packet.length());
+    if (serviceType == 0) {
+        statistics.increment(&KNXStats::packetsInvalid);
         return;
     }
-
-    // Service type is at byte 2
-    uint8_t serviceType = packet.data()[2];
     
-    // Check packet type
-    if (packet.data()[0] == 0x06 && serviceType == 0x02) {
-        // Tunneling request (typical KNX telegram)
-        const uint8_t* knxData = packet.data() + 10; // Skip KNXnet/IP header and tunneling header
-        KNXTelegram telegram = parseTelegram(knxData, packet.length() - 10);
-        
-        if (debugLevel > 0) {
-            logTelegram(telegram, false);
+    switch (serviceType) {
+    case KNXNETIP_ROUTING_INDICATION:
+    case KNXNETIP_ROUTING_BUSY:
+    case KNXNETIP_ROUTING_LOST_MESSAGE:
+        if (secureRouting.isActive()) {
+            // Only wrapped routing frames are authentic
+            secureRouting.refusePlain();
+            return;
         }
-        
-        notifyCallbacks(telegram);
+        processRoutingService(serviceType, packet.data(), packet.length(), packet.remoteIP());
+        break;
+    
+    case KNXNETIP_SECURE_WRAPPER:
+        if (connectionType == KNX_CONNECTION_UNICAST) {
+            handleTunnelPacket(packet.data(), packet.length(), packet.remoteIP());
+        } else if (secureRouting.isActive()) {
+            uint8_t plain[KNX_SECURE_FRAME_SIZE];
+            size_t length = secureRouting.unwrap(packet.data(), packet.length(), plain, sizeof(plain), millis());
+            if (length > 0) {
+                processRoutingService(knxServiceType(plain, length), plain, length, packet.remoteIP());
+            }
+        } else {
+            statistics.increment(&KNXStats::unknownServices);
+        }
+        break;
+    
+    case KNXNETIP_TIMER_NOTIFY:
+        if (!secureRouting.isActive()) {
+            statistics.increment(&KNXStats::unknownServices);
+            return;
+        }
+        secureRouting.handleTimerNotify(packet.data(), packet.length(), millis());
+        break;
+    
+    case KNXNETIP_SESSION_RESPONSE:
+    case KNXNETIP_CONNECT_RESPONSE:
+    case KNXNETIP_CONNECTIONSTATE_RESPONSE:
+    case KNXNETIP_DISCONNECT_REQUEST:
+    case KNXNETIP_DISCONNECT_RESPONSE:
+    case KNXNETIP_TUNNELING_REQUEST:
+    case KNXNETIP_TUNNELING_ACK:
+        if (connectionType != KNX_CONNECTION_UNICAST) return;
+        handleTunnelPacket(packet.data(), packet.length(), packet.remoteIP());
+        break;
+    
+    case KNXNETIP_SEARCH_RESPONSE:
+    case KNXNETIP_DESCRIPTION_RESPONSE:
+        if (discovery.isActive() &&
+            discovery.handlePacket(serviceType, packet.data(), packet.length(), packet.remoteIP())) {
+            break;
+        }
+        // Not ours to handle
+        statistics.increment(&KNXStats::unknownServices);
+        break;
+    
+    default:
+        statistics.increment(&KNXStats::unknownServices);
+        if ((serviceType >> 8) == 0x02) {
+            // Core services packet (search request/response, description, etc.)
+            if (debugLevel > 0) {
+                Serial.printf("<<< KNX Core Service packet (0x%04X)\n", serviceType);
+            }
+        } else if (debugLevel > 1) {
+            Serial.printf("<<< Unknown KNX packet, service type: 0x%04X\n", serviceType);
+        }
+        break;
     }
-    else if (packet.data()[0] == 0x06 && serviceType == 0x05) {
+}
+
+void KNXIPModule::processRoutingService(uint16_t serviceType, const uint8_t* data, size_t length,
+                                        const IPAddress& remoteIP) {
+    switch (serviceType) {
+    case KNXNETIP_ROUTING_INDICATION: {
         // KNXnet/IP Routing packet (common in multicast)
         // Header is 6 bytes, then cEMI data starts
-        const uint8_t* knxData = packet.data() + 6; 
-        KNXTelegram telegram = parseTelegram(knxData, packet.length() - 6);
-        
-        if (debugLevel > 0) {
-            logTelegram(telegram, false);
+        const uint8_t* knxData = data + KNXNETIP_HEADER_LENGTH;
+        size_t knxLength = length - KNXNETIP_HEADER_LENGTH;
+        // Bus analytics see every frame once, subscribed or not
+        bool subscribed = isSubscribed(knxData, knxLength);
+        if (!subscribed && !busAnalytics.isActive()) {
+            statistics.increment(&KNXStats::telegramsFiltered);
+            return;
         }
-        
-        notifyCallbacks(telegram);
+        if (dedup.isActive() && dedup.isDuplicate(knxData, knxLength, physicalAddress, millis())) {
+            return;
+        }
+        if (busAnalytics.isActive()) {
+            recordBusFrame(knxData, knxLength, true);
+        }
+        if (!subscribed) {
+            statistics.increment(&KNXStats::telegramsFiltered);
+            return;
+        }
+        handleCemiFrame(knxData, knxLength);
+        break;
     }
-    else if (packet.data()[0] == 0x06 && serviceType == 0x15) {
-        // Core services packet (search request/response, description, etc.)
-        if (debugLevel > 0) {
-            Serial.printf("<<< KNX Core Service packet (0x%02X 0x%02X)\n", 
-                packet.data()[2], packet.data()[3]);
+    
+    case KNXNETIP_ROUTING_BUSY:
+        if (connectionType != KNX_CONNECTION_MULTICAST) return;
+        if (routingFlow.handleBusy(data, length, remoteIP, millis()) && debugLevel > 0) {
+            Serial.printf("<<< KNX routing busy from %s, paused for %u ms\n",
+                remoteIP.toString().c_str(), (unsigned)routingFlow.msUntilSend(millis()));
+        }
+        break;
+    
+    case KNXNETIP_ROUTING_LOST_MESSAGE:
+        if (connectionType != KNX_CONNECTION_MULTICAST) return;
+        if (routingFlow.handleLostMessage(data, length, remoteIP, millis()) && debugLevel > 0) {
+            Serial.printf("<<< KNX router %s lost %u messages\n",
+                remoteIP.toString().c_str(), (data[8] << 8) | data[9]);
         }
+        break;
+    
+    default:
+        statistics.increment(&KNXStats::unknownServices);
+        break;
     }
-    else if (debugLevel > 1) {
-        Serial.printf("<<< Unknown KNX packet, service type: 0x%02X\n", serviceType);
+}
+
+void KNXIPModule::handleTunnelPacket(uint8_t* data, size_t length, const IPAddress& remoteIP) {
+    tunnel.handlePacket(data, length, remoteIP,
+        [this](const uint8_t* cemi, size_t length) {
+            // Only indications carry bus traffic; confirmations of our own
+            // requests are ignored
+            if (length < 1 || cemi[0] != KNX_CEMI_L_DATA_IND) return;
+            if (busAnalytics.isActive()) {
+                recordBusFrame(cemi, length, true);
+            }
+            if (!isSubscribed(cemi, length)) {
+                statistics.increment(&KNXStats::telegramsFiltered);
+                return;
+            }
+            handleCemiFrame(cemi, length);
+        });
+}
+
+void KNXIPModule::handleCemiFrame(const uint8_t* data, size_t length) {
+    if (rxQueue.isActive()) {
+        // Dispatch task mode: only copy the frame, parsing happens off the network task
+        if (rxQueue.push(data, length)) {
+            dispatchTask.notify();
+        }
+        return;
     }
+    
+    dispatchCemiFrame(data, length);
 }
 
-KNXTelegram KNXIPModule::parseTelegram(const uint8_t* data, size_t length) {
+void KNXIPModule::dispatchCemiFrame(const uint8_t* data, size_t length) {
     KNXTelegram telegram;
+    {
+        KNXStageTimer timer(statistics, KNX_STAGE_PARSE);
+        statistics.increment(&KNXStats::telegramsParsed);
+        telegram = parseTelegram(data, length);
+    }
     
-    if (length < 8) return telegram; // Not enough data for a valid telegram
+    if (debugLevel > 0) {
+        logTelegram(telegram, false);
+    }
     
-    // Check if this is cEMI format with message code and additional info length
-    int offset = 0;
-    if (data[0] == 0x29) {  // L_Data.req message code
-        uint8_t addInfoLen = data[1];
-        offset = 2 + addInfoLen;  // Skip message code, addInfoLen, and any additional info
+    // A cut value would pass for a complete one in callbacks, the cache and
+    // the snapshot
+    if (telegram.truncated) {
+        statistics.increment(&KNXStats::telegramsTruncated);
+        return;
     }
     
-    // Not enough remaining data
-    if (length < offset + 6) return telegram;
+    if (groupCache.isActive() && telegram.isGroupAddress) {
+        // Our own routing indications come back through multicast loopback;
+        // they were cached when sent
+        if (telegram.sourceAddress != physicalAddress) {
+            updateGroupCache(telegram);
+        }
+        
+        // Answer reads of owned addresses locally
+        KNXCachedValue value;
+        if (telegram.command == KNX_APCI_GROUP_VALUE_READ &&
+            groupCache.lookupOwned(telegram.targetAddress, value)) {
+            value.data[0] = 0x40 | (value.data[0] & 0x3F); // GroupValue_Response
+            sendKNXMessage(telegram.targetAddress, value.data, value.length);
+        }
+    }
     
-    // Extract control fields
-    uint8_t ctrl1 = data[offset];
-    uint8_t ctrl2 = data[offset + 1];
+    if (groupReads.isActive() && telegram.isGroupAddress &&
+        telegram.command == KNX_APCI_GROUP_VALUE_RESPONSE) {
+        completeReads(telegram);
+    }
     
-    // Get routing counter from control field 2
-    telegram.routingCounter = (ctrl2 & 0x70) >> 4;
+    notifyCallbacks(telegram);
+}
+
+KNXTelegram KNXIPModule::parseTelegram(const uint8_t* data, size_t length) {
+    KNXTelegram telegram;
     
-    // Extract source address
-    telegram.sourceAddress = (data[offset + 2] << 8) | data[offset + 3];
+    // L_Data.req, .con and .ind, standard or extended frame
+    KNXCemiFrame frame;
+    if (!knxParseCemi(data, length, frame)) {
+        statistics.increment(&KNXStats::parseErrors);
+        return telegram;
+    }
     
-    // Extract target address and address type
-    telegram.targetAddress = (data[offset + 4] << 8) | data[offset + 5];
-    telegram.isGroupAddress = (ctrl1 & 0x80) != 0;
+    telegram.messageCode = frame.messageCode;
+    telegram.sourceAddress = frame.source;
+    telegram.targetAddress = frame.destination;
+    // Address type is in control field 2; bit 7 of field 1 is the frame type
+    telegram.isGroupAddress = frame.isGroupAddress();
+    telegram.extendedFrame = frame.isExtended();
+    telegram.routingCounter = frame.hopCount();
     
-    // Extract command and data
-    uint8_t tpduLength = data[offset + 6];
-    if (tpduLength > 0 && length >= offset + 7 + tpduLength - 1) {
+    // The length field counts the APDU octets following the TPCI octet
+    if (frame.apduLength > 0) {
         // The command is in the APCI (first 6 bits of APCI which is across 2 bytes)
-        uint8_t tpci = data[offset + 7];
-        uint8_t apci = 0;
-        
-        if (length >= offset + 8) {
-            apci = data[offset + 8];
-        }
-        
-        // Extract command from APCI
+        uint8_t tpci = frame.tpdu[0];
+        uint8_t apci = frame.tpdu[1];
         telegram.command = ((tpci & 0x03) << 2) | ((apci & 0xC0) >> 6);
         
-        // Extract data payload (skipping TPCI/APCI)
-        for (size_t i = offset + 8; i < offset + 7 + tpduLength; i++) {
-            // First byte of data may contain APCI bits
-            if (i == offset + 8) {
-                telegram.data.push_back(apci & 0x3F);  // Mask out APCI bits
-            } else {
-                telegram.data.push_back(data[i]);
-            }
-        }
+        // Extract data payload: first byte keeps the 6 data bits of the APCI octet
+        telegram.apduLength = (uint8_t)frame.apduLength;
+        telegram.truncated = telegram.data.assign(frame.tpdu + 1, frame.apduLength) < frame.apduLength;
+        telegram.data[0] = apci & 0x3F;
     }
     
     return telegram;
 }
 
+bool KNXIPModule::isSubscribed(const uint8_t* data, size_t length) {
+    // Verbose monitoring logs every telegram, so nothing is filtered out early
+    if (debugLevel > 1) return true;
+    
+    // Malformed frames go on to parseTelegram, which counts them
+    KNXCemiFrame frame;
+    if (!knxParseCemi(data, length, frame)) return true;
+    
+    // Owned addresses pass for the cache to record and answer reads
+    return frame.isGroupAddress() && (callbacks.accepts(frame.destination) ||
+        (groupReads.isActive() && groupReads.awaiting(frame.destination)) ||
+        (groupCache.isActive() && groupCache.isOwned(frame.destination)));
+}
+
 void KNXIPModule::notifyCallbacks(const KNXTelegram& telegram) {
     if (!telegram.isGroupAddress) return; // Only process group addresses
     
-    // Find callbacks for this group address
-    auto it = callbacks.find(telegram.targetAddress);
-    if (it != callbacks.end()) {
-        // Call all registered callbacks
-        for (const auto& callback : it->second) {
-            callback(telegram);
-        }
-    }
+    KNXStageTimer timer(statistics, KNX_STAGE_CALLBACKS);
+    statistics.increment(&KNXStats::telegramsDispatched);
+    callbacks.dispatch(telegram);
+}
+
+void KNXIPModule::updateGroupCache(const KNXTelegram& telegram) {
+    if (!telegram.isGroupAddress || telegram.data.empty()) return;
+    if (telegram.command != KNX_APCI_GROUP_VALUE_WRITE &&
+        telegram.command != KNX_APCI_GROUP_VALUE_RESPONSE) return;
+    if (!isCachedAddress(telegram.targetAddress)) return;
+    groupCache.update(telegram.targetAddress, telegram.sourceAddress,
+                      telegram.data.data(), telegram.data.size(), millis());
 }
 
 void KNXIPModule::logTelegram(const KNXTelegram& telegram, bool outgoing) {
     if (debugLevel < 1) return;
     
+    if (trace.isActive()) {
+        uint16_t serviceType = connectionType == KNX_CONNECTION_UNICAST ?
+            KNXNETIP_TUNNELING_REQUEST : KNXNETIP_ROUTING_INDICATION;
+        trace.recordTelegram(telegram, serviceType, outgoing);
+        return;
+    }
+    
     Serial.print(outgoing ? ">>> " : "<<< ");
     Serial.print("KNX telegram: src=");
     Serial.printf("%d.%d.%d", 
@@ -369,80 +1526,40 @@ void KNXIPModule::logTelegram(const KNXTelegram& telegram, bool outgoing) {
 
 // DPT Encoding/Decoding Methods
 
+#if !KNX_STATIC_ALLOCATION
 std::vector<uint8_t> KNXIPModule::encodeDPT1(bool value) {
-    std::vector<uint8_t> data;
-    // First byte: 0x80 for write command + 0x00 for DPT1
-    data.push_back(0x80);
-    // Second byte: value (0 or 1)
-    data.push_back(value ? 0x01 : 0x00);
+    std::vector<uint8_t> data(KNXDpt<1, 1>::LENGTH);
+    KNXDpt<1, 1>::encode(value, data.data());
     return data;
 }
 
 std::vector<uint8_t> KNXIPModule::encodeDPT5(uint8_t value) {
-    std::vector<uint8_t> data;
-    // First byte: 0x80 for write command + 0x00 for DPT5
-    data.push_back(0x80);
-    // Second byte: percentage value (0-100)
-    data.push_back(value);
+    std::vector<uint8_t> data(KNXDpt<5, 1>::LENGTH);
+    KNXDpt<5, 1>::encode(value, data.data());
     return data;
 }
 
 std::vector<uint8_t> KNXIPModule::encodeDPT9(float value) {
-    std::vector<uint8_t> data;
-    // First byte: 0x80 for write command + 0x00 for DPT9
-    data.push_back(0x80);
-    
-    // Convert float to DPT9 format (2-byte float)
-    int16_t mantissa = (int16_t)(value * 100.0f);
-    uint8_t exponent = 0;
-    
-    // Adjust exponent and mantissa
-    while (mantissa > 2047 || mantissa < -2048) {
-        mantissa /= 2;
-        exponent++;
-    }
-    
-    // Create the DPT9 value
-    uint16_t dpt9Value = (exponent << 11) | (mantissa & 0x07FF);
-    if (value < 0) {
-        dpt9Value |= 0x8000; // Set sign bit
-    }
-    
-    // Add the two DPT9 bytes
-    data.push_back((dpt9Value >> 8) & 0xFF);
-    data.push_back(dpt9Value & 0xFF);
-    
+    std::vector<uint8_t> data(KNXDpt<9, 1>::LENGTH);
+    KNXDpt<9, 1>::encode(value, data.data());
     return data;
 }
+#endif
 
 bool KNXIPModule::decodeDPT1(const uint8_t* data, size_t length) {
-    if (length < 2) return false;
-    return (data[1] & 0x01) == 0x01;
+    bool value = false;
+    KNXDpt<1, 1>::decode(data, length, value);
+    return value;
 }
 
 uint8_t KNXIPModule::decodeDPT5(const uint8_t* data, size_t length) {
-    if (length < 2) return 0;
-    return data[1];
+    uint16_t value = 0;
+    KNXDpt<5, 1>::decode(data, length, value);
+    return (uint8_t)value;
 }
 
 float KNXIPModule::decodeDPT9(const uint8_t* data, size_t length) {
-    if (length < 3) return 0.0f;
-    
-    // Extract the DPT9 value from the data
-    uint16_t dpt9Value = (data[1] << 8) | data[2];
-    
-    // Extract components
-    bool sign = (dpt9Value & 0x8000) != 0;
-    uint8_t exponent = (dpt9Value & 0x7800) >> 11;
-    int16_t mantissa = dpt9Value & 0x07FF;
-    
-    // Sign extend the mantissa if necessary
-    if (sign && mantissa != 0) {
-        mantissa |= 0xF800; // Extend with 1s
-    }
-    
-    // Calculate the float value
-    float value = (float)mantissa * powf(2.0f, exponent) / 100.0f;
-    
+    float value = 0.0f;
+    KNXDpt<9, 1>::decode(data, length, value);
     return value;
 }
@@ -0,0 +1,256 @@
+//==== src/knx_ip_router.cpp ====
+
+#include "knx_ip_router.h"
+#include "knx_memory.h"
+
+KNXIPRouter::KNXIPRouter() : counters(), debugLevel(1) {
+    for (uint8_t i = 0; i < 2; i++) {
+        sides[i].active = false;
+        filters[i] = nullptr;
+        passIndividual[i] = false;
+    }
+}
+
+KNXIPRouter::~KNXIPRouter() {
+    end();
+    for (uint8_t i = 0; i < 2; i++) {
+        knxDeleteArray(filters[i]);
+    }
+}
+
+bool KNXIPRouter::setFilter(KNXRouterPath path, const KNXGroupFilter& filter) {
+    if (filter.overflowed()) {
+        // A dropped block rule would let traffic through
+        if (debugLevel > 0) {
+            Serial.println("KNX router filter has more rules than KNX_MAX_FILTER_RULES");
+        }
+        return false;
+    }
+    // Compiled outside the lock; the forward path only sees the finished bitmap
+    KNXGroupAddressBitmap* compiled = knxNewArray<KNXGroupAddressBitmap>(1);
+    if (!compiled) {
+        if (debugLevel > 0) {
+            Serial.println("Failed to allocate KNX router filter");
+        }
+        return false;
+    }
+    filter.compile(*compiled);
+
+    KNXGroupAddressBitmap* previous;
+    {
+        KNXLockGuard guard(lock);
+        previous = filters[path];
+        filters[path] = compiled;
+        passIndividual[path] = filter.passesIndividual();
+    }
+    knxDeleteArray(previous);
+    return true;
+}
+
+bool KNXIPRouter::begin(const KNXRouterSideConfig& sideA, const KNXRouterSideConfig& sideB) {
+    end();
+    sides[KNX_ROUTER_SIDE_A].config = sideA;
+    sides[KNX_ROUTER_SIDE_B].config = sideB;
+    if (!startSide(KNX_ROUTER_SIDE_A) || !startSide(KNX_ROUTER_SIDE_B)) {
+        end();
+        return false;
+    }
+    return true;
+}
+
+bool KNXIPRouter::startSide(uint8_t index) {
+    Side& side = sides[index];
+    side.ownIP = side.config.localIP != IPAddress() ? side.config.localIP : WiFi.localIP();
+    side.flow.reset();
+
+    bool listening;
+    if (side.config.type == KNX_ROUTER_MULTICAST) {
+        listening = side.udp.listenMulticast(KNX_MULTICAST_IP, KNX_PORT, 1, side.config.interface);
+    } else {
+        listening = side.udp.listen(side.config.tunnel.localPort);
+    }
+    if (!listening) {
+        if (debugLevel > 0) {
+            Serial.printf("Failed to start KNX router side %c\n", 'A' + index);
+        }
+        return false;
+    }
+
+    side.udp.onPacket([this, index](AsyncUDPPacket& packet) {
+        this->processDatagram(index, packet);
+    });
+    side.active = true;
+
+    if (side.config.type == KNX_ROUTER_TUNNEL) {
+        side.tunnel.setDebugLevel(debugLevel);
+        side.tunnel.begin(&side.udp, side.config.gatewayIP, KNX_PORT, side.config.tunnel);
+        return side.tunnel.connect();
+    }
+    return true;
+}
+
+void KNXIPRouter::end() {
+    for (uint8_t i = 0; i < 2; i++) {
+        Side& side = sides[i];
+        if (!side.active) continue;
+        if (side.config.type == KNX_ROUTER_TUNNEL) {
+            side.tunnel.disconnect();
+        }
+        side.udp.close();
+        side.active = false;
+    }
+}
+
+void KNXIPRouter::setDebugLevel(uint8_t level) {
+    debugLevel = level;
+    for (uint8_t i = 0; i < 2; i++) {
+        sides[i].tunnel.setDebugLevel(level);
+    }
+}
+
+void KNXIPRouter::loop() {
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < 2; i++) {
+        if (sides[i].active && sides[i].config.type == KNX_ROUTER_TUNNEL) {
+            sides[i].tunnel.poll(now);
+        }
+    }
+}
+
+bool KNXIPRouter::isConnected() const {
+    for (uint8_t i = 0; i < 2; i++) {
+        if (!sides[i].active) return false;
+        if (sides[i].config.type == KNX_ROUTER_TUNNEL && !sides[i].tunnel.isConnected()) return false;
+    }
+    return true;
+}
+
+KNXRouterStats KNXIPRouter::getStats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
+
+void KNXIPRouter::resetStats() {
+    KNXLockGuard guard(lock);
+    counters = KNXRouterStats();
+}
+
+KNXTunnelStats KNXIPRouter::getTunnelStats(KNXRouterSide side) {
+    return sides[side].tunnel.stats();
+}
+
+KNXRoutingFlowState KNXIPRouter::getRoutingFlowState(KNXRouterSide side) {
+    return sides[side].flow.state(millis());
+}
+
+void KNXIPRouter::count(uint8_t path, uint32_t KNXRouterPathStats::* counter) {
+    KNXLockGuard guard(lock);
+    counters.paths[path].*counter += 1;
+}
+
+void KNXIPRouter::processDatagram(uint8_t index, AsyncUDPPacket& packet) {
+    Side& side = sides[index];
+    uint8_t* data = packet.data();
+    size_t length = packet.length();
+    uint16_t serviceType = knxServiceType(data, length);
+    if (serviceType == 0) {
+        KNXLockGuard guard(lock);
+        counters.invalid++;
+        return;
+    }
+
+    if (side.config.type == KNX_ROUTER_TUNNEL) {
+        side.tunnel.handlePacket(data, length, packet.remoteIP(),
+            [this, index](uint8_t* cemi, size_t cemiLength) {
+                // Bus traffic only; confirmations of forwarded requests end here
+                if (cemiLength < 1 || cemi[0] != KNX_CEMI_L_DATA_IND) return;
+                // The frame, in the datagram or the client's buffer of a
+                // secure tunnel, is ours to rewrite until we return
+                this->forward(index, cemi, cemiLength);
+            });
+        return;
+    }
+
+    // Multicast loopback hands our own forwarded frames back to us
+    if (packet.remoteIP() == side.ownIP) {
+        KNXLockGuard guard(lock);
+        counters.ownEchoes++;
+        return;
+    }
+
+    switch (serviceType) {
+    case KNXNETIP_ROUTING_INDICATION:
+        forward(index, data + KNXNETIP_HEADER_LENGTH, length - KNXNETIP_HEADER_LENGTH);
+        break;
+    case KNXNETIP_ROUTING_BUSY:
+        side.flow.handleBusy(data, length, packet.remoteIP(), millis());
+        break;
+    case KNXNETIP_ROUTING_LOST_MESSAGE:
+        side.flow.handleLostMessage(data, length, packet.remoteIP(), millis());
+        break;
+    default:
+        break;
+    }
+}
+
+void KNXIPRouter::forward(uint8_t from, uint8_t* cemi, size_t length) {
+    uint8_t path = from; // KNX_ROUTER_A_TO_B leaves side A
+    Side& target = sides[from ^ 1];
+
+    // Standard or extended L_Data.ind, its length matching the datagram
+    KNXCemiFrame frame;
+    if (!knxParseCemi(cemi, length, frame) || frame.messageCode != KNX_CEMI_L_DATA_IND) {
+        KNXLockGuard guard(lock);
+        counters.invalid++;
+        return;
+    }
+    size_t offset = 2 + cemi[1];
+    uint8_t ctrl2 = frame.ctrl2;
+    bool isGroupAddress = frame.isGroupAddress();
+    uint16_t destination = frame.destination;
+
+    {
+        KNXLockGuard guard(lock);
+        KNXRouterPathStats& stats = counters.paths[path];
+        stats.received++;
+        bool pass = isGroupAddress ? (filters[path] && filters[path]->test(destination))
+                                   : passIndividual[path];
+        if (!pass) {
+            stats.filtered++;
+            return;
+        }
+    }
+
+    // Routing counter 7 means "do not decrement", 0 ends the frame's journey
+    uint8_t hops = (ctrl2 >> 4) & 0x07;
+    if (hops == 0) {
+        count(path, &KNXRouterPathStats::hopLimit);
+        return;
+    }
+    if (hops < 7) {
+        cemi[offset + 1] = ctrl2 - 0x10;
+    }
+
+    bool sent;
+    if (target.config.type == KNX_ROUTER_MULTICAST) {
+        uint32_t now = millis();
+        if (!target.flow.canSend(now)) {
+            count(path, &KNXRouterPathStats::flowControl);
+            return;
+        }
+        // Both a ROUTING_INDICATION and a TUNNELING_REQUEST have at least six
+        // header bytes before the cEMI frame; rewrite them as routing header
+        uint8_t* datagram = cemi - KNXNETIP_HEADER_LENGTH;
+        knxWriteHeader(datagram, KNXNETIP_ROUTING_INDICATION, KNXNETIP_HEADER_LENGTH + length);
+        sent = target.udp.writeTo(datagram, KNXNETIP_HEADER_LENGTH + length,
+                                  KNX_MULTICAST_IP, KNX_PORT, target.config.interface) > 0;
+        if (sent) {
+            target.flow.sent(now);
+        }
+    } else {
+        cemi[0] = KNX_CEMI_L_DATA_REQ;
+        sent = target.tunnel.send(cemi, length);
+    }
+
+    count(path, sent ? &KNXRouterPathStats::forwarded : &KNXRouterPathStats::sendFailures);
+}
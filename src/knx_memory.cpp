@@ -0,0 +1,120 @@
+//==== src/knx_memory.cpp ====
+
+#include "knx_memory.h"
+#include "knx_platform.h"
+
+namespace {
+
+const size_t ALIGN = alignof(std::max_align_t);
+
+constexpr size_t roundUp(size_t size) {
+    return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+// Precedes every block, padded so the block stays aligned
+struct BlockHeader {
+    uint32_t size; // Block size, header included
+    uint32_t free;
+};
+const size_t HEADER = (sizeof(BlockHeader) + ALIGN - 1) & ~(ALIGN - 1);
+
+KNXLock memoryLock;
+KNXMemoryStats counters = {KNX_STATIC_ALLOCATION != 0, 0, 0, 0, 0, 0};
+
+void account(uint32_t size) {
+    counters.used += size;
+    counters.blocks++;
+    if (counters.used > counters.highWater) counters.highWater = counters.used;
+}
+
+#if KNX_STATIC_ALLOCATION
+// First fit over a list of adjacent blocks. Buffers are taken at setup and
+// rarely given back, so a linear walk is fast enough and keeps the pool
+// free of extra bookkeeping.
+alignas(std::max_align_t) uint8_t pool[roundUp(KNX_STATIC_POOL_SIZE)];
+bool poolReady = false;
+
+BlockHeader* blockAt(size_t offset) {
+    return reinterpret_cast<BlockHeader*>(pool + offset);
+}
+
+void preparePool() {
+    if (poolReady) return;
+    blockAt(0)->size = sizeof(pool);
+    blockAt(0)->free = 1;
+    counters.capacity = sizeof(pool);
+    poolReady = true;
+}
+#endif
+
+} // namespace
+
+void* knxAllocate(size_t size) {
+    size_t blockSize = HEADER + roundUp(size);
+#if KNX_STATIC_ALLOCATION
+    KNXLockGuard guard(memoryLock);
+    preparePool();
+    for (size_t offset = 0; offset < sizeof(pool); offset += blockAt(offset)->size) {
+        BlockHeader* block = blockAt(offset);
+        if (!block->free || block->size < blockSize) continue;
+        if (block->size - blockSize >= HEADER + ALIGN) {
+            // Split off the remainder
+            BlockHeader* rest = blockAt(offset + blockSize);
+            rest->size = block->size - blockSize;
+            rest->free = 1;
+            block->size = blockSize;
+        }
+        block->free = 0;
+        account(block->size);
+        return pool + offset + HEADER;
+    }
+    counters.failures++;
+    return nullptr;
+#else
+    // The heap locks itself; memoryLock only covers the counters
+    uint8_t* block = static_cast<uint8_t*>(::operator new(blockSize, std::nothrow));
+    KNXLockGuard guard(memoryLock);
+    if (!block) {
+        counters.failures++;
+        return nullptr;
+    }
+    reinterpret_cast<BlockHeader*>(block)->size = blockSize;
+    reinterpret_cast<BlockHeader*>(block)->free = 0;
+    account(blockSize);
+    return block + HEADER;
+#endif
+}
+
+void knxRelease(void* pointer) {
+    if (!pointer) return;
+    uint8_t* start = static_cast<uint8_t*>(pointer) - HEADER;
+    BlockHeader* block = reinterpret_cast<BlockHeader*>(start);
+#if KNX_STATIC_ALLOCATION
+    KNXLockGuard guard(memoryLock);
+    counters.used -= block->size;
+    counters.blocks--;
+    block->free = 1;
+    // Merge runs of free blocks
+    for (size_t offset = 0; offset < sizeof(pool); offset += blockAt(offset)->size) {
+        BlockHeader* current = blockAt(offset);
+        if (!current->free) continue;
+        while (offset + current->size < sizeof(pool) && blockAt(offset + current->size)->free) {
+            current->size += blockAt(offset + current->size)->size;
+        }
+    }
+#else
+    uint32_t blockSize = block->size;
+    ::operator delete(start);
+    KNXLockGuard guard(memoryLock);
+    counters.used -= blockSize;
+    counters.blocks--;
+#endif
+}
+
+KNXMemoryStats knxMemoryStats() {
+    KNXLockGuard guard(memoryLock);
+#if KNX_STATIC_ALLOCATION
+    preparePool();
+#endif
+    return counters;
+}
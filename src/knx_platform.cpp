@@ -0,0 +1,132 @@
+//==== src/knx_platform.cpp ====
+
+#include "knx_platform.h"
+#include "knx_memory.h"
+
+#if defined(ESP32)
+
+KNXTask::KNXTask()
+    : entry(nullptr), argument(nullptr), active(false), stopping(false),
+      handle(nullptr), finished(false)
+#if KNX_STATIC_ALLOCATION
+      , stack(nullptr)
+#endif
+{}
+
+KNXTask::~KNXTask() {
+    stop();
+}
+
+bool KNXTask::start(const char* name, Entry entry, void* argument,
+                    uint32_t stackSize, uint8_t priority, int core) {
+    if (active) return false;
+    this->entry = entry;
+    this->argument = argument;
+    stopping = false;
+    finished = false;
+
+    BaseType_t affinity = core < 0 ? tskNO_AFFINITY : (BaseType_t)core;
+#if KNX_STATIC_ALLOCATION
+    stack = static_cast<StackType_t*>(knxAllocate(stackSize));
+    if (!stack) return false;
+    handle = xTaskCreateStaticPinnedToCore(run, name, stackSize, this, priority, stack, &control, affinity);
+#else
+    if (xTaskCreatePinnedToCore(run, name, stackSize, this, priority, &handle, affinity) != pdPASS) {
+        handle = nullptr;
+    }
+#endif
+    if (!handle) {
+#if KNX_STATIC_ALLOCATION
+        knxRelease(stack);
+        stack = nullptr;
+#endif
+        return false;
+    }
+    active = true;
+    return true;
+}
+
+void KNXTask::run(void* self) {
+    KNXTask* task = static_cast<KNXTask*>(self);
+    task->entry(task->argument);
+    task->finished = true;
+    vTaskDelete(nullptr);
+}
+
+void KNXTask::stop() {
+    if (!active) return;
+    stopping = true;
+    notify();
+    while (!finished) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+#if KNX_STATIC_ALLOCATION
+    // The stack is in use until vTaskDelete() has run
+    while (eTaskGetState(handle) != eDeleted) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    knxRelease(stack);
+    stack = nullptr;
+#endif
+    handle = nullptr;
+    active = false;
+}
+
+void KNXTask::notify() {
+    if (handle) xTaskNotifyGive(handle);
+}
+
+bool KNXTask::wait(uint32_t timeoutMs) {
+    return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs)) != 0;
+}
+
+#else
+
+KNXTask::KNXTask()
+    : entry(nullptr), argument(nullptr), active(false), stopping(false), notified(false) {}
+
+KNXTask::~KNXTask() {
+    stop();
+}
+
+bool KNXTask::start(const char* name, Entry entry, void* argument,
+                    uint32_t stackSize, uint8_t priority, int core) {
+    (void)name;
+    (void)stackSize;
+    (void)priority;
+    (void)core;
+    if (active) return false;
+    this->entry = entry;
+    this->argument = argument;
+    stopping = false;
+    notified = false;
+    thread = std::thread([this]() { this->entry(this->argument); });
+    active = true;
+    return true;
+}
+
+void KNXTask::stop() {
+    if (!active) return;
+    stopping = true;
+    notify();
+    if (thread.joinable()) thread.join();
+    active = false;
+}
+
+void KNXTask::notify() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        notified = true;
+    }
+    condition.notify_one();
+}
+
+bool KNXTask::wait(uint32_t timeoutMs) {
+    std::unique_lock<std::mutex> guard(mutex);
+    bool woken = condition.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+        [this]() { return notified; });
+    notified = false;
+    return woken;
+}
+
+#endif
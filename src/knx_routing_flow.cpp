@@ -0,0 +1,169 @@
+//==== src/knx_routing_flow.cpp ====
+
+#include "knx_routing_flow.h"
+
+namespace {
+
+// BUSY frames closer together than this count once
+const uint32_t BUSY_BURST_MS = 10;
+
+bool reached(uint32_t nowMs, uint32_t deadline) {
+    return (int32_t)(nowMs - deadline) >= 0;
+}
+
+uint16_t read16(const uint8_t* data) {
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+} // namespace
+
+KNXRoutingFlowControl::KNXRoutingFlowControl() {
+    reset();
+}
+
+void KNXRoutingFlowControl::setConfig(const KNXRoutingFlowConfig& config) {
+    KNXLockGuard guard(lock);
+    this->config = config;
+}
+
+void KNXRoutingFlowControl::reset() {
+    KNXLockGuard guard(lock);
+    counters = KNXRoutingFlowState();
+    busySeen = false;
+    lastBusy = 0;
+    pauseUntil = 0;
+    decayAt = 0;
+    recoverAt = 0;
+    sentBefore = false;
+    lastSend = 0;
+}
+
+KNXRoutingPeer* KNXRoutingFlowControl::peerFor(const IPAddress& router) {
+    for (uint8_t i = 0; i < counters.peerCount; i++) {
+        if (counters.peers[i].address == router) return &counters.peers[i];
+    }
+    // Routers beyond the table only show up in the totals
+    if (counters.peerCount == KNX_ROUTING_PEERS) return nullptr;
+    KNXRoutingPeer& peer = counters.peers[counters.peerCount++];
+    peer = KNXRoutingPeer();
+    peer.address = router;
+    return &peer;
+}
+
+bool KNXRoutingFlowControl::handleBusy(const uint8_t* data, size_t length,
+                                       const IPAddress& router, uint32_t nowMs) {
+    // Header, structure length 6, device state, wait time, control field
+    if (length < 12 || data[6] != 6) return false;
+    uint16_t waitMs = read16(data + 8);
+    uint16_t control = read16(data + 10);
+
+    KNXLockGuard guard(lock);
+    update(nowMs);
+    counters.busyFrames++;
+    KNXRoutingPeer* peer = peerFor(router);
+    if (peer) {
+        peer->deviceState = data[7];
+        peer->busyFrames++;
+    }
+
+    // A non-zero control field addresses specific devices, none of them us
+    if (control != 0) {
+        counters.busyIgnored++;
+        return true;
+    }
+
+    if (!busySeen || nowMs - lastBusy > BUSY_BURST_MS) {
+        if (counters.busyCount < 255) counters.busyCount++;
+    }
+    busySeen = true;
+    lastBusy = nowMs;
+
+    if (waitMs > config.maxWaitMs) waitMs = config.maxWaitMs;
+    uint32_t randomMs = (uint32_t)random((long)counters.busyCount * config.randomWaitMs + 1);
+    uint32_t until = nowMs + waitMs + randomMs;
+    if (!counters.paused || (int32_t)(until - pauseUntil) > 0) {
+        pauseUntil = until;
+        counters.paused = true;
+        counters.pauses++;
+    }
+    decayAt = pauseUntil + (uint32_t)counters.busyCount * config.slowdownPerBusyMs;
+    return true;
+}
+
+bool KNXRoutingFlowControl::handleLostMessage(const uint8_t* data, size_t length,
+                                              const IPAddress& router, uint32_t nowMs) {
+    // Header, structure length 4, device state, number of lost messages
+    if (length < 10 || data[6] != 4) return false;
+    uint16_t lost = read16(data + 8);
+
+    KNXLockGuard guard(lock);
+    update(nowMs);
+    counters.lostReports++;
+    counters.lostMessages += lost;
+    KNXRoutingPeer* peer = peerFor(router);
+    if (peer) {
+        peer->deviceState = data[7];
+        peer->lostReports++;
+        peer->lostMessages += lost;
+    }
+
+    if (lost > 0) {
+        uint32_t interval = counters.sendIntervalMs ? counters.sendIntervalMs * 2U : config.lossIntervalMs;
+        counters.sendIntervalMs = (uint16_t)(interval < config.maxIntervalMs ? interval : config.maxIntervalMs);
+        recoverAt = nowMs + config.recoveryMs;
+    }
+    return true;
+}
+
+void KNXRoutingFlowControl::update(uint32_t nowMs) {
+    if (counters.paused && reached(nowMs, pauseUntil)) {
+        counters.paused = false;
+    }
+    while (!counters.paused && counters.busyCount > 0 && reached(nowMs, decayAt)) {
+        counters.busyCount--;
+        decayAt += config.decrementMs;
+    }
+    while (counters.sendIntervalMs > 0 && reached(nowMs, recoverAt)) {
+        counters.sendIntervalMs /= 2;
+        if (counters.sendIntervalMs < config.lossIntervalMs / 2) counters.sendIntervalMs = 0;
+        recoverAt += config.recoveryMs;
+    }
+}
+
+uint32_t KNXRoutingFlowControl::waitFor(uint32_t nowMs) const {
+    uint32_t wait = 0;
+    if (counters.paused) {
+        wait = pauseUntil - nowMs;
+    }
+    if (counters.sendIntervalMs > 0 && sentBefore) {
+        uint32_t next = lastSend + counters.sendIntervalMs;
+        if (!reached(nowMs, next) && next - nowMs > wait) wait = next - nowMs;
+    }
+    return wait;
+}
+
+bool KNXRoutingFlowControl::canSend(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    update(nowMs);
+    return waitFor(nowMs) == 0;
+}
+
+void KNXRoutingFlowControl::sent(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    sentBefore = true;
+    lastSend = nowMs;
+}
+
+uint32_t KNXRoutingFlowControl::msUntilSend(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    update(nowMs);
+    return waitFor(nowMs);
+}
+
+KNXRoutingFlowState KNXRoutingFlowControl::state(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    update(nowMs);
+    KNXRoutingFlowState snapshot = counters;
+    snapshot.resumeInMs = waitFor(nowMs);
+    return snapshot;
+}
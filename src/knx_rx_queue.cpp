@@ -0,0 +1,110 @@
+//==== src/knx_rx_queue.cpp ====
+
+#include "knx_rx_queue.h"
+#include "knx_memory.h"
+
+KNXRxQueue::KNXRxQueue()
+    : slots(nullptr), mask(0), policy(KNX_RX_DROP_OLDEST),
+      head(0), tail(0), received(0), dispatched(0), dropped(0), highWater(0) {}
+
+KNXRxQueue::~KNXRxQueue() {
+    end();
+}
+
+bool KNXRxQueue::begin(size_t depth, KNXRxDropPolicy policy) {
+    end();
+    size_t capacity = 2;
+    while (capacity < depth) capacity <<= 1;
+
+    slots = knxNewArray<Slot>(capacity);
+    if (!slots) return false;
+
+    mask = capacity - 1;
+    this->policy = policy;
+    head.store(0);
+    tail.store(0);
+    received.store(0);
+    dispatched.store(0);
+    dropped.store(0);
+    highWater.store(0);
+    return true;
+}
+
+void KNXRxQueue::end() {
+    knxDeleteArray(slots);
+    slots = nullptr;
+    mask = 0;
+}
+
+bool KNXRxQueue::push(const uint8_t* data, size_t length) {
+    received.fetch_add(1, std::memory_order_relaxed);
+    // The additional info is dropped, so a slot fits every frame whose APDU
+    // fits a KNXTelegram (see knx_config.h)
+    size_t addInfo = length >= 2 ? data[1] : 0;
+    if (2 + addInfo > length) addInfo = 0; // Malformed, passed on for the parser to count
+    length -= addInfo;
+    if (length > KNX_RX_QUEUE_FRAME_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t t = tail.load(std::memory_order_acquire);
+    if (h - t > mask) {
+        if (policy == KNX_RX_DROP_NEWEST) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Reclaim the oldest slot. If the CAS fails the consumer just took it,
+        // which frees the slot as well.
+        if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Slot& slot = slots[h & mask];
+    if (addInfo > 0) {
+        slot.data[0] = data[0];
+        slot.data[1] = 0;
+        memcpy(slot.data + 2, data + 2 + addInfo, length - 2);
+    } else {
+        memcpy(slot.data, data, length);
+    }
+    slot.length = (uint16_t)length;
+    head.store(h + 1, std::memory_order_release);
+
+    uint32_t occupancy = h + 1 - tail.load(std::memory_order_relaxed);
+    if (occupancy > highWater.load(std::memory_order_relaxed)) {
+        highWater.store(occupancy, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+size_t KNXRxQueue::pop(uint8_t* buffer) {
+    while (true) {
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (t == head.load(std::memory_order_acquire)) return 0;
+
+        const Slot& slot = slots[t & mask];
+        size_t length = slot.length;
+        if (length > KNX_RX_QUEUE_FRAME_SIZE) length = KNX_RX_QUEUE_FRAME_SIZE;
+        memcpy(buffer, slot.data, length);
+
+        // Claim the slot only after copying it out; a failed CAS means the
+        // producer reclaimed it meanwhile and the copy may be torn.
+        if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+            dispatched.fetch_add(1, std::memory_order_relaxed);
+            return length;
+        }
+    }
+}
+
+KNXRxQueueStats KNXRxQueue::stats() const {
+    KNXRxQueueStats result;
+    result.received = received.load(std::memory_order_relaxed);
+    result.dispatched = dispatched.load(std::memory_order_relaxed);
+    result.dropped = dropped.load(std::memory_order_relaxed);
+    result.highWater = highWater.load(std::memory_order_relaxed);
+    result.depth = slots ? mask + 1 : 0;
+    return result;
+}
@@ -0,0 +1,448 @@
+//==== src/knx_scheduler.cpp ====
+
+#include "knx_scheduler.h"
+#include <utility>
+
+KNXTimerWheel::KNXTimerWheel() : nodes(nullptr), capacity(0), occupied(), current(0) {
+    for (uint16_t i = 0; i < LISTS; i++) heads[i] = NONE;
+}
+
+KNXTimerWheel::~KNXTimerWheel() {
+    end();
+}
+
+bool KNXTimerWheel::begin(size_t capacity, uint32_t nowMs) {
+    end();
+    if (capacity == 0 || capacity >= NONE) return false; // Indices are 16-bit
+    nodes = knxNewArray<Node>(capacity);
+    if (!nodes) return false;
+    this->capacity = capacity;
+    for (size_t i = 0; i < capacity; i++) {
+        nodes[i].list = UNARMED;
+        nodes[i].next = nodes[i].prev = NONE;
+    }
+    for (uint16_t i = 0; i < LISTS; i++) heads[i] = NONE;
+    for (uint8_t level = 0; level < LEVELS; level++) occupied[level] = 0;
+    current = nowMs;
+    return true;
+}
+
+void KNXTimerWheel::end() {
+    knxDeleteArray(nodes);
+    nodes = nullptr;
+    capacity = 0;
+}
+
+void KNXTimerWheel::swap(KNXTimerWheel& other) {
+    std::swap(nodes, other.nodes);
+    std::swap(capacity, other.capacity);
+    std::swap(heads, other.heads);
+    std::swap(occupied, other.occupied);
+    std::swap(current, other.current);
+}
+
+uint64_t KNXTimerWheel::wheelTime(uint32_t nowMs) const {
+    uint32_t elapsed = nowMs - (uint32_t)current;
+    // A time before the wheel's clock (a caller that read millis() early)
+    // counts as the current time
+    if (elapsed > 0x80000000UL) return current;
+    return current + elapsed;
+}
+
+void KNXTimerWheel::schedule(uint16_t id, uint32_t nowMs, uint32_t delayMs) {
+    unlink(id);
+    nodes[id].deadline = wheelTime(nowMs) + delayMs;
+    insert(id);
+}
+
+void KNXTimerWheel::cancel(uint16_t id) {
+    unlink(id);
+}
+
+void KNXTimerWheel::insert(uint16_t id) {
+    uint64_t deadline = nodes[id].deadline;
+    if (deadline <= current) {
+        link(id, DUE);
+        return;
+    }
+    uint64_t differing = deadline ^ current;
+    if (differing >> SPAN_BITS) {
+        link(id, BEYOND);
+        return;
+    }
+    uint8_t level = (63 - __builtin_clzll(differing)) / SLOT_BITS;
+    uint16_t slot = (deadline >> (level * SLOT_BITS)) & (SLOTS - 1);
+    link(id, level * SLOTS + slot);
+}
+
+void KNXTimerWheel::link(uint16_t id, uint16_t list) {
+    Node& node = nodes[id];
+    node.list = list;
+    node.prev = NONE;
+    node.next = heads[list];
+    if (node.next != NONE) nodes[node.next].prev = id;
+    heads[list] = id;
+    if (list < DUE) occupied[list / SLOTS] |= 1ULL << (list % SLOTS);
+}
+
+void KNXTimerWheel::unlink(uint16_t id) {
+    Node& node = nodes[id];
+    if (node.list == UNARMED) return;
+    if (node.prev != NONE) {
+        nodes[node.prev].next = node.next;
+    } else {
+        heads[node.list] = node.next;
+        if (node.next == NONE && node.list < DUE) {
+            occupied[node.list / SLOTS] &= ~(1ULL << (node.list % SLOTS));
+        }
+    }
+    if (node.next != NONE) nodes[node.next].prev = node.prev;
+    node.list = UNARMED;
+}
+
+void KNXTimerWheel::requeue(uint16_t list) {
+    uint16_t id = heads[list];
+    heads[list] = NONE;
+    if (list < DUE) occupied[list / SLOTS] &= ~(1ULL << (list % SLOTS));
+    while (id != NONE) {
+        uint16_t next = nodes[id].next;
+        insert(id);
+        id = next;
+    }
+}
+
+uint64_t KNXTimerWheel::nextEvent() const {
+    uint64_t next = UINT64_MAX;
+    for (uint8_t level = 0; level < LEVELS; level++) {
+        uint8_t shift = level * SLOT_BITS;
+        uint8_t digit = (current >> shift) & (SLOTS - 1);
+        // Occupied slots lie ahead of the current one in this level's round
+        uint64_t ahead = digit == SLOTS - 1 ? 0 : occupied[level] & (~0ULL << (digit + 1));
+        if (!ahead) continue;
+        uint64_t round = (current >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+        uint64_t at = round | ((uint64_t)__builtin_ctzll(ahead) << shift);
+        if (at < next) next = at;
+    }
+    if (heads[BEYOND] != NONE) {
+        uint64_t at = ((current >> SPAN_BITS) + 1) << SPAN_BITS;
+        if (at < next) next = at;
+    }
+    return next;
+}
+
+uint16_t KNXTimerWheel::expire(uint32_t nowMs) {
+    if (!nodes) return NONE;
+    uint64_t target = wheelTime(nowMs);
+    while (true) {
+        uint16_t id = heads[DUE];
+        if (id != NONE) {
+            unlink(id);
+            return id;
+        }
+        if (current >= target) return NONE;
+        uint64_t at = nextEvent();
+        if (at > target) {
+            current = target;
+            return NONE;
+        }
+        current = at;
+        // Timers of the slots reached move down a level, or to DUE on level 0
+        if ((at & ((1ULL << SPAN_BITS) - 1)) == 0) requeue(BEYOND);
+        for (int level = LEVELS - 1; level >= 0; level--) {
+            uint8_t shift = level * SLOT_BITS;
+            if (at & ((1ULL << shift) - 1)) continue;
+            requeue(level * SLOTS + ((at >> shift) & (SLOTS - 1)));
+        }
+    }
+}
+
+uint64_t KNXTimerWheel::nextDeadline() const {
+    if (heads[DUE] != NONE) return current;
+    // Every deadline on a level comes before the slots of the levels above are
+    // reached, so the earliest one is in the first slot ahead on the lowest
+    // occupied level
+    uint16_t list = BEYOND;
+    for (uint8_t level = 0; level < LEVELS; level++) {
+        uint8_t digit = (current >> (level * SLOT_BITS)) & (SLOTS - 1);
+        uint64_t ahead = digit == SLOTS - 1 ? 0 : occupied[level] & (~0ULL << (digit + 1));
+        if (ahead) {
+            list = level * SLOTS + __builtin_ctzll(ahead);
+            break;
+        }
+    }
+    uint64_t next = UINT64_MAX;
+    for (uint16_t id = heads[list]; id != NONE; id = nodes[id].next) {
+        if (nodes[id].deadline < next) next = nodes[id].deadline;
+    }
+    return next;
+}
+
+uint32_t KNXTimerWheel::msUntilNext(uint32_t nowMs) const {
+    if (!nodes) return UINT32_MAX;
+    uint64_t at = nextDeadline();
+    if (at == UINT64_MAX) return UINT32_MAX;
+    uint64_t now = wheelTime(nowMs);
+    if (at <= now) return 0;
+    uint64_t wait = at - now;
+    return wait < UINT32_MAX ? (uint32_t)wait : UINT32_MAX - 1;
+}
+
+KNXScheduler::KNXScheduler() : entries(nullptr), freeHead(KNXTimerWheel::NONE), counters() {}
+
+KNXScheduler::~KNXScheduler() {
+    end();
+}
+
+bool KNXScheduler::begin(const KNXSchedulerConfig& config, uint32_t nowMs) {
+    end();
+
+    size_t capacity = config.capacity;
+    if (capacity == 0) capacity = 1;
+    if (capacity >= KNXTimerWheel::NONE) capacity = KNXTimerWheel::NONE - 1;
+
+    KNXTimerWheel created;
+    Entry* createdEntries = knxNewArray<Entry>(capacity);
+    if (!createdEntries || !created.begin(capacity, nowMs)) {
+        knxDeleteArray(createdEntries);
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        createdEntries[i].kind = FREE;
+        createdEntries[i].generation = 0;
+        createdEntries[i].nextFree = (i + 1 < capacity) ? (uint16_t)(i + 1) : KNXTimerWheel::NONE;
+    }
+
+    Entry* previous;
+    {
+        KNXLockGuard guard(lock);
+        this->config = config;
+        this->config.capacity = capacity;
+        wheel.swap(created);
+        previous = entries;
+        entries = createdEntries;
+        freeHead = 0;
+        counters = KNXSchedulerStats();
+        counters.capacity = capacity;
+    }
+    knxDeleteArray(previous);
+    return true;
+}
+
+void KNXScheduler::end() {
+    KNXTimerWheel released;
+    Entry* previous;
+    {
+        KNXLockGuard guard(lock);
+        wheel.swap(released);
+        previous = entries;
+        entries = nullptr;
+        freeHead = KNXTimerWheel::NONE;
+        counters.active = 0;
+    }
+    knxDeleteArray(previous);
+}
+
+KNXScheduler::Entry* KNXScheduler::allocate(Kind kind, uint16_t& index) {
+    if (!entries) return nullptr;
+    if (freeHead == KNXTimerWheel::NONE) {
+        counters.rejected++;
+        return nullptr;
+    }
+    index = freeHead;
+    Entry& entry = entries[index];
+    freeHead = entry.nextFree;
+
+    if (++entry.generation == 0) entry.generation = 1;
+    entry.kind = kind;
+    entry.hasValue = false;
+    entry.hasSent = false;
+    entry.pending = false;
+    entry.length = 0;
+    entry.priority = KNX_PRIORITY_LOW;
+    entry.periodMs = 0;
+    entry.minIntervalMs = 0;
+    entry.due = 0;
+    entry.lastSent = 0;
+    counters.active++;
+    return &entry;
+}
+
+KNXScheduler::Entry* KNXScheduler::lookup(KNXTimerHandle handle, uint16_t& index) {
+    index = handle & 0xFFFF;
+    if (!entries || index >= config.capacity) return nullptr;
+    Entry& entry = entries[index];
+    if (entry.kind == FREE || entry.generation != (handle >> 16)) return nullptr;
+    return &entry;
+}
+
+void KNXScheduler::release(uint16_t index, KNXTimerCallback& callback, KNXValueProvider& provider) {
+    Entry& entry = entries[index];
+    wheel.cancel(index);
+    callback.swap(entry.callback);
+    provider.swap(entry.provider);
+    entry.kind = FREE;
+    entry.nextFree = freeHead;
+    freeHead = index;
+    counters.active--;
+}
+
+KNXTimerHandle KNXScheduler::timeout(uint32_t delayMs, const KNXTimerCallback& callback, uint32_t nowMs) {
+    // Copied here and swapped in below: nothing allocates or frees under the lock
+    KNXTimerCallback stored = callback;
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = allocate(TIMEOUT, index);
+    if (!entry) return 0;
+    entry->callback.swap(stored);
+    wheel.schedule(index, nowMs, delayMs);
+    return handleOf(index, *entry);
+}
+
+KNXTimerHandle KNXScheduler::cyclic(uint16_t groupAddress, uint32_t periodMs, const KNXValueProvider& provider,
+                                    KNXPriority priority, uint32_t nowMs) {
+    KNXValueProvider stored = provider;
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = allocate(CYCLIC, index);
+    if (!entry) return 0;
+    entry->provider.swap(stored);
+    entry->groupAddress = groupAddress;
+    entry->priority = priority;
+    entry->periodMs = periodMs != 0 ? periodMs : 1;
+    entry->due = nowMs + entry->periodMs;
+    wheel.schedule(index, nowMs, entry->periodMs);
+    return handleOf(index, *entry);
+}
+
+KNXTimerHandle KNXScheduler::object(uint16_t groupAddress, uint32_t refreshMs, uint32_t minIntervalMs,
+                                    KNXPriority priority) {
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = allocate(OBJECT, index);
+    if (!entry) return 0;
+    entry->groupAddress = groupAddress;
+    entry->priority = priority;
+    entry->periodMs = refreshMs;
+    entry->minIntervalMs = minIntervalMs;
+    // Armed by the first update()
+    return handleOf(index, *entry);
+}
+
+bool KNXScheduler::update(KNXTimerHandle handle, const uint8_t* data, size_t length, uint32_t nowMs,
+                          Action& send) {
+    send.length = 0;
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    Entry* entry = lookup(handle, index);
+    if (!entry || entry->kind != OBJECT || length == 0 || length > sizeof(entry->data)) return false;
+
+    if (entry->hasValue && entry->length == length && memcmp(entry->data, data, length) == 0) {
+        // A change waiting for the interval keeps waiting
+        if (!entry->pending) counters.unchanged++;
+        return true;
+    }
+    memcpy(entry->data, data, length);
+    entry->length = (uint8_t)length;
+    entry->hasValue = true;
+
+    if (entry->hasSent && nowMs - entry->lastSent < entry->minIntervalMs) {
+        entry->pending = true;
+        wheel.schedule(index, nowMs, entry->lastSent + entry->minIntervalMs - nowMs);
+        return true;
+    }
+    fillSend(*entry, send, nowMs);
+    send.handle = handle;
+    return true;
+}
+
+void KNXScheduler::fillSend(Entry& entry, Action& action, uint32_t nowMs) {
+    uint16_t index = (uint16_t)(&entry - entries);
+    action.kind = OBJECT;
+    action.groupAddress = entry.groupAddress;
+    action.priority = entry.priority;
+    action.length = entry.length;
+    memcpy(action.data, entry.data, entry.length);
+
+    entry.hasSent = true;
+    entry.pending = false;
+    entry.lastSent = nowMs;
+    counters.objectSends++;
+    if (entry.periodMs > 0) {
+        wheel.schedule(index, nowMs, entry.periodMs);
+    } else {
+        wheel.cancel(index);
+    }
+}
+
+bool KNXScheduler::cancel(KNXTimerHandle handle) {
+    KNXTimerCallback droppedCallback;
+    KNXValueProvider droppedProvider;
+    KNXLockGuard guard(lock);
+    uint16_t index;
+    if (!lookup(handle, index)) return false;
+    release(index, droppedCallback, droppedProvider);
+    return true;
+}
+
+bool KNXScheduler::takeDue(uint32_t nowMs, Action& action) {
+    KNXLockGuard guard(lock);
+    if (!entries) return false;
+    while (true) {
+        uint16_t index = wheel.expire(nowMs);
+        if (index == KNXTimerWheel::NONE) return false;
+        Entry& entry = entries[index];
+        action.handle = handleOf(index, entry);
+
+        switch (entry.kind) {
+        case TIMEOUT:
+            action.kind = TIMEOUT;
+            counters.timeouts++;
+            release(index, action.callback, action.provider);
+            return true;
+
+        case CYCLIC: {
+            // Phase-locked: the next deadline follows the one just reached
+            uint32_t late = nowMs - entry.due;
+            if ((int32_t)late < 0) late = 0;
+            uint32_t skipped = late / entry.periodMs;
+            counters.missed += skipped;
+            entry.due += (skipped + 1) * entry.periodMs;
+            wheel.schedule(index, nowMs, entry.due - nowMs);
+            action.kind = CYCLIC;
+            action.groupAddress = entry.groupAddress;
+            action.priority = entry.priority;
+            action.provider.swap(entry.provider);
+            return true;
+        }
+
+        case OBJECT:
+            // End of the minimum interval with a change pending, or a refresh
+            if (!entry.hasValue) continue;
+            fillSend(entry, action, nowMs);
+            return true;
+
+        case FREE:
+            continue;
+        }
+    }
+}
+
+void KNXScheduler::finishCyclic(Action& action, bool sent) {
+    KNXLockGuard guard(lock);
+    if (sent) counters.cyclicSends++;
+    uint16_t index;
+    Entry* entry = lookup(action.handle, index);
+    // Cancelled meanwhile: the provider is destroyed with the action
+    if (!entry || entry->kind != CYCLIC) return;
+    entry->provider.swap(action.provider);
+}
+
+uint32_t KNXScheduler::msUntilNext(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    return wheel.msUntilNext(nowMs);
+}
+
+KNXSchedulerStats KNXScheduler::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
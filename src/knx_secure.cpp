@@ -0,0 +1,526 @@
+//==== src/knx_secure.cpp ====
+
+#include "knx_secure.h"
+
+namespace {
+
+const size_t CCM_PREFIX = 14;     // Sequence or timer, serial number, tag
+const size_t WRAPPER_FIELDS = 22; // Offset of the encrypted frame in a SECURE_WRAPPER
+const size_t HANDSHAKE_DATA = 40; // Associated data of a handshake MAC
+
+void writeSequence(uint8_t* p, uint64_t value) {
+    for (int i = 0; i < 6; i++) p[i] = (uint8_t)(value >> (40 - 8 * i));
+}
+
+uint64_t readSequence(const uint8_t* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 6; i++) value = (value << 8) | p[i];
+    return value;
+}
+
+void writeFields(uint8_t* p, const KNXSecureHeader& header) {
+    writeSequence(p, header.sequence);
+    memcpy(p + 6, header.serial, 6);
+    p[12] = header.tag >> 8;
+    p[13] = header.tag & 0xFF;
+}
+
+// CBC-MAC of the KNX CCM variant: B0 (prefix and payload length), the length
+// of the associated data, the associated data and the payload, zero padded
+// once at the end. The blocks are laid out in one buffer so the AES
+// peripheral gets a single request.
+void ccmMac(const KNXAes128& key, const uint8_t* prefix, const uint8_t* associated,
+            size_t associatedLength, const uint8_t* payload, size_t payloadLength,
+            uint8_t mac[KNX_SECURE_MAC_LENGTH]) {
+    uint8_t blocks[16 + 2 + HANDSHAKE_DATA + KNX_SECURE_FRAME_SIZE + 15];
+    if (prefix) {
+        memcpy(blocks, prefix, CCM_PREFIX);
+    } else {
+        memset(blocks, 0, CCM_PREFIX);
+    }
+    blocks[14] = (uint8_t)(payloadLength >> 8);
+    blocks[15] = (uint8_t)payloadLength;
+    blocks[16] = (uint8_t)(associatedLength >> 8);
+    blocks[17] = (uint8_t)associatedLength;
+    size_t n = 18;
+    memcpy(blocks + n, associated, associatedLength);
+    n += associatedLength;
+    if (payloadLength > 0) memcpy(blocks + n, payload, payloadLength);
+    n += payloadLength;
+    size_t padded = (n + 15) & ~(size_t)15;
+    memset(blocks + n, 0, padded - n);
+
+    memset(mac, 0, KNX_SECURE_MAC_LENGTH);
+    key.cbcMac(mac, blocks, padded / 16);
+}
+
+// Counter mode from the first counter block (prefix, FF 00): its key stream
+// block encrypts the MAC, the following ones the payload
+void ccmCrypt(const KNXAes128& key, const uint8_t* prefix, uint8_t mac[KNX_SECURE_MAC_LENGTH],
+              const uint8_t* in, uint8_t* out, size_t length) {
+    uint8_t counter[16];
+    if (prefix) {
+        memcpy(counter, prefix, CCM_PREFIX);
+    } else {
+        memset(counter, 0, CCM_PREFIX);
+    }
+    counter[14] = 0xFF;
+    counter[15] = 0x00;
+    key.ctr(counter, mac, mac, KNX_SECURE_MAC_LENGTH);
+    if (length > 0) key.ctr(counter, in, out, length);
+}
+
+uint16_t totalLength(const uint8_t* datagram) {
+    return (datagram[4] << 8) | datagram[5];
+}
+
+} // namespace
+
+size_t knxSecureWrap(const KNXAes128& key, const KNXSecureHeader& header, const uint8_t* frame,
+                     size_t length, uint8_t* out, size_t outSize) {
+    size_t total = KNX_SECURE_WRAPPER_OVERHEAD + length;
+    if (length > KNX_SECURE_FRAME_SIZE || total > outSize) return 0;
+
+    knxWriteHeader(out, KNXNETIP_SECURE_WRAPPER, (uint16_t)total);
+    out[6] = header.sessionId >> 8;
+    out[7] = header.sessionId & 0xFF;
+    writeFields(out + 8, header);
+
+    // Associated data: KNXnet/IP header and session id
+    uint8_t mac[KNX_SECURE_MAC_LENGTH];
+    ccmMac(key, out + 8, out, 8, frame, length, mac);
+    ccmCrypt(key, out + 8, mac, frame, out + WRAPPER_FIELDS, length);
+    memcpy(out + WRAPPER_FIELDS + length, mac, sizeof(mac));
+    return total;
+}
+
+bool knxSecureReadHeader(const uint8_t* datagram, size_t length, KNXSecureHeader& header) {
+    uint16_t serviceType = knxServiceType(datagram, length);
+    size_t fields;
+    if (serviceType == KNXNETIP_SECURE_WRAPPER) {
+        if (length < KNX_SECURE_WRAPPER_OVERHEAD) return false;
+        header.sessionId = (datagram[6] << 8) | datagram[7];
+        fields = 8;
+    } else if (serviceType == KNXNETIP_TIMER_NOTIFY) {
+        if (length != KNX_SECURE_TIMER_NOTIFY_LENGTH) return false;
+        header.sessionId = 0;
+        fields = 6;
+    } else {
+        return false;
+    }
+    if (totalLength(datagram) != length) return false;
+    header.sequence = readSequence(datagram + fields);
+    memcpy(header.serial, datagram + fields + 6, 6);
+    header.tag = (datagram[fields + 12] << 8) | datagram[fields + 13];
+    return true;
+}
+
+size_t knxSecureUnwrap(const KNXAes128& key, const uint8_t* datagram, size_t length, uint8_t* out,
+                       size_t outSize, KNXSecureHeader& header) {
+    if (!knxSecureReadHeader(datagram, length, header) ||
+        knxServiceType(datagram, length) != KNXNETIP_SECURE_WRAPPER) {
+        return 0;
+    }
+    size_t plainLength = length - KNX_SECURE_WRAPPER_OVERHEAD;
+    if (plainLength > KNX_SECURE_FRAME_SIZE || plainLength > outSize) return 0;
+
+    uint8_t mac[KNX_SECURE_MAC_LENGTH];
+    memcpy(mac, datagram + length - KNX_SECURE_MAC_LENGTH, sizeof(mac));
+    ccmCrypt(key, datagram + 8, mac, datagram + WRAPPER_FIELDS, out, plainLength);
+
+    uint8_t expected[KNX_SECURE_MAC_LENGTH];
+    ccmMac(key, datagram + 8, datagram, 8, out, plainLength, expected);
+    if (!knxEqualConstantTime(mac, expected, sizeof(mac))) {
+        memset(out, 0, plainLength);
+        return 0;
+    }
+    return plainLength;
+}
+
+size_t knxSecureTimerNotify(const KNXAes128& key, const KNXSecureHeader& header, uint8_t* out) {
+    knxWriteHeader(out, KNXNETIP_TIMER_NOTIFY, KNX_SECURE_TIMER_NOTIFY_LENGTH);
+    writeFields(out + 6, header);
+    uint8_t* mac = out + 6 + CCM_PREFIX;
+    ccmMac(key, out + 6, out, KNXNETIP_HEADER_LENGTH, nullptr, 0, mac);
+    ccmCrypt(key, out + 6, mac, nullptr, nullptr, 0);
+    return KNX_SECURE_TIMER_NOTIFY_LENGTH;
+}
+
+bool knxSecureCheckTimerNotify(const KNXAes128& key, const uint8_t* datagram, size_t length,
+                               KNXSecureHeader& header) {
+    if (!knxSecureReadHeader(datagram, length, header) ||
+        knxServiceType(datagram, length) != KNXNETIP_TIMER_NOTIFY) {
+        return false;
+    }
+    uint8_t expected[KNX_SECURE_MAC_LENGTH];
+    ccmMac(key, datagram + 6, datagram, KNXNETIP_HEADER_LENGTH, nullptr, 0, expected);
+    ccmCrypt(key, datagram + 6, expected, nullptr, nullptr, 0);
+    return knxEqualConstantTime(expected, datagram + 6 + CCM_PREFIX, sizeof(expected));
+}
+
+void knxSecureHandshakeMac(const KNXAes128& key, const uint8_t* associated, size_t length,
+                           uint8_t mac[KNX_SECURE_MAC_LENGTH]) {
+    if (length > HANDSHAKE_DATA) length = HANDSHAKE_DATA;
+    ccmMac(key, nullptr, associated, length, nullptr, 0, mac);
+    ccmCrypt(key, nullptr, mac, nullptr, nullptr, 0);
+}
+
+void knxSecureDeviceAuthenticationCode(const char* password, uint8_t code[16]) {
+    static const char salt[] = "device-authentication-code.1.secure.ip.knx.org";
+    knxPbkdf2Sha256((const uint8_t*)password, strlen(password), (const uint8_t*)salt,
+        sizeof(salt) - 1, 65536, code, 16);
+}
+
+void knxSecureUserPasswordKey(const char* password, uint8_t key[16]) {
+    static const char salt[] = "user-password.1.secure.ip.knx.org";
+    knxPbkdf2Sha256((const uint8_t*)password, strlen(password), (const uint8_t*)salt,
+        sizeof(salt) - 1, 65536, key, 16);
+}
+
+KNXSecureRouting::KNXSecureRouting()
+    : config(), active(false), synced(false), timerBase(0), timerBaseMs(0), lastSent(0),
+      lastNotify(0), notifyDue(false), notifyTag(0), peers(), counters() {}
+
+bool KNXSecureRouting::begin(const KNXSecureRoutingConfig& config, uint32_t nowMs) {
+    end();
+    key.setKey(config.backboneKey);
+    KNXLockGuard guard(lock);
+    this->config = config;
+    synced = false;
+    timerBase = 0;
+    timerBaseMs = nowMs;
+    lastSent = 0;
+    // Announce our timer right away; devices ahead of it answer with theirs
+    notifyDue = true;
+    lastNotify = nowMs - NOTIFY_SPACING_MS;
+    memset(peers, 0, sizeof(peers));
+    counters = KNXSecureStats();
+    active = true;
+    return true;
+}
+
+void KNXSecureRouting::end() {
+    {
+        KNXLockGuard guard(lock);
+        if (!active) return;
+        active = false;
+        memset(peers, 0, sizeof(peers));
+    }
+    key.clear();
+}
+
+uint64_t KNXSecureRouting::advance(uint32_t nowMs) {
+    timerBase += (uint32_t)(nowMs - timerBaseMs);
+    timerBaseMs = nowMs;
+    return timerBase;
+}
+
+void KNXSecureRouting::adopt(uint64_t received, uint32_t nowMs) {
+    if (received > advance(nowMs)) {
+        timerBase = received;
+        counters.timerSyncs++;
+    }
+    synced = true;
+}
+
+uint64_t KNXSecureRouting::timer(uint32_t nowMs) {
+    KNXLockGuard guard(lock);
+    return advance(nowMs);
+}
+
+KNXSecureRouting::Peer* KNXSecureRouting::findPeer(const uint8_t serial[6], bool create, uint32_t nowMs) {
+    // Otherwise a free slot, or the sender heard from least recently
+    Peer* victim = nullptr;
+    for (Peer& peer : peers) {
+        if (peer.used && memcmp(peer.serial, serial, 6) == 0) return &peer;
+        if (!victim || (victim->used && (!peer.used || nowMs - peer.lastSeen > nowMs - victim->lastSeen))) {
+            victim = &peer;
+        }
+    }
+    if (!create) return nullptr;
+    memset(victim, 0, sizeof(Peer));
+    memcpy(victim->serial, serial, 6);
+    victim->used = true;
+    return victim;
+}
+
+size_t KNXSecureRouting::wrap(const uint8_t* frame, size_t length, uint8_t* out, size_t outSize,
+                              uint32_t nowMs) {
+    KNXSecureHeader header = {};
+    {
+        KNXLockGuard guard(lock);
+        if (!active) return 0;
+        uint64_t now = advance(nowMs);
+        if (now <= lastSent) {
+            // Several frames within a millisecond
+            now = lastSent + 1;
+            timerBase = now;
+        }
+        lastSent = now;
+        header.sequence = now;
+    }
+    memcpy(header.serial, config.serialNumber, 6);
+    size_t wrapped = knxSecureWrap(key, header, frame, length, out, outSize);
+
+    KNXLockGuard guard(lock);
+    if (wrapped > 0) {
+        counters.wrapped++;
+    } else {
+        counters.malformed++;
+    }
+    return wrapped;
+}
+
+size_t KNXSecureRouting::unwrap(const uint8_t* datagram, size_t length, uint8_t* out,
+                                size_t outSize, uint32_t nowMs) {
+    KNXSecureHeader header;
+    bool wellFormed = knxSecureReadHeader(datagram, length, header) && header.sessionId == 0 &&
+        length - KNX_SECURE_WRAPPER_OVERHEAD <= outSize &&
+        length - KNX_SECURE_WRAPPER_OVERHEAD <= KNX_SECURE_FRAME_SIZE;
+    size_t plainLength = wellFormed ? knxSecureUnwrap(key, datagram, length, out, outSize, header) : 0;
+
+    KNXLockGuard guard(lock);
+    if (!wellFormed) {
+        counters.malformed++;
+        return 0;
+    }
+    if (plainLength == 0) {
+        counters.authFailures++;
+        return 0;
+    }
+
+    Peer* peer = findPeer(header.serial, false, nowMs);
+    if (peer && (header.sequence < peer->timer ||
+                 (header.sequence == peer->timer && header.tag == peer->tag))) {
+        counters.replayed++;
+        return 0;
+    }
+    if (header.sequence + config.latencyToleranceMs < advance(nowMs)) {
+        // The sender's timer is behind: refuse, and tell it ours
+        counters.outdated++;
+        notifyDue = true;
+        return 0;
+    }
+    adopt(header.sequence, nowMs);
+    peer = findPeer(header.serial, true, nowMs);
+    peer->timer = header.sequence;
+    peer->tag = header.tag;
+    peer->lastSeen = nowMs;
+    counters.unwrapped++;
+    return plainLength;
+}
+
+void KNXSecureRouting::handleTimerNotify(const uint8_t* datagram, size_t length, uint32_t nowMs) {
+    KNXSecureHeader header;
+    bool wellFormed = knxSecureReadHeader(datagram, length, header);
+    bool authentic = wellFormed && knxSecureCheckTimerNotify(key, datagram, length, header);
+
+    KNXLockGuard guard(lock);
+    if (!active) return;
+    if (!wellFormed) {
+        counters.malformed++;
+        return;
+    }
+    if (!authentic) {
+        counters.authFailures++;
+        return;
+    }
+    counters.notifiesReceived++;
+    if (memcmp(header.serial, config.serialNumber, 6) == 0 && header.tag == notifyTag) {
+        return; // Our own, looped back
+    }
+    if (header.sequence + config.latencyToleranceMs < advance(nowMs)) {
+        notifyDue = true;
+        return;
+    }
+    adopt(header.sequence, nowMs);
+}
+
+void KNXSecureRouting::refusePlain() {
+    KNXLockGuard guard(lock);
+    counters.plainDropped++;
+}
+
+size_t KNXSecureRouting::poll(uint8_t* out, size_t outSize, uint32_t nowMs) {
+    if (outSize < KNX_SECURE_TIMER_NOTIFY_LENGTH) return 0;
+    uint8_t tag[2];
+    knxRandomBytes(tag, sizeof(tag));
+
+    KNXSecureHeader header = {};
+    {
+        KNXLockGuard guard(lock);
+        if (!active) return 0;
+        bool periodic = config.notifyIntervalMs > 0 && nowMs - lastNotify >= config.notifyIntervalMs;
+        bool answer = notifyDue && nowMs - lastNotify >= NOTIFY_SPACING_MS;
+        if (!periodic && !answer) return 0;
+        notifyDue = false;
+        lastNotify = nowMs;
+        header.sequence = advance(nowMs);
+        header.tag = notifyTag = (tag[0] << 8) | tag[1];
+        counters.notifiesSent++;
+    }
+    memcpy(header.serial, config.serialNumber, 6);
+    return knxSecureTimerNotify(key, header, out);
+}
+
+KNXSecureStats KNXSecureRouting::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
+
+KNXSecureSession::KNXSecureSession()
+    : config(), active(false), currentState(IDLE), privateKey(), publicKeys(), clientPublic(),
+      sessionId(0), sendSequence(0), receiveSequence(0), lastSent(0), counters() {}
+
+void KNXSecureSession::begin(const KNXSecureTunnelConfig& config) {
+    this->config = config;
+    reset();
+    counters = KNXSecureStats();
+    active = true;
+}
+
+void KNXSecureSession::end() {
+    reset();
+    config = KNXSecureTunnelConfig();
+    active = false;
+}
+
+void KNXSecureSession::reset() {
+    sessionKey.clear();
+    memset(privateKey, 0, sizeof(privateKey));
+    currentState = IDLE;
+    sessionId = 0;
+    sendSequence = 0;
+    receiveSequence = 0;
+}
+
+size_t KNXSecureSession::request(uint8_t* out, const IPAddress& ip, uint16_t port) {
+    reset();
+    knxRandomBytes(privateKey, sizeof(privateKey));
+    knxX25519Base(clientPublic, privateKey);
+
+    size_t length = KNXNETIP_HEADER_LENGTH;
+    length += knxWriteHpai(out + length, ip, port);
+    memcpy(out + length, clientPublic, sizeof(clientPublic));
+    length += sizeof(clientPublic);
+    knxWriteHeader(out, KNXNETIP_SESSION_REQUEST, (uint16_t)length);
+    currentState = REQUESTED;
+    return length;
+}
+
+size_t KNXSecureSession::respond(const uint8_t* data, size_t length, uint8_t* out) {
+    // Header, session id, server public key, MAC
+    if (currentState != REQUESTED || length != 56 || totalLength(data) != length) {
+        counters.malformed++;
+        return 0;
+    }
+    const uint8_t* serverPublic = data + 8;
+    for (size_t i = 0; i < sizeof(publicKeys); i++) publicKeys[i] = clientPublic[i] ^ serverPublic[i];
+
+    // The server proves it knows the device authentication code
+    uint8_t associated[HANDSHAKE_DATA];
+    memcpy(associated, data, 8);
+    memcpy(associated + 8, publicKeys, sizeof(publicKeys));
+    uint8_t mac[KNX_SECURE_MAC_LENGTH];
+    {
+        KNXAes128 deviceKey;
+        deviceKey.setKey(config.deviceAuthenticationCode);
+        knxSecureHandshakeMac(deviceKey, associated, sizeof(associated), mac);
+    }
+    uint8_t secret[32];
+    knxX25519(secret, privateKey, serverPublic);
+    memset(privateKey, 0, sizeof(privateKey));
+    uint8_t nonZero = 0;
+    for (uint8_t b : secret) nonZero |= b;
+    if (!knxEqualConstantTime(mac, data + 40, sizeof(mac)) || nonZero == 0) {
+        counters.authFailures++;
+        counters.sessionFailures++;
+        reset();
+        return 0;
+    }
+
+    // Session key: the first half of SHA-256 over the shared secret
+    uint8_t digest[32];
+    KNXSha256 hash;
+    hash.update(secret, sizeof(secret));
+    hash.finish(digest);
+    sessionKey.setKey(digest);
+    memset(secret, 0, sizeof(secret));
+    memset(digest, 0, sizeof(digest));
+    sessionId = (data[6] << 8) | data[7];
+    sendSequence = 0;
+    receiveSequence = 0;
+    currentState = AUTHENTICATING;
+
+    // SESSION_AUTHENTICATE: reserved, user id, MAC with the user password key
+    knxWriteHeader(out, KNXNETIP_SESSION_AUTHENTICATE, 24);
+    out[6] = 0x00;
+    out[7] = config.userId;
+    memcpy(associated, out, 8);
+    KNXAes128 userKey;
+    userKey.setKey(config.userPasswordKey);
+    knxSecureHandshakeMac(userKey, associated, sizeof(associated), out + 8);
+    return 24;
+}
+
+uint8_t KNXSecureSession::handleStatus(const uint8_t* frame, size_t length) {
+    uint8_t status = length >= 8 ? frame[6] : KNXNETIP_SECURE_UNAUTHENTICATED;
+    if (status == KNXNETIP_SECURE_AUTH_SUCCESS) {
+        if (currentState == AUTHENTICATING) {
+            currentState = ESTABLISHED;
+            counters.sessions++;
+        }
+    } else if (status != KNXNETIP_SECURE_KEEPALIVE) {
+        if (currentState != ESTABLISHED) counters.sessionFailures++;
+        reset();
+    }
+    return status;
+}
+
+size_t KNXSecureSession::buildStatus(uint8_t status, uint8_t* out) {
+    knxWriteHeader(out, KNXNETIP_SESSION_STATUS, 8);
+    out[6] = status;
+    out[7] = 0x00;
+    return 8;
+}
+
+size_t KNXSecureSession::wrap(const uint8_t* frame, size_t length, uint8_t* out, size_t outSize,
+                              uint32_t nowMs) {
+    if (!hasKey()) return 0;
+    KNXSecureHeader header;
+    header.sessionId = sessionId;
+    header.sequence = sendSequence;
+    memcpy(header.serial, config.serialNumber, 6);
+    header.tag = 0;
+    size_t wrapped = knxSecureWrap(sessionKey, header, frame, length, out, outSize);
+    if (wrapped == 0) {
+        counters.malformed++;
+        return 0;
+    }
+    sendSequence++;
+    lastSent = nowMs;
+    counters.wrapped++;
+    return wrapped;
+}
+
+size_t KNXSecureSession::unwrap(const uint8_t* datagram, size_t length, uint8_t* out, size_t outSize) {
+    if (!hasKey()) return 0;
+    KNXSecureHeader header;
+    if (!knxSecureReadHeader(datagram, length, header) || header.sessionId != sessionId ||
+        length - KNX_SECURE_WRAPPER_OVERHEAD > outSize) {
+        counters.malformed++;
+        return 0;
+    }
+    if (header.sequence < receiveSequence) {
+        counters.replayed++;
+        return 0;
+    }
+    size_t plainLength = knxSecureUnwrap(sessionKey, datagram, length, out, outSize, header);
+    if (plainLength == 0) {
+        counters.authFailures++;
+        return 0;
+    }
+    receiveSequence = header.sequence + 1;
+    counters.unwrapped++;
+    return plainLength;
+}
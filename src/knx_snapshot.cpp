@@ -0,0 +1,253 @@
+//==== src/knx_snapshot.cpp ====
+
+#include "knx_snapshot.h"
+
+#if defined(ESP32)
+bool KNXPartitionFlash::find() {
+    if (!partition) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    }
+    return partition != nullptr;
+}
+
+bool KNXPartitionFlash::read(size_t offset, void* data, size_t length) {
+    return find() && esp_partition_read(partition, offset, data, length) == ESP_OK;
+}
+
+bool KNXPartitionFlash::write(size_t offset, const void* data, size_t length) {
+    return find() && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+bool KNXPartitionFlash::erase(size_t offset, size_t length) {
+    return find() && esp_partition_erase_range(partition, offset, length) == ESP_OK;
+}
+#endif
+
+static const uint8_t SNAPSHOT_MAGIC[4] = {'K', 'N', 'X', 'S'};
+
+KNXGroupSnapshot::KNXGroupSnapshot()
+    : store(nullptr), sectorSize(0), sectors(0), sector(0), offset(0), sequence(0),
+      sealed(false), needCheckpoint(true), lastFlush(0), counters() {}
+
+bool KNXGroupSnapshot::begin(KNXFlashStore* store, const KNXSnapshotConfig& config) {
+    end();
+    size_t size = store ? store->size() : 0;
+    size_t sectorSize = store ? store->sectorSize() : 0;
+    if (sectorSize <= HEADER_SIZE || size % sectorSize != 0 || size / sectorSize < 2) return false;
+
+    this->store = store;
+    this->config = config;
+    this->sectorSize = sectorSize;
+    sectors = size / sectorSize;
+    counters = KNXSnapshotStats();
+    counters.sectorSize = sectorSize;
+    counters.sectors = sectors;
+
+    // Continue the sequence of what is in flash, even before restore()
+    sector = sectors - 1;
+    sequence = 0;
+    bool found = false;
+    for (size_t i = 0; i < sectors; i++) {
+        uint32_t candidate;
+        if (!readHeader(i, candidate)) continue;
+        if (!found || (int32_t)(candidate - sequence) > 0) {
+            sector = i;
+            sequence = candidate;
+            found = true;
+        }
+    }
+    offset = sectorSize;
+    sealed = found;
+    needCheckpoint = true;
+    lastFlush = millis();
+    return true;
+}
+
+void KNXGroupSnapshot::end() {
+    store = nullptr;
+}
+
+bool KNXGroupSnapshot::readHeader(size_t index, uint32_t& sequence) {
+    uint8_t header[HEADER_SIZE];
+    if (!store->read(index * sectorSize, header, sizeof(header))) {
+        counters.errors++;
+        return false;
+    }
+    if (memcmp(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header[4] != VERSION ||
+        header[SEAL_OFFSET] != 0x00) {
+        return false; // Erased, another format, or checkpoint not completed
+    }
+    sequence = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+    return true;
+}
+
+size_t KNXGroupSnapshot::restore(const RestoreHandler& handler) {
+    if (!store) return 0;
+    uint32_t start = micros();
+    uint32_t newest;
+    size_t restored = 0;
+    if (!readHeader(sector, newest)) {
+        // Nothing sealed yet
+        needCheckpoint = true;
+        counters.restored = 0;
+        counters.restoreMicros = micros() - start;
+        return 0;
+    }
+
+    size_t base = sector * sectorSize;
+    size_t position = HEADER_SIZE;
+    bool clean = false;
+    while (position + RECORD_HEADER <= sectorSize) {
+        uint8_t record[RECORD_HEADER + KNX_TELEGRAM_MAX_DATA];
+        if (!store->read(base + position, record, RECORD_HEADER)) break;
+        uint8_t length = record[0];
+        if (length == 0xFF) {
+            clean = true; // End of the log
+            break;
+        }
+        if (length == 0 || length > KNX_TELEGRAM_MAX_DATA || position + RECORD_HEADER + length > sectorSize ||
+            !store->read(base + position + RECORD_HEADER, record + RECORD_HEADER, length)) {
+            break;
+        }
+        uint8_t crc = crc8(record, 3);
+        if (crc8(record + RECORD_HEADER, length, crc) != record[3]) break;
+
+        handler((record[1] << 8) | record[2], record + RECORD_HEADER, length);
+        restored++;
+        position += RECORD_HEADER + length;
+    }
+    if (position + RECORD_HEADER > sectorSize) clean = true; // Full sector
+
+    offset = position;
+    // Bytes after a torn record are not erased: continue in a new sector
+    needCheckpoint = !clean;
+    if (!clean) counters.errors++;
+    counters.restored = restored;
+    counters.restoreMicros = micros() - start;
+    return restored;
+}
+
+size_t KNXGroupSnapshot::flush(KNXGroupCache& cache, const Filter& filter, uint32_t nowMs) {
+    if (!store) return 0;
+    lastFlush = nowMs;
+    counters.flushes++;
+    uint32_t recordsBefore = counters.records;
+
+    if (needCheckpoint) {
+        checkpoint(cache, filter);
+        return counters.records - recordsBefore;
+    }
+
+    uint32_t cursor = 0;
+    KNXCachedValue value;
+    // Only the changed values: records of the others are already in the sector
+    while (cache.nextValue(cursor, value, true)) {
+        if (filter && !filter(value.groupAddress)) continue;
+        int written = append(value);
+        if (written < 0) {
+            cache.markChanged(value.groupAddress);
+            break;
+        }
+        if (written == 0) {
+            // Sector full: the checkpoint writes this value and every other
+            // changed one
+            checkpoint(cache, filter);
+            break;
+        }
+    }
+    return counters.records - recordsBefore;
+}
+
+bool KNXGroupSnapshot::checkpoint(KNXGroupCache& cache, const Filter& filter) {
+    // A sector whose checkpoint failed is reused, so the last sealed one
+    // survives until a new one is complete
+    size_t next = sealed ? (sector + 1) % sectors : sector;
+    size_t base = next * sectorSize;
+    if (!store->erase(base, sectorSize)) {
+        counters.errors++;
+        return false;
+    }
+    counters.erases++;
+
+    uint32_t nextSequence = sequence + 1;
+    uint8_t header[HEADER_SIZE];
+    memset(header, 0xFF, sizeof(header));
+    memcpy(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header[4] = VERSION;
+    header[8] = nextSequence & 0xFF;
+    header[9] = (nextSequence >> 8) & 0xFF;
+    header[10] = (nextSequence >> 16) & 0xFF;
+    header[11] = nextSequence >> 24;
+    if (!store->write(base, header, sizeof(header))) {
+        counters.errors++;
+        return false;
+    }
+    counters.bytesWritten += sizeof(header);
+
+    // Not sealed yet: until then, restore uses the previous sector
+    sector = next;
+    sequence = nextSequence;
+    offset = HEADER_SIZE;
+    sealed = false;
+    needCheckpoint = true;
+    counters.checkpoints++;
+
+    uint32_t cursor = 0;
+    KNXCachedValue value;
+    while (cache.nextValue(cursor, value, false)) {
+        if (filter && !filter(value.groupAddress)) continue;
+        int written = append(value);
+        if (written < 0) return false;
+        if (written == 0) counters.skipped++;
+    }
+
+    static const uint8_t seal = 0x00;
+    if (!store->write(base + SEAL_OFFSET, &seal, 1)) {
+        counters.errors++;
+        return false;
+    }
+    counters.bytesWritten++;
+    sealed = true;
+    needCheckpoint = false;
+    return true;
+}
+
+int KNXGroupSnapshot::append(const KNXCachedValue& value) {
+    size_t length = value.length;
+    if (offset + RECORD_HEADER + length > sectorSize) return 0;
+
+    uint8_t record[RECORD_HEADER + KNX_TELEGRAM_MAX_DATA];
+    record[0] = (uint8_t)length;
+    record[1] = value.groupAddress >> 8;
+    record[2] = value.groupAddress & 0xFF;
+    record[3] = crc8(value.data, length, crc8(record, 3));
+    memcpy(record + RECORD_HEADER, value.data, length);
+    if (!store->write(sector * sectorSize + offset, record, RECORD_HEADER + length)) {
+        counters.errors++;
+        // Whatever reached the flash cannot be overwritten
+        needCheckpoint = true;
+        return -1;
+    }
+    offset += RECORD_HEADER + length;
+    counters.records++;
+    counters.bytesWritten += RECORD_HEADER + length;
+    return 1;
+}
+
+uint8_t KNXGroupSnapshot::crc8(const uint8_t* data, size_t length, uint8_t crc) {
+    // CRC-8/ATM (polynomial 0x07)
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+KNXSnapshotStats KNXGroupSnapshot::stats() const {
+    KNXSnapshotStats snapshot = counters;
+    snapshot.sector = sector;
+    snapshot.sectorUsed = offset < sectorSize ? offset : sectorSize;
+    return snapshot;
+}
@@ -0,0 +1,172 @@
+//==== src/knx_stats.cpp ====
+
+#include "knx_stats.h"
+#include <cstdarg>
+
+namespace {
+
+const uint8_t BINARY_VERSION = 2;
+const char* const STAGE_NAMES[KNX_STAGE_COUNT] = {"receive", "parse", "callbacks", "send"};
+
+// Counters in serialization order
+const KNXStatsCollector::Counter COUNTERS[] = {
+    &KNXStats::cyclesPerMicrosecond,
+    &KNXStats::packetsReceived,
+    &KNXStats::packetsInvalid,
+    &KNXStats::unknownServices,
+    &KNXStats::telegramsFiltered,
+    &KNXStats::telegramsParsed,
+    &KNXStats::parseErrors,
+    &KNXStats::telegramsTruncated,
+    &KNXStats::telegramsDispatched,
+    &KNXStats::telegramsSent,
+    &KNXStats::sendFailures,
+};
+const char* const COUNTER_NAMES[] = {
+    "cyclesPerMicrosecond", "packetsReceived", "packetsInvalid", "unknownServices",
+    "telegramsFiltered", "telegramsParsed", "parseErrors", "telegramsTruncated",
+    "telegramsDispatched", "telegramsSent", "sendFailures",
+};
+const size_t COUNTER_COUNT = sizeof(COUNTERS) / sizeof(COUNTERS[0]);
+
+#if KNX_STATS
+size_t bucketOf(uint32_t cycles) {
+    size_t bucket = 0;
+    while (cycles > 1 && bucket < KNXLatencyHistogram::BUCKETS - 1) {
+        cycles >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+#endif
+
+uint8_t* put32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) *out++ = (value >> (8 * i)) & 0xFF;
+    return out;
+}
+
+// snprintf into the remainder of a buffer; false once it no longer fits
+bool append(char* buffer, size_t size, size_t& length, const char* format, ...) {
+    if (length >= size) return false;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer + length, size - length, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= size - length) return false;
+    length += written;
+    return true;
+}
+
+} // namespace
+
+uint32_t KNXLatencyHistogram::percentileCycles(float quantile) const {
+    if (count == 0) return 0;
+    uint32_t rank = (uint32_t)(quantile * count + 0.5f);
+    if (rank == 0) rank = 1;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < BUCKETS - 1; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = (uint32_t)((2ULL << i) - 1);
+            return upper < maxCycles ? upper : maxCycles;
+        }
+    }
+    return maxCycles;
+}
+
+#if KNX_STATS
+void KNXStatsCollector::record(KNXStatsStage stage, uint32_t cycles) {
+    KNXLatencyHistogram& histogram = data.stages[stage];
+    __atomic_fetch_add(&histogram.count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram.totalCycles, (uint64_t)cycles, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram.buckets[bucketOf(cycles)], 1, __ATOMIC_RELAXED);
+    uint32_t seen = __atomic_load_n(&histogram.maxCycles, __ATOMIC_RELAXED);
+    while (cycles > seen && !__atomic_compare_exchange_n(&histogram.maxCycles, &seen, cycles, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+#endif
+
+KNXStats KNXStatsCollector::snapshot() {
+    KNXStats copy;
+    KNXLockGuard guard(lock);
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        copy.*COUNTERS[i] = __atomic_load_n(&(data.*COUNTERS[i]), __ATOMIC_RELAXED);
+    }
+    for (size_t stage = 0; stage < KNX_STAGE_COUNT; stage++) {
+        const KNXLatencyHistogram& from = data.stages[stage];
+        KNXLatencyHistogram& to = copy.stages[stage];
+        to.count = __atomic_load_n(&from.count, __ATOMIC_RELAXED);
+        to.maxCycles = __atomic_load_n(&from.maxCycles, __ATOMIC_RELAXED);
+        to.totalCycles = __atomic_load_n(&from.totalCycles, __ATOMIC_RELAXED);
+        for (size_t i = 0; i < KNXLatencyHistogram::BUCKETS; i++) {
+            to.buckets[i] = __atomic_load_n(&from.buckets[i], __ATOMIC_RELAXED);
+        }
+    }
+    return copy;
+}
+
+void KNXStatsCollector::reset() {
+    KNXLockGuard guard(lock);
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        __atomic_store_n(&(data.*COUNTERS[i]), 0, __ATOMIC_RELAXED);
+    }
+    for (size_t stage = 0; stage < KNX_STAGE_COUNT; stage++) {
+        KNXLatencyHistogram& histogram = data.stages[stage];
+        __atomic_store_n(&histogram.count, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram.maxCycles, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&histogram.totalCycles, 0, __ATOMIC_RELAXED);
+        for (size_t i = 0; i < KNXLatencyHistogram::BUCKETS; i++) {
+            __atomic_store_n(&histogram.buckets[i], 0, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_store_n(&data.cyclesPerMicrosecond, knxCyclesPerMicrosecond(), __ATOMIC_RELAXED);
+}
+
+size_t knxStatsToBinary(const KNXStats& stats, uint8_t* buffer, size_t size) {
+    const size_t histogramSize = 4 + 4 + 8 + 4 * KNXLatencyHistogram::BUCKETS;
+    const size_t length = 8 + 4 * COUNTER_COUNT + KNX_STAGE_COUNT * histogramSize;
+    if (size < length) return 0;
+
+    uint8_t* out = buffer;
+    memcpy(out, "KNXS", 4);
+    out += 4;
+    *out++ = BINARY_VERSION;
+    *out++ = COUNTER_COUNT;
+    *out++ = KNX_STAGE_COUNT;
+    *out++ = KNXLatencyHistogram::BUCKETS;
+
+    for (size_t i = 0; i < COUNTER_COUNT; i++) out = put32(out, stats.*COUNTERS[i]);
+    for (size_t stage = 0; stage < KNX_STAGE_COUNT; stage++) {
+        const KNXLatencyHistogram& histogram = stats.stages[stage];
+        out = put32(out, histogram.count);
+        out = put32(out, histogram.maxCycles);
+        out = put32(out, (uint32_t)histogram.totalCycles);
+        out = put32(out, (uint32_t)(histogram.totalCycles >> 32));
+        for (size_t i = 0; i < KNXLatencyHistogram::BUCKETS; i++) out = put32(out, histogram.buckets[i]);
+    }
+    return length;
+}
+
+size_t knxStatsToJson(const KNXStats& stats, char* buffer, size_t size) {
+    size_t length = 0;
+    bool fits = append(buffer, size, length, "{");
+    for (size_t i = 0; i < COUNTER_COUNT; i++) {
+        fits = fits && append(buffer, size, length, "\"%s\":%lu,",
+                              COUNTER_NAMES[i], (unsigned long)(stats.*COUNTERS[i]));
+    }
+    fits = fits && append(buffer, size, length, "\"stages\":{");
+    for (size_t stage = 0; stage < KNX_STAGE_COUNT; stage++) {
+        const KNXLatencyHistogram& histogram = stats.stages[stage];
+        unsigned long mean = histogram.count ?
+            (unsigned long)(histogram.totalCycles / histogram.count) : 0;
+        fits = fits && append(buffer, size, length,
+            "%s\"%s\":{\"count\":%lu,\"meanCycles\":%lu,\"p50Cycles\":%lu,\"p99Cycles\":%lu,\"maxCycles\":%lu}",
+            stage ? "," : "", STAGE_NAMES[stage], (unsigned long)histogram.count, mean,
+            (unsigned long)histogram.percentileCycles(0.5f),
+            (unsigned long)histogram.percentileCycles(0.99f),
+            (unsigned long)histogram.maxCycles);
+    }
+    fits = fits && append(buffer, size, length, "}}");
+    return fits ? length : 0;
+}
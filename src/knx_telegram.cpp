@@ -0,0 +1,37 @@
+//==== src/knx_telegram.cpp ====
+
+#include "knx_telegram.h"
+#include <stdio.h>
+
+size_t KNXTelegram::toString(char* buffer, size_t size) const {
+    size_t length = 0;
+    // Appends like snprintf, counting what did not fit
+    auto append = [&](int written) {
+        if (written > 0) length += written;
+    };
+    auto rest = [&]() { return length < size ? size - length : 0; };
+    auto end = [&]() { return length < size ? buffer + length : nullptr; };
+
+    append(snprintf(end(), rest(), "src=%d.%d.%d, dst=",
+        (sourceAddress >> 12) & 0x0F, (sourceAddress >> 8) & 0x0F, sourceAddress & 0xFF));
+    if (isGroupAddress) {
+        append(snprintf(end(), rest(), "%d/%d/%d",
+            (targetAddress >> 11) & 0x1F, (targetAddress >> 8) & 0x07, targetAddress & 0xFF));
+    } else {
+        append(snprintf(end(), rest(), "%d.%d.%d",
+            (targetAddress >> 12) & 0x0F, (targetAddress >> 8) & 0x0F, targetAddress & 0xFF));
+    }
+    append(snprintf(end(), rest(), ", cmd=0x%02X, data=", command));
+    for (size_t i = 0; i < data.size(); i++) {
+        append(snprintf(end(), rest(), i ? " %02X" : "%02X", data[i]));
+    }
+    return length;
+}
+
+#if !KNX_STATIC_ALLOCATION
+String KNXTelegram::toString() const {
+    char text[32 + 3 * KNX_TELEGRAM_MAX_DATA];
+    toString(text, sizeof(text));
+    return String(text);
+}
+#endif
@@ -0,0 +1,155 @@
+//==== src/knx_trace.cpp ====
+
+#include "knx_trace.h"
+#include "knx_memory.h"
+
+KNXTraceBuffer::KNXTraceBuffer()
+    : records(nullptr), capacity(0), head(0), count(0), lastOverflows(0), counters() {}
+
+KNXTraceBuffer::~KNXTraceBuffer() {
+    end();
+}
+
+bool KNXTraceBuffer::begin(size_t capacity) {
+    end();
+    if (capacity == 0) capacity = 1;
+    KNXTraceRecord* allocated = knxNewArray<KNXTraceRecord>(capacity);
+    if (!allocated) return false;
+
+    KNXLockGuard guard(lock);
+    records = allocated;
+    this->capacity = capacity;
+    head = 0;
+    count = 0;
+    lastOverflows = 0;
+    counters = KNXTraceStats();
+    counters.capacity = capacity;
+    return true;
+}
+
+void KNXTraceBuffer::end() {
+    KNXTraceRecord* released;
+    {
+        KNXLockGuard guard(lock);
+        released = records;
+        records = nullptr;
+        capacity = 0;
+        count = 0;
+    }
+    knxDeleteArray(released);
+}
+
+void KNXTraceBuffer::push(const KNXTraceRecord& record) {
+    KNXLockGuard guard(lock);
+    if (!records) return;
+    if (count == capacity) {
+        counters.overflows++;
+        return;
+    }
+    uint32_t index = head + count;
+    if (index >= capacity) index -= capacity;
+    records[index] = record;
+    count++;
+    counters.recorded++;
+}
+
+void KNXTraceBuffer::recordDatagram(const uint8_t* data, size_t length) {
+    KNXTraceRecord record;
+    record.timestamp = micros();
+    record.serviceType = length >= 4 ? (data[2] << 8) | data[3] : 0;
+    record.sourceAddress = 0;
+    record.targetAddress = 0;
+    record.length = (uint16_t)length;
+    record.kind = KNX_TRACE_RX_DATAGRAM;
+    record.command = 0;
+    record.isGroupAddress = 0;
+    record.captured = (uint8_t)(length < KNX_TRACE_DATA ? length : KNX_TRACE_DATA);
+    memcpy(record.data, data, record.captured);
+    push(record);
+}
+
+void KNXTraceBuffer::recordTelegram(const KNXTelegram& telegram, uint16_t serviceType, bool outgoing) {
+    KNXTraceRecord record;
+    record.timestamp = micros();
+    record.serviceType = serviceType;
+    record.sourceAddress = telegram.sourceAddress;
+    record.targetAddress = telegram.targetAddress;
+    record.length = (uint16_t)telegram.data.size();
+    record.kind = outgoing ? KNX_TRACE_TX_TELEGRAM : KNX_TRACE_RX_TELEGRAM;
+    record.command = telegram.command;
+    record.isGroupAddress = telegram.isGroupAddress;
+    record.captured = (uint8_t)(telegram.data.size() < KNX_TRACE_DATA ? telegram.data.size() : KNX_TRACE_DATA);
+    memcpy(record.data, telegram.data.data(), record.captured);
+    push(record);
+}
+
+bool KNXTraceBuffer::pop(KNXTraceRecord& record) {
+    KNXLockGuard guard(lock);
+    if (!records || count == 0) return false;
+    record = records[head];
+    if (++head == capacity) head = 0;
+    count--;
+    return true;
+}
+
+size_t KNXTraceBuffer::drain(Print& output, size_t maxRecords) {
+    size_t printed = 0;
+    KNXTraceRecord record;
+    while (printed < maxRecords && pop(record)) {
+        format(record, output);
+        printed++;
+    }
+
+    // Report losses once, after the records that made it; the trace task and
+    // dumpTrace() may drain at the same time, so the count is claimed under
+    // the lock
+    uint32_t lost;
+    {
+        KNXLockGuard guard(lock);
+        lost = counters.overflows - lastOverflows;
+        lastOverflows = counters.overflows;
+    }
+    if (lost != 0) {
+        output.printf("!!! KNX trace: %u records lost\n", (unsigned)lost);
+    }
+    return printed;
+}
+
+void KNXTraceBuffer::format(const KNXTraceRecord& record, Print& output) {
+    output.printf("[%10.6f] ", record.timestamp / 1000000.0);
+
+    if (record.kind == KNX_TRACE_RX_DATAGRAM) {
+        output.printf("<<< UDP service 0x%04X, %u bytes:", record.serviceType, record.length);
+    } else {
+        output.print(record.kind == KNX_TRACE_TX_TELEGRAM ? ">>> " : "<<< ");
+        output.printf("KNX telegram: src=%d.%d.%d, dst=",
+            (record.sourceAddress >> 12) & 0x0F,
+            (record.sourceAddress >> 8) & 0x0F,
+            record.sourceAddress & 0xFF);
+        if (record.isGroupAddress) {
+            output.printf("%d/%d/%d",
+                (record.targetAddress >> 11) & 0x1F,
+                (record.targetAddress >> 8) & 0x07,
+                record.targetAddress & 0xFF);
+        } else {
+            output.printf("%d.%d.%d",
+                (record.targetAddress >> 12) & 0x0F,
+                (record.targetAddress >> 8) & 0x0F,
+                record.targetAddress & 0xFF);
+        }
+        output.printf(", cmd=0x%02X, data=", record.command);
+    }
+
+    for (uint8_t i = 0; i < record.captured; i++) {
+        output.printf(" %02X", record.data[i]);
+    }
+    if (record.captured < record.length) output.print(" ...");
+    output.println();
+}
+
+KNXTraceStats KNXTraceBuffer::stats() {
+    KNXLockGuard guard(lock);
+    KNXTraceStats result = counters;
+    result.depth = count;
+    return result;
+}
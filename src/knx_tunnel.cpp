@@ -0,0 +1,572 @@
+//==== src/knx_tunnel.cpp ====
+
+#include "knx_tunnel.h"
+#include <WiFi.h>
+
+namespace {
+
+// Time left until `since + periodMs`, 0 once it passed
+uint32_t remaining(uint32_t nowMs, uint32_t since, uint32_t periodMs) {
+    uint32_t elapsed = nowMs - since;
+    return elapsed >= periodMs ? 0 : periodMs - elapsed;
+}
+
+} // namespace
+
+KNXTunnelClient::KNXTunnelClient()
+    : udp(nullptr), debugLevel(1), controlPort(KNX_PORT), dataPort(KNX_PORT),
+      currentState(KNX_TUNNEL_DISCONNECTED), channelId(0), assignedAddress(0),
+      sendSequence(0), receiveSequence(0), stateSince(0), lastHeartbeat(0),
+      heartbeatPending(false), heartbeatFailures(0), backlogCount(0), started(false),
+      counters() {}
+
+void KNXTunnelClient::begin(AsyncUDP* udp, const IPAddress& gatewayIP, uint16_t gatewayPort,
+                            const KNXTunnelConfig& config) {
+    KNXMutexGuard guard(mutex);
+    this->udp = udp;
+    this->config = config;
+    if (this->config.window == 0) this->config.window = 1;
+    controlIP = gatewayIP;
+    controlPort = gatewayPort;
+    dataIP = gatewayIP;
+    dataPort = gatewayPort;
+    started = true;
+}
+
+void KNXTunnelClient::setConfig(const KNXTunnelConfig& config) {
+    KNXMutexGuard guard(mutex);
+    this->config = config;
+    if (this->config.window == 0) this->config.window = 1;
+}
+
+void KNXTunnelClient::enableSecure(const KNXSecureTunnelConfig& config) {
+    KNXMutexGuard guard(mutex);
+    session.begin(config);
+}
+
+void KNXTunnelClient::disableSecure() {
+    KNXMutexGuard guard(mutex);
+    session.end();
+}
+
+KNXSecureStats KNXTunnelClient::secureStats() {
+    KNXMutexGuard guard(mutex);
+    return session.stats();
+}
+
+void KNXTunnelClient::enterState(KNXTunnelState state, uint32_t nowMs) {
+    if (state == KNX_TUNNEL_DISCONNECTED && session.hasKey()) {
+        // The secure session ends with the connection
+        uint8_t buffer[8];
+        sendToControl(buffer, session.buildStatus(KNXNETIP_SECURE_CLOSE, buffer));
+        session.reset();
+    }
+    currentState = state;
+    stateSince = nowMs;
+}
+
+bool KNXTunnelClient::connect() {
+    KNXMutexGuard guard(mutex);
+    if (!udp || currentState == KNX_TUNNEL_CONNECTED || currentState == KNX_TUNNEL_CONNECTING) {
+        return currentState != KNX_TUNNEL_DISCONNECTING && udp != nullptr;
+    }
+    started = true;
+
+    startConnect(millis());
+    if (debugLevel > 0) {
+        Serial.print("KNX tunnel: connecting to ");
+        Serial.println(controlIP);
+    }
+    return true;
+}
+
+void KNXTunnelClient::startConnect(uint32_t nowMs) {
+    uint8_t buffer[64];
+    enterState(KNX_TUNNEL_CONNECTING, nowMs);
+    if (session.isActive()) {
+        // A fresh secure session first; the CONNECT_REQUEST follows once it
+        // is authenticated
+        IPAddress localIP = config.routeBack ? IPAddress() : localEndpointIP();
+        uint16_t localPort = config.routeBack ? 0 : config.localPort;
+        sendToControl(buffer, session.request(buffer, localIP, localPort));
+        return;
+    }
+    sendToControl(buffer, buildConnectRequest(buffer));
+}
+
+void KNXTunnelClient::disconnect() {
+    KNXMutexGuard guard(mutex);
+    started = false;
+    if (currentState == KNX_TUNNEL_CONNECTED) {
+        uint8_t buffer[16];
+        size_t length = buildControlRequest(buffer, KNXNETIP_DISCONNECT_REQUEST);
+        sendToControl(buffer, length);
+        enterState(KNX_TUNNEL_DISCONNECTING, millis());
+    } else {
+        enterState(KNX_TUNNEL_DISCONNECTED, millis());
+    }
+}
+
+bool KNXTunnelClient::send(const uint8_t* cemi, size_t length) {
+    KNXMutexGuard guard(mutex);
+    bool acceptable = currentState == KNX_TUNNEL_CONNECTED || currentState == KNX_TUNNEL_CONNECTING ||
+        (currentState == KNX_TUNNEL_DISCONNECTED && started && config.reconnectDelayMs > 0);
+    if (!acceptable || length > KNX_TUNNEL_FRAME_SIZE || backlogCount >= KNX_TUNNEL_BACKLOG) {
+        counters.rejected++;
+        return false;
+    }
+
+    Request& request = backlog[backlogCount++];
+    memcpy(request.cemi, cemi, length);
+    request.length = (uint16_t)length;
+    request.inFlight = false;
+    request.attempts = 0;
+
+    sendPending(millis());
+    return true;
+}
+
+bool KNXTunnelClient::canSend() {
+    KNXMutexGuard guard(mutex);
+    return currentState == KNX_TUNNEL_CONNECTED && backlogCount < KNX_TUNNEL_BACKLOG;
+}
+
+void KNXTunnelClient::sendPending(uint32_t nowMs) {
+    if (currentState != KNX_TUNNEL_CONNECTED) return;
+
+    uint8_t buffer[KNX_TUNNEL_FRAME_SIZE + 10];
+    for (uint8_t i = 0; i < backlogCount && i < config.window; i++) {
+        Request& request = backlog[i];
+        if (request.inFlight) continue;
+        // Sliding window: never run more than `window` sequence numbers ahead
+        // of the oldest unacknowledged request, so repeats stay recognisable
+        if (backlog[0].inFlight && (uint8_t)(sendSequence - backlog[0].sequence) >= config.window) break;
+        request.sequence = sendSequence++;
+        request.inFlight = true;
+        request.attempts = 1;
+        request.sentAt = nowMs;
+        size_t length = buildTunnelingRequest(buffer, request);
+        sendToData(buffer, length);
+    }
+}
+
+void KNXTunnelClient::removeRequest(uint8_t index) {
+    for (uint8_t i = index; i + 1 < backlogCount; i++) {
+        backlog[i] = backlog[i + 1];
+    }
+    backlogCount--;
+}
+
+bool KNXTunnelClient::handlePacket(uint8_t* data, size_t length, const IPAddress& remoteIP,
+                                   const FrameHandler& onFrame) {
+    uint16_t serviceType = knxServiceType(data, length);
+    if (serviceType == 0) return false;
+    if (remoteIP != controlIP && remoteIP != dataIP) return false;
+
+    uint8_t plain[KNX_SECURE_FRAME_SIZE];
+    bool deliver = false;
+    bool handled;
+    {
+        KNXMutexGuard guard(mutex);
+        uint32_t now = millis();
+        if (session.isActive()) {
+            if (serviceType != KNXNETIP_SECURE_WRAPPER) {
+                return processSession(serviceType, data, length, now);
+            }
+            length = session.unwrap(data, length, plain, sizeof(plain));
+            if (length == 0) return true;
+            data = plain;
+            serviceType = knxServiceType(data, length);
+            if (serviceType == KNXNETIP_SESSION_STATUS) {
+                return processSession(serviceType, data, length, now);
+            }
+        }
+        handled = processService(serviceType, data, length, now, deliver);
+    }
+
+    // Deliver inbound frames without holding the mutex, callbacks may send
+    if (deliver && length > 10) {
+        onFrame(data + 10, length - 10);
+    }
+    return handled;
+}
+
+bool KNXTunnelClient::processSession(uint16_t serviceType, const uint8_t* data, size_t length,
+                                     uint32_t now) {
+    switch (serviceType) {
+    case KNXNETIP_SESSION_RESPONSE: {
+        if (currentState != KNX_TUNNEL_CONNECTING || session.state() != KNXSecureSession::REQUESTED) {
+            return true;
+        }
+        uint8_t buffer[32];
+        size_t authenticate = session.respond(data, length, buffer);
+        if (authenticate == 0) {
+            if (debugLevel > 0) {
+                Serial.println("KNX tunnel: secure session response not authentic");
+            }
+            enterState(KNX_TUNNEL_DISCONNECTED, now);
+            return true;
+        }
+        // Wrapped with the session key just agreed
+        sendToControl(buffer, authenticate);
+        return true;
+    }
+
+    case KNXNETIP_SESSION_STATUS: {
+        bool authenticating = session.state() == KNXSecureSession::AUTHENTICATING;
+        uint8_t status = session.handleStatus(data, length);
+        if (status == KNXNETIP_SECURE_AUTH_SUCCESS) {
+            if (authenticating && currentState == KNX_TUNNEL_CONNECTING) {
+                uint8_t buffer[32];
+                sendToControl(buffer, buildConnectRequest(buffer));
+            }
+        } else if (status != KNXNETIP_SECURE_KEEPALIVE) {
+            // Authentication refused, or the server closed the session
+            if (debugLevel > 0) {
+                Serial.printf("KNX tunnel: secure session ended (status %u)\n", status);
+            }
+            if (currentState == KNX_TUNNEL_CONNECTED) counters.disconnects++;
+            for (uint8_t i = 0; i < backlogCount; i++) backlog[i].inFlight = false;
+            enterState(KNX_TUNNEL_DISCONNECTED, now);
+        }
+        return true;
+    }
+
+    case KNXNETIP_CONNECT_RESPONSE:
+    case KNXNETIP_CONNECTIONSTATE_RESPONSE:
+    case KNXNETIP_DISCONNECT_REQUEST:
+    case KNXNETIP_DISCONNECT_RESPONSE:
+    case KNXNETIP_TUNNELING_REQUEST:
+    case KNXNETIP_TUNNELING_ACK:
+        session.countPlainDropped();
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool KNXTunnelClient::processService(uint16_t serviceType, const uint8_t* data, size_t length,
+                                     uint32_t now, bool& deliver) {
+    switch (serviceType) {
+    case KNXNETIP_CONNECT_RESPONSE: {
+        if (currentState != KNX_TUNNEL_CONNECTING || length < 8) return true;
+        uint8_t status = data[7];
+        if (status != KNXNETIP_E_NO_ERROR) {
+            if (debugLevel > 0) {
+                Serial.printf("KNX tunnel: connect refused (status 0x%02X)\n", status);
+            }
+            enterState(KNX_TUNNEL_DISCONNECTED, now);
+            return true;
+        }
+
+        channelId = data[6];
+        IPAddress ip;
+        uint16_t port;
+        if (!config.routeBack && knxReadHpai(data + 8, length - 8, ip, port) &&
+            ip != IPAddress() && port != 0) {
+            dataIP = ip;
+            dataPort = port;
+        } else {
+            dataIP = controlIP;
+            dataPort = controlPort;
+        }
+        // Connection response data block: length, type, individual address
+        if (length >= 20 && data[16] == 0x04 && data[17] == KNXNETIP_TUNNEL_CONNECTION) {
+            assignedAddress = (data[18] << 8) | data[19];
+        }
+
+        sendSequence = 0;
+        receiveSequence = 0;
+        heartbeatPending = false;
+        heartbeatFailures = 0;
+        lastHeartbeat = now;
+        for (uint8_t i = 0; i < backlogCount; i++) backlog[i].inFlight = false;
+        enterState(KNX_TUNNEL_CONNECTED, now);
+        counters.connects++;
+
+        if (debugLevel > 0) {
+            Serial.printf("KNX tunnel: connected, channel %u, address %u.%u.%u\n", channelId,
+                (assignedAddress >> 12) & 0x0F, (assignedAddress >> 8) & 0x0F, assignedAddress & 0xFF);
+        }
+        sendPending(now);
+        return true;
+    }
+
+    case KNXNETIP_CONNECTIONSTATE_RESPONSE:
+        if (length < 8 || data[6] != channelId || currentState != KNX_TUNNEL_CONNECTED) return true;
+        heartbeatPending = false;
+        if (data[7] == KNXNETIP_E_NO_ERROR) {
+            heartbeatFailures = 0;
+        } else {
+            connectionLost(now, "connection state error");
+        }
+        return true;
+
+    case KNXNETIP_DISCONNECT_REQUEST: {
+        if (length < 8 || data[6] != channelId) return true;
+        uint8_t response[8];
+        knxWriteHeader(response, KNXNETIP_DISCONNECT_RESPONSE, sizeof(response));
+        response[6] = channelId;
+        response[7] = KNXNETIP_E_NO_ERROR;
+        sendToControl(response, sizeof(response));
+        if (currentState == KNX_TUNNEL_CONNECTED) counters.disconnects++;
+        for (uint8_t i = 0; i < backlogCount; i++) backlog[i].inFlight = false;
+        enterState(KNX_TUNNEL_DISCONNECTED, now);
+        if (debugLevel > 0) {
+            Serial.println("KNX tunnel: disconnected by gateway");
+        }
+        return true;
+    }
+
+    case KNXNETIP_DISCONNECT_RESPONSE:
+        if (currentState == KNX_TUNNEL_DISCONNECTING) {
+            counters.disconnects++;
+            enterState(KNX_TUNNEL_DISCONNECTED, now);
+        }
+        return true;
+
+    case KNXNETIP_TUNNELING_ACK: {
+        if (length < 10 || data[7] != channelId || currentState != KNX_TUNNEL_CONNECTED) return true;
+        uint8_t sequence = data[8];
+        uint8_t status = data[9];
+        for (uint8_t i = 0; i < backlogCount; i++) {
+            Request& request = backlog[i];
+            if (!request.inFlight || request.sequence != sequence) continue;
+            // A negative ACK leaves the request to the retransmit timer
+            if (status == KNXNETIP_E_NO_ERROR) {
+                removeRequest(i);
+                counters.sent++;
+                sendPending(now);
+            }
+            break;
+        }
+        return true;
+    }
+
+    case KNXNETIP_TUNNELING_REQUEST: {
+        if (length < 10 || data[7] != channelId || currentState != KNX_TUNNEL_CONNECTED) return true;
+        uint8_t sequence = data[8];
+        if (sequence == receiveSequence) {
+            sendAck(sequence, KNXNETIP_E_NO_ERROR);
+            receiveSequence++;
+            counters.received++;
+            deliver = true;
+        } else if (sequence == (uint8_t)(receiveSequence - 1)) {
+            // Our ACK got lost: confirm again but do not deliver twice
+            sendAck(sequence, KNXNETIP_E_NO_ERROR);
+            counters.duplicates++;
+            return true;
+        } else {
+            counters.outOfSequence++;
+        }
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+void KNXTunnelClient::poll(uint32_t nowMs) {
+    KNXMutexGuard guard(mutex);
+
+    switch (currentState) {
+    case KNX_TUNNEL_CONNECTING:
+        if (nowMs - stateSince >= config.connectTimeoutMs) {
+            if (debugLevel > 0) {
+                Serial.println("KNX tunnel: no connect response");
+            }
+            if (session.isActive() && !session.established()) session.countFailure();
+            enterState(KNX_TUNNEL_DISCONNECTED, nowMs);
+        }
+        break;
+
+    case KNX_TUNNEL_DISCONNECTING:
+        if (nowMs - stateSince >= config.connectTimeoutMs) {
+            counters.disconnects++;
+            enterState(KNX_TUNNEL_DISCONNECTED, nowMs);
+        }
+        break;
+
+    case KNX_TUNNEL_DISCONNECTED:
+        if (started && udp && config.reconnectDelayMs > 0 &&
+            nowMs - stateSince >= config.reconnectDelayMs) {
+            startConnect(nowMs);
+        }
+        break;
+
+    case KNX_TUNNEL_CONNECTED: {
+        // Heartbeat
+        if (heartbeatPending) {
+            if (nowMs - lastHeartbeat >= config.heartbeatTimeoutMs) {
+                heartbeatPending = false;
+                counters.heartbeatFailures++;
+                if (++heartbeatFailures >= config.heartbeatRetries) {
+                    connectionLost(nowMs, "heartbeat timeout");
+                    return;
+                }
+                // Retry right away
+                lastHeartbeat = nowMs - config.heartbeatIntervalMs;
+            }
+        }
+        if (!heartbeatPending && nowMs - lastHeartbeat >= config.heartbeatIntervalMs) {
+            uint8_t buffer[16];
+            size_t length = buildControlRequest(buffer, KNXNETIP_CONNECTIONSTATE_REQUEST);
+            sendToControl(buffer, length);
+            heartbeatPending = true;
+            lastHeartbeat = nowMs;
+        }
+        if (session.keepaliveDue(nowMs)) {
+            uint8_t buffer[8];
+            sendToControl(buffer, session.buildStatus(KNXNETIP_SECURE_KEEPALIVE, buffer));
+        }
+
+        // Retransmit unacknowledged requests
+        uint8_t buffer[KNX_TUNNEL_FRAME_SIZE + 10];
+        for (uint8_t i = 0; i < backlogCount; i++) {
+            Request& request = backlog[i];
+            if (!request.inFlight || nowMs - request.sentAt < config.ackTimeoutMs) continue;
+            if (request.attempts > config.maxRetransmits) {
+                counters.ackTimeouts++;
+                removeRequest(i);
+                connectionLost(nowMs, "no tunnelling ACK");
+                return;
+            }
+            request.attempts++;
+            request.sentAt = nowMs;
+            counters.retransmits++;
+            size_t length = buildTunnelingRequest(buffer, request);
+            sendToData(buffer, length);
+        }
+        break;
+    }
+    }
+}
+
+uint32_t KNXTunnelClient::msUntilDue(uint32_t nowMs) {
+    KNXMutexGuard guard(mutex);
+
+    switch (currentState) {
+    case KNX_TUNNEL_CONNECTING:
+    case KNX_TUNNEL_DISCONNECTING:
+        return remaining(nowMs, stateSince, config.connectTimeoutMs);
+
+    case KNX_TUNNEL_DISCONNECTED:
+        if (!started || !udp || config.reconnectDelayMs == 0) return UINT32_MAX;
+        return remaining(nowMs, stateSince, config.reconnectDelayMs);
+
+    case KNX_TUNNEL_CONNECTED: {
+        uint32_t wait = remaining(nowMs, lastHeartbeat,
+            heartbeatPending ? config.heartbeatTimeoutMs : config.heartbeatIntervalMs);
+        uint32_t keepalive = session.msUntilKeepalive(nowMs);
+        if (keepalive < wait) wait = keepalive;
+        for (uint8_t i = 0; i < backlogCount; i++) {
+            if (!backlog[i].inFlight) continue;
+            uint32_t ack = remaining(nowMs, backlog[i].sentAt, config.ackTimeoutMs);
+            if (ack < wait) wait = ack;
+        }
+        return wait;
+    }
+    }
+    return UINT32_MAX;
+}
+
+void KNXTunnelClient::connectionLost(uint32_t nowMs, const char* reason) {
+    if (debugLevel > 0) {
+        Serial.print("KNX tunnel: connection lost, ");
+        Serial.println(reason);
+    }
+    uint8_t buffer[16];
+    size_t length = buildControlRequest(buffer, KNXNETIP_DISCONNECT_REQUEST);
+    sendToControl(buffer, length);
+
+    // Unacknowledged frames are sent again on the next connection
+    for (uint8_t i = 0; i < backlogCount; i++) backlog[i].inFlight = false;
+    counters.disconnects++;
+    enterState(KNX_TUNNEL_DISCONNECTED, nowMs);
+}
+
+KNXTunnelStats KNXTunnelClient::stats() {
+    KNXMutexGuard guard(mutex);
+    KNXTunnelStats result = counters;
+    result.state = currentState;
+    result.channelId = channelId;
+    result.tunnelAddress = assignedAddress;
+    result.backlog = backlogCount;
+    result.inFlight = 0;
+    for (uint8_t i = 0; i < backlogCount; i++) {
+        if (backlog[i].inFlight) result.inFlight++;
+    }
+    return result;
+}
+
+IPAddress KNXTunnelClient::localEndpointIP() const {
+    return config.localIP != IPAddress() ? config.localIP : WiFi.localIP();
+}
+
+size_t KNXTunnelClient::buildConnectRequest(uint8_t* buffer) {
+    IPAddress localIP = config.routeBack ? IPAddress() : localEndpointIP();
+    uint16_t localPort = config.routeBack ? 0 : config.localPort;
+    size_t length = KNXNETIP_HEADER_LENGTH;
+    length += knxWriteHpai(buffer + length, localIP, localPort); // Control endpoint
+    length += knxWriteHpai(buffer + length, localIP, localPort); // Data endpoint
+    buffer[length++] = 0x04;                                     // CRI length
+    buffer[length++] = KNXNETIP_TUNNEL_CONNECTION;
+    buffer[length++] = KNXNETIP_TUNNEL_LINKLAYER;
+    buffer[length++] = 0x00;
+    knxWriteHeader(buffer, KNXNETIP_CONNECT_REQUEST, length);
+    return length;
+}
+
+size_t KNXTunnelClient::buildControlRequest(uint8_t* buffer, uint16_t serviceType) {
+    IPAddress localIP = config.routeBack ? IPAddress() : localEndpointIP();
+    uint16_t localPort = config.routeBack ? 0 : config.localPort;
+    size_t length = KNXNETIP_HEADER_LENGTH;
+    buffer[length++] = channelId;
+    buffer[length++] = 0x00;
+    length += knxWriteHpai(buffer + length, localIP, localPort);
+    knxWriteHeader(buffer, serviceType, length);
+    return length;
+}
+
+size_t KNXTunnelClient::buildTunnelingRequest(uint8_t* buffer, const Request& request) {
+    size_t length = KNXNETIP_HEADER_LENGTH;
+    buffer[length++] = 0x04; // Connection header length
+    buffer[length++] = channelId;
+    buffer[length++] = request.sequence;
+    buffer[length++] = 0x00;
+    memcpy(buffer + length, request.cemi, request.length);
+    length += request.length;
+    knxWriteHeader(buffer, KNXNETIP_TUNNELING_REQUEST, length);
+    return length;
+}
+
+void KNXTunnelClient::sendAck(uint8_t sequence, uint8_t status) {
+    uint8_t buffer[10];
+    knxWriteHeader(buffer, KNXNETIP_TUNNELING_ACK, sizeof(buffer));
+    buffer[6] = 0x04;
+    buffer[7] = channelId;
+    buffer[8] = sequence;
+    buffer[9] = status;
+    sendToData(buffer, sizeof(buffer));
+}
+
+void KNXTunnelClient::sendToControl(const uint8_t* buffer, size_t length) {
+    transmit(buffer, length, controlIP, controlPort);
+}
+
+void KNXTunnelClient::sendToData(const uint8_t* buffer, size_t length) {
+    transmit(buffer, length, dataIP, dataPort);
+}
+
+void KNXTunnelClient::transmit(const uint8_t* buffer, size_t length, const IPAddress& ip, uint16_t port) {
+    uint8_t wrapped[KNX_SECURE_WRAPPER_OVERHEAD + KNXNETIP_HEADER_LENGTH + 4 + KNX_TUNNEL_FRAME_SIZE];
+    if (session.hasKey()) {
+        length = session.wrap(buffer, length, wrapped, sizeof(wrapped), millis());
+        if (length == 0) return;
+        buffer = wrapped;
+    }
+    if (tap) tap(buffer, length, ip, port);
+    if (udp) udp->writeTo(buffer, length, ip, port);
+}
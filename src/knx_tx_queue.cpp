@@ -0,0 +1,217 @@
+//==== src/knx_tx_queue.cpp ====
+
+#include "knx_tx_queue.h"
+#include "knx_memory.h"
+
+KNXTxQueue::KNXTxQueue()
+    : entries(nullptr), next(nullptr), freeList(NONE),
+      costMicros(0), creditMicros(0), lastRefill(0), counters() {
+    memset(first, NONE, sizeof(first));
+    memset(last, NONE, sizeof(last));
+}
+
+KNXTxQueue::~KNXTxQueue() {
+    end();
+}
+
+bool KNXTxQueue::begin(const KNXTxQueueConfig& config) {
+    end();
+
+    KNXTxQueueConfig settings = config;
+    if (settings.capacity == 0) settings.capacity = 1;
+    if (settings.capacity > 254) settings.capacity = 254; // Indices are 8-bit
+    if (settings.telegramsPerSecond == 0) settings.telegramsPerSecond = 1;
+    if (settings.burst == 0) settings.burst = 1;
+
+    Entry* createdEntries = knxNewArray<Entry>(settings.capacity);
+    uint8_t* createdNext = knxNewArray<uint8_t>(settings.capacity);
+    if (!createdEntries || !createdNext) {
+        knxDeleteArray(createdEntries);
+        knxDeleteArray(createdNext);
+        return false;
+    }
+    // Chain all entries into the free list
+    for (size_t i = 0; i < settings.capacity; i++) {
+        createdNext[i] = (i + 1 < settings.capacity) ? (uint8_t)(i + 1) : NONE;
+    }
+
+    Entry* previousEntries;
+    uint8_t* previousNext;
+    {
+        KNXLockGuard guard(lock);
+        this->config = settings;
+        previousEntries = entries;
+        previousNext = next;
+        entries = createdEntries;
+        next = createdNext;
+        freeList = 0;
+        memset(first, NONE, sizeof(first));
+        memset(last, NONE, sizeof(last));
+
+        costMicros = 1000000UL / settings.telegramsPerSecond;
+        creditMicros = costMicros * settings.burst;
+        lastRefill = micros();
+
+        counters = KNXTxQueueStats();
+        counters.capacity = settings.capacity;
+    }
+    knxDeleteArray(previousEntries);
+    knxDeleteArray(previousNext);
+    return true;
+}
+
+void KNXTxQueue::end() {
+    Entry* previousEntries;
+    uint8_t* previousNext;
+    {
+        KNXLockGuard guard(lock);
+        previousEntries = entries;
+        previousNext = next;
+        entries = nullptr;
+        next = nullptr;
+        freeList = NONE;
+    }
+    knxDeleteArray(previousEntries);
+    knxDeleteArray(previousNext);
+}
+
+uint8_t KNXTxQueue::rankOf(KNXPriority priority) {
+    // Bus arbitration order: system, urgent, normal, low
+    static const uint8_t ranks[] = {0, 2, 1, 3};
+    return ranks[priority & 0x03];
+}
+
+bool KNXTxQueue::isWrite(const uint8_t* data, size_t length) {
+    // The APCI octet leads the data; group services keep the TPCI's APCI bits 0
+    return length > 0 && (data[0] & 0xC0) == 0x80;
+}
+
+uint8_t KNXTxQueue::findPendingWrite(uint16_t groupAddress, uint8_t& rank, uint8_t& previous) const {
+    for (rank = 0; rank < PRIORITY_CLASSES; rank++) {
+        previous = NONE;
+        for (uint8_t index = first[rank]; index != NONE; index = next[index]) {
+            const Entry& entry = entries[index];
+            if (entry.groupAddress == groupAddress && isWrite(entry.data, entry.length)) return index;
+            previous = index;
+        }
+    }
+    return NONE;
+}
+
+void KNXTxQueue::unlink(uint8_t rank, uint8_t index, uint8_t previous) {
+    if (previous == NONE) {
+        first[rank] = next[index];
+    } else {
+        next[previous] = next[index];
+    }
+    if (last[rank] == index) last[rank] = previous;
+    next[index] = NONE;
+}
+
+void KNXTxQueue::append(uint8_t rank, uint8_t index) {
+    next[index] = NONE;
+    if (last[rank] == NONE) {
+        first[rank] = index;
+    } else {
+        next[last[rank]] = index;
+    }
+    last[rank] = index;
+}
+
+bool KNXTxQueue::push(uint16_t groupAddress, const uint8_t* data, size_t length, KNXPriority priority) {
+    if (length > KNX_TELEGRAM_MAX_DATA) return false;
+    KNXLockGuard guard(lock);
+    if (!entries) return false;
+
+    uint8_t rank = rankOf(priority);
+    // Only a write replaces a write: a read or a response to the same address
+    // is a different request and keeps its own place
+    if (config.coalesce && isWrite(data, length)) {
+        uint8_t pendingRank;
+        uint8_t previous;
+        uint8_t index = findPendingWrite(groupAddress, pendingRank, previous);
+        if (index != NONE) {
+            Entry& entry = entries[index];
+            memcpy(entry.data, data, length);
+            entry.length = (uint8_t)length;
+            if (rank < pendingRank) {
+                // Raised priority: move to the tail of the more urgent class
+                unlink(pendingRank, index, previous);
+                append(rank, index);
+                entry.priority = priority;
+            }
+            counters.coalesced++;
+            return true;
+        }
+    }
+
+    if (freeList == NONE) {
+        counters.dropped++;
+        return false;
+    }
+
+    uint8_t index = freeList;
+    freeList = next[index];
+    Entry& entry = entries[index];
+    entry.groupAddress = groupAddress;
+    entry.priority = priority;
+    entry.length = (uint8_t)length;
+    memcpy(entry.data, data, length);
+    append(rank, index);
+
+    counters.queued++;
+    counters.depth++;
+    if (counters.depth > counters.highWater) counters.highWater = counters.depth;
+    return true;
+}
+
+void KNXTxQueue::refill(uint32_t nowMicros) {
+    uint32_t elapsed = nowMicros - lastRefill;
+    lastRefill = nowMicros;
+    uint32_t limit = costMicros * config.burst;
+    creditMicros = (elapsed >= limit - creditMicros) ? limit : creditMicros + elapsed;
+}
+
+bool KNXTxQueue::pop(uint32_t nowMicros, Entry& entry) {
+    KNXLockGuard guard(lock);
+    if (!entries || counters.depth == 0) return false;
+
+    refill(nowMicros);
+    if (creditMicros < costMicros) return false;
+
+    for (uint8_t rank = 0; rank < PRIORITY_CLASSES; rank++) {
+        uint8_t index = first[rank];
+        if (index == NONE) continue;
+
+        unlink(rank, index, NONE);
+        entry = entries[index];
+        next[index] = freeList;
+        freeList = index;
+
+        creditMicros -= costMicros;
+        counters.depth--;
+        return true;
+    }
+    return false;
+}
+
+void KNXTxQueue::released(bool sent) {
+    KNXLockGuard guard(lock);
+    if (sent) {
+        counters.sent++;
+    } else {
+        counters.dropped++;
+    }
+}
+
+uint32_t KNXTxQueue::microsUntilNext(uint32_t nowMicros) {
+    KNXLockGuard guard(lock);
+    if (!entries || counters.depth == 0) return UINT32_MAX;
+    refill(nowMicros);
+    return creditMicros >= costMicros ? 0 : costMicros - creditMicros;
+}
+
+KNXTxQueueStats KNXTxQueue::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
@@ -0,0 +1,147 @@
+//==== src/knx_value_filter.cpp ====
+
+#include "knx_value_filter.h"
+#include "knx_protocol.h"
+#include <utility>
+
+KNXValueFilterTable::KNXValueFilterTable() : slots(nullptr), counters() {}
+
+KNXValueFilterTable::~KNXValueFilterTable() {
+    knxDeleteArray(slots);
+}
+
+int KNXValueFilterTable::add(uint16_t groupAddress, const KNXValueFilter& filter,
+                             const KNXValueCodec* codec, KNXGroupAddressCallback callback) {
+    if ((filter.deadband > 0 || filter.average > 1) && !codec) return -1;
+
+    // Allocated and filled outside the lock; only swapped in under it
+    if (!slots) {
+        Slot* allocated = knxNewArray<Slot>(KNX_MAX_VALUE_FILTERS);
+        if (!allocated) return -1;
+        {
+            KNXLockGuard guard(lock);
+            if (!slots) std::swap(slots, allocated);
+        }
+        knxDeleteArray(allocated);
+    }
+    Slot entry;
+    entry.callback = callback;
+    entry.filter = filter;
+    entry.codec = codec;
+    entry.groupAddress = groupAddress;
+    entry.used = true;
+
+    KNXLockGuard guard(lock);
+    size_t index = 0;
+    while (index < KNX_MAX_VALUE_FILTERS && slots[index].used) index++;
+    if (index == KNX_MAX_VALUE_FILTERS) return -1;
+    std::swap(slots[index], entry);
+    counters.filters++;
+    return (int)index;
+}
+
+void KNXValueFilterTable::release(int slot) {
+    if (slot < 0 || slot >= KNX_MAX_VALUE_FILTERS) return;
+    Slot released; // Destroyed after the lock, with the callback
+    KNXLockGuard guard(lock);
+    if (!slots || !slots[slot].used) return;
+    std::swap(slots[slot], released);
+    counters.filters--;
+}
+
+void KNXValueFilterTable::remove(uint16_t groupAddress) {
+    for (size_t index = 0; index < KNX_MAX_VALUE_FILTERS; index++) {
+        Slot released;
+        KNXLockGuard guard(lock);
+        if (!slots) return;
+        if (slots[index].used && slots[index].groupAddress == groupAddress) {
+            std::swap(slots[index], released);
+            counters.filters--;
+        }
+    }
+}
+
+void KNXValueFilterTable::deliver(int index, const KNXTelegram& telegram, uint32_t nowMs) {
+    // Reads and other services carry no value: they pass unfiltered
+    if (telegram.command != KNX_APCI_GROUP_VALUE_WRITE &&
+        telegram.command != KNX_APCI_GROUP_VALUE_RESPONSE) {
+        if (slots[index].used) slots[index].callback(telegram);
+        return;
+    }
+
+    KNXTelegram scratch;
+    const KNXTelegram* forward;
+    {
+        KNXLockGuard guard(lock);
+        Slot& slot = slots[index];
+        if (!slot.used) return;
+        counters.evaluated++;
+        forward = evaluate(slot, telegram, scratch, nowMs);
+        if (!forward) return;
+        counters.forwarded++;
+    }
+    // The callback runs without the lock, it may send or subscribe
+    slots[index].callback(*forward);
+}
+
+const KNXTelegram* KNXValueFilterTable::evaluate(Slot& slot, const KNXTelegram& telegram,
+                                                 KNXTelegram& scratch, uint32_t nowMs) {
+    const KNXValueFilter& filter = slot.filter;
+    const KNXTelegram* forward = &telegram;
+    double value = 0;
+    bool numeric = slot.codec && slot.codec->decode(telegram.data.data(), telegram.data.size(), value);
+
+    if (filter.downsample > 1) {
+        if (++slot.phase < filter.downsample) {
+            counters.windowed++;
+            return nullptr;
+        }
+        slot.phase = 0;
+    }
+
+    if (filter.average > 1 && numeric) {
+        slot.sum += value;
+        if (++slot.samples < filter.average) {
+            counters.windowed++;
+            return nullptr;
+        }
+        // The last telegram of the window carries the mean, in the DPT's resolution
+        uint8_t data[KNXPayload::CAPACITY];
+        size_t length = slot.codec->encode(slot.sum / slot.samples, data);
+        slot.sum = 0;
+        slot.samples = 0;
+        scratch = telegram;
+        scratch.data.assign(data, length);
+        slot.codec->decode(scratch.data.data(), scratch.data.size(), value);
+        forward = &scratch;
+    }
+
+    if (slot.forwarded) {
+        if (filter.minIntervalMs > 0 && nowMs - slot.lastForwardMs < filter.minIntervalMs) {
+            counters.rateLimited++;
+            return nullptr;
+        }
+        bool unchanged = false;
+        if (filter.deadband > 0 && numeric) {
+            unchanged = std::fabs(value - slot.lastValue) < filter.deadband;
+        } else if (filter.onChange) {
+            unchanged = forward->data.size() == slot.lastData.size() &&
+                memcmp(forward->data.data(), slot.lastData.data(), slot.lastData.size()) == 0;
+        }
+        if (unchanged) {
+            counters.unchanged++;
+            return nullptr;
+        }
+    }
+
+    slot.forwarded = true;
+    slot.lastForwardMs = nowMs;
+    slot.lastValue = value;
+    slot.lastData = forward->data;
+    return forward;
+}
+
+KNXValueFilterStats KNXValueFilterTable::stats() {
+    KNXLockGuard guard(lock);
+    return counters;
+}
@@ -33,6 +33,13 @@ void setup() {
     // Set debug level (0=minimal, 1=normal, 2=verbose)
     knxModule.setDebugLevel(2);
 
+    // Run callbacks on their own task so slow handlers (Serial output) cannot
+    // stall the network task
+    knxModule.enableDispatchTask();
+
+    // Timed sends on the module's timer wheel instead of polling millis()
+    knxModule.enableScheduler();
+
     // Choose mode based on needs:
     // For debug/monitoring:
     if (knxModule.beginMulticast(1, 1, 0)) {
@@ -42,28 +49,28 @@ void setup() {
     // For normal operation:
     //if (knxModule.begin(knxGateway, 1, 1, 0)) {
     //    Serial.println("KNX module started");
+    // Or find the gateway by search and fail over between several:
+    //if (knxModule.beginDiscovery(1, 1, 0)) {
         
         // Register callback for group address 3/2/1 (temperature)
         int temperatureGroupAddr = (3 << 11) | (2 << 8) | 1;
         knxModule.onGroupAddress(temperatureGroupAddr, onTemperatureUpdate);
+
+        // Send temperature value (22.5°C) to group address 1/0/1 every 5 seconds
+        knxModule.sendCyclic<KNXDpt<9, 1>>((1 << 11) | (0 << 8) | 1, 5000, [] { return 22.5f; });
+
+        // Send boolean value (ON) to group address 2/1/5 when it changes, and
+        // repeat it every 5 seconds
+        KNXTimerHandle light = knxModule.addSendObject((2 << 11) | (1 << 8) | 5, 5000);
+        knxModule.updateSendObject<KNXDpt<1, 1>>(light, true);
     } else {
         Serial.println("KNX module failed to start");
     }
 }
 
 void loop() {
-    static unsigned long lastSendTime = 0;
-    if (millis() - lastSendTime > 5000) { // Send every 5 seconds
-        lastSendTime = millis();
-        
-        // Example: Send temperature value (22.5°C) to group address 1/0/1
-        int groupAddr = (1 << 11) | (0 << 8) | 1;
-        knxModule.sendTemperature(groupAddr, 22.5);
-        
-        // Example: Send boolean value (ON) to group address 2/1/5
-        groupAddr = (2 << 11) | (1 << 8) | 5;
-        knxModule.sendBool(groupAddr, true);
-    }
-    
-    delay(10);
+    // Services the module's background work and sleeps until it has more;
+    // received telegrams are dispatched by the dispatch task meanwhile
+    uint32_t idleMs = knxModule.poll();
+    delay(idleMs < 100 ? idleMs : 100);
 }
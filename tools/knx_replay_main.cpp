@@ -0,0 +1,145 @@
+//==== tools/knx_replay_main.cpp ====
+
+// Replays a packet capture into a KNXIPModule on the host and reports how
+// fast the module took it. Captures come from KNXIPModule::enableCapture() or
+// from Wireshark/tcpdump on the KNX network.
+//
+//   pio run -e replay && .pio/build/replay/program capture.pcap [options]
+//
+//   --speed N        replay at N times the captured rate (default 1)
+//   --max            no pacing, as fast as the module accepts datagrams
+//   --repeat N       replay the capture N times
+//   --skip IP        leave out datagrams sent by IP (the capturing device)
+//   --dispatch-task  parse and dispatch on the dispatch task
+//   --dedup          enable the dedup stage
+//
+// Every main group gets a counting callback, so all group telegrams reach the
+// dispatch stage. Routing (multicast) traffic replays as live; tunnelled
+// datagrams are delivered but dropped, as no tunnel is connected.
+
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "knx_ip_module.h"
+#include "knx_replay.h"
+
+namespace {
+
+void usage() {
+    printf("usage: program <capture.pcap> [--speed N | --max] [--repeat N] [--skip IP]\n"
+           "               [--dispatch-task] [--dedup]\n");
+}
+
+bool parseIP(const char* text, IPAddress& ip) {
+    unsigned a, b, c, d;
+    if (sscanf(text, "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    ip = IPAddress(a, b, c, d);
+    return true;
+}
+
+void printStage(const KNXStats& stats, KNXStatsStage stage, const char* name) {
+    const KNXLatencyHistogram& histogram = stats.stages[stage];
+    double perUs = stats.cyclesPerMicrosecond;
+    double mean = histogram.count ? (double)histogram.totalCycles / histogram.count : 0;
+    printf("  %-10s %9u samples  mean %8.2f us  p50 <%8.2f us  p99 <%8.2f us  max %8.2f us\n",
+        name, histogram.count, mean / perUs, histogram.percentileCycles(0.5f) / perUs,
+        histogram.percentileCycles(0.99f) / perUs, histogram.maxCycles / perUs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    KNXReplayOptions options;
+    options.speed = 1;
+    unsigned repeat = 1;
+    bool dispatchTask = false;
+    bool dedup = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--speed" && i + 1 < argc) {
+            options.speed = atof(argv[++i]);
+        } else if (arg == "--max") {
+            options.speed = 0;
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = (unsigned)atoi(argv[++i]);
+        } else if (arg == "--skip" && i + 1 < argc && parseIP(argv[i + 1], options.skipSource)) {
+            i++;
+        } else if (arg == "--dispatch-task") {
+            dispatchTask = true;
+        } else if (arg == "--dedup") {
+            dedup = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    KNXPcapReader reader;
+    if (!reader.load(argv[1])) {
+        printf("%s: %s\n", argv[1], reader.error().c_str());
+        return 1;
+    }
+    const std::vector<KNXReplayDatagram>& datagrams = reader.datagrams();
+    double durationS = datagrams.empty() ? 0 : datagrams.back().timestampUs / 1e6;
+    printf("%s: %zu UDP datagrams over %.3f s, %u other records skipped\n",
+        argv[1], datagrams.size(), durationS, reader.skipped());
+
+    KNXIPModule module;
+    module.setDebugLevel(0);
+    std::atomic<uint64_t> callbacks{0};
+    for (int mainGroup = 0; mainGroup < 32; mainGroup++) {
+        module.onMainGroup(mainGroup, [&callbacks](const KNXTelegram&) { callbacks++; });
+    }
+    if (dispatchTask) module.enableDispatchTask();
+    if (dedup) module.enableDedup();
+    module.beginMulticast(15, 15, 254);
+    AsyncUDPLoopback::setMulticastLoop(false);
+
+    std::vector<uint64_t> deliveryNs;
+    deliveryNs.reserve(datagrams.size() * repeat);
+    options.deliveryNs = &deliveryNs;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t delivered = 0;
+    for (unsigned i = 0; i < repeat; i++) {
+        delivered += knxReplay(datagrams, options);
+    }
+    if (dispatchTask) {
+        KNXRxQueueStats queue;
+        do {
+            delay(1);
+            queue = module.getRxQueueStats();
+        } while (queue.dispatched + queue.dropped < queue.received);
+    }
+    double elapsedS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    KNXStats stats = module.getStats();
+    printf("replayed %zu datagrams in %.3f s (%.0f datagrams/s, speed %s)\n",
+        delivered, elapsedS, elapsedS > 0 ? delivered / elapsedS : 0.0,
+        options.speed > 0 ? std::to_string(options.speed).c_str() : "max");
+    printf("  %u received, %u invalid, %u unknown services, %u filtered, %u parsed, %u parse errors\n",
+        stats.packetsReceived, stats.packetsInvalid, stats.unknownServices, stats.telegramsFiltered,
+        stats.telegramsParsed, stats.parseErrors);
+    printf("  %u dispatched, %llu callbacks\n", stats.telegramsDispatched, (unsigned long long)callbacks.load());
+    if (dispatchTask) {
+        KNXRxQueueStats queue = module.getRxQueueStats();
+        printf("  dispatch queue: %u dropped, high water %u of %u\n",
+            queue.dropped, queue.highWater, queue.depth);
+    }
+    if (dedup) {
+        KNXDedupStats dedupStats = module.getDedupStats();
+        printf("  dedup: %u own frames, %u duplicates\n", dedupStats.ownFrames, dedupStats.duplicates);
+    }
+    printStage(stats, KNX_STAGE_RECEIVE, "receive");
+    printStage(stats, KNX_STAGE_PARSE, "parse");
+    printStage(stats, KNX_STAGE_CALLBACKS, "callbacks");
+    return 0;
+}